@@ -0,0 +1,47 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "benchmark.hpp"
+
+#include "resources/track_loader.hpp"
+#include "resources/track.hpp"
+
+#include "scene/track_scene_generator_detail.hpp"
+
+#include "utility/parallel_for.hpp"
+
+using namespace ts;
+
+// Composes the texture atlases of a tile-heavy track without uploading them, once with
+// the serial per-atlas function and once with the parallel pipeline. Both include decoding
+// the source images, because that is a large part of the work.
+TS_BENCHMARK("atlas_composition")
+{
+  resources::TrackLoader track_loader;
+  track_loader.load_from_file("assets/tracks/test.trk");
+  auto track = track_loader.get_result();
+
+  auto image_mapping = scene::detail::generate_image_mapping(track);
+  auto placement_map = scene::detail::generate_atlas_placement_map(track, image_mapping, { 2048, 2048 }, true);
+
+  benchmark.report("atlas_count", static_cast<double>(placement_map.atlases.size()));
+  benchmark.report("threads", static_cast<double>(utility::default_thread_count()));
+
+  benchmark.measure("serial", [&]()
+  {
+    scene::detail::ImageLoader image_loader;
+    for (const auto& atlas : placement_map.atlases)
+    {
+      scene::detail::build_atlas_image(atlas, image_loader);
+    }
+  });
+
+  benchmark.measure("parallel", [&]()
+  {
+    scene::detail::ImageLoader image_loader;
+    scene::detail::build_atlas_images(placement_map, image_loader);
+  });
+}
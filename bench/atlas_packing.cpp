@@ -0,0 +1,58 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "benchmark.hpp"
+
+#include "resources/track_loader.hpp"
+#include "resources/track.hpp"
+
+#include "scene/track_scene_generator_detail.hpp"
+
+#include <string>
+
+using namespace ts;
+
+// Packs the atlases of the test tracks with every strategy, reporting the resulting
+// atlas count and occupancy along with the time it takes.
+TS_BENCHMARK("atlas_packing")
+{
+  using scene::detail::AtlasPackingOptions;
+  using utility::AtlasPackingStrategy;
+
+  for (const char* track_name : { "test", "banaring" })
+  {
+    resources::TrackLoader track_loader;
+    track_loader.load_from_file(std::string("assets/tracks/") + track_name + ".trk");
+    auto track = track_loader.get_result();
+
+    auto image_mapping = scene::detail::generate_image_mapping(track);
+
+    auto run_strategy = [&](const char* strategy_name, AtlasPackingStrategy strategy, bool presort)
+    {
+      AtlasPackingOptions options;
+      options.strategy = strategy;
+      options.presort = presort;
+
+      auto case_name = std::string(track_name) + "/" + strategy_name;
+      auto placement_map = scene::detail::generate_atlas_placement_map(track, image_mapping, { 2048, 2048 },
+                                                                       true, options);
+
+      auto stats = scene::detail::compute_packing_stats(placement_map);
+      benchmark.report(case_name + "/atlas_count", static_cast<double>(stats.atlas_count));
+      benchmark.report(case_name + "/occupancy", stats.total_occupancy);
+
+      benchmark.measure(case_name, [&]()
+      {
+        scene::detail::generate_atlas_placement_map(track, image_mapping, { 2048, 2048 }, true, options);
+      });
+    };
+
+    run_strategy("maxrects_in_order", AtlasPackingStrategy::MaxRects, false);
+    run_strategy("maxrects_presorted", AtlasPackingStrategy::MaxRects, true);
+    run_strategy("skyline_in_order", AtlasPackingStrategy::Skyline, false);
+    run_strategy("skyline_presorted", AtlasPackingStrategy::Skyline, true);
+  }
+}
@@ -0,0 +1,79 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace ts
+{
+  namespace bench
+  {
+    static std::vector<BenchmarkEntry>& benchmark_registry()
+    {
+      static std::vector<BenchmarkEntry> registry;
+      return registry;
+    }
+
+    const std::vector<BenchmarkEntry>& registered_benchmarks()
+    {
+      return benchmark_registry();
+    }
+
+    BenchmarkRegistration::BenchmarkRegistration(const char* name, BenchmarkFunction function)
+    {
+      benchmark_registry().push_back({ name, function });
+    }
+
+    Benchmark::Benchmark(std::string name, std::size_t iterations)
+      : name_(std::move(name)),
+        iterations_(std::max<std::size_t>(iterations, 1))
+    {
+    }
+
+    const std::string& Benchmark::name() const
+    {
+      return name_;
+    }
+
+    std::size_t Benchmark::iterations() const
+    {
+      return iterations_;
+    }
+
+    const std::vector<Measurement>& Benchmark::measurements() const
+    {
+      return measurements_;
+    }
+
+    const std::vector<Metric>& Benchmark::metrics() const
+    {
+      return metrics_;
+    }
+
+    void Benchmark::report(const std::string& metric_name, double value)
+    {
+      Metric metric;
+      metric.name = metric_name;
+      metric.value = value;
+      metrics_.push_back(metric);
+    }
+
+    void Benchmark::add_measurement(const std::string& case_name, std::vector<double> samples)
+    {
+      std::sort(samples.begin(), samples.end());
+
+      Measurement measurement;
+      measurement.name = case_name;
+      measurement.iterations = samples.size();
+      measurement.min = samples.front();
+      measurement.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+      measurement.median = samples[samples.size() / 2];
+      measurements_.push_back(measurement);
+    }
+  }
+}
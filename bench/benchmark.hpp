@@ -0,0 +1,110 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace ts
+{
+  namespace bench
+  {
+    // Timing statistics of one measured case, in milliseconds.
+    struct Measurement
+    {
+      std::string name;
+      std::size_t iterations = 0;
+      double min = 0.0;
+      double mean = 0.0;
+      double median = 0.0;
+    };
+
+    // Arbitrary numbers a benchmark wants to show along with its timings, e.g. atlas counts.
+    struct Metric
+    {
+      std::string name;
+      double value = 0.0;
+    };
+
+    // The Benchmark class is handed to every benchmark function. It times the cases
+    // passed to measure() and collects the results, so that they can be printed afterwards.
+    class Benchmark
+    {
+    public:
+      explicit Benchmark(std::string name, std::size_t iterations);
+
+      // Calls func once to warm up, and then times it for the configured number of iterations.
+      template <typename Func>
+      void measure(const std::string& case_name, Func&& func);
+
+      void report(const std::string& metric_name, double value);
+
+      const std::string& name() const;
+      std::size_t iterations() const;
+
+      const std::vector<Measurement>& measurements() const;
+      const std::vector<Metric>& metrics() const;
+
+    private:
+      void add_measurement(const std::string& case_name, std::vector<double> samples);
+
+      std::string name_;
+      std::size_t iterations_;
+      std::vector<Measurement> measurements_;
+      std::vector<Metric> metrics_;
+    };
+
+    using BenchmarkFunction = void(*)(Benchmark&);
+
+    struct BenchmarkEntry
+    {
+      const char* name;
+      BenchmarkFunction function;
+    };
+
+    const std::vector<BenchmarkEntry>& registered_benchmarks();
+
+    // Adds a benchmark to the global list upon construction. Use the TS_BENCHMARK macro
+    // instead of using this directly.
+    struct BenchmarkRegistration
+    {
+      BenchmarkRegistration(const char* name, BenchmarkFunction function);
+    };
+
+    template <typename Func>
+    void Benchmark::measure(const std::string& case_name, Func&& func)
+    {
+      using clock_type = std::chrono::steady_clock;
+
+      func();
+
+      std::vector<double> samples;
+      samples.reserve(iterations_);
+      for (std::size_t i = 0; i != iterations_; ++i)
+      {
+        auto start = clock_type::now();
+        func();
+        auto end = clock_type::now();
+
+        samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+      }
+
+      add_measurement(case_name, std::move(samples));
+    }
+  }
+}
+
+#define TS_BENCHMARK_CONCAT_IMPL(a, b) a##b
+#define TS_BENCHMARK_CONCAT(a, b) TS_BENCHMARK_CONCAT_IMPL(a, b)
+
+#define TS_BENCHMARK(name) \
+  static void TS_BENCHMARK_CONCAT(benchmark_function_, __LINE__)(ts::bench::Benchmark&); \
+  static const ts::bench::BenchmarkRegistration TS_BENCHMARK_CONCAT(benchmark_registration_, __LINE__) \
+    (name, &TS_BENCHMARK_CONCAT(benchmark_function_, __LINE__)); \
+  static void TS_BENCHMARK_CONCAT(benchmark_function_, __LINE__)(ts::bench::Benchmark& benchmark)
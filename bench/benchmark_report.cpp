@@ -0,0 +1,136 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "benchmark_report.hpp"
+
+#include "utility/stream_utilities.hpp"
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+namespace ts
+{
+  namespace bench
+  {
+    namespace detail
+    {
+      // JSON has no representation for infinity and NaN.
+      void write_json_number(std::ostream& stream, double value)
+      {
+        if (std::isfinite(value)) stream << value;
+        else stream << "null";
+      }
+    }
+
+    void write_json_report(std::ostream& stream, const std::vector<Benchmark>& benchmarks)
+    {
+      auto precision = stream.precision(std::numeric_limits<double>::digits10);
+
+      stream << "{\n  \"benchmarks\": [";
+      for (std::size_t index = 0; index != benchmarks.size(); ++index)
+      {
+        const auto& benchmark = benchmarks[index];
+        stream << (index == 0 ? "\n" : ",\n") << "    {\n      \"name\": ";
+        write_json_string(stream, benchmark.name());
+        stream << ",\n      \"iterations\": " << benchmark.iterations() << ",\n      \"measurements\": [";
+
+        const auto& measurements = benchmark.measurements();
+        for (std::size_t m = 0; m != measurements.size(); ++m)
+        {
+          const auto& measurement = measurements[m];
+          stream << (m == 0 ? "\n" : ",\n") << "        { \"name\": ";
+          write_json_string(stream, measurement.name);
+          stream << ", \"iterations\": " << measurement.iterations << ", \"min_ms\": ";
+          detail::write_json_number(stream, measurement.min);
+          stream << ", \"median_ms\": ";
+          detail::write_json_number(stream, measurement.median);
+          stream << ", \"mean_ms\": ";
+          detail::write_json_number(stream, measurement.mean);
+          stream << " }";
+        }
+
+        stream << (measurements.empty() ? "]" : "\n      ]") << ",\n      \"metrics\": [";
+
+        const auto& metrics = benchmark.metrics();
+        for (std::size_t m = 0; m != metrics.size(); ++m)
+        {
+          stream << (m == 0 ? "\n" : ",\n") << "        { \"name\": ";
+          write_json_string(stream, metrics[m].name);
+          stream << ", \"value\": ";
+          detail::write_json_number(stream, metrics[m].value);
+          stream << " }";
+        }
+
+        stream << (metrics.empty() ? "]" : "\n      ]") << "\n    }";
+      }
+
+      stream << (benchmarks.empty() ? "]" : "\n  ]") << "\n}\n";
+      stream.precision(precision);
+    }
+
+    std::map<std::string, double> load_baseline(const std::string& file_name)
+    {
+      boost::property_tree::ptree tree;
+      try
+      {
+        boost::property_tree::read_json(file_name, tree);
+      }
+
+      catch (const boost::property_tree::json_parser_error& error)
+      {
+        throw std::runtime_error("could not read baseline: " + std::string(error.what()));
+      }
+
+      std::map<std::string, double> baseline;
+      for (const auto& benchmark : tree.get_child("benchmarks", {}))
+      {
+        auto benchmark_name = benchmark.second.get<std::string>("name", "");
+        for (const auto& measurement : benchmark.second.get_child("measurements", {}))
+        {
+          auto median = measurement.second.get_optional<double>("median_ms");
+          if (median)
+          {
+            baseline[benchmark_name + "/" + measurement.second.get<std::string>("name", "")] = *median;
+          }
+        }
+      }
+
+      return baseline;
+    }
+
+    std::vector<BaselineComparison> compare_to_baseline(const std::vector<Benchmark>& benchmarks,
+                                                        const std::map<std::string, double>& baseline,
+                                                        double threshold)
+    {
+      std::vector<BaselineComparison> result;
+      for (const auto& benchmark : benchmarks)
+      {
+        for (const auto& measurement : benchmark.measurements())
+        {
+          auto name = benchmark.name() + "/" + measurement.name;
+          auto it = baseline.find(name);
+          if (it == baseline.end() || it->second <= 0.0) continue;
+
+          BaselineComparison comparison;
+          comparison.name = name;
+          comparison.baseline = it->second;
+          comparison.current = measurement.median;
+          comparison.change = (measurement.median - it->second) * 100.0 / it->second;
+          comparison.regressed = comparison.change > threshold;
+          result.push_back(comparison);
+        }
+      }
+
+      return result;
+    }
+  }
+}
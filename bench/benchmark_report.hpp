@@ -0,0 +1,45 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include "benchmark.hpp"
+
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ts
+{
+  namespace bench
+  {
+    // Writes the measurements and metrics of all benchmarks as JSON, so that they can be
+    // stored and compared with later runs.
+    void write_json_report(std::ostream& stream, const std::vector<Benchmark>& benchmarks);
+
+    // The median times of a JSON report written by write_json_report(), in milliseconds,
+    // keyed by "benchmark/case". Throws std::runtime_error if the file can't be read.
+    std::map<std::string, double> load_baseline(const std::string& file_name);
+
+    struct BaselineComparison
+    {
+      std::string name;
+      double baseline = 0.0;
+      double current = 0.0;
+
+      // The relative change of the median, in percent. Positive means slower.
+      double change = 0.0;
+      bool regressed = false;
+    };
+
+    // Compares the medians of every case that is also in the baseline. A case has regressed
+    // if it got slower by more than threshold percent.
+    std::vector<BaselineComparison> compare_to_baseline(const std::vector<Benchmark>& benchmarks,
+                                                        const std::map<std::string, double>& baseline,
+                                                        double threshold);
+  }
+}
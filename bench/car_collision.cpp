@@ -0,0 +1,140 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "benchmark.hpp"
+
+#include "world/car.hpp"
+#include "world/car_collision.hpp"
+#include "world/world_event_interface.hpp"
+
+#include "resources/car_definition.hpp"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace ts;
+
+namespace
+{
+  struct CollisionCounter
+    : world::EventInterface
+  {
+    virtual void on_collision(const world::Entity*, const world::Entity*,
+                              const world::CollisionResult&) override
+    {
+      ++count;
+    }
+
+    std::size_t count = 0;
+  };
+}
+
+// A pile-up at the start of a race: a full field of cars on a tight start grid, all driving
+// towards the middle of the grid. Each tick moves the cars and resolves their collisions.
+TS_BENCHMARK("car_collision")
+{
+  const std::size_t car_count = 256;
+  const std::size_t column_count = 4;
+  const std::size_t tick_count = 50;
+  const double frame_duration = 0.02;
+
+  resources::CarDefinition car_definition;
+  car_definition.image_rect = IntRect(0, 0, 48, 24);
+  car_definition.image_scale = 2.0;
+  car_definition.bounciness = 0.5;
+  auto collision_shape = world::car_collision_shape(car_definition);
+
+  std::mt19937 random_engine(1234);
+  std::uniform_real_distribution<double> jitter_dist(-2.0, 2.0);
+
+  std::vector<std::unique_ptr<world::Car>> cars;
+  std::vector<Vector2d> start_positions, start_velocities;
+  for (std::size_t index = 0; index != car_count; ++index)
+  {
+    auto row = static_cast<double>(index / column_count);
+    auto column = static_cast<double>(index % column_count);
+
+    start_positions.push_back({ 1000.0 + column * 14.0 + jitter_dist(random_engine),
+                                1000.0 + row * 26.0 + jitter_dist(random_engine) });
+
+    auto towards_middle = make_vector2(1000.0 + column_count * 7.0, 1000.0 + car_count / column_count * 13.0) -
+      start_positions.back();
+    start_velocities.push_back(normalize(towards_middle) * 150.0);
+
+    cars.push_back(std::make_unique<world::Car>(car_definition, static_cast<std::uint16_t>(index)));
+  }
+
+  auto reset_cars = [&]()
+  {
+    for (std::size_t index = 0; index != car_count; ++index)
+    {
+      cars[index]->set_position(start_positions[index]);
+      cars[index]->set_velocity(start_velocities[index]);
+      cars[index]->set_rotation(degrees(90.0));
+      cars[index]->set_angular_velocity(0.0);
+    }
+  };
+
+  world::CarCollisions car_collisions;
+  for (auto& car : cars) car_collisions.add_entity(car.get(), collision_shape);
+
+  auto case_prefix = std::to_string(car_count) + "_cars/";
+
+  CollisionCounter collision_counter;
+  std::size_t candidate_pairs = 0;
+  benchmark.measure(case_prefix + "pile_up", [&]()
+  {
+    reset_cars();
+    collision_counter.count = 0;
+    candidate_pairs = 0;
+
+    for (std::size_t tick = 0; tick != tick_count; ++tick)
+    {
+      for (auto& car : cars)
+      {
+        car->set_position(car->position() + car->velocity() * frame_duration);
+      }
+
+      car_collisions.update(collision_counter);
+      candidate_pairs += car_collisions.candidate_pair_count();
+    }
+  });
+
+  const auto& measurement = benchmark.measurements().back();
+  if (measurement.median > 0.0)
+  {
+    benchmark.report(case_prefix + "pile_up/microseconds_per_tick", measurement.median * 1000.0 / tick_count);
+  }
+
+  benchmark.report(case_prefix + "pile_up/candidate_pairs_per_tick", static_cast<double>(candidate_pairs) / tick_count);
+  benchmark.report(case_prefix + "pile_up/collisions_per_tick",
+                   static_cast<double>(collision_counter.count) / tick_count);
+
+  // The broad-phase on its own, against testing every pair.
+  reset_cars();
+  std::vector<world::BoundingCircle> circles;
+  for (auto& car : cars) circles.push_back({ car->position(), magnitude(make_vector2(24.0, 12.0)), 0 });
+
+  world::BroadPhase broad_phase;
+  benchmark.measure(case_prefix + "broad_phase/sweep_and_prune", [&]()
+  {
+    for (std::size_t tick = 0; tick != tick_count; ++tick)
+    {
+      broad_phase.find_pairs(circles.data(), circles.size());
+    }
+  });
+
+  std::vector<world::CollisionPair> all_pairs;
+  benchmark.measure(case_prefix + "broad_phase/all_pairs", [&]()
+  {
+    for (std::size_t tick = 0; tick != tick_count; ++tick)
+    {
+      world::detail::find_all_pairs(circles.data(), circles.size(), all_pairs);
+    }
+  });
+}
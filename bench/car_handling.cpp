@@ -0,0 +1,114 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "benchmark.hpp"
+
+#include "world/car.hpp"
+#include "world/handling_batch.hpp"
+
+#include "resources/car_definition.hpp"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace ts;
+
+// Updates the handling of a full field of cars, once car by car as Car::update() used to, and
+// once with all cars in a single batch. The terrain lookups are left out, because they need a
+// world, and they are the same for both.
+TS_BENCHMARK("car_handling")
+{
+  const std::size_t car_count = 256;
+  const std::size_t tick_count = 100;
+  const double frame_duration = 0.01;
+
+  resources::CarDefinition car_definition;
+  car_definition.handling.gear_ratios = { 3.0, 2.2, 1.7, 1.35, 1.1 };
+  car_definition.handling.max_acceleration_force = 60000.0;
+  car_definition.handling.max_braking_force = 30000.0;
+
+  std::mt19937 random_engine(1234);
+  std::uniform_real_distribution<double> unit_dist(0.0, 1.0);
+
+  std::vector<std::unique_ptr<world::Car>> cars;
+  std::vector<world::Car*> car_pointers;
+  for (std::size_t index = 0; index != car_count; ++index)
+  {
+    auto car = std::make_unique<world::Car>(car_definition, static_cast<std::uint16_t>(index));
+    car->set_position({ unit_dist(random_engine) * 4000.0, unit_dist(random_engine) * 4000.0 });
+    car->set_velocity({ unit_dist(random_engine) * 200.0 - 100.0, unit_dist(random_engine) * 200.0 - 100.0 });
+    car->set_rotation(degrees(unit_dist(random_engine) * 360.0));
+    car->set_control_state(controls::Control::Throttle, true);
+    car->set_control_state(controls::Control::Left, index % 2 == 0);
+
+    car_pointers.push_back(car.get());
+    cars.push_back(std::move(car));
+  }
+
+  world::HandlingBatch batch;
+  auto case_prefix = std::to_string(car_count) + "_cars/";
+
+  auto report_tick_time = [&](const std::string& case_name)
+  {
+    const auto& measurement = benchmark.measurements().back();
+    if (measurement.median > 0.0)
+    {
+      benchmark.report(case_name + "/microseconds_per_tick", measurement.median * 1000.0 / tick_count);
+    }
+  };
+
+  benchmark.measure(case_prefix + "per_car", [&]()
+  {
+    for (std::size_t tick = 0; tick != tick_count; ++tick)
+    {
+      for (auto& car : car_pointers)
+      {
+        world::gather_car_states(batch, &car, 1);
+        world::detail::compute_wheel_kinematics_scalar(batch, 0, 1);
+        world::compute_handling_forces(batch, frame_duration);
+        world::apply_handling_forces(batch, &car);
+      }
+    }
+  });
+
+  report_tick_time(case_prefix + "per_car");
+
+  benchmark.measure(case_prefix + "batched", [&]()
+  {
+    for (std::size_t tick = 0; tick != tick_count; ++tick)
+    {
+      world::gather_car_states(batch, car_pointers.data(), car_count);
+      world::compute_wheel_kinematics(batch);
+      world::compute_handling_forces(batch, frame_duration);
+      world::apply_handling_forces(batch, car_pointers.data());
+    }
+  });
+
+  report_tick_time(case_prefix + "batched");
+
+  // The kinematics kernel on its own, which is the part that is vectorized.
+  benchmark.measure(case_prefix + "wheel_kinematics_scalar", [&]()
+  {
+    for (std::size_t tick = 0; tick != tick_count; ++tick)
+    {
+      world::detail::compute_wheel_kinematics_scalar(batch, 0, batch.size());
+    }
+  });
+
+  report_tick_time(case_prefix + "wheel_kinematics_scalar");
+
+  benchmark.measure(case_prefix + "wheel_kinematics", [&]()
+  {
+    for (std::size_t tick = 0; tick != tick_count; ++tick)
+    {
+      world::compute_wheel_kinematics(batch);
+    }
+  });
+
+  report_tick_time(case_prefix + "wheel_kinematics");
+}
@@ -0,0 +1,70 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "benchmark.hpp"
+
+#include "scene/car_instances.hpp"
+
+#include "graphics/texture.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace ts;
+
+// Records and packs the car instances of a full field, the CPU-side part of drawing the cars.
+// Cars are spread over a couple of levels and car textures, as in a typical race. The textures
+// have no GL texture behind them, so they're told apart by address only.
+TS_BENCHMARK("car_instances")
+{
+  graphics::Texture car_textures[2] = { graphics::Texture(0, { 2048, 2048 }), graphics::Texture(0, { 2048, 2048 }) };
+  graphics::Texture colorizer_texture(0, { 2048, 2048 });
+
+  for (std::size_t car_count : { 16, 256 })
+  {
+    std::mt19937 random_engine(1234);
+    std::uniform_real_distribution<float> position_dist(0.0f, 4096.0f);
+    std::uniform_real_distribution<float> rotation_dist(0.0f, 360.0f);
+
+    std::vector<scene::DrawableEntity> entities(car_count);
+    for (auto& entity : entities)
+    {
+      auto index = static_cast<std::uint32_t>(&entity - entities.data());
+      entity.texture = &car_textures[index * 2 / car_count];
+      entity.colorizer_texture = &colorizer_texture;
+      entity.level = index % 3;
+
+      entity.model_transform.translate(position_dist(random_engine), position_dist(random_engine));
+      entity.model_transform.rotate(rotation_dist(random_engine));
+      entity.model_transform.scale(32.0f, 16.0f);
+      entity.new_model_transform = entity.model_transform;
+      entity.new_model_transform.translate(0.1f, 0.0f);
+
+      entity.texture_coords_scale = { 0.25f, 0.25f };
+      entity.colors.fill(0.5f);
+    }
+
+    scene::DrawCommandList commands;
+    std::vector<scene::CarInstance> instances;
+    std::vector<scene::CarInstanceBatch> batches;
+
+    auto case_name = std::to_string(car_count) + "_cars";
+    benchmark.measure(case_name, [&]()
+    {
+      scene::record_entity_commands(entities.data(), entities.size(), commands);
+      scene::pack_car_instances(entities.data(), commands, instances, batches);
+    });
+
+    benchmark.report(case_name + "/batch_count", static_cast<double>(batches.size()));
+
+    const auto& measurement = benchmark.measurements().back();
+    if (measurement.median > 0.0)
+    {
+      benchmark.report(case_name + "/instances_per_microsecond", car_count / (measurement.median * 1000.0));
+    }
+  }
+}
@@ -0,0 +1,125 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "benchmark.hpp"
+
+#include "resources/pattern.hpp"
+#include "resources/collision_mask.hpp"
+#include "resources/collision_mask_detail.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace ts;
+
+// Builds the rotated frames of a car-sized mask, and tests it against a maze of walls and
+// against other cars. Both patterns are generated, so that the numbers don't depend on assets.
+TS_BENCHMARK("collision_mask")
+{
+  const std::uint32_t frame_count = 64;
+  const std::size_t test_count = 100000;
+  const Vector2i scenery_size = { 2048, 2048 };
+
+  // An oval car shape with a hole for the cockpit.
+  resources::Pattern car_pattern({ 48, 24 });
+  for (std::int32_t y = 0; y != 24; ++y)
+  {
+    for (std::int32_t x = 0; x != 48; ++x)
+    {
+      auto dx = (x - 23.5) / 24.0, dy = (y - 11.5) / 12.0;
+      auto distance = dx * dx + dy * dy;
+      car_pattern(x, y) = distance <= 1.0 && distance >= 0.1 ? 1 : 0;
+    }
+  }
+
+  // Wall blocks on a regular grid, one of every four cells.
+  resources::Pattern scenery_pattern(scenery_size);
+  for (std::int32_t y = 0; y != scenery_size.y; ++y)
+  {
+    for (std::int32_t x = 0; x != scenery_size.x; ++x)
+    {
+      scenery_pattern(x, y) = (x / 64 % 2 == 0 && y / 64 % 2 == 0) ? 1 : 0;
+    }
+  }
+
+  auto object_wall_test = [](auto p) { return p != 0; };
+  auto scenery_wall_test = [](auto p, auto) { return p != 0; };
+
+  benchmark.measure("dynamic_mask_build", [&]()
+  {
+    resources::CollisionMask mask(resources::dynamic_mask, car_pattern, frame_count, object_wall_test);
+  });
+
+  benchmark.measure("static_mask_build", [&]()
+  {
+    resources::CollisionMask mask(scenery_pattern, 1, scenery_wall_test);
+  });
+
+  resources::CollisionMask car_mask(resources::dynamic_mask, car_pattern, frame_count, object_wall_test);
+  resources::CollisionMask scenery_mask(scenery_pattern, 1, scenery_wall_test);
+
+  struct Test
+  {
+    std::uint32_t subject_frame;
+    std::uint32_t object_frame;
+    Vector2i subject_position;
+    Vector2i object_offset;
+  };
+
+  std::mt19937 random_engine(1234);
+  std::uniform_int_distribution<std::uint32_t> frame_dist(0, frame_count - 1);
+  std::uniform_int_distribution<std::int32_t> position_dist(0, scenery_size.x - 64);
+  std::uniform_int_distribution<std::int32_t> offset_dist(-40, 40);
+
+  std::vector<Test> tests(test_count);
+  for (auto& test : tests)
+  {
+    test.subject_frame = frame_dist(random_engine);
+    test.object_frame = frame_dist(random_engine);
+    test.subject_position = { position_dist(random_engine), position_dist(random_engine) };
+    test.object_offset = { offset_dist(random_engine), offset_dist(random_engine) };
+  }
+
+  auto scenery_frame = scenery_mask.frame(0);
+  auto report_test_time = [&](const std::string& case_name, std::size_t hit_count)
+  {
+    const auto& measurement = benchmark.measurements().back();
+    if (measurement.median > 0.0)
+    {
+      benchmark.report(case_name + "/nanoseconds_per_test", measurement.median * 1e6 / test_count);
+    }
+
+    benchmark.report(case_name + "/hit_ratio", static_cast<double>(hit_count) / test_count);
+  };
+
+  std::size_t hit_count = 0;
+  benchmark.measure("scenery_test", [&]()
+  {
+    hit_count = 0;
+    for (const auto& test : tests)
+    {
+      auto collision = resources::test_scenery_collision(car_mask.frame(test.subject_frame), scenery_frame,
+                                                         test.subject_position);
+      if (collision) ++hit_count;
+    }
+  });
+
+  report_test_time("scenery_test", hit_count);
+
+  benchmark.measure("object_test", [&]()
+  {
+    hit_count = 0;
+    for (const auto& test : tests)
+    {
+      auto collision = resources::test_collision(car_mask.frame(test.subject_frame), car_mask.frame(test.object_frame),
+                                                 test.subject_position, test.subject_position + test.object_offset);
+      if (collision) ++hit_count;
+    }
+  });
+
+  report_test_time("object_test", hit_count);
+}
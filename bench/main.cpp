@@ -0,0 +1,149 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "benchmark.hpp"
+#include "benchmark_report.hpp"
+
+#include "utility/debug_log.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace ts;
+
+// Usage: tselements_bench [-n iterations] [--json file] [--baseline file] [--threshold percent] [filter]
+// Runs all benchmarks whose name contains the filter string. Must be run from a directory
+// that contains the test assets, the build copies them next to the executable.
+// --json writes the results to a file, and --baseline compares them with the results of an
+// earlier run. If any case got slower by more than the threshold (10% by default), the exit
+// code is 2.
+int main(int argc, char* argv[])
+{
+  debug::DebugConfig debug_config;
+  debug_config.debug_level = debug::level::essential;
+  debug::ScopedLogger debug_log(debug_config, "bench_debug.txt");
+
+  std::size_t iterations = 10;
+  std::string filter;
+  std::string json_file;
+  std::string baseline_file;
+  double threshold = 10.0;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+    {
+      iterations = std::strtoul(argv[++i], nullptr, 10);
+    }
+
+    else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+    {
+      json_file = argv[++i];
+    }
+
+    else if (std::strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+    {
+      baseline_file = argv[++i];
+    }
+
+    else if (std::strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+    {
+      threshold = std::strtod(argv[++i], nullptr);
+    }
+
+    else
+    {
+      filter = argv[i];
+    }
+  }
+
+  int result = 0;
+  std::vector<bench::Benchmark> results;
+  for (const auto& entry : bench::registered_benchmarks())
+  {
+    if (std::strstr(entry.name, filter.c_str()) == nullptr) continue;
+
+    bench::Benchmark benchmark(entry.name, iterations);
+    try
+    {
+      entry.function(benchmark);
+    }
+
+    catch (const std::exception& e)
+    {
+      std::cerr << entry.name << ": " << e.what() << std::endl;
+      result = 1;
+      continue;
+    }
+
+    std::cout << entry.name << "\n";
+    for (const auto& measurement : benchmark.measurements())
+    {
+      std::cout << "  " << std::left << std::setw(32) << measurement.name << std::right << std::fixed
+        << std::setprecision(3) << " min " << std::setw(10) << measurement.min << " ms"
+        << "  median " << std::setw(10) << measurement.median << " ms"
+        << "  mean " << std::setw(10) << measurement.mean << " ms"
+        << "  (" << measurement.iterations << " iterations)\n";
+    }
+
+    for (const auto& metric : benchmark.metrics())
+    {
+      std::cout << "  " << std::left << std::setw(32) << metric.name << std::right << " "
+        << std::defaultfloat << metric.value << "\n";
+    }
+
+    results.push_back(std::move(benchmark));
+  }
+
+  if (!json_file.empty())
+  {
+    std::ofstream stream(json_file);
+    bench::write_json_report(stream, results);
+    if (!stream)
+    {
+      std::cerr << "could not write " << json_file << std::endl;
+      result = 1;
+    }
+  }
+
+  if (!baseline_file.empty())
+  {
+    try
+    {
+      auto comparisons = bench::compare_to_baseline(results, bench::load_baseline(baseline_file), threshold);
+
+      std::cout << "\ncompared to " << baseline_file << "\n";
+      for (const auto& comparison : comparisons)
+      {
+        std::cout << "  " << std::left << std::setw(48) << comparison.name << std::right << std::fixed
+          << std::setprecision(3) << std::setw(10) << comparison.baseline << " ms -> "
+          << std::setw(10) << comparison.current << " ms  " << std::showpos << std::setprecision(1)
+          << std::setw(7) << comparison.change << "%" << std::noshowpos
+          << (comparison.regressed ? "  REGRESSED" : "") << "\n";
+
+        if (comparison.regressed && result == 0) result = 2;
+      }
+    }
+
+    catch (const std::exception& e)
+    {
+      std::cerr << e.what() << std::endl;
+      result = 1;
+    }
+  }
+
+  return result;
+}
+
+#define TS_DATA_DIRECTORY "assets/data"
+
+#include "core/config_definitions.hpp"
@@ -0,0 +1,72 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "benchmark.hpp"
+
+#include "world/world_event_translator.hpp"
+#include "world/world_event_translator_detail.hpp"
+#include "world/collision_result.hpp"
+#include "world/control_point_manager.hpp"
+
+#include "server/server_message_dispatcher.hpp"
+
+#include <string>
+
+using namespace ts;
+
+// Sends world events through the event translator and the server's message dispatcher, the
+// path every collision and control point hit takes during a race. No stage or cup is attached,
+// so this measures the cost of translating and routing the messages, not of handling them.
+TS_BENCHMARK("message_dispatch")
+{
+  const std::size_t event_count = 1000000;
+
+  server::MessageDispatcher dispatcher{ server::MessageConveyor() };
+  auto event_translator = world::make_world_event_translator(dispatcher);
+  world::EventInterface& event_interface = event_translator;
+
+  world::ControlPoint control_point;
+  world::CollisionResult collision;
+
+  auto report_event_time = [&](const std::string& case_name)
+  {
+    const auto& measurement = benchmark.measurements().back();
+    if (measurement.median > 0.0)
+    {
+      benchmark.report(case_name + "/nanoseconds_per_event", measurement.median * 1e6 / event_count);
+    }
+  };
+
+  benchmark.measure("entity_collision", [&]()
+  {
+    for (std::size_t index = 0; index != event_count; ++index)
+    {
+      event_interface.on_collision(nullptr, nullptr, collision);
+    }
+  });
+
+  report_event_time("entity_collision");
+
+  benchmark.measure("scenery_collision", [&]()
+  {
+    for (std::size_t index = 0; index != event_count; ++index)
+    {
+      event_interface.on_collision(nullptr, collision);
+    }
+  });
+
+  report_event_time("scenery_collision");
+
+  benchmark.measure("control_point_hit", [&]()
+  {
+    for (std::size_t index = 0; index != event_count; ++index)
+    {
+      event_interface.on_control_point_hit(nullptr, control_point, static_cast<std::uint32_t>(index % 20));
+    }
+  });
+
+  report_event_time("control_point_hit");
+}
@@ -0,0 +1,78 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "benchmark.hpp"
+
+#include "scene/particle_generator.hpp"
+
+#include <random>
+#include <string>
+
+using namespace ts;
+
+// Runs the particle generator for a full field of cars driving over rough terrain, with the
+// default and the old, much smaller particle capacity. The time per tick should not depend on
+// the capacity, because only the spawned and expired particles are touched.
+TS_BENCHMARK("particle_generator")
+{
+  const std::uint32_t level_count = 3;
+  const std::uint32_t frame_duration = 10;
+  const std::uint32_t tick_count = 100;
+
+  for (std::size_t car_count : { 16, 256 })
+  {
+    std::mt19937 random_engine(1234);
+    std::uniform_real_distribution<float> position_dist(0.0f, 4096.0f);
+    std::uniform_real_distribution<float> unit_dist(0.0f, 1.0f);
+
+    scene::ParticleEmitters emitters;
+    for (std::size_t wheel = 0; wheel != car_count * 4; ++wheel)
+    {
+      auto level = static_cast<std::uint32_t>(wheel / 4 % level_count);
+      emitters.push_back({ position_dist(random_engine), position_dist(random_engine) }, level,
+                         50.0f + unit_dist(random_engine) * 200.0f, unit_dist(random_engine),
+                         unit_dist(random_engine) < 0.5f ? 0.0f : unit_dist(random_engine),
+                         { 120, 100, 80, 255 });
+    }
+
+    for (std::uint32_t max_particles : { 1024, 16384 })
+    {
+      scene::ParticleSettings settings;
+      settings.max_particles = max_particles;
+
+      scene::ParticleGenerator particle_generator(level_count, settings);
+
+      // Fill the rings up to their steady state before measuring.
+      for (std::uint32_t tick = 0; tick * frame_duration < settings.display_time; ++tick)
+      {
+        particle_generator.update(frame_duration, emitters);
+      }
+
+      auto case_name = std::to_string(car_count) + "_cars/" + std::to_string(max_particles) + "_max_particles";
+      benchmark.measure(case_name, [&]()
+      {
+        for (std::uint32_t tick = 0; tick != tick_count; ++tick)
+        {
+          particle_generator.update(frame_duration, emitters);
+        }
+      });
+
+      std::size_t live_particles = 0;
+      for (std::uint32_t level = 0; level != level_count; ++level)
+      {
+        live_particles += particle_generator.spawn_ring(level).size();
+      }
+
+      benchmark.report(case_name + "/live_particles", static_cast<double>(live_particles));
+
+      const auto& measurement = benchmark.measurements().back();
+      if (measurement.median > 0.0)
+      {
+        benchmark.report(case_name + "/microseconds_per_tick", measurement.median * 1000.0 / tick_count);
+      }
+    }
+  }
+}
@@ -0,0 +1,175 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "benchmark.hpp"
+
+#include "scene/path_flattening.hpp"
+#include "scene/path_geometry.hpp"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace ts;
+
+namespace
+{
+  // A closed, wavy loop, so that every curve needs a few subdivisions.
+  resources::TrackPath make_loop_path(std::size_t node_count)
+  {
+    resources::SubPath sub_path;
+    sub_path.closed = true;
+
+    const float pi = 3.14159265f;
+    for (std::size_t index = 0; index != node_count; ++index)
+    {
+      auto angle = static_cast<float>(index) * 2.0f * pi / node_count;
+      auto radius = 2000.0f + (index % 2 == 0 ? 40.0f : -40.0f);
+      auto direction = make_vector2(std::cos(angle), std::sin(angle));
+      auto tangent = make_vector2(-direction.y, direction.x) * 10.0f;
+
+      resources::TrackPathNode node;
+      node.position = direction * radius + make_vector2(2500.0f, 2500.0f);
+      node.first_control = node.position - tangent;
+      node.second_control = node.position + tangent;
+      node.width = 16.0f + static_cast<float>(index % 5);
+      sub_path.nodes.push_back(node);
+    }
+
+    resources::TrackPath path;
+    path.sub_paths.push_back(sub_path);
+    return path;
+  }
+}
+
+// Rebuilds the geometry of a long path the way the editor does while a node is being dragged:
+// once from scratch, and once with the outlines of the unaffected curves taken from the cache.
+TS_BENCHMARK("path_geometry")
+{
+  const std::size_t node_count = 500;
+  const std::size_t drag_steps = 20;
+
+  auto path = make_loop_path(node_count);
+
+  resources::PathStyle path_style;
+  path_style.width = 8.0f;
+
+  std::vector<scene::PathVertex> vertices;
+  std::vector<scene::PathFace> faces;
+  float max_width = 0.0f;
+
+  auto case_prefix = std::to_string(node_count) + "_nodes/";
+  auto& dragged_node = path.sub_paths.front().nodes[node_count / 2];
+  auto original_node = dragged_node;
+
+  auto drag = [&](std::size_t step)
+  {
+    auto offset = make_vector2(static_cast<float>(step), static_cast<float>(step) * 0.5f);
+    dragged_node.position = original_node.position + offset;
+    dragged_node.first_control = original_node.first_control + offset;
+    dragged_node.second_control = original_node.second_control + offset;
+  };
+
+  auto report_step_time = [&](const std::string& case_name)
+  {
+    const auto& measurement = benchmark.measurements().back();
+    if (measurement.median > 0.0)
+    {
+      benchmark.report(case_name + "/microseconds_per_drag_step", measurement.median * 1000.0 / drag_steps);
+    }
+  };
+
+  benchmark.measure(case_prefix + "full_rebuild", [&]()
+  {
+    for (std::size_t step = 0; step != drag_steps; ++step)
+    {
+      drag(step);
+      scene::create_path_geometry(path, path_style, 0.1f, max_width, vertices, faces);
+    }
+  });
+
+  report_step_time(case_prefix + "full_rebuild");
+
+  scene::OutlineCache outline_cache;
+  scene::create_path_geometry(path, path_style, 0.1f, max_width, vertices, faces, &outline_cache);
+
+  benchmark.measure(case_prefix + "cached_rebuild", [&]()
+  {
+    for (std::size_t step = 0; step != drag_steps; ++step)
+    {
+      drag(step);
+      scene::create_path_geometry(path, path_style, 0.1f, max_width, vertices, faces, &outline_cache);
+    }
+  });
+
+  report_step_time(case_prefix + "cached_rebuild");
+  benchmark.report(case_prefix + "cached_rebuild/tessellated_curves_per_drag_step",
+                   static_cast<double>(outline_cache.miss_count()));
+  benchmark.report(case_prefix + "vertex_count", static_cast<double>(vertices.size()));
+}
+
+// Flattens both sides of many long sub-paths, the recursive way and the uniform way,
+// and reports how many curves per second each of them gets through.
+TS_BENCHMARK("path_flattening")
+{
+  const std::size_t node_count = 500;
+  const std::size_t sub_path_count = 32;
+
+  auto path = make_loop_path(node_count);
+  path.sub_paths.resize(sub_path_count, path.sub_paths.front());
+
+  scene::OutlineProperties properties;
+  properties.width = 8.0f;
+  properties.tolerance = 0.1f;
+
+  std::vector<scene::FlattenRequest> requests;
+  for (const auto& sub_path : path.sub_paths)
+  {
+    requests.push_back({ &sub_path, properties });
+    requests.push_back({ &sub_path, invert(properties) });
+  }
+
+  auto curve_count = static_cast<double>(node_count * requests.size());
+  auto case_prefix = std::to_string(requests.size()) + "_outlines/";
+
+  auto report_throughput = [&](const std::string& case_name, std::size_t point_count)
+  {
+    const auto& measurement = benchmark.measurements().back();
+    if (measurement.median > 0.0)
+    {
+      benchmark.report(case_name + "/curves_per_second", curve_count * 1000.0 / measurement.median);
+    }
+
+    benchmark.report(case_name + "/point_count", static_cast<double>(point_count));
+  };
+
+  std::vector<scene::OutlinePoint> outline_points;
+  benchmark.measure(case_prefix + "recursive", [&]()
+  {
+    outline_points.clear();
+    for (const auto& request : requests)
+    {
+      scene::generate_path_segment_outline(*request.sub_path, request.properties, outline_points);
+    }
+  });
+
+  report_throughput(case_prefix + "recursive", outline_points.size());
+
+  scene::PathFlattener flattener;
+  benchmark.measure(case_prefix + "uniform", [&]()
+  {
+    flattener.flatten(requests.data(), requests.size(), 1);
+  });
+
+  report_throughput(case_prefix + "uniform", flattener.outline_points().size());
+
+  benchmark.measure(case_prefix + "uniform_parallel", [&]()
+  {
+    flattener.flatten(requests.data(), requests.size());
+  });
+
+  report_throughput(case_prefix + "uniform_parallel", flattener.outline_points().size());
+}
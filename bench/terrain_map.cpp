@@ -0,0 +1,74 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "benchmark.hpp"
+
+#include "resources/track_loader.hpp"
+#include "resources/track.hpp"
+
+#include "world/terrain_map.hpp"
+#include "world/terrain_map_builder.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace ts;
+
+// Loads the test tracks, builds their terrain maps, and looks up the terrain at random points
+// of the track, which is what the world does for every wheel of every car.
+TS_BENCHMARK("terrain_map")
+{
+  const std::size_t query_count = 100000;
+
+  for (const char* track_name : { "test", "banaring" })
+  {
+    auto track_path = std::string("assets/tracks/") + track_name + ".trk";
+    auto case_prefix = std::string(track_name) + "/";
+
+    benchmark.measure(case_prefix + "track_load", [&]()
+    {
+      resources::TrackLoader track_loader;
+      track_loader.load_from_file(track_path);
+    });
+
+    resources::TrackLoader track_loader;
+    track_loader.load_from_file(track_path);
+    auto track = track_loader.get_result();
+
+    benchmark.measure(case_prefix + "terrain_map_build", [&]()
+    {
+      world::build_terrain_map(track);
+    });
+
+    auto terrain_map = world::build_terrain_map(track);
+
+    std::mt19937 random_engine(1234);
+    std::uniform_int_distribution<std::int32_t> x_dist(0, track.size().x - 1), y_dist(0, track.size().y - 1);
+
+    // All at ground level, where the cars spend nearly all of their time.
+    std::vector<Vector2i> queries(query_count);
+    for (auto& query : queries)
+    {
+      query = { x_dist(random_engine), y_dist(random_engine) };
+    }
+
+    const auto& terrain_lib = track.terrain_library();
+    benchmark.measure(case_prefix + "terrain_at", [&]()
+    {
+      for (const auto& query : queries)
+      {
+        terrain_map.terrain_at(query, 0, terrain_lib);
+      }
+    });
+
+    const auto& measurement = benchmark.measurements().back();
+    if (measurement.median > 0.0)
+    {
+      benchmark.report(case_prefix + "terrain_at/nanoseconds_per_query", measurement.median * 1e6 / query_count);
+    }
+  }
+}
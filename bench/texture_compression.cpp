@@ -0,0 +1,99 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "benchmark.hpp"
+
+#include "graphics/texture_compression.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+
+using namespace ts;
+
+namespace
+{
+  // Smooth gradients with some noise on top, and an alpha channel that is either fully
+  // opaque or has soft edges, which is roughly what the track atlases look like.
+  gli::texture2d make_test_texture(std::uint32_t size, bool opaque)
+  {
+    gli::texture2d texture(gli::FORMAT_RGBA8_UNORM_PACK8, gli::extent2d(size, size), 1);
+    auto* pixels = static_cast<std::uint8_t*>(texture.data());
+
+    std::mt19937 random_engine(1234);
+    std::uniform_int_distribution<int> noise_dist(-12, 12);
+    auto clamp = [](int value) { return static_cast<std::uint8_t>(std::min(std::max(value, 0), 255)); };
+
+    for (std::uint32_t y = 0; y != size; ++y)
+    {
+      for (std::uint32_t x = 0; x != size; ++x)
+      {
+        auto* p = pixels + (y * size + x) * 4;
+        p[0] = clamp(static_cast<int>(x * 255 / size) + noise_dist(random_engine));
+        p[1] = clamp(static_cast<int>(y * 255 / size) + noise_dist(random_engine));
+        p[2] = clamp(static_cast<int>(128 + 100 * std::sin((x + y) * 0.05)) + noise_dist(random_engine));
+        p[3] = opaque ? 255 : clamp(static_cast<int>(255 * (0.5 + 0.5 * std::sin(x * 0.02) * std::cos(y * 0.03))));
+      }
+    }
+
+    return texture;
+  }
+
+  double peak_signal_to_noise_ratio(const gli::texture2d& a, const gli::texture2d& b)
+  {
+    const auto* pixels_a = static_cast<const std::uint8_t*>(a.data());
+    const auto* pixels_b = static_cast<const std::uint8_t*>(b.data());
+
+    double squared_error = 0.0;
+    for (std::size_t index = 0; index != a.size(); ++index)
+    {
+      double difference = static_cast<double>(pixels_a[index]) - pixels_b[index];
+      squared_error += difference * difference;
+    }
+
+    auto mean_squared_error = squared_error / a.size();
+    if (mean_squared_error == 0.0) return 100.0;
+
+    return 10.0 * std::log10(255.0 * 255.0 / mean_squared_error);
+  }
+}
+
+// Encodes an atlas-sized texture to BC1 and BC3, on a single thread and on all of them.
+TS_BENCHMARK("texture_compression")
+{
+  const std::uint32_t texture_size = 2048;
+  const auto megapixels = texture_size * texture_size / 1000000.0;
+
+  for (auto format : { graphics::BlockFormat::BC1, graphics::BlockFormat::BC3 })
+  {
+    auto source = make_test_texture(texture_size, format == graphics::BlockFormat::BC1);
+    std::string format_name = format == graphics::BlockFormat::BC1 ? "bc1" : "bc3";
+
+    gli::texture2d compressed;
+    for (std::size_t thread_count : { std::size_t(1), utility::default_thread_count() })
+    {
+      // On a single core, both cases are the same.
+      if (thread_count == 1 && compressed.size() != 0) continue;
+
+      auto case_name = format_name + "/" + std::to_string(thread_count) + "_threads";
+      benchmark.measure(case_name, [&]()
+      {
+        compressed = graphics::compress_texture(source, format, thread_count);
+      });
+
+      const auto& measurement = benchmark.measurements().back();
+      if (measurement.median > 0.0)
+      {
+        benchmark.report(case_name + "/megapixels_per_second", megapixels * 1000.0 / measurement.median);
+      }
+    }
+
+    benchmark.report(format_name + "/compression_ratio", static_cast<double>(source.size()) / compressed.size());
+    benchmark.report(format_name + "/psnr", peak_signal_to_noise_ratio(source, graphics::decompress_texture(compressed)));
+  }
+}
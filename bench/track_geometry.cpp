@@ -0,0 +1,82 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "benchmark.hpp"
+
+#include "resources/track_loader.hpp"
+#include "resources/track.hpp"
+#include "resources/tile_library.hpp"
+
+#include "scene/track_vertices.hpp"
+#include "scene/texture_mapping.hpp"
+
+#include "graphics/texture.hpp"
+
+#include <string>
+
+using namespace ts;
+
+namespace
+{
+  // Maps every tile of the track to a texture object without a GL texture behind it.
+  // Only the size of the texture is used by the geometry generation.
+  scene::TextureMapping make_headless_texture_mapping(const resources::Track& track,
+                                                      const graphics::Texture* texture)
+  {
+    scene::TextureMapping texture_mapping;
+    {
+      auto mapping_interface = texture_mapping.create_mapping_interface();
+      for (const auto& tile_def : track.tile_library().tiles())
+      {
+        mapping_interface.map_texture(scene::TextureMapping::tile_id(tile_def.id), texture, tile_def.image_rect);
+      }
+    }
+
+    return texture_mapping;
+  }
+}
+
+// Generates the tile geometry of the test tracks, the CPU-side part of building a track scene,
+// both serially and with one thread per layer.
+TS_BENCHMARK("track_geometry")
+{
+  graphics::Texture texture(0, { 2048, 2048 });
+
+  for (const char* track_name : { "test", "banaring" })
+  {
+    resources::TrackLoader track_loader;
+    track_loader.load_from_file(std::string("assets/tracks/") + track_name + ".trk");
+    auto track = track_loader.get_result();
+
+    auto texture_mapping = make_headless_texture_mapping(track, &texture);
+
+    std::size_t vertex_count = 0;
+    for (const auto& geometry : scene::generate_tile_geometry(track, texture_mapping, 1))
+    {
+      vertex_count += geometry.vertices.size();
+    }
+
+    benchmark.report(std::string(track_name) + "/vertex_count", static_cast<double>(vertex_count));
+
+    auto run_case = [&](const char* case_name, std::size_t thread_count)
+    {
+      auto full_case_name = std::string(track_name) + "/" + case_name;
+      benchmark.measure(full_case_name, [&]()
+      {
+        scene::generate_tile_geometry(track, texture_mapping, thread_count);
+      });
+
+      const auto& measurement = benchmark.measurements().back();
+      if (measurement.median > 0.0)
+      {
+        benchmark.report(full_case_name + "/vertices_per_second", vertex_count * 1000.0 / measurement.median);
+      }
+    };
+
+    run_case("serial", 1);
+    run_case("parallel", utility::default_thread_count());
+  }
+}
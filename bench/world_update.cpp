@@ -0,0 +1,114 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "benchmark.hpp"
+
+#include "world/world.hpp"
+#include "world/car.hpp"
+#include "world/terrain_map_builder.hpp"
+#include "world/world_event_interface.hpp"
+
+#include "resources/track_loader.hpp"
+#include "resources/track.hpp"
+#include "resources/car_definition.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace ts;
+
+namespace
+{
+  // Start points on a grid over the whole track, because the track's own start grid
+  // only has room for 20 cars.
+  void add_grid_start_points(resources::Track& track, std::size_t car_count)
+  {
+    const std::int32_t spacing = 48;
+    auto track_size = track.size();
+    auto column_count = std::max((track_size.x - spacing) / spacing, 1);
+
+    for (std::size_t index = 0; index != car_count; ++index)
+    {
+      auto column = static_cast<std::int32_t>(index) % column_count;
+      auto row = static_cast<std::int32_t>(index) / column_count;
+
+      resources::StartPoint point;
+      point.position = { spacing + column * spacing, std::min(spacing + row * spacing, track_size.y - 1) };
+      point.rotation = static_cast<std::int32_t>(index * 37 % 360);
+      track.add_start_point(point);
+    }
+  }
+}
+
+// Full world ticks on the test track with a growing number of cars, all of them on the throttle.
+// This includes the handling, the terrain lookups, the physics step and the car collisions.
+TS_BENCHMARK("world_update")
+{
+  const std::size_t tick_count = 50;
+  const std::uint32_t frame_duration = 20;
+
+  resources::TrackLoader track_loader;
+  track_loader.load_from_file("assets/tracks/test.trk");
+  auto base_track = track_loader.get_result();
+
+  resources::CarDefinition car_definition;
+  car_definition.image_rect = IntRect(0, 0, 48, 24);
+  car_definition.handling.gear_ratios = { 3.0, 2.2, 1.7, 1.35, 1.1 };
+  car_definition.handling.max_acceleration_force = 60000.0;
+  car_definition.handling.max_braking_force = 30000.0;
+
+  world::EventInterface event_interface;
+  for (std::size_t car_count : { 8, 64, 256 })
+  {
+    auto track = base_track;
+    add_grid_start_points(track, car_count);
+
+    auto terrain_map = world::build_terrain_map(track);
+    world::World world(std::move(track), std::move(terrain_map));
+
+    std::vector<world::Car*> cars;
+    for (std::size_t index = 0; index != car_count; ++index)
+    {
+      auto car = world.create_car(car_definition, static_cast<std::uint8_t>(index), static_cast<std::uint16_t>(index));
+      if (!car) throw std::runtime_error("could not place car " + std::to_string(index));
+
+      car->set_control_state(controls::Control::Throttle, true);
+      car->set_control_state(controls::Control::Left, index % 3 == 0);
+      cars.push_back(car);
+    }
+
+    // Every iteration starts from the grid, so that all of them do the same work.
+    const auto& start_points = world.track().start_points();
+    auto reset_cars = [&]()
+    {
+      for (std::size_t index = 0; index != car_count; ++index)
+      {
+        cars[index]->set_position(vector2_cast<double>(start_points[index].position));
+        cars[index]->set_velocity({ 0.0, 0.0 });
+        cars[index]->set_rotation(degrees(static_cast<double>(start_points[index].rotation)));
+        cars[index]->set_angular_velocity(0.0);
+      }
+    };
+
+    auto case_name = std::to_string(car_count) + "_cars";
+    benchmark.measure(case_name, [&]()
+    {
+      reset_cars();
+      for (std::size_t tick = 0; tick != tick_count; ++tick)
+      {
+        world.update(frame_duration, event_interface);
+      }
+    });
+
+    const auto& measurement = benchmark.measurements().back();
+    if (measurement.median > 0.0)
+    {
+      benchmark.report(case_name + "/microseconds_per_tick", measurement.median * 1000.0 / tick_count);
+    }
+  }
+}
@@ -10,6 +10,8 @@
 #include "stage/race_messages.hpp"
 #include "world/world_messages.hpp"
 
+#include "utility/stats.hpp"
+
 namespace ts
 {
   namespace client
@@ -31,6 +33,9 @@ namespace ts
     template <typename MessageType>
     void MessageConveyor::process_internal(const MessageType& message) const
     {
+      static const stats::Counter messages("client.messages_dispatched");
+      messages.add();
+
       process_helper(action_state_, message, 0);
     }
 
@@ -6,11 +6,17 @@
 
 #pragma once
 
+#include <cstdint>
+
 namespace ts
 {
   namespace config
   {
     extern const char* const data_directory;
     extern const char* const audio_directory;
+    extern const char* const cache_directory;
+
+    // In bytes.
+    extern const std::uintmax_t cache_size_limit;
   }
 }
@@ -22,6 +22,20 @@
 #define TS_AUDIO_DIRECTORY "sound"
 #endif
 
+#ifndef TS_CACHE_DIRECTORY
+#define TS_CACHE_DIRECTORY "cache"
+#endif
+
+#ifndef TS_CACHE_SIZE_LIMIT
+#define TS_CACHE_SIZE_LIMIT (512 * 1024 * 1024)
+#endif
+
 // The data directory is where the game looks for default track assets.
 const char* const ts::config::data_directory = TS_DATA_DIRECTORY;
 const char* const ts::config::audio_directory = TS_AUDIO_DIRECTORY;
+
+// The cache directory holds generated data that can safely be deleted, like texture atlases.
+const char* const ts::config::cache_directory = TS_CACHE_DIRECTORY;
+
+// When the cache directory grows past this size, the least recently used files are removed.
+const std::uintmax_t ts::config::cache_size_limit = TS_CACHE_SIZE_LIMIT;
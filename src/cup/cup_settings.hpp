@@ -11,6 +11,9 @@
 #include "resources/track_reference.hpp"
 #include "resources/car_definition.hpp"
 
+#include "world/sub_stepping.hpp"
+#include "world/physics_mode.hpp"
+
 #include <vector>
 
 namespace ts
@@ -23,6 +26,10 @@ namespace ts
       std::vector<resources::CarDefinition> selected_cars;
       CarMode car_mode = CarMode::Free;
       std::size_t max_players = 20;
+
+      // Sub-stepping is off unless max_sub_steps is raised, see SubStepConfig.
+      world::SubStepConfig sub_step_config;
+      world::PhysicsMode physics_mode = world::PhysicsMode::Chipmunk;
     };
   }
 }
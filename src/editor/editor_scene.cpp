@@ -23,7 +23,7 @@ namespace ts
 
     EditorScene::EditorScene(resources::Track track)
       : track_(std::move(track)),
-      render_scene_(scene::generate_track_scene(track_, true))
+      render_scene_(scene::generate_track_scene(track_, true, false))
     {
       render_scene_->set_background_color(editor_bg_color);
     }
@@ -75,12 +75,25 @@ namespace ts
 
     void EditorState::async_load_track(const std::string& file_name)
     {
-      loading_future_ = context().loading_thread->async_task([=]()
+      auto& loading_thread = *context().loading_thread;
+      auto track_task = loading_thread.schedule([=]()
       {
         resources::TrackLoader track_loader;
         track_loader.load_from_file(file_name);
-        return std::make_unique<EditorScene>(track_loader.get_result());
+        return track_loader.get_result();
       });
+
+      // Parsing the track doesn't need the GL context, but creating the scene does.
+      game::TaskOptions scene_options;
+      scene_options.affinity = game::TaskAffinity::GLContext;
+
+      auto scene_task = loading_thread.schedule_continuation(std::move(track_task),
+                                                             [](std::future<resources::Track> track)
+      {
+        return std::make_unique<EditorScene>(track.get());
+      }, scene_options);
+
+      loading_future_ = std::move(scene_task.future());
     }
 
     void EditorState::async_load_test_state()
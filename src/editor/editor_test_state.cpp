@@ -54,6 +54,9 @@ namespace ts
       const auto& player_settings = settings.player_settings();
 
       stage::StageDescription stage_description;
+      stage_description.sub_step_config = cup_settings.sub_step_config;
+      stage_description.physics_mode = cup_settings.physics_mode;
+
       if (!cup_settings.selected_cars.empty())
       {
         stage_description.car_models.push_back(cup_settings.selected_cars.front());
@@ -143,6 +146,16 @@ namespace ts
           }
         }
       }
+
+      else if (e.type == e.KeyPressed && e.key.code == sf::Keyboard::F5)
+      {
+        // Switch between chipmunk and fixed-point physics, without restarting the test drive.
+        world::messages::PhysicsModeChange mode_change;
+        mode_change.mode = scene_obj().stage().world().physics_mode() == world::PhysicsMode::FixedPoint ?
+          world::PhysicsMode::Chipmunk : world::PhysicsMode::FixedPoint;
+
+        dispatch_message(mode_change);
+      }
     }
 
     void TestState::update(const update_context& u)
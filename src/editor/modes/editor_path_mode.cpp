@@ -9,6 +9,8 @@
 #include "editor/editor_context.hpp"
 #include "editor/editor_state.hpp"
 
+#include "scene/path_flattening.hpp"
+
 #include "utility/interpolate.hpp"
 
 #include "imgui/imgui.h"
@@ -794,24 +796,32 @@ namespace ts
       path_outline_partitions_.clear();
 
       path_outline_width_ = static_cast<std::uint32_t>(p.style.width);
-      std::size_t sub_path_id = 0;
+
+      scene::OutlineProperties props;
+      props.width = p.style.width;
+      props.tolerance = 1.0f;
+
+      // Both sides of every sub-path, flattened all at once.
+      std::vector<scene::FlattenRequest> requests;
       for (const auto& sub_path : p.path->sub_paths)
       {
-        scene::OutlineProperties props;
-        props.width = p.style.width;
-        props.tolerance = 1.0f;        
+        requests.push_back({ &sub_path, props });
+        requests.push_back({ &sub_path, invert(props) });
+      }
 
-        path_outline_partitions_.push_back({ sub_path_id, path_outline_cache_.size(), false });
-        scene::generate_path_segment_outline(sub_path, props, path_outline_cache_);
+      scene::PathFlattener flattener;
+      flattener.flatten(requests.data(), requests.size());
 
-        path_outline_partitions_.push_back({ sub_path_id, path_outline_cache_.size(), true });
-        scene::generate_path_segment_outline(sub_path, invert(props), path_outline_cache_);
+      const auto& outline_points = flattener.outline_points();
+      path_outline_cache_.assign(outline_points.begin(), outline_points.end());
 
-        ++sub_path_id;
+      for (std::size_t index = 0; index != requests.size(); ++index)
+      {
+        path_outline_partitions_.push_back({ index / 2, flattener.point_offset(index), index % 2 != 0 });
       }
 
       // Add sentinel thing
-      path_outline_partitions_.push_back({ sub_path_id, path_outline_cache_.size() });
+      path_outline_partitions_.push_back({ p.path->sub_paths.size(), path_outline_cache_.size() });
     }
   }
 }
\ No newline at end of file
@@ -9,53 +9,192 @@
 
 #include "graphics/gl_context.hpp"
 
+#include "utility/profiler.hpp"
+
+#include <algorithm>
+
 #include <GL/glew.h>
 
 namespace ts
 {
   namespace game
   {
-    LoadingThread::LoadingThread()
-      : worker_thread_([this]() { worker_function(); })
+    CancellationToken::CancellationToken()
+      : cancelled_(std::make_shared<std::atomic<bool>>(false))
+    {
+    }
+
+    void CancellationToken::cancel() const
+    {
+      *cancelled_ = true;
+    }
+
+    bool CancellationToken::is_cancelled() const
+    {
+      return *cancelled_;
+    }
+
+    TaskCancelled::TaskCancelled()
+      : std::runtime_error("task cancelled")
     {
     }
 
+    bool LoadingThread::TaskQueue::empty() const
+    {
+      return std::all_of(tasks.begin(), tasks.end(), [](const auto& queue) { return queue.empty(); });
+    }
+
+    void LoadingThread::TaskQueue::push(std::shared_ptr<LoadingTaskBase> task)
+    {
+      auto priority = static_cast<std::size_t>(task->options.priority);
+      tasks[priority].push_back(std::move(task));
+    }
+
+    std::shared_ptr<LoadingTaskBase> LoadingThread::TaskQueue::pop()
+    {
+      for (auto it = tasks.rbegin(); it != tasks.rend(); ++it)
+      {
+        if (!it->empty())
+        {
+          auto task = std::move(it->front());
+          it->pop_front();
+          return task;
+        }
+      }
+
+      return nullptr;
+    }
+
+    std::size_t LoadingThread::default_worker_count()
+    {
+      return std::max(std::thread::hardware_concurrency(), 2U) - 1;
+    }
+
+    LoadingThread::LoadingThread(std::size_t worker_count)
+      : gl_thread_([this]() { worker_function(TaskAffinity::GLContext); })
+    {
+      for (std::size_t i = 0; i < std::max<std::size_t>(worker_count, 1); ++i)
+      {
+        worker_threads_.emplace_back([this]() { worker_function(TaskAffinity::Worker); });
+      }
+    }
+
     LoadingThread::~LoadingThread()
     {
-      is_finished_ = true;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        is_finished_ = true;
+      }
+
+      worker_cv_.notify_all();
+      gl_cv_.notify_all();
 
-      cv_.notify_one();
-      worker_thread_.join();
+      gl_thread_.join();
+      for (auto& thread : worker_threads_)
+      {
+        thread.join();
+      }
     }
 
-    void LoadingThread::worker_function()
+    std::size_t LoadingThread::worker_count() const
     {
-      auto context = graphics::create_gl_context();
-      graphics::activate_gl_context(context);
+      return worker_threads_.size();
+    }
 
-      while (!is_finished_)
+    void LoadingThread::enqueue(std::shared_ptr<LoadingTaskBase> task)
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      enqueue_locked(std::move(task));
+    }
+
+    void LoadingThread::enqueue_locked(std::shared_ptr<LoadingTaskBase> task)
+    {
+      if (task->options.affinity == TaskAffinity::GLContext)
+      {
+        gl_queue_.push(std::move(task));
+        gl_cv_.notify_one();
+      }
+
+      else
+      {
+        worker_queue_.push(std::move(task));
+        worker_cv_.notify_one();
+      }
+    }
+
+    void LoadingThread::attach_continuation(const std::shared_ptr<LoadingTaskBase>& antecedent,
+                                            std::shared_ptr<LoadingTaskBase> continuation)
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (!antecedent || antecedent->is_finished)
+      {
+        enqueue_locked(std::move(continuation));
+      }
+
+      else
+      {
+        antecedent->continuations.push_back(std::move(continuation));
+      }
+    }
+
+    void LoadingThread::complete_task(LoadingTaskBase& task)
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      task.is_finished = true;
+
+      for (auto& continuation : task.continuations)
+      {
+        enqueue_locked(std::move(continuation));
+      }
+
+      task.continuations.clear();
+    }
+
+    void LoadingThread::worker_function(TaskAffinity affinity)
+    {
+      // Only the GL thread needs a context of its own.
+      graphics::GLContextHandle context;
+      if (affinity == TaskAffinity::GLContext)
+      {
+        TS_PROFILE_THREAD("loading: gl");
+
+        context = graphics::create_gl_context();
+        graphics::activate_gl_context(context);
+      }
+
+      else
+      {
+        TS_PROFILE_THREAD("loading: worker");
+      }
+
+      auto& queue = affinity == TaskAffinity::GLContext ? gl_queue_ : worker_queue_;
+      auto& cv = affinity == TaskAffinity::GLContext ? gl_cv_ : worker_cv_;
+
+      while (true)
       {
+        std::shared_ptr<LoadingTaskBase> task;
+
         {
           std::unique_lock<std::mutex> lock(mutex_);
-          cv_.wait(lock, [this]() { return is_finished_ || task_count_ != 0; });
+          cv.wait(lock, [&]() { return is_finished_ || !queue.empty(); });
+
+          if (is_finished_) break;
+          task = queue.pop();
         }
 
-        while (task_count_ != 0)
+        if (task->options.cancellation.is_cancelled())
         {
-          auto pop_task = [this]()
-          {
-            std::unique_lock<std::mutex> lock(mutex_);
-            auto task = std::move(task_list_.front());
-            task_list_.pop_front();
-            return task;
-          };
-
-          auto task = pop_task();
-          (*task)();
+          task->cancel();
+        }
 
-          --task_count_;
+        else
+        {
+          TS_PROFILE_ZONE("LoadingThread task");
+          (*task)();
         }
+
+        complete_task(*task);
       }
     }
   }
-}
\ No newline at end of file
+}
@@ -12,58 +12,174 @@
 #include <condition_variable>
 #include <atomic>
 #include <deque>
+#include <array>
+#include <vector>
+#include <memory>
+#include <stdexcept>
 
 namespace ts
 {
   namespace game
   {
+    enum class TaskPriority
+    {
+      Low,
+      Normal,
+      High
+    };
+
+    enum class TaskAffinity
+    {
+      Worker, // Any of the CPU worker threads.
+      GLContext // The thread that owns the shared OpenGL context.
+    };
+
+    // Cancellation is cooperative: a cancelled task that has not been started yet is skipped,
+    // and a running task may poll is_cancelled() to bail out early. All copies of a token
+    // share the same state, so one token can be used to cancel a whole chain of tasks.
+    class CancellationToken
+    {
+    public:
+      CancellationToken();
+
+      void cancel() const;
+      bool is_cancelled() const;
+
+    private:
+      std::shared_ptr<std::atomic<bool>> cancelled_;
+    };
+
+    // The exception that is stored in a cancelled task's future.
+    struct TaskCancelled
+      : std::runtime_error
+    {
+      TaskCancelled();
+    };
+
+    struct TaskOptions
+    {
+      TaskPriority priority = TaskPriority::Normal;
+      TaskAffinity affinity = TaskAffinity::Worker;
+      CancellationToken cancellation;
+    };
+
     struct LoadingTaskBase
     {
       virtual ~LoadingTaskBase() = default;
 
       virtual void operator()() = 0;
+      virtual void cancel() = 0;
+
+      TaskOptions options;
+
+      // Both of these are protected by the loading thread's mutex.
+      bool is_finished = false;
+      std::vector<std::shared_ptr<LoadingTaskBase>> continuations;
     };
 
     template <typename FuncType>
     struct LoadingTaskModel
       : LoadingTaskBase
     {
-      using result_type = decltype(std::declval<FuncType>()());
+      using result_type = decltype(std::declval<FuncType&>()());
 
       explicit LoadingTaskModel(FuncType&& func);
 
       virtual void operator()() override;
+      virtual void cancel() override;
       
       std::promise<result_type> promise_;
       FuncType func_;
     };
 
-    // The LoadingThread wraps a single thread that can be used to execute various tasks
-    // asynchronously. This worker thread has an internal OpenGL context that can be
-    // shared with other threads' GL contexts.
+    class LoadingThread;
+
+    // A handle to a scheduled task, which provides access to the task's future,
+    // and allows the task to be cancelled.
+    template <typename ResultType>
+    class TaskHandle
+    {
+    public:
+      TaskHandle() = default;
+
+      bool valid() const;
+      bool is_ready() const;
+      ResultType get();
+
+      std::future<ResultType>& future();
+
+      void cancel() const;
+      const CancellationToken& cancellation_token() const;
+
+    private:
+      friend LoadingThread;
+
+      TaskHandle(std::shared_ptr<LoadingTaskBase> task, std::future<ResultType> future);
+
+      std::shared_ptr<LoadingTaskBase> task_;
+      std::future<ResultType> future_;
+    };
+
+    // The LoadingThread manages a number of CPU worker threads, plus one thread that has an
+    // internal OpenGL context that can be shared with other threads' GL contexts. CPU-only work
+    // should go to the workers, so that it does not have to wait for GL uploads and vice versa.
     class LoadingThread
     {
     public:
-      explicit LoadingThread();
+      // By default, one worker is created per hardware thread, minus one for the main thread.
+      explicit LoadingThread(std::size_t worker_count = default_worker_count());
       ~LoadingThread();
 
       LoadingThread(LoadingThread&&) = default;
       LoadingThread& operator=(LoadingThread&&) = default;
 
-      // Execute a task asynchronously. Returns a std::future object.
+      // Execute a task asynchronously on the GL context thread. Returns a std::future object.
       template <typename FuncType>
       auto async_task(FuncType&& func);
 
+      // Execute a task with the given priority and affinity.
+      template <typename FuncType>
+      auto schedule(FuncType&& func, TaskOptions options = TaskOptions());
+
+      // Schedule a task that runs as soon as the antecedent task has finished, or has been cancelled.
+      // The continuation is invoked with the antecedent's future, which is ready at that point.
+      // The antecedent handle is consumed in the process.
+      template <typename ResultType, typename FuncType>
+      auto schedule_continuation(TaskHandle<ResultType>&& antecedent, FuncType&& func,
+                                 TaskOptions options = TaskOptions());
+
+      std::size_t worker_count() const;
+      static std::size_t default_worker_count();
+
     private:
-      void worker_function();
+      // Tasks are popped in order of priority, and in FIFO order within the same priority.
+      struct TaskQueue
+      {
+        bool empty() const;
+        void push(std::shared_ptr<LoadingTaskBase> task);
+        std::shared_ptr<LoadingTaskBase> pop();
+
+        std::array<std::deque<std::shared_ptr<LoadingTaskBase>>, 3> tasks;
+      };
+
+      void worker_function(TaskAffinity affinity);
+
+      void enqueue(std::shared_ptr<LoadingTaskBase> task);
+      void enqueue_locked(std::shared_ptr<LoadingTaskBase> task);
+      void attach_continuation(const std::shared_ptr<LoadingTaskBase>& antecedent,
+                               std::shared_ptr<LoadingTaskBase> continuation);
+      void complete_task(LoadingTaskBase& task);
 
-      std::thread worker_thread_;
       std::mutex mutex_;
-      std::condition_variable cv_;
-      std::atomic<bool> is_finished_ = false;
-      std::atomic<std::uint32_t> task_count_ = 0;
+      std::condition_variable worker_cv_;
+      std::condition_variable gl_cv_;
+      std::atomic<bool> is_finished_{ false };
+
+      TaskQueue worker_queue_;
+      TaskQueue gl_queue_;
 
-      std::deque<std::unique_ptr<LoadingTaskBase>> task_list_;
+      std::vector<std::thread> worker_threads_;
+      std::thread gl_thread_;
     };
   }
 }
@@ -12,6 +12,22 @@ namespace ts
 {
   namespace game
   {
+    namespace detail
+    {
+      template <typename ResultType, typename FuncType>
+      void fulfill_promise(std::promise<ResultType>& promise, FuncType& func)
+      {
+        promise.set_value(func());
+      }
+
+      template <typename FuncType>
+      void fulfill_promise(std::promise<void>& promise, FuncType& func)
+      {
+        func();
+        promise.set_value();
+      }
+    }
+
     template <typename FuncType>
     LoadingTaskModel<FuncType>::LoadingTaskModel(FuncType&& func)
       : func_(std::move(func))
@@ -22,9 +38,7 @@ namespace ts
     {
       try 
       {
-        auto result = func_();
-
-        promise_.set_value(std::move(result));
+        detail::fulfill_promise(promise_, func_);
       }        
 
       catch (...)
@@ -33,22 +47,100 @@ namespace ts
       }
     }
 
+    template <typename FuncType>
+    void LoadingTaskModel<FuncType>::cancel()
+    {
+      promise_.set_exception(std::make_exception_ptr(TaskCancelled()));
+    }
+
+    template <typename ResultType>
+    TaskHandle<ResultType>::TaskHandle(std::shared_ptr<LoadingTaskBase> task, std::future<ResultType> future)
+      : task_(std::move(task)),
+        future_(std::move(future))
+    {
+    }
+
+    template <typename ResultType>
+    bool TaskHandle<ResultType>::valid() const
+    {
+      return future_.valid();
+    }
+
+    template <typename ResultType>
+    bool TaskHandle<ResultType>::is_ready() const
+    {
+      return future_.valid() && future_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    template <typename ResultType>
+    ResultType TaskHandle<ResultType>::get()
+    {
+      return future_.get();
+    }
+
+    template <typename ResultType>
+    std::future<ResultType>& TaskHandle<ResultType>::future()
+    {
+      return future_;
+    }
+
+    template <typename ResultType>
+    void TaskHandle<ResultType>::cancel() const
+    {
+      if (task_) task_->options.cancellation.cancel();
+    }
+
+    template <typename ResultType>
+    const CancellationToken& TaskHandle<ResultType>::cancellation_token() const
+    {
+      return task_->options.cancellation;
+    }
+
     template <typename FuncType>
     auto LoadingThread::async_task(FuncType&& func)
+    {
+      TaskOptions options;
+      options.affinity = TaskAffinity::GLContext;
+
+      return std::move(schedule(std::forward<FuncType>(func), std::move(options)).future());
+    }
+
+    template <typename FuncType>
+    auto LoadingThread::schedule(FuncType&& func, TaskOptions options)
     {
       using func_type = std::remove_reference_t<FuncType>;
       using task_type = LoadingTaskModel<func_type>;
+      using result_type = typename task_type::result_type;
+
+      auto task = std::make_shared<task_type>(std::move(func));
+      task->options = std::move(options);
+
+      TaskHandle<result_type> handle(task, task->promise_.get_future());
+      enqueue(std::move(task));
+
+      return handle;
+    }
+
+    template <typename ResultType, typename FuncType>
+    auto LoadingThread::schedule_continuation(TaskHandle<ResultType>&& antecedent, FuncType&& func,
+                                              TaskOptions options)
+    {
+      auto antecedent_task = std::move(antecedent.task_);
+      auto continuation = [future = std::move(antecedent.future_), func = std::move(func)]() mutable
+      {
+        return func(std::move(future));
+      };
 
-      auto task = std::make_unique<task_type>(std::move(func));
-      auto future = task->promise_.get_future();
+      using task_type = LoadingTaskModel<decltype(continuation)>;
+      using result_type = typename task_type::result_type;
 
-      std::unique_lock<std::mutex> lock(mutex_);
-      task_list_.push_back(std::move(task));
-      ++task_count_;
+      auto task = std::make_shared<task_type>(std::move(continuation));
+      task->options = std::move(options);
 
-      cv_.notify_one();
+      TaskHandle<result_type> handle(task, task->promise_.get_future());
+      attach_continuation(antecedent_task, std::move(task));
 
-      return future;
+      return handle;
     }
   }
 }
@@ -12,6 +12,13 @@
 
 #include "imgui/imgui_sfml_opengl.hpp"
 
+#include "utility/profiler.hpp"
+#include "utility/stats.hpp"
+
+#if defined(TS_PROFILER)
+#include "profiler_window.hpp"
+#endif
+
 #include <chrono>
 
 namespace ts
@@ -44,8 +51,16 @@ namespace ts
 
       if (window) window->activate();     
 
+      TS_PROFILE_THREAD("main");
+
+#if defined(TS_PROFILER)
+      ProfilerWindow profiler_window;
+#endif
+
       while (state_machine)
       {
+        TS_PROFILE_ZONE("main_loop");
+
         auto time_point = high_resolution_clock::now();
 
         auto frame_time = (time_point - last_frame);
@@ -60,6 +75,8 @@ namespace ts
 
           if (window)
           {
+            TS_PROFILE_ZONE("process_events");
+
             for (sf::Event event; window->poll_event(event);)
             {
               if (event.type == sf::Event::Closed)
@@ -68,6 +85,14 @@ namespace ts
                 state_machine.clear();
               }
 
+#if defined(TS_PROFILER)
+              if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F11)
+              {
+                profiler_window.toggle();
+                continue;
+              }
+#endif
+
               bool process = window->has_focus();
 
               // Certain events should be processed regardless of whether the window has focus
@@ -89,13 +114,26 @@ namespace ts
               frame_accumulator -= frame_duration;
             }
 
+            // The counters of the previous update and everything that was rendered after it.
+            stats::merge_frame();
+
             if (gui_context) gui_context->new_frame(update_context.frame_duration);
+
+#if defined(TS_PROFILER)
+            // The window shows the zones up to the previous iteration, this one is still running.
+            profiler_window.update();
+            if (gui_context) profiler_window.show();
+#endif
+
+            TS_PROFILE_ZONE("update");
             state_machine->update(update_context);            
           }
         }
 
         if (window)
         {
+          TS_PROFILE_ZONE("render");
+
           game::RenderContext render_context;
           render_context.screen_size = window->size();
 
@@ -107,6 +145,7 @@ namespace ts
           if (state_machine) state_machine->render(render_context);
           if (gui_context) gui_context->render();  
 
+          TS_PROFILE_ZONE("display");
           window->display();
         }
       }
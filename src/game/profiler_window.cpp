@@ -0,0 +1,153 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "profiler_window.hpp"
+
+#include "imgui/imgui.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+
+namespace ts
+{
+  namespace game
+  {
+    namespace detail
+    {
+      // Zones with the same name get the same color, on every thread.
+      ImU32 zone_color(const char* name)
+      {
+        std::uint32_t hash = 2166136261U;
+        for (; *name; ++name)
+        {
+          hash = (hash ^ static_cast<std::uint8_t>(*name)) * 16777619U;
+        }
+
+        auto component = [=](int shift) { return 80 + static_cast<int>((hash >> shift) & 0x7F); };
+        return ImColor(component(0), component(8), component(16));
+      }
+    }
+
+    void ProfilerWindow::update()
+    {
+      if (is_open_ && !is_paused_)
+      {
+        collector_.collect();
+      }
+    }
+
+    void ProfilerWindow::toggle()
+    {
+      is_open_ = !is_open_;
+
+      // Start with a clean slate instead of the zones that piled up in the meantime.
+      if (is_open_)
+      {
+        collector_.collect();
+        collector_.clear();
+      }
+    }
+
+    bool ProfilerWindow::is_open() const
+    {
+      return is_open_;
+    }
+
+    void ProfilerWindow::show()
+    {
+      if (!is_open_) return;
+
+      ImGui::SetNextWindowSize(ImVec2(800.0f, 400.0f), ImGuiSetCond_FirstUseEver);
+      if (ImGui::Begin("Profiler", &is_open_))
+      {
+        ImGui::Checkbox("Pause", &is_paused_);
+        ImGui::SameLine();
+        ImGui::PushItemWidth(200.0f);
+        ImGui::SliderFloat("Range", &visible_duration_, 5.0f, 2000.0f, "%.0f ms", 2.0f);
+        ImGui::PopItemWidth();
+        ImGui::SameLine();
+        if (ImGui::Button("Export trace")) export_trace();
+
+        ImGui::Text("Dropped zones: %u", static_cast<unsigned>(collector_.dropped_count()));
+        if (!export_status_.empty())
+        {
+          ImGui::SameLine();
+          ImGui::TextUnformatted(export_status_.c_str());
+        }
+
+        ImGui::BeginChild("timeline", ImVec2(0.0f, 0.0f), true);
+        show_timeline();
+        ImGui::EndChild();
+      }
+
+      ImGui::End();
+    }
+
+    void ProfilerWindow::show_timeline()
+    {
+      const float lane_height = ImGui::GetTextLineHeight() + 4.0f;
+      const auto text_color = ImColor(255, 255, 255);
+
+      auto draw_list = ImGui::GetWindowDrawList();
+      auto canvas_pos = ImGui::GetCursorScreenPos();
+      auto width = std::max(ImGui::GetContentRegionAvailWidth(), 1.0f);
+
+      auto visible_duration = static_cast<std::uint64_t>(visible_duration_ * 1000000.0);
+      auto latest_time = collector_.latest_time();
+      auto origin = latest_time > visible_duration ? latest_time - visible_duration : 0;
+      auto scale = width / static_cast<float>(visible_duration);
+
+      ImGui::PushClipRect(canvas_pos, ImVec2(canvas_pos.x + width, canvas_pos.y + 100000.0f), true);
+
+      auto y = canvas_pos.y;
+      for (const auto& thread : collector_.threads())
+      {
+        draw_list->AddText(ImVec2(canvas_pos.x, y), text_color, thread.name.c_str());
+        y += lane_height;
+
+        std::uint32_t max_depth = 0;
+        for (const auto& zone : thread.zones)
+        {
+          if (zone.end < origin) continue;
+
+          max_depth = std::max(max_depth, zone.depth);
+
+          auto x0 = canvas_pos.x + static_cast<float>(zone.start > origin ? zone.start - origin : 0) * scale;
+          auto x1 = canvas_pos.x + static_cast<float>(zone.end - origin) * scale;
+          if (x1 - x0 < 1.0f) x1 = x0 + 1.0f;
+
+          ImVec2 zone_min(x0, y + zone.depth * lane_height);
+          ImVec2 zone_max(x1, zone_min.y + lane_height - 1.0f);
+          draw_list->AddRectFilled(zone_min, zone_max, detail::zone_color(zone.name));
+
+          if (x1 - x0 > ImGui::CalcTextSize(zone.name).x + 4.0f)
+          {
+            draw_list->AddText(ImVec2(x0 + 2.0f, zone_min.y + 2.0f), text_color, zone.name);
+          }
+
+          if (ImGui::IsMouseHoveringRect(zone_min, zone_max))
+          {
+            ImGui::SetTooltip("%s: %.3f ms", zone.name, (zone.end - zone.start) * 0.000001);
+          }
+        }
+
+        y += (max_depth + 1) * lane_height + 4.0f;
+      }
+
+      ImGui::PopClipRect();
+      ImGui::Dummy(ImVec2(width, y - canvas_pos.y));
+    }
+
+    void ProfilerWindow::export_trace()
+    {
+      std::ofstream stream(export_path_, std::ios::out | std::ios::trunc);
+      profiler::write_chrome_trace(stream, collector_);
+
+      export_status_ = stream ? "Saved to " + export_path_ : "Could not write " + export_path_;
+    }
+  }
+}
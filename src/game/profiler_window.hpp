@@ -0,0 +1,45 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include "utility/profiler.hpp"
+
+#include <string>
+
+namespace ts
+{
+  namespace game
+  {
+    // The ProfilerWindow shows the profiler's zones as a timeline, with one lane per thread
+    // and the nested zones stacked below their parents. The zones can be exported as a
+    // Chrome trace from there.
+    class ProfilerWindow
+    {
+    public:
+      // Gathers the zones of the last frame, unless the view is paused.
+      void update();
+
+      // Must be called between the gui context's new_frame() and render().
+      void show();
+
+      void toggle();
+      bool is_open() const;
+
+    private:
+      void show_timeline();
+      void export_trace();
+
+      profiler::Collector collector_;
+
+      bool is_open_ = false;
+      bool is_paused_ = false;
+      float visible_duration_ = 100.0f;
+      std::string export_path_ = "profile.json";
+      std::string export_status_;
+    };
+  }
+}
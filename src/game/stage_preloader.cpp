@@ -0,0 +1,116 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "stage_preloader.hpp"
+
+#include "resources/track_loader.hpp"
+
+#include "world/terrain_map_builder.hpp"
+
+#include "scene/track_scene_generator.hpp"
+
+#include "utility/debug_log.hpp"
+
+namespace ts
+{
+  namespace game
+  {
+    StagePreloader::StagePreloader(LoadingThread* loading_thread, bool generate_track_scene)
+      : loading_thread_(loading_thread),
+        generate_track_scene_(generate_track_scene)
+    {
+    }
+
+    StagePreloader::~StagePreloader()
+    {
+      discard();
+    }
+
+    void StagePreloader::preload(const resources::TrackReference& track_ref)
+    {
+      if (is_preloading(track_ref)) return;
+
+      discard();
+
+      // Speculative work shouldn't get in the way of anything that's actually needed right now.
+      TaskOptions options;
+      options.priority = TaskPriority::Low;
+
+      auto path = track_ref.path;
+      auto world_task = loading_thread_->schedule([path]()
+      {
+        resources::TrackLoader track_loader;
+        track_loader.load_from_file(path);
+
+        auto track = track_loader.get_result();
+        auto terrain_map = world::build_terrain_map(track);
+        return std::unique_ptr<PreloadedStage>(new PreloadedStage{ std::move(track), std::move(terrain_map), boost::none });
+      }, options);
+
+      if (generate_track_scene_)
+      {
+        // Share the cancellation token, so that discarding the preloaded stage cancels both tasks.
+        options.cancellation = world_task.cancellation_token();
+        options.affinity = TaskAffinity::GLContext;
+
+        task_ = loading_thread_->schedule_continuation(std::move(world_task),
+                                                       [](std::future<std::unique_ptr<PreloadedStage>> future)
+        {
+          auto preloaded = future.get();
+          preloaded->track_scene = scene::generate_track_scene(preloaded->track);
+          return preloaded;
+        }, options);
+      }
+
+      else
+      {
+        task_ = std::move(world_task);
+      }
+
+      track_path_ = track_ref.path;
+    }
+
+    void StagePreloader::discard()
+    {
+      if (task_.valid())
+      {
+        task_.cancel();
+        task_ = {};
+      }
+
+      track_path_.clear();
+    }
+
+    bool StagePreloader::is_preloading(const resources::TrackReference& track_ref) const
+    {
+      return task_.valid() && track_path_ == track_ref.path;
+    }
+
+    bool StagePreloader::is_ready() const
+    {
+      return task_.valid() && task_.is_ready();
+    }
+
+    std::unique_ptr<PreloadedStage> StagePreloader::take(const resources::TrackReference& track_ref)
+    {
+      if (!is_preloading(track_ref)) return nullptr;
+
+      auto task = std::move(task_);
+      track_path_.clear();
+
+      try
+      {
+        return task.get();
+      }
+
+      catch (const std::exception& e)
+      {
+        DEBUG_RELEVANT << "Failed to preload track '" << track_ref.path << "': " << e.what() << debug::endl;
+        return nullptr;
+      }
+    }
+  }
+}
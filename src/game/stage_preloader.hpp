@@ -0,0 +1,69 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include "loading_thread.hpp"
+
+#include "resources/track.hpp"
+#include "resources/track_reference.hpp"
+
+#include "world/terrain_map.hpp"
+
+#include "scene/track_scene.hpp"
+
+#include <boost/optional.hpp>
+
+#include <memory>
+
+namespace ts
+{
+  namespace game
+  {
+    // The parts of a stage that can be prepared before the stage description is known,
+    // because they only depend on the track.
+    struct PreloadedStage
+    {
+      resources::Track track;
+      world::TerrainMap terrain_map;
+      boost::optional<scene::TrackScene> track_scene;
+    };
+
+    // The StagePreloader speculatively loads a track, builds its terrain map and optionally
+    // generates its track scene in the background, so that the stage loaders can adopt the results
+    // instead of starting from scratch. To keep the memory usage bounded, at most one stage is
+    // preloaded at any time: preloading a different track discards the previous one.
+    // Its intended user is the server cup, which starts preloading at the intermission. That code is
+    // still commented out in this tree, so for now nothing preloads stages between races.
+    class StagePreloader
+    {
+    public:
+      explicit StagePreloader(LoadingThread* loading_thread, bool generate_track_scene = true);
+      ~StagePreloader();
+
+      StagePreloader(StagePreloader&&) = default;
+      StagePreloader& operator=(StagePreloader&&) = default;
+
+      void preload(const resources::TrackReference& track_ref);
+      void discard();
+
+      bool is_preloading(const resources::TrackReference& track_ref) const;
+      bool is_ready() const;
+
+      // Waits for the preloaded stage if it matches the given track, and hands it over.
+      // Returns nullptr if the track was not preloaded or if preloading failed, in which case
+      // the caller is expected to fall back to regular loading.
+      std::unique_ptr<PreloadedStage> take(const resources::TrackReference& track_ref);
+
+    private:
+      LoadingThread* loading_thread_;
+      bool generate_track_scene_;
+
+      std::string track_path_;
+      TaskHandle<std::unique_ptr<PreloadedStage>> task_;
+    };
+  }
+}
@@ -46,6 +46,33 @@ namespace ts
         return it->second;
       }
 
+      // Returns a pointer to the cached image, or nullptr if it has not been loaded yet.
+      template <typename StringType>
+      const ImageType* find_image(const StringType& file_name) const
+      {
+        auto it = images_.find(file_name);
+        if (it == images_.end()) return nullptr;
+
+        return &it->second;
+      }
+
+      // Adds an image that was loaded elsewhere, e.g. on a worker thread, to the cache.
+      // Existing entries are left untouched.
+      template <typename StringType>
+      ImageType& store_image(const StringType& file_name, ImageType image)
+      {
+        using std::begin;
+        using std::end;
+
+        return images_.insert(std::make_pair(std::string(begin(file_name), end(file_name)),
+                                             std::move(image))).first->second;
+      }
+
+      const LoadingFunc& loading_func() const
+      {
+        return loading_func_;
+      }
+
     private:
       std::map<std::string, ImageType, std::less<>> images_;
       LoadingFunc loading_func_;
@@ -0,0 +1,175 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "state_cache.hpp"
+#include "gl_check.hpp"
+
+#include <stdexcept>
+
+namespace ts
+{
+  namespace graphics
+  {
+    StateCache::StateCache(bool issue_gl_calls)
+      : issue_gl_calls_(issue_gl_calls)
+    {
+      invalidate();
+    }
+
+    void StateCache::invalidate()
+    {
+      program_ = unknown_object;
+      vertex_array_ = unknown_object;
+      active_texture_unit_ = unknown_object;
+      textures_.fill(unknown_object);
+
+      depth_test_ = Unknown;
+      depth_write_ = Unknown;
+    }
+
+    void StateCache::reset_counters()
+    {
+      counters_ = RenderCounters();
+    }
+
+    const RenderCounters& StateCache::counters() const
+    {
+      return counters_;
+    }
+
+    bool StateCache::use_program(GLuint program)
+    {
+      if (program == program_)
+      {
+        ++counters_.redundant_changes;
+        return false;
+      }
+
+      if (issue_gl_calls_)
+      {
+        glCheck(glUseProgram(program));
+      }
+
+      program_ = program;
+      ++counters_.program_binds;
+      return true;
+    }
+
+    bool StateCache::bind_vertex_array(GLuint vertex_array)
+    {
+      if (vertex_array == vertex_array_)
+      {
+        ++counters_.redundant_changes;
+        return false;
+      }
+
+      if (issue_gl_calls_)
+      {
+        glCheck(glBindVertexArray(vertex_array));
+      }
+
+      vertex_array_ = vertex_array;
+      ++counters_.vertex_array_binds;
+      return true;
+    }
+
+    bool StateCache::bind_texture(std::uint32_t unit, GLuint texture)
+    {
+      if (unit >= max_texture_units)
+      {
+        throw std::out_of_range("texture unit out of range");
+      }
+
+      if (texture == textures_[unit])
+      {
+        ++counters_.redundant_changes;
+        return false;
+      }
+
+      if (issue_gl_calls_)
+      {
+        if (unit != active_texture_unit_)
+        {
+          glCheck(glActiveTexture(GL_TEXTURE0 + unit));
+        }
+
+        glCheck(glBindTexture(GL_TEXTURE_2D, texture));
+      }
+
+      active_texture_unit_ = unit;
+      textures_[unit] = texture;
+      ++counters_.texture_binds;
+      return true;
+    }
+
+    bool StateCache::enable_depth_test(bool enable)
+    {
+      auto flags = enable ? Enabled : Disabled;
+      if (flags == depth_test_)
+      {
+        ++counters_.redundant_changes;
+        return false;
+      }
+
+      if (issue_gl_calls_)
+      {
+        if (enable)
+        {
+          glCheck(glEnable(GL_DEPTH_TEST));
+        }
+
+        else
+        {
+          glCheck(glDisable(GL_DEPTH_TEST));
+        }
+      }
+
+      depth_test_ = flags;
+      ++counters_.capability_changes;
+      return true;
+    }
+
+    bool StateCache::enable_depth_write(bool enable)
+    {
+      auto flags = enable ? Enabled : Disabled;
+      if (flags == depth_write_)
+      {
+        ++counters_.redundant_changes;
+        return false;
+      }
+
+      if (issue_gl_calls_)
+      {
+        glCheck(glDepthMask(enable ? GL_TRUE : GL_FALSE));
+      }
+
+      depth_write_ = flags;
+      ++counters_.capability_changes;
+      return true;
+    }
+
+    void StateCache::draw_elements(GLenum mode, GLsizei count, GLenum type, std::uintptr_t offset)
+    {
+      if (issue_gl_calls_)
+      {
+        glCheck(glDrawElements(mode, count, type, reinterpret_cast<const void*>(offset)));
+      }
+
+      ++counters_.draw_calls;
+    }
+
+    void StateCache::draw_elements_instanced(GLenum mode, GLsizei count, GLenum type, std::uintptr_t offset,
+                                             GLsizei instance_count)
+    {
+      if (issue_gl_calls_)
+      {
+        glCheck(glDrawElementsInstanced(mode, count, type, reinterpret_cast<const void*>(offset), instance_count));
+      }
+
+      ++counters_.draw_calls;
+    }
+  }
+}
@@ -0,0 +1,81 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include <GL/glew.h>
+#include <GL/GL.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace ts
+{
+  namespace graphics
+  {
+    // The number of state changes and draw calls that went through a StateCache.
+    struct RenderCounters
+    {
+      std::size_t program_binds = 0;
+      std::size_t vertex_array_binds = 0;
+      std::size_t texture_binds = 0;
+      std::size_t capability_changes = 0;
+      std::size_t redundant_changes = 0;
+      std::size_t draw_calls = 0;
+    };
+
+    // StateCache shadows the parts of the GL state that change frequently while rendering,
+    // and drops the state changes that would have no effect. With issue_gl_calls set to false,
+    // it only keeps track of the state, so that the filtering can be used without a GL context.
+    class StateCache
+    {
+    public:
+      static const std::uint32_t max_texture_units = 4;
+
+      explicit StateCache(bool issue_gl_calls = true);
+
+      // Forget the shadowed state, this must be called whenever GL state may have been
+      // changed without going through the cache.
+      void invalidate();
+      void reset_counters();
+
+      // These return true if the state was actually changed.
+      bool use_program(GLuint program);
+      bool bind_vertex_array(GLuint vertex_array);
+      bool bind_texture(std::uint32_t unit, GLuint texture);
+      bool enable_depth_test(bool enable);
+      bool enable_depth_write(bool enable);
+
+      void draw_elements(GLenum mode, GLsizei count, GLenum type, std::uintptr_t offset);
+      void draw_elements_instanced(GLenum mode, GLsizei count, GLenum type, std::uintptr_t offset,
+                                   GLsizei instance_count);
+
+      const RenderCounters& counters() const;
+
+    private:
+      enum Flags : std::uint8_t
+      {
+        Disabled = 0,
+        Enabled = 1,
+        Unknown = 2
+      };
+
+      static const GLuint unknown_object = 0xFFFFFFFF;
+
+      bool issue_gl_calls_;
+      RenderCounters counters_;
+
+      GLuint program_ = unknown_object;
+      GLuint vertex_array_ = unknown_object;
+      std::uint32_t active_texture_unit_ = unknown_object;
+      std::array<GLuint, max_texture_units> textures_;
+
+      Flags depth_test_ = Unknown;
+      Flags depth_write_ = Unknown;
+    };
+  }
+}
@@ -97,7 +97,12 @@ namespace ts
         }
       }
 
-      glGenerateMipmap(target);
+      // Compressed formats can't be rendered to, so their levels can't be generated either.
+      if (!gli::is_compressed(tex_2d.format()))
+      {
+        glGenerateMipmap(target);
+      }
+
       return result;
     }
 
@@ -0,0 +1,529 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "texture_compression.hpp"
+
+#include <SFML/Graphics/Image.hpp>
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace ts
+{
+  namespace graphics
+  {
+    namespace detail
+    {
+      static std::uint16_t pack_565(const float* color)
+      {
+        auto quantize = [](float value, float max)
+        {
+          auto result = static_cast<int>(value * max / 255.0f + 0.5f);
+          return static_cast<std::uint16_t>(std::min(std::max(result, 0), static_cast<int>(max)));
+        };
+
+        return static_cast<std::uint16_t>((quantize(color[0], 31.0f) << 11) |
+                                          (quantize(color[1], 63.0f) << 5) |
+                                          quantize(color[2], 31.0f));
+      }
+
+      static void unpack_565(std::uint16_t value, int* color)
+      {
+        auto r = (value >> 11) & 31;
+        auto g = (value >> 5) & 63;
+        auto b = value & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+      }
+
+      // In four-color mode, the two intermediate colors lie at one and two thirds between the endpoints.
+      // Otherwise, there's a single intermediate color, and the last index means transparent black.
+      static void make_color_palette(std::uint16_t color_0, std::uint16_t color_1, bool four_colors,
+                                     int (&palette)[4][3])
+      {
+        unpack_565(color_0, palette[0]);
+        unpack_565(color_1, palette[1]);
+
+        for (int channel = 0; channel != 3; ++channel)
+        {
+          auto a = palette[0][channel], b = palette[1][channel];
+          if (four_colors)
+          {
+            palette[2][channel] = (2 * a + b) / 3;
+            palette[3][channel] = (a + 2 * b) / 3;
+          }
+
+          else
+          {
+            palette[2][channel] = (a + b) / 2;
+            palette[3][channel] = 0;
+          }
+        }
+      }
+
+      // Returns the two-bit palette index of every pixel, and the total squared error.
+      static std::uint32_t select_color_indices(const std::uint8_t* pixels, const int (&palette)[4][3],
+                                                std::uint32_t& total_error)
+      {
+        std::uint32_t indices = 0;
+        total_error = 0;
+        for (int pixel = 0; pixel != 16; ++pixel)
+        {
+          const auto* p = pixels + pixel * 4;
+
+          std::uint32_t best_index = 0, best_error = 0xFFFFFFFF;
+          for (std::uint32_t index = 0; index != 4; ++index)
+          {
+            auto dr = p[0] - palette[index][0];
+            auto dg = p[1] - palette[index][1];
+            auto db = p[2] - palette[index][2];
+
+            auto error = static_cast<std::uint32_t>(dr * dr + dg * dg + db * db);
+            if (error < best_error)
+            {
+              best_error = error;
+              best_index = index;
+            }
+          }
+
+          indices |= best_index << (pixel * 2);
+          total_error += best_error;
+        }
+
+        return indices;
+      }
+
+      // Picks the endpoints along the principal axis of the block's colors, which is found by
+      // a few rounds of power iteration on the covariance matrix.
+      static void fit_color_endpoints(const std::uint8_t* pixels, float* endpoint_0, float* endpoint_1)
+      {
+        float mean[3] = {};
+        float min[3] = { 255.0f, 255.0f, 255.0f };
+        float max[3] = {};
+        for (int pixel = 0; pixel != 16; ++pixel)
+        {
+          for (int channel = 0; channel != 3; ++channel)
+          {
+            float value = pixels[pixel * 4 + channel];
+            mean[channel] += value;
+            min[channel] = std::min(min[channel], value);
+            max[channel] = std::max(max[channel], value);
+          }
+        }
+
+        for (auto& value : mean) value /= 16.0f;
+
+        float covariance[6] = {};
+        for (int pixel = 0; pixel != 16; ++pixel)
+        {
+          float r = pixels[pixel * 4] - mean[0];
+          float g = pixels[pixel * 4 + 1] - mean[1];
+          float b = pixels[pixel * 4 + 2] - mean[2];
+          covariance[0] += r * r;
+          covariance[1] += r * g;
+          covariance[2] += r * b;
+          covariance[3] += g * g;
+          covariance[4] += g * b;
+          covariance[5] += b * b;
+        }
+
+        float axis[3] = { max[0] - min[0], max[1] - min[1], max[2] - min[2] };
+        for (int iteration = 0; iteration != 4; ++iteration)
+        {
+          float r = axis[0] * covariance[0] + axis[1] * covariance[1] + axis[2] * covariance[2];
+          float g = axis[0] * covariance[1] + axis[1] * covariance[3] + axis[2] * covariance[4];
+          float b = axis[0] * covariance[2] + axis[1] * covariance[4] + axis[2] * covariance[5];
+
+          auto largest = std::max({ std::abs(r), std::abs(g), std::abs(b) });
+          if (largest < 1e-6f) break;
+
+          axis[0] = r / largest;
+          axis[1] = g / largest;
+          axis[2] = b / largest;
+        }
+
+        int min_pixel = 0, max_pixel = 0;
+        float min_projection = 1e30f, max_projection = -1e30f;
+        for (int pixel = 0; pixel != 16; ++pixel)
+        {
+          const auto* p = pixels + pixel * 4;
+          auto projection = p[0] * axis[0] + p[1] * axis[1] + p[2] * axis[2];
+          if (projection < min_projection)
+          {
+            min_projection = projection;
+            min_pixel = pixel;
+          }
+
+          if (projection > max_projection)
+          {
+            max_projection = projection;
+            max_pixel = pixel;
+          }
+        }
+
+        for (int channel = 0; channel != 3; ++channel)
+        {
+          endpoint_0[channel] = pixels[max_pixel * 4 + channel];
+          endpoint_1[channel] = pixels[min_pixel * 4 + channel];
+        }
+      }
+
+      // Least-squares fit of the endpoints, given the palette index of every pixel in four-color mode.
+      static bool refine_color_endpoints(const std::uint8_t* pixels, std::uint32_t indices,
+                                         float* endpoint_0, float* endpoint_1)
+      {
+        static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ap[3] = {}, bp[3] = {};
+        for (int pixel = 0; pixel != 16; ++pixel)
+        {
+          auto a = weights[(indices >> (pixel * 2)) & 3];
+          auto b = 1.0f - a;
+
+          aa += a * a;
+          ab += a * b;
+          bb += b * b;
+          for (int channel = 0; channel != 3; ++channel)
+          {
+            ap[channel] += a * pixels[pixel * 4 + channel];
+            bp[channel] += b * pixels[pixel * 4 + channel];
+          }
+        }
+
+        auto determinant = aa * bb - ab * ab;
+        if (std::abs(determinant) < 1e-6f) return false;
+
+        for (int channel = 0; channel != 3; ++channel)
+        {
+          auto e0 = (ap[channel] * bb - bp[channel] * ab) / determinant;
+          auto e1 = (bp[channel] * aa - ap[channel] * ab) / determinant;
+          endpoint_0[channel] = std::min(std::max(e0, 0.0f), 255.0f);
+          endpoint_1[channel] = std::min(std::max(e1, 0.0f), 255.0f);
+        }
+
+        return true;
+      }
+
+      static void write_color_block(std::uint16_t color_0, std::uint16_t color_1, std::uint32_t indices,
+                                    std::uint8_t* block)
+      {
+        block[0] = static_cast<std::uint8_t>(color_0 & 0xFF);
+        block[1] = static_cast<std::uint8_t>(color_0 >> 8);
+        block[2] = static_cast<std::uint8_t>(color_1 & 0xFF);
+        block[3] = static_cast<std::uint8_t>(color_1 >> 8);
+        for (int byte = 0; byte != 4; ++byte)
+        {
+          block[4 + byte] = static_cast<std::uint8_t>(indices >> (byte * 8));
+        }
+      }
+
+      // Always encodes in four-color mode, which is what BC3 requires.
+      static void encode_color_block(const std::uint8_t* pixels, std::uint8_t* block)
+      {
+        float endpoint_0[3], endpoint_1[3];
+        fit_color_endpoints(pixels, endpoint_0, endpoint_1);
+
+        struct Candidate
+        {
+          std::uint16_t color_0;
+          std::uint16_t color_1;
+          std::uint32_t indices;
+          std::uint32_t error;
+        };
+
+        auto make_candidate = [=](const float* e0, const float* e1)
+        {
+          Candidate candidate;
+          candidate.color_0 = pack_565(e0);
+          candidate.color_1 = pack_565(e1);
+          if (candidate.color_0 < candidate.color_1) std::swap(candidate.color_0, candidate.color_1);
+
+          int palette[4][3];
+          make_color_palette(candidate.color_0, candidate.color_1, true, palette);
+          candidate.indices = select_color_indices(pixels, palette, candidate.error);
+          return candidate;
+        };
+
+        auto best = make_candidate(endpoint_0, endpoint_1);
+        if (best.color_0 == best.color_1)
+        {
+          // Only the first palette entry is meaningful.
+          write_color_block(best.color_0, best.color_1, 0, block);
+          return;
+        }
+
+        if (best.error != 0 && refine_color_endpoints(pixels, best.indices, endpoint_0, endpoint_1))
+        {
+          auto refined = make_candidate(endpoint_0, endpoint_1);
+          if (refined.color_0 != refined.color_1 && refined.error < best.error) best = refined;
+        }
+
+        write_color_block(best.color_0, best.color_1, best.indices, block);
+      }
+
+      static void encode_alpha_block(const std::uint8_t* pixels, std::uint8_t* block)
+      {
+        std::uint8_t alpha_0 = 0, alpha_1 = 255;
+        for (int pixel = 0; pixel != 16; ++pixel)
+        {
+          alpha_0 = std::max(alpha_0, pixels[pixel * 4 + 3]);
+          alpha_1 = std::min(alpha_1, pixels[pixel * 4 + 3]);
+        }
+
+        block[0] = alpha_0;
+        block[1] = alpha_1;
+
+        std::uint64_t bits = 0;
+        if (alpha_0 != alpha_1)
+        {
+          // Eight-value mode: the endpoints and six values in between.
+          int palette[8] = { alpha_0, alpha_1 };
+          for (int index = 2; index != 8; ++index)
+          {
+            palette[index] = ((8 - index) * alpha_0 + (index - 1) * alpha_1) / 7;
+          }
+
+          for (int pixel = 0; pixel != 16; ++pixel)
+          {
+            int alpha = pixels[pixel * 4 + 3];
+
+            std::uint64_t best_index = 0;
+            int best_error = 256;
+            for (int index = 0; index != 8; ++index)
+            {
+              auto error = std::abs(alpha - palette[index]);
+              if (error < best_error)
+              {
+                best_error = error;
+                best_index = index;
+              }
+            }
+
+            bits |= best_index << (pixel * 3);
+          }
+        }
+
+        for (int byte = 0; byte != 6; ++byte)
+        {
+          block[2 + byte] = static_cast<std::uint8_t>(bits >> (byte * 8));
+        }
+      }
+
+      void encode_bc1_block(const std::uint8_t* pixels, std::uint8_t* block)
+      {
+        encode_color_block(pixels, block);
+      }
+
+      void encode_bc3_block(const std::uint8_t* pixels, std::uint8_t* block)
+      {
+        encode_alpha_block(pixels, block);
+        encode_color_block(pixels, block + 8);
+      }
+
+      static void decode_color_block(const std::uint8_t* block, std::uint8_t* pixels, bool allow_three_colors)
+      {
+        auto color_0 = static_cast<std::uint16_t>(block[0] | (block[1] << 8));
+        auto color_1 = static_cast<std::uint16_t>(block[2] | (block[3] << 8));
+        auto four_colors = !allow_three_colors || color_0 > color_1;
+
+        int palette[4][3];
+        make_color_palette(color_0, color_1, four_colors, palette);
+
+        std::uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (std::uint32_t(block[7]) << 24);
+        for (int pixel = 0; pixel != 16; ++pixel)
+        {
+          auto index = (indices >> (pixel * 2)) & 3;
+          auto* p = pixels + pixel * 4;
+          p[0] = static_cast<std::uint8_t>(palette[index][0]);
+          p[1] = static_cast<std::uint8_t>(palette[index][1]);
+          p[2] = static_cast<std::uint8_t>(palette[index][2]);
+          p[3] = (!four_colors && index == 3) ? 0 : 255;
+        }
+      }
+
+      void decode_bc1_block(const std::uint8_t* block, std::uint8_t* pixels)
+      {
+        decode_color_block(block, pixels, true);
+      }
+
+      void decode_bc3_block(const std::uint8_t* block, std::uint8_t* pixels)
+      {
+        decode_color_block(block + 8, pixels, false);
+
+        int alpha_0 = block[0], alpha_1 = block[1];
+        int palette[8] = { alpha_0, alpha_1 };
+        if (alpha_0 > alpha_1)
+        {
+          for (int index = 2; index != 8; ++index)
+          {
+            palette[index] = ((8 - index) * alpha_0 + (index - 1) * alpha_1) / 7;
+          }
+        }
+
+        else
+        {
+          for (int index = 2; index != 6; ++index)
+          {
+            palette[index] = ((6 - index) * alpha_0 + (index - 1) * alpha_1) / 5;
+          }
+
+          palette[6] = 0;
+          palette[7] = 255;
+        }
+
+        std::uint64_t bits = 0;
+        for (int byte = 0; byte != 6; ++byte)
+        {
+          bits |= std::uint64_t(block[2 + byte]) << (byte * 8);
+        }
+
+        for (int pixel = 0; pixel != 16; ++pixel)
+        {
+          pixels[pixel * 4 + 3] = static_cast<std::uint8_t>(palette[(bits >> (pixel * 3)) & 7]);
+        }
+      }
+    }
+
+    BlockFormat select_block_format(const gli::texture2d& texture)
+    {
+      if (texture.format() != gli::FORMAT_RGBA8_UNORM_PACK8)
+      {
+        throw std::invalid_argument("block format selection requires an RGBA8 texture");
+      }
+
+      const auto* pixels = static_cast<const std::uint8_t*>(texture.data(0, 0, texture.base_level()));
+      auto extent = texture.extent(texture.base_level());
+      auto pixel_count = static_cast<std::size_t>(extent.x) * extent.y;
+
+      for (std::size_t pixel = 0; pixel != pixel_count; ++pixel)
+      {
+        if (pixels[pixel * 4 + 3] != 255) return BlockFormat::BC3;
+      }
+
+      return BlockFormat::BC1;
+    }
+
+    gli::texture2d compress_texture(const gli::texture2d& texture, BlockFormat format, std::size_t thread_count)
+    {
+      if (texture.format() != gli::FORMAT_RGBA8_UNORM_PACK8)
+      {
+        throw std::invalid_argument("only RGBA8 textures can be block-compressed");
+      }
+
+      auto extent = texture.extent(texture.base_level());
+      auto result_format = format == BlockFormat::BC1 ? gli::FORMAT_RGB_DXT1_UNORM_BLOCK8 :
+        gli::FORMAT_RGBA_DXT5_UNORM_BLOCK16;
+
+      gli::texture2d result(result_format, extent, 1);
+
+      const auto* source = static_cast<const std::uint8_t*>(texture.data(0, 0, texture.base_level()));
+      auto* destination = static_cast<std::uint8_t*>(result.data(0, 0, 0));
+
+      const std::size_t block_size = format == BlockFormat::BC1 ? 8 : 16;
+      const std::size_t blocks_x = (extent.x + 3) / 4;
+      const std::size_t blocks_y = (extent.y + 3) / 4;
+
+      // Each task encodes a row of blocks.
+      utility::parallel_for(blocks_y, [&](std::size_t block_y)
+      {
+        std::uint8_t pixels[64];
+        for (std::size_t block_x = 0; block_x != blocks_x; ++block_x)
+        {
+          for (std::size_t y = 0; y != 4; ++y)
+          {
+            auto source_y = std::min<std::size_t>(block_y * 4 + y, extent.y - 1);
+            for (std::size_t x = 0; x != 4; ++x)
+            {
+              auto source_x = std::min<std::size_t>(block_x * 4 + x, extent.x - 1);
+              std::memcpy(pixels + (y * 4 + x) * 4, source + (source_y * extent.x + source_x) * 4, 4);
+            }
+          }
+
+          auto* block = destination + (block_y * blocks_x + block_x) * block_size;
+          if (format == BlockFormat::BC1) detail::encode_bc1_block(pixels, block);
+          else detail::encode_bc3_block(pixels, block);
+        }
+      }, thread_count);
+
+      return result;
+    }
+
+    gli::texture2d decompress_texture(const gli::texture2d& texture)
+    {
+      auto format = texture.format();
+      bool is_bc1 = format == gli::FORMAT_RGB_DXT1_UNORM_BLOCK8 || format == gli::FORMAT_RGBA_DXT1_UNORM_BLOCK8;
+      if (!is_bc1 && format != gli::FORMAT_RGBA_DXT5_UNORM_BLOCK16)
+      {
+        throw std::invalid_argument("only BC1 and BC3 textures can be decompressed");
+      }
+
+      auto extent = texture.extent(texture.base_level());
+      gli::texture2d result(gli::FORMAT_RGBA8_UNORM_PACK8, extent, 1);
+
+      const auto* source = static_cast<const std::uint8_t*>(texture.data(0, 0, texture.base_level()));
+      auto* destination = static_cast<std::uint8_t*>(result.data(0, 0, 0));
+
+      const std::size_t block_size = is_bc1 ? 8 : 16;
+      const std::size_t blocks_x = (extent.x + 3) / 4;
+      const std::size_t blocks_y = (extent.y + 3) / 4;
+
+      std::uint8_t pixels[64];
+      for (std::size_t block_y = 0; block_y != blocks_y; ++block_y)
+      {
+        for (std::size_t block_x = 0; block_x != blocks_x; ++block_x)
+        {
+          const auto* block = source + (block_y * blocks_x + block_x) * block_size;
+          if (is_bc1) detail::decode_bc1_block(block, pixels);
+          else detail::decode_bc3_block(block, pixels);
+
+          for (std::size_t y = 0; y != 4 && block_y * 4 + y < std::size_t(extent.y); ++y)
+          {
+            for (std::size_t x = 0; x != 4 && block_x * 4 + x < std::size_t(extent.x); ++x)
+            {
+              auto pixel_index = (block_y * 4 + y) * extent.x + block_x * 4 + x;
+              std::memcpy(destination + pixel_index * 4, pixels + (y * 4 + x) * 4, 4);
+            }
+          }
+        }
+      }
+
+      return result;
+    }
+
+    gli::texture2d make_texture_data(const sf::Image& image)
+    {
+      auto size = image.getSize();
+      gli::texture2d result(gli::FORMAT_RGBA8_UNORM_PACK8, gli::extent2d(size.x, size.y), 1);
+      std::memcpy(result.data(), image.getPixelsPtr(), result.size());
+      return result;
+    }
+
+    bool block_compression_supported()
+    {
+      return GLEW_EXT_texture_compression_s3tc != 0;
+    }
+
+    Texture create_compressed_texture(const sf::Image& image)
+    {
+      if (!block_compression_supported()) return create_texture(image);
+
+      auto data = make_texture_data(image);
+      auto texture = create_texture(compress_texture(data, select_block_format(data)));
+
+      glCheck(glBindTexture(GL_TEXTURE_2D, texture.get()));
+      glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+      glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+      glCheck(glBindTexture(GL_TEXTURE_2D, 0));
+      return texture;
+    }
+  }
+}
@@ -0,0 +1,68 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include "texture.hpp"
+
+#include "utility/parallel_for.hpp"
+
+#include <gli/texture2d.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sf
+{
+  class Image;
+}
+
+namespace ts
+{
+  namespace graphics
+  {
+    // S3TC block compression. BC1 stores a 4x4 block of opaque pixels in 8 bytes, and BC3 stores a block
+    // with alpha in 16 bytes, a 8:1 and a 4:1 reduction compared to RGBA8.
+    enum class BlockFormat
+    {
+      BC1,
+      BC3
+    };
+
+    // The width and height of a block, in pixels.
+    static const std::int32_t block_extent = 4;
+
+    // Picks BC1 for textures that are fully opaque, and BC3 otherwise.
+    BlockFormat select_block_format(const gli::texture2d& texture);
+
+    // Compresses the base level of an RGBA8 texture, the result has a single level. The blocks
+    // are encoded concurrently. Partial blocks at the edges are padded by repeating the edge pixels.
+    gli::texture2d compress_texture(const gli::texture2d& texture, BlockFormat format,
+                                    std::size_t thread_count = utility::default_thread_count());
+
+    // Decodes the base level of a BC1 or BC3 texture to RGBA8, for when the hardware can't sample them.
+    gli::texture2d decompress_texture(const gli::texture2d& texture);
+
+    gli::texture2d make_texture_data(const sf::Image& image);
+
+    // Requires a GL context.
+    bool block_compression_supported();
+
+    // Uploads the image as a block-compressed texture with linear filtering, or as a regular texture
+    // if block compression is not supported.
+    Texture create_compressed_texture(const sf::Image& image);
+
+    namespace detail
+    {
+      // Pixels are 16 RGBA8 values in row-major order.
+      void encode_bc1_block(const std::uint8_t* pixels, std::uint8_t* block);
+      void encode_bc3_block(const std::uint8_t* pixels, std::uint8_t* block);
+
+      void decode_bc1_block(const std::uint8_t* block, std::uint8_t* pixels);
+      void decode_bc3_block(const std::uint8_t* block, std::uint8_t* pixels);
+    }
+  }
+}
@@ -16,6 +16,7 @@
 #include "utility/stream_utilities.hpp"
 #include "utility/string_utilities.hpp"
 #include "utility/debug_log.hpp"
+#include "utility/profiler.hpp"
 
 #include <boost/filesystem/path.hpp>
 
@@ -362,6 +363,8 @@ namespace ts
 
     std::size_t CarLoader::load_cars_from_file(const std::string& file_name)
     {
+      TS_PROFILE_ZONE("CarLoader::load_cars_from_file");
+
       auto stream = make_ifstream(file_name, std::ios::in);
       if (stream)
       {
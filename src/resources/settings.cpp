@@ -12,6 +12,8 @@
 #include "client/key_settings.hpp"
 #include "client/player_settings.hpp"
 
+#include "scene/video_settings.hpp"
+
 namespace ts
 {
   namespace resources
@@ -21,6 +23,7 @@ namespace ts
       cup::CupSettings cup_settings;
       client::KeySettings key_settings = client::default_key_settings();
       client::PlayerSettings player_settings;
+      scene::VideoSettings video_settings;
     };
 
     Settings::Settings()
@@ -61,5 +64,15 @@ namespace ts
     {
       return impl_->player_settings;
     }
+
+    scene::VideoSettings& Settings::video_settings()
+    {
+      return impl_->video_settings;
+    }
+
+    const scene::VideoSettings& Settings::video_settings() const
+    {
+      return impl_->video_settings;
+    }
   }
 }
\ No newline at end of file
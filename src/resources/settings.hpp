@@ -21,6 +21,11 @@ namespace ts
     struct PlayerSettings;
   }
 
+  namespace scene
+  {
+    struct VideoSettings;
+  }
+
   namespace resources
   {
     // The Settings class encompasses all kinds of different settings
@@ -40,6 +45,9 @@ namespace ts
       client::PlayerSettings& player_settings();
       const client::PlayerSettings& player_settings() const;
 
+      scene::VideoSettings& video_settings();
+      const scene::VideoSettings& video_settings() const;
+
     private:
       struct Impl;
       std::unique_ptr<Impl> impl_;
@@ -18,6 +18,7 @@
 #include "utility/debug_log.hpp"
 #include "utility/stream_utilities.hpp"
 #include "utility/string_utilities.hpp"
+#include "utility/profiler.hpp"
 
 #include <boost/optional.hpp>
 #include <boost/algorithm/string.hpp>
@@ -757,6 +758,8 @@ namespace ts
 
     void TrackLoader::load_from_file(const std::string& file_name)
     {
+      TS_PROFILE_ZONE("TrackLoader::load_from_file");
+
       // Reset the track instance with a default-constructed one
       // so we don't have any residual state.
       Track dummy_track;
@@ -0,0 +1,380 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "atlas_cache.hpp"
+#include "texture_mapping.hpp"
+
+#include "core/config.hpp"
+
+#include "resources/track.hpp"
+#include "resources/track_layer.hpp"
+#include "resources/tile_library.hpp"
+
+#include "utility/sha256.hpp"
+#include "utility/stream_utilities.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <gli/load_ktx.hpp>
+#include <gli/save_ktx.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+namespace ts
+{
+  namespace scene
+  {
+    namespace detail
+    {
+      // Bump this whenever the file layout, or anything else that affects the
+      // atlas contents, e.g. the packing algorithm, changes.
+      static const std::uint32_t atlas_cache_version = 2;
+      static const char atlas_cache_magic[4] = { 'T', 'S', 'A', 'C' };
+    }
+
+    AtlasCacheKey compute_atlas_cache_key(const resources::Track& track, Vector2i atlas_size,
+                                          bool include_all_assets, bool compressed)
+    {
+      hash::SHA256 hasher;
+      auto add_value = [&](const auto& value)
+      {
+        hasher.add(&value, sizeof(value));
+      };
+
+      auto add_string = [&](boost::string_ref string)
+      {
+        add_value(static_cast<std::uint64_t>(string.size()));
+        hasher.add(string.data(), string.size());
+      };
+
+      auto add_rect = [&](const IntRect& rect)
+      {
+        add_value(rect.left);
+        add_value(rect.top);
+        add_value(rect.width);
+        add_value(rect.height);
+      };
+
+      add_value(detail::atlas_cache_version);
+      add_value(atlas_size.x);
+      add_value(atlas_size.y);
+      add_value(static_cast<std::uint8_t>(include_all_assets));
+      add_value(static_cast<std::uint8_t>(compressed));
+
+      const auto& tile_library = track.tile_library();
+      std::vector<boost::string_ref> image_files;
+      for (const auto& tile : tile_library.tiles())
+      {
+        add_value(tile.id);
+        add_string(tile.image_file);
+        add_rect(tile.image_rect);
+
+        image_files.push_back(tile.image_file);
+      }
+
+      for (const auto& tile_group : tile_library.tile_groups())
+      {
+        add_value(tile_group.id);
+        for (const auto& sub_tile : tile_group.sub_tiles)
+        {
+          add_value(sub_tile.id);
+        }
+      }
+
+      // Hashing the image contents would take about as long as decoding them,
+      // so settle for the file size and modification time.
+      std::sort(image_files.begin(), image_files.end());
+      image_files.erase(std::unique(image_files.begin(), image_files.end()), image_files.end());
+      for (auto image_file : image_files)
+      {
+        boost::system::error_code error;
+        boost::filesystem::path path(image_file.begin(), image_file.end());
+
+        auto file_size = boost::filesystem::file_size(path, error);
+        if (error) file_size = 0;
+
+        auto write_time = boost::filesystem::last_write_time(path, error);
+        if (error) write_time = 0;
+
+        add_string(image_file);
+        add_value(static_cast<std::uint64_t>(file_size));
+        add_value(static_cast<std::int64_t>(write_time));
+      }
+
+      // Without all assets, the atlases only contain the tiles that are used on the track.
+      if (!include_all_assets)
+      {
+        std::vector<resources::TileId> tile_ids;
+        for (const auto& layer : track.layers())
+        {
+          if (auto tiles = layer.tiles())
+          {
+            for (const auto& tile : *tiles)
+            {
+              tile_ids.push_back(tile.id);
+            }
+          }
+        }
+
+        std::sort(tile_ids.begin(), tile_ids.end());
+        tile_ids.erase(std::unique(tile_ids.begin(), tile_ids.end()), tile_ids.end());
+        for (auto tile_id : tile_ids)
+        {
+          add_value(tile_id);
+        }
+      }
+
+      return hasher();
+    }
+
+    std::string cache_file_name(const std::string& prefix, const AtlasCacheKey& key)
+    {
+      static const char hex_digits[] = "0123456789abcdef";
+
+      std::string file_name = config::cache_directory;
+      file_name += "/";
+      file_name += prefix;
+      for (auto word : key)
+      {
+        for (int shift = 28; shift >= 0; shift -= 4)
+        {
+          file_name += hex_digits[(word >> shift) & 0xF];
+        }
+      }
+
+      file_name += ".bin";
+      return file_name;
+    }
+
+    std::string atlas_cache_file_name(const AtlasCacheKey& key)
+    {
+      return cache_file_name("atlas_", key);
+    }
+
+    std::string cache_temp_file_name(const std::string& file_name)
+    {
+      return boost::filesystem::unique_path(file_name + ".%%%%-%%%%-%%%%.tmp").string();
+    }
+
+    void touch_cache_file(const std::string& file_name)
+    {
+      boost::system::error_code error;
+      boost::filesystem::last_write_time(file_name, std::time(nullptr), error);
+    }
+
+    void trim_cache_directory(const std::string& directory, std::uintmax_t max_size)
+    {
+      struct CacheFile
+      {
+        boost::filesystem::path path;
+        std::uintmax_t size;
+        std::time_t write_time;
+      };
+
+      // A temp file that was written to recently may belong to a writer that is still busy,
+      // older ones were left behind by writers that didn't get to finish.
+      const std::time_t temp_file_lifetime = 60 * 60;
+      auto now = std::time(nullptr);
+
+      boost::system::error_code error;
+      std::vector<CacheFile> files;
+      std::uintmax_t total_size = 0;
+      for (boost::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error))
+      {
+        CacheFile file;
+        file.path = it->path();
+        if (!boost::filesystem::is_regular_file(file.path, error)) continue;
+
+        file.size = boost::filesystem::file_size(file.path, error);
+        if (error) continue;
+
+        file.write_time = boost::filesystem::last_write_time(file.path, error);
+        if (error) continue;
+
+        total_size += file.size;
+        if (file.path.extension() != ".tmp" || now - file.write_time > temp_file_lifetime)
+        {
+          files.push_back(file);
+        }
+      }
+
+      std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b)
+      {
+        return a.write_time < b.write_time;
+      });
+
+      for (auto file = files.begin(); file != files.end() && total_size > max_size; ++file)
+      {
+        if (boost::filesystem::remove(file->path, error)) total_size -= file->size;
+      }
+    }
+
+    boost::optional<AtlasCacheEntry> load_atlas_cache(const std::string& file_name)
+    {
+      boost::system::error_code error;
+      if (!boost::filesystem::is_regular_file(file_name, error)) return boost::none;
+
+      auto contents = load_file_contents(file_name);
+
+      BufferReader reader{ contents.data(), contents.data() + contents.size() };
+      auto magic = reader.read<std::array<char, 4>>();
+      auto version = reader.read<std::uint32_t>();
+      if (!reader.valid || version != detail::atlas_cache_version ||
+          !std::equal(magic.begin(), magic.end(), detail::atlas_cache_magic))
+      {
+        return boost::none;
+      }
+
+      auto atlas_count = reader.read<std::uint32_t>();
+      auto mapping_count = reader.read<std::uint32_t>();
+
+      AtlasCacheEntry result;
+      for (std::uint32_t i = 0; i != mapping_count && reader.valid; ++i)
+      {
+        AtlasCacheMapping mapping;
+        mapping.resource_id = reader.read<std::uint64_t>();
+        mapping.atlas_id = reader.read<std::uint32_t>();
+        mapping.texture_rect.left = reader.read<std::int32_t>();
+        mapping.texture_rect.top = reader.read<std::int32_t>();
+        mapping.texture_rect.width = reader.read<std::int32_t>();
+        mapping.texture_rect.height = reader.read<std::int32_t>();
+        mapping.fragment_offset.x = reader.read<std::int32_t>();
+        mapping.fragment_offset.y = reader.read<std::int32_t>();
+        mapping.is_fragment = reader.read<std::uint8_t>() != 0;
+
+        if (mapping.atlas_id >= atlas_count) return boost::none;
+        result.mappings.push_back(mapping);
+      }
+
+      for (std::uint32_t i = 0; i != atlas_count && reader.valid; ++i)
+      {
+        auto data_size = reader.read<std::uint64_t>();
+        if (!reader.valid || data_size > static_cast<std::uint64_t>(reader.end - reader.data)) return boost::none;
+
+        gli::texture2d atlas(gli::load_ktx(reader.data, static_cast<std::size_t>(data_size)));
+        if (atlas.empty()) return boost::none;
+
+        result.atlases.push_back(std::move(atlas));
+        reader.data += data_size;
+      }
+
+      if (!reader.valid) return boost::none;
+
+      touch_cache_file(file_name);
+      return result;
+    }
+
+    void save_atlas_cache(const std::string& file_name, const AtlasCacheEntry& cache_entry)
+    {
+      boost::filesystem::path path(file_name);
+      boost::filesystem::path temp_path(cache_temp_file_name(file_name));
+
+      if (path.has_parent_path())
+      {
+        boost::filesystem::create_directories(path.parent_path());
+      }
+
+      {
+        auto stream = make_ofstream(temp_path.string());
+        if (!stream) throw std::runtime_error("failed to open atlas cache file '" + temp_path.string() + "'");
+
+        stream.write(detail::atlas_cache_magic, sizeof(detail::atlas_cache_magic));
+        write_value(stream, detail::atlas_cache_version);
+        write_value(stream, static_cast<std::uint32_t>(cache_entry.atlases.size()));
+        write_value(stream, static_cast<std::uint32_t>(cache_entry.mappings.size()));
+
+        for (const auto& mapping : cache_entry.mappings)
+        {
+          write_value(stream, mapping.resource_id);
+          write_value(stream, mapping.atlas_id);
+          write_value(stream, mapping.texture_rect.left);
+          write_value(stream, mapping.texture_rect.top);
+          write_value(stream, mapping.texture_rect.width);
+          write_value(stream, mapping.texture_rect.height);
+          write_value(stream, mapping.fragment_offset.x);
+          write_value(stream, mapping.fragment_offset.y);
+          write_value(stream, static_cast<std::uint8_t>(mapping.is_fragment));
+        }
+
+        std::vector<char> atlas_data;
+        for (const auto& atlas : cache_entry.atlases)
+        {
+          atlas_data.clear();
+          if (!gli::save_ktx(atlas, atlas_data))
+          {
+            throw std::runtime_error("failed to encode texture atlas for '" + file_name + "'");
+          }
+
+          write_value(stream, static_cast<std::uint64_t>(atlas_data.size()));
+          stream.write(atlas_data.data(), atlas_data.size());
+        }
+
+        if (!stream) throw std::runtime_error("failed to write atlas cache file '" + temp_path.string() + "'");
+      }
+
+      boost::filesystem::rename(temp_path, path);
+    }
+
+    std::vector<AtlasCacheMapping> extract_atlas_mappings(const TextureMapping& texture_mapping,
+                                                          std::size_t atlas_count)
+    {
+      const auto& textures = texture_mapping.textures();
+      auto texture_end = textures.begin() + std::min(atlas_count, textures.size());
+
+      std::vector<AtlasCacheMapping> result;
+      auto add_mappings = [&](TextureMapping::mapping_range range, bool is_fragment)
+      {
+        for (const auto& mapped_texture : range)
+        {
+          auto it = std::find_if(textures.begin(), texture_end,
+                                 [&](const auto& texture)
+          {
+            return texture.get() == mapped_texture.texture;
+          });
+
+          if (it != texture_end)
+          {
+            AtlasCacheMapping mapping;
+            mapping.resource_id = mapped_texture.resource_id;
+            mapping.atlas_id = static_cast<std::uint32_t>(std::distance(textures.begin(), it));
+            mapping.texture_rect = mapped_texture.texture_rect;
+            mapping.fragment_offset = mapped_texture.fragment_offset;
+            mapping.is_fragment = is_fragment;
+            result.push_back(mapping);
+          }
+        }
+      };
+
+      add_mappings(texture_mapping.mapped_textures(), false);
+      add_mappings(texture_mapping.mapped_fragments(), true);
+      return result;
+    }
+
+    void apply_atlas_mappings(TextureMapping& texture_mapping, const std::vector<AtlasCacheMapping>& mappings)
+    {
+      const auto& textures = texture_mapping.textures();
+      auto map_interface = texture_mapping.create_mapping_interface();
+
+      for (const auto& mapping : mappings)
+      {
+        const auto* texture = textures[mapping.atlas_id].get();
+        if (mapping.is_fragment)
+        {
+          map_interface.map_texture_fragment(mapping.resource_id, texture, mapping.texture_rect,
+                                             mapping.fragment_offset);
+        }
+
+        else
+        {
+          map_interface.map_texture(mapping.resource_id, texture, mapping.texture_rect);
+        }
+      }
+    }
+  }
+}
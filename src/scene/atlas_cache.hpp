@@ -0,0 +1,89 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include "utility/rect.hpp"
+#include "utility/vector2.hpp"
+
+#include <boost/optional.hpp>
+
+#include <gli/texture2d.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ts
+{
+  namespace resources
+  {
+    class Track;
+  }
+
+  namespace scene
+  {
+    class TextureMapping;
+
+    // The atlas cache stores the composed texture atlases of a track scene on disk, along with the
+    // texture mapping that refers to them. The key is a hash of everything that affects the atlases'
+    // contents, so a cache hit only requires reading one file and uploading the textures.
+    using AtlasCacheKey = std::array<std::uint32_t, 8>;
+
+    struct AtlasCacheMapping
+    {
+      std::uint64_t resource_id;
+      std::uint32_t atlas_id;
+      IntRect texture_rect;
+      Vector2i fragment_offset;
+      bool is_fragment;
+    };
+
+    struct AtlasCacheEntry
+    {
+      std::vector<gli::texture2d> atlases;
+      std::vector<AtlasCacheMapping> mappings;
+    };
+
+    // Hashes the tile definitions, the source image files' sizes and modification times, and if not
+    // all assets are included, the ids of the tiles that are actually placed on the track.
+    // Block-compressed atlases are cached separately from uncompressed ones.
+    AtlasCacheKey compute_atlas_cache_key(const resources::Track& track, Vector2i atlas_size,
+                                          bool include_all_assets, bool compressed = false);
+
+    // Builds a file name in the cache directory out of a prefix and the hexadecimal representation of the key.
+    std::string cache_file_name(const std::string& prefix, const AtlasCacheKey& key);
+    std::string atlas_cache_file_name(const AtlasCacheKey& key);
+
+    // The name of the temporary file that a cache file is written to before it is renamed. It has a
+    // random suffix, so that processes or threads writing the same cache file don't share a temp file.
+    std::string cache_temp_file_name(const std::string& file_name);
+
+    // Marks a cache file as recently used, so that trim_cache_directory removes it last.
+    void touch_cache_file(const std::string& file_name);
+
+    // Removes the least recently used files from the directory, until the remaining files take up
+    // at most max_size bytes. Temporary files that may still be in the process of being written
+    // are left alone.
+    void trim_cache_directory(const std::string& directory, std::uintmax_t max_size);
+
+    // Returns boost::none if the file does not exist or is not a valid cache file.
+    boost::optional<AtlasCacheEntry> load_atlas_cache(const std::string& file_name);
+
+    // Writes the cache entry to a temporary file first, which is then renamed, so that an interrupted
+    // write never leaves a truncated cache file behind. Throws std::runtime_error on failure.
+    void save_atlas_cache(const std::string& file_name, const AtlasCacheEntry& cache_entry);
+
+    // Converts the mapping tables to their cached form, with texture pointers replaced by their index
+    // in texture_mapping.textures(). Only the first atlas_count textures are considered.
+    std::vector<AtlasCacheMapping> extract_atlas_mappings(const TextureMapping& texture_mapping,
+                                                          std::size_t atlas_count);
+
+    // Adds the cached mappings to a texture mapping whose textures are the uploaded cached atlases.
+    void apply_atlas_mappings(TextureMapping& texture_mapping, const std::vector<AtlasCacheMapping>& mappings);
+  }
+}
@@ -0,0 +1,75 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "car_instances.hpp"
+
+#include "graphics/texture.hpp"
+
+namespace ts
+{
+  namespace scene
+  {
+    namespace detail
+    {
+      std::array<float, 6> affine_rows(const sf::Transform& transform)
+      {
+        // sf::Transform stores a column-major 4x4 matrix.
+        const float* m = transform.getMatrix();
+        return{ { m[0], m[4], m[12], m[1], m[5], m[13] } };
+      }
+    }
+
+    void record_entity_commands(const DrawableEntity* entities, std::size_t entity_count,
+                                DrawCommandList& commands)
+    {
+      // Overlapping cars must be drawn in the same order as they always were, so within a level
+      // the entity order decides. Only consecutive cars that share their textures end up in one batch.
+      commands.clear();
+      for (std::uint32_t index = 0; index != entity_count; ++index)
+      {
+        const auto& entity = entities[index];
+
+        DrawKey key;
+        key.level = entity.level;
+        key.sequence = index;
+        key.texture = entity.texture->get();
+        commands.push(make_sort_key(key), index);
+      }
+
+      commands.sort();
+    }
+
+    void pack_car_instances(const DrawableEntity* entities, const DrawCommandList& commands,
+                            std::vector<CarInstance>& instances, std::vector<CarInstanceBatch>& batches)
+    {
+      instances.resize(commands.size());
+      batches.clear();
+
+      auto instance = instances.data();
+      for (const auto& command : commands)
+      {
+        const auto& entity = entities[command.index];
+        auto instance_index = static_cast<std::uint32_t>(instance - instances.data());
+
+        if (batches.empty() || batches.back().level != entity.level ||
+            batches.back().texture != entity.texture || batches.back().colorizer_texture != entity.colorizer_texture)
+        {
+          batches.push_back({ entity.level, entity.texture, entity.colorizer_texture, instance_index, 0 });
+        }
+
+        ++batches.back().instance_count;
+
+        instance->model_transform = detail::affine_rows(entity.model_transform);
+        instance->new_model_transform = detail::affine_rows(entity.new_model_transform);
+        instance->colorizer_transform = detail::affine_rows(entity.colorizer_transform);
+        instance->texture_coords_offset = entity.texture_coords_offset;
+        instance->texture_coords_scale = entity.texture_coords_scale;
+        instance->colors = entity.colors;
+        ++instance;
+      }
+    }
+  }
+}
@@ -0,0 +1,58 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include "drawable_entity.hpp"
+#include "render_commands.hpp"
+
+#include "utility/vector2.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace ts
+{
+  namespace graphics
+  {
+    class Texture;
+  }
+
+  namespace scene
+  {
+    // The per-instance data of the car shader, laid out exactly like the instance attributes.
+    // The transforms are stored as the top two rows of their 2D affine matrices.
+    struct CarInstance
+    {
+      std::array<float, 6> model_transform;
+      std::array<float, 6> new_model_transform;
+      std::array<float, 6> colorizer_transform;
+      Vector2f texture_coords_offset;
+      Vector2f texture_coords_scale;
+      std::array<float, 9> colors;
+    };
+
+    // A range of consecutive instances that can be drawn with a single instanced draw call.
+    struct CarInstanceBatch
+    {
+      std::uint32_t level;
+      const graphics::Texture* texture;
+      const graphics::Texture* colorizer_texture;
+      std::uint32_t instance_offset;
+      std::uint32_t instance_count;
+    };
+
+    // Records a draw command for every entity, ordered by level, and by entity index within a level.
+    void record_entity_commands(const DrawableEntity* entities, std::size_t entity_count,
+                                DrawCommandList& commands);
+
+    // Packs the entities into instances in command order, and splits them into batches that share
+    // their level and textures. This does not touch any GL state.
+    void pack_car_instances(const DrawableEntity* entities, const DrawCommandList& commands,
+                            std::vector<CarInstance>& instances, std::vector<CarInstanceBatch>& batches);
+  }
+}
@@ -9,6 +9,7 @@
 #include "dynamic_scene.hpp"
 
 #include "graphics/texture.hpp"
+#include "graphics/texture_compression.hpp"
 #include "graphics/image_loader.hpp"
 #include "graphics/image.hpp"
 
@@ -141,6 +142,13 @@ namespace ts
       auto atlas_size = std::min(graphics::max_texture_size(), 2048);
       utility::AtlasList atlas_list({ atlas_size, atlas_size });
 
+      // The car textures are block-compressed if possible, see create_compressed_texture.
+      if (graphics::block_compression_supported())
+      {
+        atlas_list.set_padding(graphics::block_extent);
+        atlas_list.set_alignment(graphics::block_extent);
+      }
+
       auto texture_atlas = detail::generate_car_model_atlas(stage_desc, atlas_list, image_loader);
 
       // Use a vector to map atlas entries to dynamic scene models.
@@ -188,7 +196,7 @@ namespace ts
       std::vector<std::size_t> texture_ids;
       for (const auto& image : atlas_images)
       {
-        auto texture = std::make_unique<graphics::Texture>(graphics::create_texture(image));
+        auto texture = std::make_unique<graphics::Texture>(graphics::create_compressed_texture(image));
         
         Vector2i image_size(image.getSize().x, image.getSize().y);
         auto texture_id = dynamic_scene.register_texture(std::move(texture), image_size);
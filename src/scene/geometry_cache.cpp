@@ -0,0 +1,389 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "geometry_cache.hpp"
+#include "track_scene.hpp"
+
+#include "resources/track.hpp"
+#include "resources/track_layer.hpp"
+#include "resources/tile_library.hpp"
+#include "resources/texture_library.hpp"
+
+#include "utility/sha256.hpp"
+#include "utility/stream_utilities.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace ts
+{
+  namespace scene
+  {
+    namespace detail
+    {
+      // Bump this whenever the file layout, or the way the geometry is generated, changes.
+      static const std::uint32_t geometry_cache_version = 3;
+      static const char geometry_cache_magic[4] = { 'T', 'S', 'G', 'C' };
+
+      static const std::uint32_t no_texture = 0xFFFFFFFF;
+
+      struct CachedSceneLayer
+      {
+        std::uint32_t layer_index;
+        std::uint32_t level_offset;
+        TrackSceneLayer::Type type;
+        std::uint32_t primary_texture;
+        std::uint32_t secondary_texture;
+        Vector2f primary_texture_tile_size;
+        Vector2f secondary_texture_tile_size;
+        float relative_border_width;
+
+        std::vector<TrackSceneLayer::vertex_type> vertices;
+        TrackSceneLayer::ComponentContainer components;
+      };
+    }
+
+    GeometryCacheKey compute_geometry_cache_key(const resources::Track& track, const AtlasCacheKey& atlas_key)
+    {
+      hash::SHA256 hasher;
+      auto add_value = [&](const auto& value)
+      {
+        hasher.add(&value, sizeof(value));
+      };
+
+      auto add_string = [&](const std::string& string)
+      {
+        add_value(static_cast<std::uint64_t>(string.size()));
+        hasher.add(string.data(), string.size());
+      };
+
+      auto add_vector = [&](Vector2f v)
+      {
+        add_value(v.x);
+        add_value(v.y);
+      };
+
+      add_value(detail::geometry_cache_version);
+      add_value(atlas_key);
+      add_value(track.size().x);
+      add_value(track.size().y);
+
+      // The atlas key covers the tile images, but not the tile's pattern rects, which determine their size.
+      for (const auto& tile : track.tile_library().tiles())
+      {
+        add_value(tile.id);
+        add_value(tile.pattern_rect.left);
+        add_value(tile.pattern_rect.top);
+        add_value(tile.pattern_rect.width);
+        add_value(tile.pattern_rect.height);
+      }
+
+      // Terrain texture coordinates depend on the textures' sizes.
+      for (const auto& texture : track.texture_library().textures())
+      {
+        boost::system::error_code error;
+        auto write_time = boost::filesystem::last_write_time(texture.file_name, error);
+        if (error) write_time = 0;
+
+        add_value(texture.id);
+        add_string(texture.file_name);
+        add_value(static_cast<std::int64_t>(write_time));
+      }
+
+      // Tile groups are expanded into their sub-tiles, so the group layouts determine the geometry too.
+      for (const auto& tile_group : track.tile_library().tile_groups())
+      {
+        add_value(tile_group.id);
+        add_value(static_cast<std::uint64_t>(tile_group.sub_tiles.size()));
+        for (const auto& sub_tile : tile_group.sub_tiles)
+        {
+          add_value(sub_tile.id);
+          add_value(sub_tile.position.x);
+          add_value(sub_tile.position.y);
+          add_value(sub_tile.rotation);
+          add_value(sub_tile.level);
+        }
+      }
+
+      for (const auto& layer : track.layers())
+      {
+        add_value(layer.type());
+        add_value(layer.level());
+
+        if (auto tiles = layer.tiles())
+        {
+          add_value(static_cast<std::uint64_t>(tiles->size()));
+          for (const auto& tile : *tiles)
+          {
+            add_value(tile.id);
+            add_value(tile.position.x);
+            add_value(tile.position.y);
+            add_value(tile.rotation);
+            add_value(tile.level);
+          }
+        }
+
+        else if (auto path_style = layer.path_style())
+        {
+          const auto& style = path_style->style;
+          add_value(style.base_texture);
+          add_value(style.border_texture);
+          add_value(style.is_segmented);
+          add_value(style.border_only);
+          add_value(style.fade_length);
+          add_value(style.width);
+          add_value(style.border_width);
+          add_vector(style.base_texture_tile_size);
+          add_vector(style.border_texture_tile_size);
+          add_value(style.texture_mode);
+
+          add_value(static_cast<std::uint64_t>(style.segments.size()));
+          for (const auto& segment : style.segments)
+          {
+            add_value(segment.sub_path_id);
+            add_value(segment.start_time_point);
+            add_value(segment.end_time_point);
+            add_value(segment.side);
+          }
+
+          if (path_style->path)
+          {
+            add_value(static_cast<std::uint64_t>(path_style->path->sub_paths.size()));
+            for (const auto& sub_path : path_style->path->sub_paths)
+            {
+              add_value(sub_path.closed);
+              add_value(static_cast<std::uint64_t>(sub_path.nodes.size()));
+              for (const auto& node : sub_path.nodes)
+              {
+                add_vector(node.first_control);
+                add_vector(node.position);
+                add_vector(node.second_control);
+                add_value(node.width);
+              }
+            }
+          }
+        }
+
+        else if (auto base_terrain = layer.base_terrain())
+        {
+          add_value(base_terrain->texture_id);
+          add_value(base_terrain->color);
+        }
+      }
+
+      return hasher();
+    }
+
+    std::string geometry_cache_file_name(const GeometryCacheKey& key)
+    {
+      return cache_file_name("geometry_", key);
+    }
+
+    bool load_geometry_cache(const std::string& file_name, const resources::Track& track, TrackScene& track_scene)
+    {
+      boost::system::error_code error;
+      if (!boost::filesystem::is_regular_file(file_name, error)) return false;
+
+      auto contents = load_file_contents(file_name);
+
+      BufferReader reader{ contents.data(), contents.data() + contents.size() };
+      auto magic = reader.read<std::array<char, 4>>();
+      auto version = reader.read<std::uint32_t>();
+      if (!reader.valid || version != detail::geometry_cache_version ||
+          !std::equal(magic.begin(), magic.end(), detail::geometry_cache_magic))
+      {
+        return false;
+      }
+
+      std::vector<const resources::TrackLayer*> track_layers;
+      for (const auto& layer : track.layers())
+      {
+        track_layers.push_back(&layer);
+      }
+
+      const auto& textures = track_scene.texture_mapping().textures();
+      bool textures_valid = true;
+      auto texture_at = [&](std::uint32_t index) -> const graphics::Texture*
+      {
+        if (index == detail::no_texture) return nullptr;
+
+        if (index >= textures.size())
+        {
+          textures_valid = false;
+          return nullptr;
+        }
+
+        return textures[index].get();
+      };
+
+      // Read everything before touching the track scene, so that a damaged file leaves it intact.
+      auto layer_count = reader.read<std::uint32_t>();
+
+      std::vector<detail::CachedSceneLayer> cached_layers;
+      for (std::uint32_t layer_id = 0; layer_id != layer_count && reader.valid && textures_valid; ++layer_id)
+      {
+        detail::CachedSceneLayer cached_layer;
+        cached_layer.layer_index = reader.read<std::uint32_t>();
+        cached_layer.level_offset = reader.read<std::uint32_t>();
+        cached_layer.type = static_cast<TrackSceneLayer::Type>(reader.read<std::uint32_t>());
+        cached_layer.primary_texture = reader.read<std::uint32_t>();
+        cached_layer.secondary_texture = reader.read<std::uint32_t>();
+        cached_layer.primary_texture_tile_size = reader.read<Vector2f>();
+        cached_layer.secondary_texture_tile_size = reader.read<Vector2f>();
+        cached_layer.relative_border_width = reader.read<float>();
+        if (cached_layer.layer_index >= track_layers.size()) return false;
+
+        auto vertex_count = reader.read<std::uint32_t>();
+        if (vertex_count > contents.size()) return false;
+
+        cached_layer.vertices.resize(vertex_count);
+        reader.read(cached_layer.vertices.data(), cached_layer.vertices.size());
+
+        auto region_count = reader.read<std::uint32_t>();
+        if (region_count > TrackSceneLayer::max_component_regions) return false;
+
+        cached_layer.components.resize(region_count);
+        for (auto& region : cached_layer.components)
+        {
+          auto component_count = reader.read<std::uint32_t>();
+          for (std::uint32_t i = 0; i != component_count && reader.valid; ++i)
+          {
+            TrackSceneLayer::Component component;
+            component.texture = texture_at(reader.read<std::uint32_t>());
+            component.bounding_box = reader.read<IntRect>();
+
+            auto face_count = reader.read<std::uint32_t>();
+            if (face_count > contents.size()) return false;
+
+            component.faces.resize(face_count);
+            reader.read(component.faces.data(), component.faces.size());
+
+            for (const auto& face : component.faces)
+            {
+              for (auto index : face.indices)
+              {
+                if (index >= vertex_count) return false;
+              }
+            }
+
+            region.push_back(std::move(component));
+          }
+        }
+
+        texture_at(cached_layer.primary_texture);
+        texture_at(cached_layer.secondary_texture);
+        cached_layers.push_back(std::move(cached_layer));
+      }
+
+      if (!reader.valid || !textures_valid) return false;
+
+      for (auto& cached_layer : cached_layers)
+      {
+        auto& scene_layer = track_scene.scene_layer(track_layers[cached_layer.layer_index], cached_layer.level_offset);
+        scene_layer.set_type(cached_layer.type);
+        scene_layer.set_primary_texture(texture_at(cached_layer.primary_texture));
+        scene_layer.set_secondary_texture(texture_at(cached_layer.secondary_texture));
+        scene_layer.set_primary_texture_tile_size(cached_layer.primary_texture_tile_size);
+        scene_layer.set_secondary_texture_tile_size(cached_layer.secondary_texture_tile_size);
+        scene_layer.set_path_relative_border_width(cached_layer.relative_border_width);
+        scene_layer.assign_geometry(std::move(cached_layer.vertices), std::move(cached_layer.components));
+      }
+
+      touch_cache_file(file_name);
+      return true;
+    }
+
+    void save_geometry_cache(const std::string& file_name, const resources::Track& track,
+                             const TrackScene& track_scene)
+    {
+      std::unordered_map<const resources::TrackLayer*, std::uint32_t> layer_indices;
+      for (const auto& layer : track.layers())
+      {
+        auto index = static_cast<std::uint32_t>(layer_indices.size());
+        layer_indices.insert(std::make_pair(&layer, index));
+      }
+
+      std::unordered_map<const graphics::Texture*, std::uint32_t> texture_indices;
+      for (const auto& texture : track_scene.texture_mapping().textures())
+      {
+        auto index = static_cast<std::uint32_t>(texture_indices.size());
+        texture_indices.insert(std::make_pair(texture.get(), index));
+      }
+
+      auto texture_index = [&](const graphics::Texture* texture)
+      {
+        if (!texture) return detail::no_texture;
+
+        auto it = texture_indices.find(texture);
+        if (it == texture_indices.end())
+        {
+          throw std::runtime_error("track scene refers to a texture that is not part of its texture mapping");
+        }
+
+        return it->second;
+      };
+
+      boost::filesystem::path path(file_name);
+      boost::filesystem::path temp_path(cache_temp_file_name(file_name));
+
+      if (path.has_parent_path())
+      {
+        boost::filesystem::create_directories(path.parent_path());
+      }
+
+      {
+        auto stream = make_ofstream(temp_path.string());
+        if (!stream) throw std::runtime_error("failed to open geometry cache file '" + temp_path.string() + "'");
+
+        auto scene_layers = track_scene.layers();
+        stream.write(detail::geometry_cache_magic, sizeof(detail::geometry_cache_magic));
+        write_value(stream, detail::geometry_cache_version);
+        write_value(stream, static_cast<std::uint32_t>(scene_layers.size()));
+
+        for (const auto& scene_layer : scene_layers)
+        {
+          auto associated_layer = scene_layer.associated_layer();
+
+          write_value(stream, layer_indices.at(associated_layer));
+          write_value(stream, scene_layer.level() - associated_layer->level());
+          write_value(stream, static_cast<std::uint32_t>(scene_layer.type()));
+          write_value(stream, texture_index(scene_layer.primary_texture()));
+          write_value(stream, texture_index(scene_layer.secondary_texture()));
+          write_value(stream, scene_layer.primary_texture_tile_size());
+          write_value(stream, scene_layer.secondary_texture_tile_size());
+          write_value(stream, scene_layer.path_relative_border_width());
+
+          const auto& vertices = scene_layer.vertices();
+          write_value(stream, static_cast<std::uint32_t>(vertices.size()));
+          write_values(stream, vertices.data(), vertices.size());
+
+          const auto& regions = scene_layer.component_regions();
+          assert(regions.size() <= TrackSceneLayer::max_component_regions);
+          write_value(stream, static_cast<std::uint32_t>(regions.size()));
+          for (const auto& region : regions)
+          {
+            write_value(stream, static_cast<std::uint32_t>(region.size()));
+            for (const auto& component : region)
+            {
+              write_value(stream, texture_index(component.texture));
+              write_value(stream, component.bounding_box);
+              write_value(stream, static_cast<std::uint32_t>(component.faces.size()));
+              write_values(stream, component.faces.data(), component.faces.size());
+            }
+          }
+        }
+
+        if (!stream) throw std::runtime_error("failed to write geometry cache file '" + temp_path.string() + "'");
+      }
+
+      boost::filesystem::rename(temp_path, path);
+    }
+  }
+}
@@ -0,0 +1,43 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include "atlas_cache.hpp"
+
+#include <string>
+
+namespace ts
+{
+  namespace resources
+  {
+    class Track;
+  }
+
+  namespace scene
+  {
+    class TrackScene;
+
+    // The geometry cache stores the vertices, faces and component regions of every layer of a
+    // track scene, so that tile expansion and path tessellation can be skipped on the next load.
+    // Textures are stored by their index in the scene's texture mapping, which is why the key
+    // includes the atlas cache key in addition to a hash of the track's layers.
+    using GeometryCacheKey = AtlasCacheKey;
+
+    GeometryCacheKey compute_geometry_cache_key(const resources::Track& track, const AtlasCacheKey& atlas_key);
+
+    std::string geometry_cache_file_name(const GeometryCacheKey& key);
+
+    // Loads the geometry into a track scene that has no layers yet, the texture mapping must be
+    // complete at this point. Returns false if the file does not exist or is not a valid cache file,
+    // in which case the track scene is left untouched.
+    bool load_geometry_cache(const std::string& file_name, const resources::Track& track, TrackScene& track_scene);
+
+    // Throws std::runtime_error on failure. Like the atlas cache, this goes through a temporary file.
+    void save_geometry_cache(const std::string& file_name, const resources::Track& track,
+                             const TrackScene& track_scene);
+  }
+}
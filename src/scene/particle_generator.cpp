@@ -14,6 +14,7 @@
 
 #include "utility/random.hpp"
 #include "utility/transform.hpp"
+#include "utility/stats.hpp"
 
 #include <algorithm>
 
@@ -21,42 +22,49 @@ namespace ts
 {
   namespace scene
   {
-    ParticleGenerator::ParticleGenerator(const world::World* world_ptr, const ParticleSettings& settings)
-      : world_(world_ptr),
-      settings_(settings)
+    void ParticleEmitters::clear()
     {
-      auto num_levels = world_ptr->track().height_level_count();
-      particle_info_.resize(settings.max_particles * num_levels);
-      level_info_.resize(num_levels);
+      positions.clear();
+      levels.clear();
+      speeds.clear();
+      slide_ratios.clear();
+      terrain_roughness.clear();
+      terrain_colors.clear();
+    }
 
-      std::uint32_t index = 0;
-      for (auto& level_info : level_info_)
-      {
-        level_info.index = 0;
-        level_info.count = 0;
-        level_info.base_index = index;
-        index += settings.max_particles;
-      }
+    void ParticleEmitters::push_back(Vector2f position, std::uint32_t level, float speed, float slide_ratio,
+                                     float roughness, Colorb terrain_color)
+    {
+      positions.push_back(position);
+      levels.push_back(level);
+      speeds.push_back(speed);
+      slide_ratios.push_back(slide_ratio);
+      terrain_roughness.push_back(roughness);
+      terrain_colors.push_back(terrain_color);
     }
 
-    std::uint32_t ParticleGenerator::level_count() const
+    std::size_t ParticleEmitters::size() const
     {
-      return static_cast<std::uint32_t>(level_info_.size());
+      return positions.size();
     }
 
-    std::uint32_t ParticleGenerator::particle_count(std::uint32_t level) const
+    ParticleGenerator::ParticleGenerator(const world::World* world_ptr, const ParticleSettings& settings)
+      : ParticleGenerator(world_ptr->track().height_level_count(), settings)
     {
-      return level_info_[level].count;
+      world_ = world_ptr;
     }
 
-    std::uint32_t ParticleGenerator::particle_start_index(std::uint32_t level) const
+    ParticleGenerator::ParticleGenerator(std::uint32_t level_count, const ParticleSettings& settings)
+      : settings_(settings),
+        spawn_rings_(level_count, ParticleSpawnRing(settings.max_particles)),
+        seed_counter_(utility::random_integer<std::uint32_t>()),
+        random_engine_(utility::random_integer<std::uint64_t>())
     {
-      return level_info_[level].index;
     }
 
-    const ParticleGenerator::ParticleInfo* ParticleGenerator::particle_info(std::uint32_t level) const
+    std::uint32_t ParticleGenerator::level_count() const
     {
-      return particle_info_.data() + level_info_[level].base_index;
+      return static_cast<std::uint32_t>(spawn_rings_.size());
     }
 
     std::uint32_t ParticleGenerator::max_particles_per_level() const
@@ -64,124 +72,119 @@ namespace ts
       return settings_.max_particles;
     }
 
-    void ParticleGenerator::add_particle(LevelInfo& level_info, const ParticleInfo& particle_info)
+    const ParticleSpawnRing& ParticleGenerator::spawn_ring(std::uint32_t level) const
     {
-      auto idx = level_info.index + level_info.count;
-      if (idx >= max_particles_per_level())
-      {
-        idx -= max_particles_per_level();
-      }
+      return spawn_rings_[level];
+    }
 
-      particle_info_[idx] = particle_info;
-      ++level_info.count;
+    const ParticleSettings& ParticleGenerator::settings() const
+    {
+      return settings_;
     }
 
-    void ParticleGenerator::update(std::uint32_t frame_duration)
+    std::uint32_t ParticleGenerator::tick_counter() const
     {
-      const auto fd = frame_duration * 0.001;
-      tick_counter_ += frame_duration;      
+      return tick_counter_;
+    }
 
-      for (auto& level_info : level_info_)
+    void ParticleGenerator::update(std::uint32_t frame_duration)
+    {
+      emitters_.clear();
+      if (world_)
       {
-        auto level_start = particle_info_.begin() + level_info.base_index;
-
-        // Remove the "expired" particles   
-        auto& idx = level_info.index;
-        auto& count = level_info.count;
-        while (count != 0 && tick_counter_ >= level_start[idx].end_ticks)
+        for (const auto& car : world_->cars())
         {
-          ++idx;
-          --count;
-
-          if (idx == max_particles_per_level()) idx = 0;          
-        }       
+          for (const auto& ws : car.handling_state().wheel_states)
+          {
+            emitters_.push_back(vector2_cast<float>(ws.pos), car.z_level(), static_cast<float>(ws.speed),
+                                static_cast<float>(ws.slide_ratio), static_cast<float>(ws.terrain_roughness),
+                                ws.terrain_color);
+          }
+        }
       }
 
-      std::uniform_real_distribution<double> chance_dist(0.0, 10.0);
-      std::uniform_real_distribution<double> position_dist(-settings_.position_variance, settings_.position_variance);
-      std::uniform_real_distribution<double> color_dist(-settings_.color_variance * 0.5, 
-                                                        settings_.color_variance * 0.5);
-      std::uniform_real_distribution<double> size_dist(settings_.min_size, settings_.max_size);
-      std::uniform_real_distribution<double> smoke_size_dist(settings_.min_smoke_size, settings_.max_smoke_size);
-
-      const auto max_particles = max_particles_per_level();
-      using utility::random_number;
-
-      auto generate_position = [=](auto car_position)
-      {
-        auto offset = make_vector2(random_number(position_dist), random_number(position_dist)) * 0.5;
-        return vector2_cast<float>(car_position + offset);        
-      };
+      update(frame_duration, emitters_);
+    }
 
-      auto generate_radius = [=]()
-      {
-        return static_cast<float>(random_number(size_dist) * 0.5);
-      };
+    void ParticleGenerator::update(std::uint32_t frame_duration, const ParticleEmitters& emitters)
+    {
+      const auto fd = frame_duration * 0.001f;
+      tick_counter_ += frame_duration;      
 
-      auto generate_smoke_radius = [=]()
+      // Remove the "expired" particles   
+      for (auto& spawn_ring : spawn_rings_)
       {
-        return static_cast<float>(random_number(smoke_size_dist) * 0.5);
-      };
+        spawn_ring.expire(tick_counter_, settings_.display_time);
+      }
 
-      auto generate_color = [=](auto base_color)
-      {
-        auto color = base_color;
-        auto color_variance = std::max(std::min(random_number(color_dist), 1.0), -1.0);
-
-        color.r += static_cast<int>(color.r * color_variance);
-        color.g += static_cast<int>(color.g * color_variance);
-        color.b += static_cast<int>(color.b * color_variance);
-        color.a = 255;
-        return color;
-      };
-
-      // Loop through all cars
-      for (const auto& car : world_->cars())
+      // The probability of spawning a particle is positively affected by car speed, frame duration and
+      // terrain roughness, or the slide ratio if the wheel is producing smoke instead.
+      // This loop is kept free of branches and function calls so that the compiler can vectorize it.
+      const auto emitter_count = emitters.size();
+      spawn_chances_.resize(emitter_count);
+
+      const auto chance_factor = static_cast<float>(settings_.chance_factor * 0.1);
+      const auto smoke_chance_factor = static_cast<float>(settings_.smoke_chance_factor * 0.1);
+      const auto max_effect_speed = static_cast<float>(settings_.max_effect_speed);
+      const auto* speeds = emitters.speeds.data();
+      const auto* slide_ratios = emitters.slide_ratios.data();
+      const auto* roughness = emitters.terrain_roughness.data();
+      auto* spawn_chances = spawn_chances_.data();
+
+      for (std::size_t i = 0; i < emitter_count; ++i)
       {
-        auto level = car.z_level();
-        auto& level_info = level_info_[level];
-        const auto& handling_state = car.handling_state();
+        auto speed_factor = std::min(max_effect_speed, speeds[i]) * fd;
+        auto smoke = roughness[i] < 0.001f;
+        auto chance = smoke ?
+          smoke_chance_factor * speed_factor * slide_ratios[i] :
+          chance_factor * speed_factor * std::min(roughness[i], 1.0f);
 
-        for (const auto& ws : handling_state.wheel_states)
-        {          
-          if (ws.terrain_roughness < 0.001 && ws.slide_ratio < 0.1) continue;
-
-          bool smoke = ws.terrain_roughness < 0.001;
-          auto speed = std::min(settings_.max_effect_speed, ws.speed);
+        spawn_chances[i] = (smoke && slide_ratios[i] < 0.1f) ? 0.0f : chance;
+      }
 
-          // If we roll a number below the "chance factor", add a new particle.
-          // The probability of success is positively affected by car speed, frame duration and terrain roughness.
+      // The position, size and color variance are applied by the particle shader.
+      const auto min_radius = static_cast<float>(settings_.min_size * 0.5);
+      const auto max_radius = static_cast<float>(settings_.max_size * 0.5);
+      const auto min_smoke_radius = static_cast<float>(settings_.min_smoke_size * 0.5);
+      const auto max_smoke_radius = static_cast<float>(settings_.max_smoke_size * 0.5);
 
-          
+      for (std::size_t i = 0; i < emitter_count; ++i)
+      {
+        // If we roll a number below the chance, add a new particle.
+        if (spawn_chances[i] <= 0.0f || random_engine_.next_float() >= spawn_chances[i]) continue;
 
-          auto chance_factor = !smoke ?
-            settings_.chance_factor * speed * fd * std::min(ws.terrain_roughness, 1.0) :
-            settings_.smoke_chance_factor * speed * fd * ws.slide_ratio;
+        auto level = emitters.levels[i];
+        if (level >= spawn_rings_.size()) continue;
 
-          double roll = random_number(chance_dist);
+        auto& spawn_ring = spawn_rings_[level];
+        if (spawn_ring.full()) continue;
 
-          Colorb base_color = { 150, 150, 150, 100 }; // Smoke color
-          if (!smoke)
-          {
-            base_color = ws.terrain_color;
-            base_color.r = (base_color.r * 225) >> 8;
-            base_color.g = (base_color.g * 225) >> 8;
-            base_color.b = (base_color.b * 225) >> 8;
-            base_color.a = 255;
-          }
+        bool smoke = roughness[i] < 0.001f;
 
-          for (; roll < chance_factor && level_info.count < max_particles; roll += chance_factor)
-          {
-            ParticleInfo info;
-            info.position = generate_position(ws.pos);
-            info.radius = smoke ? generate_smoke_radius() : generate_radius();
-            info.color = generate_color(base_color);
-            info.end_ticks = tick_counter_ + settings_.display_time;
+        ParticleSpawnRecord record;
+        record.position = emitters.positions[i];
+        record.min_radius = smoke ? min_smoke_radius : min_radius;
+        record.max_radius = smoke ? max_smoke_radius : max_radius;
+        record.color = { 150, 150, 150, 100 }; // Smoke color
+        record.seed = seed_counter_++;
+        record.spawn_ticks = tick_counter_;
 
-            add_particle(level_info, info);
-          }
+        if (!smoke)
+        {
+          record.color = emitters.terrain_colors[i];
+          record.color.r = (record.color.r * 225) >> 8;
+          record.color.g = (record.color.g * 225) >> 8;
+          record.color.b = (record.color.b * 225) >> 8;
+          record.color.a = 255;
         }
+
+        spawn_ring.push(record);
       }
+
+      static const stats::Gauge particles_alive("scene.particles_alive");
+      std::int64_t particle_count = 0;
+      for (const auto& ring : spawn_rings_) particle_count += ring.size();
+      particles_alive.set(particle_count);
     }
   }
-}
\ No newline at end of file
+}
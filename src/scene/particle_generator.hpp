@@ -6,7 +6,10 @@
 
 #pragma once
 
+#include "particle_stream.hpp"
+
 #include "utility/vertex.hpp"
+#include "utility/random.hpp"
 
 #include <vector>
 
@@ -31,51 +34,64 @@ namespace ts
       double position_variance = 3.0;
       double color_variance = 0.4;
       std::uint32_t display_time = 400;      
-      std::uint32_t max_particles = 1024;
+      std::uint32_t max_particles = 16384;
+    };
+
+    // The wheels that may emit particles in a frame, as a struct of arrays, so that the spawn
+    // chances of all wheels can be computed in a single, vectorizable loop.
+    struct ParticleEmitters
+    {
+      void clear();
+      void push_back(Vector2f position, std::uint32_t level, float speed, float slide_ratio,
+                     float terrain_roughness, Colorb terrain_color);
+
+      std::size_t size() const;
+
+      std::vector<Vector2f> positions;
+      std::vector<std::uint32_t> levels;
+      std::vector<float> speeds;
+      std::vector<float> slide_ratios;
+      std::vector<float> terrain_roughness;
+      std::vector<Colorb> terrain_colors;
     };
 
     // The particle generator class generates particles for all cars in the game world,
     // if certain criteria are met. On rough terrains, particles will be shown, 
     // otherwise if the car is sliding, smoke will be shown. The particle's properties are
     // affected by the settings as they were passed to the constructor.
+    // Particles are only stored as spawn records, the work per update is proportional to the number
+    // of particles that are spawned or expire, not to the number of live particles.
     class ParticleGenerator
     {
     public:
       explicit ParticleGenerator(const world::World* world, const ParticleSettings& particle_settings);
 
+      // Creates a generator that isn't attached to a world, particles can only be spawned
+      // by passing the emitters to update() explicitly.
+      explicit ParticleGenerator(std::uint32_t level_count, const ParticleSettings& particle_settings);
+
+      // Gathers the emitters from the world's cars, and spawns particles for them.
       void update(std::uint32_t frame_duration);
+      void update(std::uint32_t frame_duration, const ParticleEmitters& emitters);
 
       std::uint32_t level_count() const;
       std::uint32_t max_particles_per_level() const;      
 
-      struct ParticleInfo
-      {
-        Vector2f position;
-        float radius;
-        Colorb color;
-        std::uint32_t end_ticks;
-      };
-
-      const ParticleInfo* particle_info(std::uint32_t level) const;
-      std::uint32_t particle_count(std::uint32_t level) const;
-      std::uint32_t particle_start_index(std::uint32_t level) const;
+      const ParticleSpawnRing& spawn_ring(std::uint32_t level) const;
+      const ParticleSettings& settings() const;
+      std::uint32_t tick_counter() const;
 
     private:
-      struct LevelInfo
-      {
-        std::uint32_t base_index;
-        std::uint32_t index;
-        std::uint32_t count;
-      };
-
-      void add_particle(LevelInfo& level_info, const ParticleInfo& particle_info);
-
-      const world::World* world_;
+      const world::World* world_ = nullptr;
       ParticleSettings settings_;
 
-      std::vector<ParticleInfo> particle_info_;
-      std::vector<LevelInfo> level_info_;
+      std::vector<ParticleSpawnRing> spawn_rings_;
       std::uint32_t tick_counter_ = 0;   
+      std::uint32_t seed_counter_ = 0;
+
+      utility::Pcg32 random_engine_;
+      ParticleEmitters emitters_;
+      std::vector<float> spawn_chances_;
     };
   }
 }
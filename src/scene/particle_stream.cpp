@@ -0,0 +1,142 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "particle_stream.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace ts
+{
+  namespace scene
+  {
+    RingRanges split_ring_range(std::uint64_t first, std::uint64_t last, std::uint32_t capacity)
+    {
+      RingRanges result;
+      if (first >= last || capacity == 0) return result;
+
+      if (last - first > capacity)
+      {
+        throw std::out_of_range("ring range exceeds the capacity of the ring");
+      }
+
+      auto offset = static_cast<std::uint32_t>(first % capacity);
+      auto count = static_cast<std::uint32_t>(last - first);
+      auto first_count = std::min(count, capacity - offset);
+
+      result.push_back({ offset, first_count });
+      if (first_count != count)
+      {
+        result.push_back({ 0, count - first_count });
+      }
+
+      return result;
+    }
+
+    ParticleSpawnRing::ParticleSpawnRing(std::uint32_t capacity)
+      : capacity_(capacity),
+        positions_(capacity),
+        radius_ranges_(capacity),
+        colors_(capacity),
+        seeds_(capacity),
+        spawn_ticks_(capacity)
+    {
+    }
+
+    void ParticleSpawnRing::push(const ParticleSpawnRecord& record)
+    {
+      if (capacity_ == 0) return;
+
+      if (full()) ++begin_sequence_;
+
+      auto index = end_sequence_ % capacity_;
+      positions_[index] = record.position;
+      radius_ranges_[index] = { record.min_radius, record.max_radius };
+      colors_[index] = record.color;
+      seeds_[index] = record.seed;
+      spawn_ticks_[index] = record.spawn_ticks;
+      ++end_sequence_;
+    }
+
+    void ParticleSpawnRing::expire(std::uint32_t current_ticks, std::uint32_t lifetime)
+    {
+      while (begin_sequence_ != end_sequence_ &&
+             current_ticks - spawn_ticks_[begin_sequence_ % capacity_] >= lifetime)
+      {
+        ++begin_sequence_;
+      }
+    }
+
+    void ParticleSpawnRing::clear()
+    {
+      begin_sequence_ = end_sequence_;
+    }
+
+    std::uint32_t ParticleSpawnRing::capacity() const
+    {
+      return capacity_;
+    }
+
+    std::uint32_t ParticleSpawnRing::size() const
+    {
+      return static_cast<std::uint32_t>(end_sequence_ - begin_sequence_);
+    }
+
+    bool ParticleSpawnRing::full() const
+    {
+      return size() == capacity();
+    }
+
+    std::uint64_t ParticleSpawnRing::begin_sequence() const
+    {
+      return begin_sequence_;
+    }
+
+    std::uint64_t ParticleSpawnRing::end_sequence() const
+    {
+      return end_sequence_;
+    }
+
+    ParticleSpawnRecord ParticleSpawnRing::record(std::uint64_t sequence) const
+    {
+      auto index = sequence % capacity_;
+
+      ParticleSpawnRecord result;
+      result.position = positions_[index];
+      result.min_radius = radius_ranges_[index].x;
+      result.max_radius = radius_ranges_[index].y;
+      result.color = colors_[index];
+      result.seed = seeds_[index];
+      result.spawn_ticks = spawn_ticks_[index];
+      return result;
+    }
+
+    const Vector2f* ParticleSpawnRing::positions() const
+    {
+      return positions_.data();
+    }
+
+    const Vector2f* ParticleSpawnRing::radius_ranges() const
+    {
+      return radius_ranges_.data();
+    }
+
+    const Colorb* ParticleSpawnRing::colors() const
+    {
+      return colors_.data();
+    }
+
+    const std::uint32_t* ParticleSpawnRing::seeds() const
+    {
+      return seeds_.data();
+    }
+
+    const std::uint32_t* ParticleSpawnRing::spawn_ticks() const
+    {
+      return spawn_ticks_.data();
+    }
+  }
+}
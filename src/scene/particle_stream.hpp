@@ -0,0 +1,92 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include "utility/vector2.hpp"
+#include "utility/color.hpp"
+
+#include <boost/container/static_vector.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace ts
+{
+  namespace scene
+  {
+    // A particle as it was spawned. Everything else about the particle, that is its exact position,
+    // size, color and opacity over time, is derived from the seed and its age in the particle shader.
+    struct ParticleSpawnRecord
+    {
+      Vector2f position;
+      float min_radius;
+      float max_radius;
+      Colorb color;
+      std::uint32_t seed;
+      std::uint32_t spawn_ticks;
+    };
+
+    struct RingRange
+    {
+      std::uint32_t offset;
+      std::uint32_t count;
+    };
+
+    using RingRanges = boost::container::static_vector<RingRange, 2>;
+
+    // Splits the sequence numbers [first, last) of a ring buffer with the given capacity into
+    // contiguous ranges of storage. last - first must not exceed the capacity.
+    RingRanges split_ring_range(std::uint64_t first, std::uint64_t last, std::uint32_t capacity);
+
+    // ParticleSpawnRing is a fixed-capacity ring buffer of spawn records, ordered by spawn time.
+    // Every record gets a sequence number that keeps counting up, which allows consumers such
+    // as the renderer to keep track of the records they have already seen.
+    // The records are stored as a struct of arrays, so that expiring them only touches the spawn times,
+    // and so that every field can be uploaded as a tightly packed vertex attribute.
+    class ParticleSpawnRing
+    {
+    public:
+      explicit ParticleSpawnRing(std::uint32_t capacity = 0);
+
+      // Overwrites the oldest record if the ring is full.
+      void push(const ParticleSpawnRecord& record);
+
+      // Drops the records that have been alive for at least the given lifetime.
+      void expire(std::uint32_t current_ticks, std::uint32_t lifetime);
+      void clear();
+
+      std::uint32_t capacity() const;
+      std::uint32_t size() const;
+      bool full() const;
+
+      // The sequence number of the oldest live record, and one past the newest one.
+      std::uint64_t begin_sequence() const;
+      std::uint64_t end_sequence() const;
+
+      ParticleSpawnRecord record(std::uint64_t sequence) const;
+
+      // The storage of the individual fields, indexed by sequence number modulo capacity.
+      // Radius ranges are stored as (min_radius, max_radius) pairs.
+      const Vector2f* positions() const;
+      const Vector2f* radius_ranges() const;
+      const Colorb* colors() const;
+      const std::uint32_t* seeds() const;
+      const std::uint32_t* spawn_ticks() const;
+
+    private:
+      std::uint32_t capacity_ = 0;
+      std::vector<Vector2f> positions_;
+      std::vector<Vector2f> radius_ranges_;
+      std::vector<Colorb> colors_;
+      std::vector<std::uint32_t> seeds_;
+      std::vector<std::uint32_t> spawn_ticks_;
+
+      std::uint64_t begin_sequence_ = 0;
+      std::uint64_t end_sequence_ = 0;
+    };
+  }
+}
@@ -0,0 +1,392 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "path_flattening.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace ts
+{
+  namespace scene
+  {
+    namespace detail
+    {
+      static const std::uint32_t max_flattened_segment_count = 256;
+
+      // The curve's point and derivative as polynomials in the index of the segment, relative to the
+      // curve's start point to keep the magnitudes small. With t = t1 + h * i:
+      // point(i) = d + i * (c + i * (b + i * a)), derivative(i) = e + i * (f + i * g).
+      struct CurvePolynomial
+      {
+        Vector2f origin;
+        Vector2f a, b, c, d;
+        Vector2f e, f, g;
+        float start_width, width_step;
+        float start_time, time_step;
+        float half_width_factor;
+        float normal_sign;
+      };
+
+      static CurvePolynomial make_curve_polynomial(const resources::TrackPathNode& node_a,
+                                                   const resources::TrackPathNode& node_b,
+                                                   float t1, float t2, float base_t, std::uint32_t segment_count,
+                                                   const OutlineProperties& properties)
+      {
+        auto origin = node_a.position;
+        auto p1 = node_a.second_control - origin;
+        auto p2 = node_b.first_control - origin;
+        auto p3 = node_b.position - origin;
+
+        // Power basis of the curve in t, the constant term is zero.
+        auto c1 = 3.0f * p1;
+        auto c2 = 3.0f * (p2 - 2.0f * p1);
+        auto c3 = p3 + 3.0f * (p1 - p2);
+
+        auto h = (t2 - t1) / static_cast<float>(segment_count);
+        auto hh = h * h;
+
+        CurvePolynomial result;
+        result.origin = origin;
+        result.a = c3 * (hh * h);
+        result.b = (c2 + 3.0f * t1 * c3) * hh;
+        result.c = (c1 + 2.0f * t1 * c2 + 3.0f * t1 * t1 * c3) * h;
+        result.d = t1 * (c1 + t1 * (c2 + t1 * c3));
+
+        result.e = c1 + 2.0f * t1 * c2 + 3.0f * t1 * t1 * c3;
+        result.f = (2.0f * c2 + 6.0f * t1 * c3) * h;
+        result.g = 3.0f * hh * c3;
+
+        result.start_width = resources::path_width_at(node_a, node_b, t1) + properties.width;
+        result.width_step = (node_b.width - node_a.width) * h;
+        result.start_time = base_t + t1;
+        result.time_step = h;
+        result.half_width_factor = properties.center_line ? 0.0f : 0.5f;
+        result.normal_sign = properties.invert_normal ? -1.0f : 1.0f;
+        return result;
+      }
+
+      // Turns the point and derivative into an outline point, the same way outline_point_at() does.
+      static OutlinePoint make_outline_point(const CurvePolynomial& poly, float index,
+                                             Vector2f point, Vector2f derivative)
+      {
+        auto length = magnitude(derivative);
+        auto inv_length = length == 0.0f ? 0.0f : 1.0f / length;
+        auto normal = make_vector2(-derivative.y, derivative.x) * (inv_length * poly.normal_sign);
+        auto width = poly.start_width + poly.width_step * index;
+
+        return
+        {
+          poly.start_time + poly.time_step * index,
+          poly.origin + point + normal * (width * poly.half_width_factor),
+          normal, width
+        };
+      }
+
+      static void flatten_curve_scalar(const CurvePolynomial& poly, std::uint32_t begin, std::uint32_t end,
+                                       OutlinePoint* outline_points)
+      {
+        for (auto index = begin; index != end; ++index)
+        {
+          auto i = static_cast<float>(index);
+          auto point = poly.d + i * (poly.c + i * (poly.b + i * poly.a));
+          auto derivative = poly.e + i * (poly.f + i * poly.g);
+
+          outline_points[index] = make_outline_point(poly, i, point, derivative);
+        }
+      }
+
+#if defined(__AVX2__)
+      // Forward differencing of a cubic, eight segments at a time. Every lane starts at its own index,
+      // and all lanes advance by eight segments per step.
+      struct CubicDifferences
+      {
+        __m256 value, first, second, third;
+      };
+
+      struct QuadraticDifferences
+      {
+        __m256 value, first, second;
+      };
+
+      static CubicDifferences make_cubic_differences(float a, float b, float c, float d, __m256 i)
+      {
+        const float s = 8.0f;
+        auto va = _mm256_set1_ps(a), vb = _mm256_set1_ps(b), vc = _mm256_set1_ps(c);
+        auto ii = _mm256_mul_ps(i, i);
+
+        // d + i * (c + i * (b + i * a))
+        CubicDifferences result;
+        result.value = _mm256_add_ps(_mm256_set1_ps(d),
+                                     _mm256_mul_ps(i, _mm256_add_ps(vc, _mm256_mul_ps(i, _mm256_add_ps(vb, _mm256_mul_ps(i, va))))));
+
+        // a * (3 i^2 s + 3 i s^2 + s^3) + b * (2 i s + s^2) + c * s
+        auto first_a = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ii, _mm256_set1_ps(3.0f * s)),
+                                                   _mm256_mul_ps(i, _mm256_set1_ps(3.0f * s * s))),
+                                     _mm256_set1_ps(s * s * s));
+        auto first_b = _mm256_add_ps(_mm256_mul_ps(i, _mm256_set1_ps(2.0f * s)), _mm256_set1_ps(s * s));
+        result.first = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(va, first_a), _mm256_mul_ps(vb, first_b)),
+                                     _mm256_set1_ps(c * s));
+
+        // a * (6 i s^2 + 6 s^3) + 2 b s^2
+        auto second_a = _mm256_add_ps(_mm256_mul_ps(i, _mm256_set1_ps(6.0f * s * s)), _mm256_set1_ps(6.0f * s * s * s));
+        result.second = _mm256_add_ps(_mm256_mul_ps(va, second_a), _mm256_set1_ps(2.0f * b * s * s));
+
+        result.third = _mm256_set1_ps(6.0f * a * s * s * s);
+        return result;
+      }
+
+      static QuadraticDifferences make_quadratic_differences(float e, float f, float g, __m256 i)
+      {
+        const float s = 8.0f;
+        auto vf = _mm256_set1_ps(f), vg = _mm256_set1_ps(g);
+
+        // e + i * (f + i * g)
+        QuadraticDifferences result;
+        result.value = _mm256_add_ps(_mm256_set1_ps(e), _mm256_mul_ps(i, _mm256_add_ps(vf, _mm256_mul_ps(i, vg))));
+
+        // f * s + g * (2 i s + s^2)
+        result.first = _mm256_add_ps(_mm256_set1_ps(f * s),
+                                     _mm256_mul_ps(vg, _mm256_add_ps(_mm256_mul_ps(i, _mm256_set1_ps(2.0f * s)),
+                                                                     _mm256_set1_ps(s * s))));
+        result.second = _mm256_set1_ps(2.0f * g * s * s);
+        return result;
+      }
+
+      static void advance(CubicDifferences& differences)
+      {
+        differences.value = _mm256_add_ps(differences.value, differences.first);
+        differences.first = _mm256_add_ps(differences.first, differences.second);
+        differences.second = _mm256_add_ps(differences.second, differences.third);
+      }
+
+      static void advance(QuadraticDifferences& differences)
+      {
+        differences.value = _mm256_add_ps(differences.value, differences.first);
+        differences.first = _mm256_add_ps(differences.first, differences.second);
+      }
+
+      // Processes the segments in groups of eight, and returns the number of segments that were processed.
+      static std::uint32_t flatten_curve_avx2(const CurvePolynomial& poly, std::uint32_t segment_count,
+                                              OutlinePoint* outline_points)
+      {
+        auto group_end = segment_count - segment_count % 8;
+        if (group_end == 0) return 0;
+
+        auto index = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+        auto point_x = make_cubic_differences(poly.a.x, poly.b.x, poly.c.x, poly.d.x, index);
+        auto point_y = make_cubic_differences(poly.a.y, poly.b.y, poly.c.y, poly.d.y, index);
+        auto derivative_x = make_quadratic_differences(poly.e.x, poly.f.x, poly.g.x, index);
+        auto derivative_y = make_quadratic_differences(poly.e.y, poly.f.y, poly.g.y, index);
+
+        auto origin_x = _mm256_set1_ps(poly.origin.x), origin_y = _mm256_set1_ps(poly.origin.y);
+        auto start_width = _mm256_set1_ps(poly.start_width), width_step = _mm256_set1_ps(poly.width_step);
+        auto start_time = _mm256_set1_ps(poly.start_time), time_step = _mm256_set1_ps(poly.time_step);
+        auto half_width_factor = _mm256_set1_ps(poly.half_width_factor);
+        auto normal_sign = _mm256_set1_ps(poly.normal_sign);
+        auto zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), eight = _mm256_set1_ps(8.0f);
+
+        alignas(32) float time_points[8], xs[8], ys[8], normal_xs[8], normal_ys[8], widths[8];
+        for (std::uint32_t group = 0; group != group_end; group += 8)
+        {
+          auto dx = derivative_x.value, dy = derivative_y.value;
+          auto length_squared = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+          auto is_zero = _mm256_cmp_ps(length_squared, zero, _CMP_EQ_OQ);
+          auto inv_length = _mm256_div_ps(one, _mm256_sqrt_ps(length_squared));
+          inv_length = _mm256_mul_ps(_mm256_andnot_ps(is_zero, inv_length), normal_sign);
+
+          auto normal_x = _mm256_mul_ps(_mm256_sub_ps(zero, dy), inv_length);
+          auto normal_y = _mm256_mul_ps(dx, inv_length);
+          auto width = _mm256_add_ps(start_width, _mm256_mul_ps(width_step, index));
+          auto offset = _mm256_mul_ps(width, half_width_factor);
+
+          auto x = _mm256_add_ps(_mm256_add_ps(origin_x, point_x.value), _mm256_mul_ps(normal_x, offset));
+          auto y = _mm256_add_ps(_mm256_add_ps(origin_y, point_y.value), _mm256_mul_ps(normal_y, offset));
+
+          _mm256_store_ps(time_points, _mm256_add_ps(start_time, _mm256_mul_ps(time_step, index)));
+          _mm256_store_ps(xs, x);
+          _mm256_store_ps(ys, y);
+          _mm256_store_ps(normal_xs, normal_x);
+          _mm256_store_ps(normal_ys, normal_y);
+          _mm256_store_ps(widths, width);
+
+          auto* out = outline_points + group;
+          for (int lane = 0; lane != 8; ++lane)
+          {
+            out[lane] = { time_points[lane], { xs[lane], ys[lane] }, { normal_xs[lane], normal_ys[lane] }, widths[lane] };
+          }
+
+          advance(point_x);
+          advance(point_y);
+          advance(derivative_x);
+          advance(derivative_y);
+          index = _mm256_add_ps(index, eight);
+        }
+
+        return group_end;
+      }
+#endif
+
+      static float turning_angle(Vector2f a, Vector2f b)
+      {
+        if (a == Vector2f() || b == Vector2f()) return 0.0f;
+
+        return std::abs(std::atan2(cross_product(a, b), dot_product(a, b)));
+      }
+
+      static std::size_t sub_path_curve_count(const resources::SubPath& sub_path)
+      {
+        auto node_count = sub_path.nodes.size();
+        if (node_count < 2) return 0;
+
+        return sub_path.closed ? node_count : node_count - 1;
+      }
+    }
+
+    std::uint32_t flattened_segment_count(const resources::TrackPathNode& a, const resources::TrackPathNode& b,
+                                          const OutlineProperties& properties)
+    {
+      auto tolerance = std::max(properties.tolerance, 0.001f);
+
+      // Wang's formula: n^2 = 3 * 2 / 8 * max |p[i] - 2 p[i + 1] + p[i + 2]| / tolerance
+      auto d0 = a.position - 2.0f * a.second_control + b.first_control;
+      auto d1 = a.second_control - 2.0f * b.first_control + b.position;
+      auto center_line = 0.75f * std::sqrt(std::max(magnitude_squared(d0), magnitude_squared(d1))) / tolerance;
+
+      // The outline is offset from the center line, and the offset part turns like an arc
+      // with a radius of half the width. An arc of angle theta needs theta * sqrt(r / (8 tolerance))
+      // segments, and the errors of both parts add up.
+      auto offset = 0.0f;
+      if (!properties.center_line)
+      {
+        auto theta = detail::turning_angle(a.second_control - a.position, b.first_control - a.second_control) +
+          detail::turning_angle(b.first_control - a.second_control, b.position - b.first_control);
+
+        auto radius = (std::max(a.width, b.width) + properties.width) * 0.5f;
+        offset = theta * theta * radius / (8.0f * tolerance);
+      }
+
+      auto count = std::ceil(std::sqrt(center_line + offset));
+      return static_cast<std::uint32_t>(std::min(std::max(count, 1.0f),
+                                                 static_cast<float>(detail::max_flattened_segment_count)));
+    }
+
+    void flatten_curve(const resources::TrackPathNode& a, const resources::TrackPathNode& b,
+                       float t1, float t2, float base_t, std::uint32_t segment_count,
+                       const OutlineProperties& properties, OutlinePoint* outline_points)
+    {
+      if (segment_count == 0) return;
+
+      auto poly = detail::make_curve_polynomial(a, b, t1, t2, base_t, segment_count, properties);
+
+      std::uint32_t index = 0;
+
+#if defined(__AVX2__)
+      index = detail::flatten_curve_avx2(poly, segment_count, outline_points);
+#endif
+
+      detail::flatten_curve_scalar(poly, index, segment_count, outline_points);
+    }
+
+    void PathFlattener::flatten(const FlattenRequest* requests, std::size_t request_count,
+                                std::size_t thread_count)
+    {
+      curve_offsets_.resize(request_count + 1);
+      point_offsets_.resize(request_count + 1);
+
+      std::size_t curve_count = 0;
+      for (std::size_t index = 0; index != request_count; ++index)
+      {
+        curve_offsets_[index] = curve_count;
+        curve_count += detail::sub_path_curve_count(*requests[index].sub_path);
+      }
+
+      curve_offsets_[request_count] = curve_count;
+      segment_counts_.resize(curve_count);
+
+      // First estimate the number of segments of every curve, so that every sub-path knows where
+      // its points go, and then write the points.
+      utility::parallel_for(request_count, [&](std::size_t index)
+      {
+        const auto& nodes = requests[index].sub_path->nodes;
+        auto curve_begin = curve_offsets_[index], curve_end = curve_offsets_[index + 1];
+        for (auto curve = curve_begin; curve != curve_end; ++curve)
+        {
+          auto node_index = curve - curve_begin;
+          auto next_index = node_index + 1 == nodes.size() ? 0 : node_index + 1;
+          segment_counts_[curve] = flattened_segment_count(nodes[node_index], nodes[next_index],
+                                                           requests[index].properties);
+        }
+      }, thread_count);
+
+      std::size_t point_count = 0;
+      for (std::size_t index = 0; index != request_count; ++index)
+      {
+        point_offsets_[index] = point_count;
+
+        auto curve_begin = curve_offsets_[index], curve_end = curve_offsets_[index + 1];
+        if (curve_begin != curve_end)
+        {
+          for (auto curve = curve_begin; curve != curve_end; ++curve) point_count += segment_counts_[curve];
+
+          // The end point of the last curve.
+          ++point_count;
+        }
+      }
+
+      point_offsets_[request_count] = point_count;
+      outline_points_.resize(point_count);
+
+      utility::parallel_for(request_count, [&](std::size_t index)
+      {
+        const auto& nodes = requests[index].sub_path->nodes;
+        const auto& properties = requests[index].properties;
+        auto* out = outline_points_.data() + point_offsets_[index];
+
+        auto curve_begin = curve_offsets_[index], curve_end = curve_offsets_[index + 1];
+        for (auto curve = curve_begin; curve != curve_end; ++curve)
+        {
+          auto node_index = curve - curve_begin;
+          auto next_index = node_index + 1 == nodes.size() ? 0 : node_index + 1;
+          auto segment_count = segment_counts_[curve];
+          auto base_t = static_cast<float>(node_index);
+
+          flatten_curve(nodes[node_index], nodes[next_index], 0.0f, 1.0f, base_t, segment_count, properties, out);
+          out += segment_count;
+
+          if (curve + 1 == curve_end)
+          {
+            flatten_curve(nodes[node_index], nodes[next_index], 1.0f, 1.0f, base_t, 1, properties, out);
+          }
+        }
+      }, thread_count);
+    }
+
+    const std::vector<OutlinePoint>& PathFlattener::outline_points() const
+    {
+      return outline_points_;
+    }
+
+    std::size_t PathFlattener::point_offset(std::size_t request_index) const
+    {
+      return point_offsets_[request_index];
+    }
+
+    std::size_t PathFlattener::point_count(std::size_t request_index) const
+    {
+      return point_offsets_[request_index + 1] - point_offsets_[request_index];
+    }
+
+    std::size_t PathFlattener::curve_count() const
+    {
+      return segment_counts_.size();
+    }
+  }
+}
@@ -0,0 +1,68 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include "path_geometry.hpp"
+
+#include "resources/track_path.hpp"
+
+#include "utility/parallel_for.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ts
+{
+  namespace scene
+  {
+    // The number of line segments that the outline of the curve between a and b is split into,
+    // so that it stays within the tolerance. Based on Wang's formula for the center line, plus
+    // the error that the offset by half the width adds in the bends.
+    std::uint32_t flattened_segment_count(const resources::TrackPathNode& a, const resources::TrackPathNode& b,
+                                          const OutlineProperties& properties);
+
+    // Writes the outline of the curve between a and b, from t1 to t2, as segment_count points
+    // spaced evenly in time. The end point is left out, it is the first point of the next curve.
+    void flatten_curve(const resources::TrackPathNode& a, const resources::TrackPathNode& b,
+                       float t1, float t2, float base_t, std::uint32_t segment_count,
+                       const OutlineProperties& properties, OutlinePoint* outline_points);
+
+    struct FlattenRequest
+    {
+      const resources::SubPath* sub_path;
+      OutlineProperties properties;
+    };
+
+    // PathFlattener is the uniform counterpart of generate_path_segment_outline. Rather than splitting
+    // the curves recursively, it estimates the number of segments of every curve up front, so that
+    // all outlines can be written into one preallocated array, and independent sub-paths can be
+    // flattened in parallel. Reusing a flattener avoids allocating once its buffers are large enough.
+    class PathFlattener
+    {
+    public:
+      void flatten(const FlattenRequest* requests, std::size_t request_count,
+                   std::size_t thread_count = utility::default_thread_count());
+
+      // The outlines of all requests of the most recent flatten() call. Closed sub-paths end
+      // with their starting point.
+      const std::vector<OutlinePoint>& outline_points() const;
+
+      // The range of the outline points that belongs to the request with the given index.
+      std::size_t point_offset(std::size_t request_index) const;
+      std::size_t point_count(std::size_t request_index) const;
+
+      std::size_t curve_count() const;
+
+    private:
+      std::vector<std::uint32_t> segment_counts_;
+      std::vector<std::size_t> curve_offsets_;
+      std::vector<std::size_t> point_offsets_;
+      std::vector<OutlinePoint> outline_points_;
+    };
+  }
+}
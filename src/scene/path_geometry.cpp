@@ -12,6 +12,7 @@
 #include "utility/interpolate.hpp"
 
 #include <boost/container/small_vector.hpp>
+#include <boost/functional/hash.hpp>
 
 #include <utility>
 #include <algorithm>
@@ -121,9 +122,146 @@ namespace ts
       generate_path_segment_outline(path, seg, properties, outline_points);
     }
 
+    namespace detail
+    {
+      // Appends the outline of the curve between a and b, from t1 to t2. The end point is only
+      // added for the last curve of a segment.
+      void generate_curve_outline(const resources::TrackPathNode& a, const resources::TrackPathNode& b,
+                                  float t1, float t2, float base_t, bool is_last,
+                                  const OutlineProperties& properties, std::vector<OutlinePoint>& outline_points)
+      {
+        auto start = outline_point_at(a, b, t1, properties);
+        auto end = outline_point_at(a, b, t2, properties);
+
+        if (t2 - t1 < 0.5f)
+        {
+          split_outline_segment(a, b, start, end, properties, base_t, outline_points);
+        }
+
+        else
+        {
+          auto mid = outline_point_at(a, b, (t1 + t2) * 0.5f, properties);
+
+          split_outline_segment(a, b, start, mid, properties, base_t, outline_points);
+          split_outline_segment(a, b, mid, end, properties, base_t, outline_points);
+        }
+
+        if (is_last)
+        {
+          if (t2 - t1 > 0.5f || magnitude_squared(start.point - end.point) >= properties.tolerance * properties.tolerance)
+          {
+            end.time_point += base_t;
+            outline_points.push_back(end);
+          }
+        }
+      }
+
+      bool equal_nodes(const resources::TrackPathNode& a, const resources::TrackPathNode& b)
+      {
+        return a.first_control == b.first_control && a.position == b.position &&
+          a.second_control == b.second_control && a.width == b.width;
+      }
+    }
+
+    bool OutlineCache::Key::operator==(const Key& other) const
+    {
+      return sub_path_id == other.sub_path_id && curve_index == other.curve_index &&
+        start_time == other.start_time && end_time == other.end_time && is_last == other.is_last &&
+        invert_normal == other.invert_normal && center_line == other.center_line &&
+        width == other.width && tolerance == other.tolerance;
+    }
+
+    std::size_t OutlineCache::KeyHash::operator()(const Key& key) const
+    {
+      std::size_t seed = 0;
+      boost::hash_combine(seed, key.sub_path_id);
+      boost::hash_combine(seed, key.curve_index);
+      boost::hash_combine(seed, key.start_time);
+      boost::hash_combine(seed, key.end_time);
+      boost::hash_combine(seed, key.is_last);
+      boost::hash_combine(seed, key.invert_normal);
+      boost::hash_combine(seed, key.center_line);
+      boost::hash_combine(seed, key.width);
+      boost::hash_combine(seed, key.tolerance);
+      return seed;
+    }
+
+    const std::vector<OutlinePoint>& OutlineCache::curve_outline(std::uint32_t sub_path_id, std::size_t curve_index,
+                                                                 const resources::TrackPathNode& a,
+                                                                 const resources::TrackPathNode& b,
+                                                                 float t1, float t2, bool is_last,
+                                                                 const OutlineProperties& properties)
+    {
+      Key key;
+      key.sub_path_id = sub_path_id;
+      key.curve_index = curve_index;
+      key.start_time = t1;
+      key.end_time = t2;
+      key.is_last = is_last;
+      key.invert_normal = properties.invert_normal;
+      key.center_line = properties.center_line;
+      key.width = properties.width;
+      key.tolerance = properties.tolerance;
+
+      auto result = entries_.insert(std::make_pair(key, Entry()));
+      auto& entry = result.first->second;
+      entry.generation = generation_;
+
+      if (!result.second && detail::equal_nodes(entry.first_node, a) && detail::equal_nodes(entry.second_node, b))
+      {
+        ++hit_count_;
+        return entry.points;
+      }
+
+      ++miss_count_;
+      entry.first_node = a;
+      entry.second_node = b;
+      entry.points.clear();
+      detail::generate_curve_outline(a, b, t1, t2, static_cast<float>(curve_index), is_last, properties, entry.points);
+      return entry.points;
+    }
+
+    void OutlineCache::begin_rebuild()
+    {
+      hit_count_ = 0;
+      miss_count_ = 0;
+    }
+
+    void OutlineCache::end_rebuild()
+    {
+      for (auto it = entries_.begin(); it != entries_.end(); )
+      {
+        if (it->second.generation != generation_) it = entries_.erase(it);
+        else ++it;
+      }
+
+      ++generation_;
+    }
+
+    void OutlineCache::clear()
+    {
+      entries_.clear();
+    }
+
+    std::size_t OutlineCache::size() const
+    {
+      return entries_.size();
+    }
+
+    std::size_t OutlineCache::hit_count() const
+    {
+      return hit_count_;
+    }
+
+    std::size_t OutlineCache::miss_count() const
+    {
+      return miss_count_;
+    }
+
     void generate_path_segment_outline(const resources::SubPath& path, const resources::StrokeSegment& segment,
                                        const OutlineProperties& properties,
-                                       std::vector<OutlinePoint>& outline_points)
+                                       std::vector<OutlinePoint>& outline_points,
+                                       OutlineCache* outline_cache)
     {      
       auto node_count = path.nodes.size();
       if (node_count >= 2)
@@ -157,32 +295,17 @@ namespace ts
           auto t1 = std::max(0.0f, start_time - base_t);
           auto t2 = std::min(1.0f, end_time - base_t);
 
-          auto start = detail::outline_point_at(path.nodes[a], path.nodes[b], t1, properties);
-          auto end = detail::outline_point_at(path.nodes[a], path.nodes[b], t2, properties);
-
-          if (t2 - t1 < 0.5f)
+          if (outline_cache)
           {
-            detail::split_outline_segment(path.nodes[a], path.nodes[b], start, end, 
-                                          properties, base_t, outline_points);
+            const auto& points = outline_cache->curve_outline(segment.sub_path_id, idx, path.nodes[a], path.nodes[b],
+                                                              t1, t2, idx == end_idx, properties);
+            outline_points.insert(outline_points.end(), points.begin(), points.end());
           }
 
           else
-          {            
-            auto mid = detail::outline_point_at(path.nodes[a], path.nodes[b], (t1 + t2) * 0.5f, properties);
-
-            detail::split_outline_segment(path.nodes[a], path.nodes[b], start, mid, 
-                                          properties, base_t, outline_points);
-            detail::split_outline_segment(path.nodes[a], path.nodes[b], mid, end,
-                                          properties, base_t, outline_points);
-          }          
-
-          if (idx == end_idx)
           {
-            if (t2 - t1 > 0.5f || magnitude_squared(start.point - end.point) >= properties.tolerance * properties.tolerance)
-            {
-              end.time_point += base_t;
-              outline_points.push_back(end);
-            }
+            detail::generate_curve_outline(path.nodes[a], path.nodes[b], t1, t2, base_t, idx == end_idx,
+                                           properties, outline_points);
           }
         }
       }
@@ -429,9 +552,11 @@ namespace ts
 
     void create_path_geometry(const resources::TrackPath& path, const resources::PathStyle& path_style,
                               float tolerance, float& max_width,
-                              std::vector<PathVertex>& vertices, std::vector<PathFace>& faces)
-                              
+                              std::vector<PathVertex>& vertices, std::vector<PathFace>& faces,
+                              OutlineCache* outline_cache)
     {
+      if (outline_cache) outline_cache->begin_rebuild();
+
       max_width = max_path_width(path) + path_style.width;
 
       auto inv_max_width = 0.0f;
@@ -481,10 +606,12 @@ namespace ts
           OutlineIndices indices{};
           indices.first_start = current_idx();
 
-          generate_path_segment_outline(sub_path, seg, seg.side == seg.First ? inner : invert(inner), outline_points);
+          generate_path_segment_outline(sub_path, seg, seg.side == seg.First ? inner : invert(inner), outline_points,
+                                        outline_cache);
           indices.second_start = current_idx();
 
-          generate_path_segment_outline(sub_path, seg, seg.side == seg.First ? outer : invert(outer), outline_points);
+          generate_path_segment_outline(sub_path, seg, seg.side == seg.First ? outer : invert(outer), outline_points,
+                                        outline_cache);
           if (path_style.fade_length >= 0.5f)
           {
             fade_outline(outline_points, indices.second_start, current_idx(), path_style.fade_length);
@@ -541,13 +668,13 @@ namespace ts
 
           OutlineIndices indices{};
           indices.first_start = current_idx();
-          generate_path_segment_outline(sub_path, seg, first, outline_points);
+          generate_path_segment_outline(sub_path, seg, first, outline_points, outline_cache);
 
           indices.second_start = current_idx();
-          generate_path_segment_outline(sub_path, seg, second, outline_points);
+          generate_path_segment_outline(sub_path, seg, second, outline_points, outline_cache);
 
           indices.center_start = current_idx();
-          generate_path_segment_outline(sub_path, seg, center, outline_points);
+          generate_path_segment_outline(sub_path, seg, center, outline_points, outline_cache);
 
           indices.end = current_idx();
           build_vertices(indices);
@@ -576,6 +703,8 @@ namespace ts
           }
         }
       }
+
+      if (outline_cache) outline_cache->end_rebuild();
     }
   }
-}
+}
\ No newline at end of file
@@ -15,6 +15,7 @@
 
 #include <SFML/Graphics/Image.hpp>
 
+#include <unordered_map>
 #include <vector>
 #include <cstdint>
 
@@ -48,15 +49,77 @@ namespace ts
     using PathVertex = resources::Vertex;
     using PathFace = resources::Face;
 
+    // Caches the outline of every curve between two consecutive nodes, so that rebuilding the geometry
+    // after a node was moved only has to tessellate the curves that are attached to that node.
+    // An entry is only reused if both of its nodes are still the same, which means the cache
+    // never has to be invalidated explicitly.
+    class OutlineCache
+    {
+    public:
+      const std::vector<OutlinePoint>& curve_outline(std::uint32_t sub_path_id, std::size_t curve_index,
+                                                     const resources::TrackPathNode& a,
+                                                     const resources::TrackPathNode& b,
+                                                     float t1, float t2, bool is_last,
+                                                     const OutlineProperties& properties);
+
+      // end_rebuild() drops the entries that weren't used since begin_rebuild().
+      void begin_rebuild();
+      void end_rebuild();
+
+      void clear();
+      std::size_t size() const;
+
+      // The number of curves that were taken from the cache and that were tessellated
+      // since begin_rebuild().
+      std::size_t hit_count() const;
+      std::size_t miss_count() const;
+
+    private:
+      struct Key
+      {
+        std::uint32_t sub_path_id;
+        std::size_t curve_index;
+        float start_time;
+        float end_time;
+        bool is_last;
+        bool invert_normal;
+        bool center_line;
+        float width;
+        float tolerance;
+
+        bool operator==(const Key& other) const;
+      };
+
+      struct KeyHash
+      {
+        std::size_t operator()(const Key& key) const;
+      };
+
+      struct Entry
+      {
+        resources::TrackPathNode first_node;
+        resources::TrackPathNode second_node;
+        std::vector<OutlinePoint> points;
+        std::uint64_t generation = 0;
+      };
+
+      std::unordered_map<Key, Entry, KeyHash> entries_;
+      std::uint64_t generation_ = 0;
+      std::size_t hit_count_ = 0;
+      std::size_t miss_count_ = 0;
+    };
+
     void generate_path_segment_outline(const resources::SubPath& path, const resources::StrokeSegment& segment,
                                        const OutlineProperties& properties,
-                                       std::vector<OutlinePoint>& outline_points);
+                                       std::vector<OutlinePoint>& outline_points,
+                                       OutlineCache* outline_cache = nullptr);
 
     void generate_path_segment_outline(const resources::SubPath& path, const OutlineProperties& properties,
                                        std::vector<OutlinePoint>& outline_points);
 
     void create_path_geometry(const resources::TrackPath& path, const resources::PathStyle& path_style,
                               float tolerance, float& max_width,
-                              std::vector<PathVertex>& vertices, std::vector<PathFace>& faces);
+                              std::vector<PathVertex>& vertices, std::vector<PathFace>& faces,
+                              OutlineCache* outline_cache = nullptr);
   }
 }
\ No newline at end of file
@@ -0,0 +1,93 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "render_commands.hpp"
+
+#include <algorithm>
+
+namespace ts
+{
+  namespace scene
+  {
+    namespace detail
+    {
+      std::uint64_t clamp_field(std::uint32_t value, std::uint32_t bits)
+      {
+        const auto max_value = (std::uint64_t(1) << bits) - 1;
+        return std::min<std::uint64_t>(value, max_value);
+      }
+    }
+
+    bool operator<(const SortKey& a, const SortKey& b)
+    {
+      return a.order < b.order || (a.order == b.order && a.state < b.state);
+    }
+
+    bool operator==(const SortKey& a, const SortKey& b)
+    {
+      return a.order == b.order && a.state == b.state;
+    }
+
+    SortKey make_sort_key(const DrawKey& key)
+    {
+      using detail::clamp_field;
+
+      SortKey result;
+      result.order = clamp_field(key.level, 8) << 56 |
+        clamp_field(key.z_index, 12) << 44 |
+        clamp_field(key.layer, 12) << 32 |
+        key.sequence;
+
+      result.state = static_cast<std::uint32_t>(clamp_field(key.program, 8) << 24 |
+                                                (key.texture & 0xFFFFFF));
+      return result;
+    }
+
+    std::uint32_t sort_key_level(const SortKey& sort_key)
+    {
+      return static_cast<std::uint32_t>(sort_key.order >> 56);
+    }
+
+    void DrawCommandList::clear()
+    {
+      commands_.clear();
+    }
+
+    void DrawCommandList::push(const SortKey& sort_key, std::uint32_t index)
+    {
+      commands_.push_back({ sort_key, index });
+    }
+
+    void DrawCommandList::sort()
+    {
+      std::stable_sort(commands_.begin(), commands_.end(),
+                       [](const DrawCommand& a, const DrawCommand& b)
+      {
+        return a.sort_key < b.sort_key;
+      });
+    }
+
+    DrawCommandList::const_iterator DrawCommandList::begin() const
+    {
+      return commands_.begin();
+    }
+
+    DrawCommandList::const_iterator DrawCommandList::end() const
+    {
+      return commands_.end();
+    }
+
+    std::size_t DrawCommandList::size() const
+    {
+      return commands_.size();
+    }
+
+    bool DrawCommandList::empty() const
+    {
+      return commands_.empty();
+    }
+  }
+}
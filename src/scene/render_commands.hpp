@@ -0,0 +1,73 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace ts
+{
+  namespace scene
+  {
+    // The fields that determine the order in which things are drawn, from most to least significant.
+    // Only the level, z-index, layer and sequence affect what ends up on screen. The program and
+    // texture are there to group draw calls that can share their state.
+    struct DrawKey
+    {
+      std::uint32_t level = 0;
+      std::uint32_t z_index = 0;
+      std::uint32_t layer = 0;
+      std::uint32_t sequence = 0;
+      std::uint32_t program = 0;
+      std::uint32_t texture = 0;
+    };
+
+    // The packed form of a DrawKey. The first word holds the fields that determine the order on screen:
+    // 8 bits of level, 12 bits of z-index, 12 bits of layer and the full 32 bits of sequence. The second
+    // word holds 8 bits of program and 24 bits of texture. Fields that exceed their width are clamped,
+    // except for the texture, of which only the lower 24 bits are used.
+    struct SortKey
+    {
+      std::uint64_t order;
+      std::uint32_t state;
+    };
+
+    bool operator<(const SortKey& a, const SortKey& b);
+    bool operator==(const SortKey& a, const SortKey& b);
+
+    SortKey make_sort_key(const DrawKey& key);
+
+    std::uint32_t sort_key_level(const SortKey& sort_key);
+
+    // A draw command refers to an item in one of the renderer's lists by its index.
+    struct DrawCommand
+    {
+      SortKey sort_key;
+      std::uint32_t index;
+    };
+
+    // DrawCommandList records draw commands and puts them in draw order. Commands with equal
+    // keys keep the order in which they were recorded. This is independent of any GL state.
+    class DrawCommandList
+    {
+    public:
+      using const_iterator = std::vector<DrawCommand>::const_iterator;
+
+      void clear();
+      void push(const SortKey& sort_key, std::uint32_t index);
+      void sort();
+
+      const_iterator begin() const;
+      const_iterator end() const;
+      std::size_t size() const;
+      bool empty() const;
+
+    private:
+      std::vector<DrawCommand> commands_;
+    };
+  }
+}
@@ -17,8 +17,11 @@
 #include "graphics/gl_check.hpp"
 
 #include "world/world_limits.hpp"
+#include "world/entity.hpp"
 
 #include "utility/math_utilities.hpp"
+#include "utility/profiler.hpp"
+#include "utility/stats.hpp"
 
 #include <GL/glew.h>
 #include <GL/GL.h>
@@ -34,10 +37,94 @@ namespace ts
       Vector2f position;
       Vector2f texture_coords;
     };
+
+    namespace detail
+    {
+      // How far ahead of the cameras streamed textures are prefetched, in seconds.
+      static const double texture_look_ahead_time = 1.0;
+
+      // Points the car instance attributes at the given instance in the instance buffer, which
+      // must be bound to GL_ARRAY_BUFFER, while the car vertex array is bound.
+      void set_car_instance_pointers(std::uint32_t instance_offset)
+      {
+        auto pointer = [=](std::size_t member_offset)
+        {
+          auto offset = instance_offset * sizeof(CarInstance) + member_offset;
+          return reinterpret_cast<const void*>(static_cast<std::uintptr_t>(offset));
+        };
+
+        const auto stride = sizeof(CarInstance);
+        const auto row_size = sizeof(float) * 3;
+        glCheck(glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, pointer(offsetof(CarInstance, model_transform))));
+        glCheck(glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, pointer(offsetof(CarInstance, model_transform) + row_size)));
+        glCheck(glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, stride, pointer(offsetof(CarInstance, new_model_transform))));
+        glCheck(glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, stride, pointer(offsetof(CarInstance, new_model_transform) + row_size)));
+        glCheck(glVertexAttribPointer(6, 3, GL_FLOAT, GL_FALSE, stride, pointer(offsetof(CarInstance, colorizer_transform))));
+        glCheck(glVertexAttribPointer(7, 3, GL_FLOAT, GL_FALSE, stride, pointer(offsetof(CarInstance, colorizer_transform) + row_size)));
+
+        // Offset and scale are adjacent, and are passed as a single vec4.
+        glCheck(glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, stride, pointer(offsetof(CarInstance, texture_coords_offset))));
+
+        glCheck(glVertexAttribPointer(9, 3, GL_FLOAT, GL_FALSE, stride, pointer(offsetof(CarInstance, colors))));
+        glCheck(glVertexAttribPointer(10, 3, GL_FLOAT, GL_FALSE, stride, pointer(offsetof(CarInstance, colors) + row_size)));
+        glCheck(glVertexAttribPointer(11, 3, GL_FLOAT, GL_FALSE, stride, pointer(offsetof(CarInstance, colors) + row_size * 2)));
+      }
+
+      // The particle record buffer mirrors the spawn rings' struct of arrays: every field has
+      // its own region, which holds the records of all levels.
+      struct ParticleBufferLayout
+      {
+        std::uintptr_t positions;
+        std::uintptr_t radius_ranges;
+        std::uintptr_t colors;
+        std::uintptr_t seeds;
+        std::uintptr_t spawn_ticks;
+        std::uintptr_t total_size;
+      };
+
+      ParticleBufferLayout particle_buffer_layout(std::uintptr_t record_count)
+      {
+        ParticleBufferLayout layout;
+        layout.positions = 0;
+        layout.radius_ranges = layout.positions + record_count * sizeof(Vector2f);
+        layout.colors = layout.radius_ranges + record_count * sizeof(Vector2f);
+        layout.seeds = layout.colors + record_count * sizeof(Colorb);
+        layout.spawn_ticks = layout.seeds + record_count * sizeof(std::uint32_t);
+        layout.total_size = layout.spawn_ticks + record_count * sizeof(std::uint32_t);
+        return layout;
+      }
+
+      void set_particle_record_pointers(const ParticleBufferLayout& layout, std::uintptr_t record_offset)
+      {
+        auto pointer = [=](std::uintptr_t region_offset, std::size_t element_size)
+        {
+          return reinterpret_cast<const void*>(region_offset + record_offset * element_size);
+        };
+
+        glCheck(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, pointer(layout.positions, sizeof(Vector2f))));
+        glCheck(glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, pointer(layout.radius_ranges, sizeof(Vector2f))));
+        glCheck(glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, pointer(layout.colors, sizeof(Colorb))));
+        glCheck(glVertexAttribIPointer(4, 1, GL_UNSIGNED_INT, 0, pointer(layout.seeds, sizeof(std::uint32_t))));
+        glCheck(glVertexAttribIPointer(5, 1, GL_UNSIGNED_INT, 0, pointer(layout.spawn_ticks, sizeof(std::uint32_t))));
+      }
+    }
     
     RenderScene::RenderScene(TrackScene track_scene)
       : track_scene_(std::move(track_scene))
     {
+      // The first textures of the texture mapping are the atlases, if they are streamed.
+      auto atlas_sources = track_scene_.release_atlas_sources();
+      const auto& textures = track_scene_.texture_mapping().textures();
+      atlas_sources.resize(std::min(atlas_sources.size(), textures.size()));
+
+      std::vector<graphics::Texture*> atlas_textures;
+      for (std::size_t index = 0; index != atlas_sources.size(); ++index)
+      {
+        atlas_textures.push_back(textures[index].get());
+      }
+
+      texture_residency_.assign(atlas_textures, std::move(atlas_sources));
+
       load_shader_programs();
 
       reload_track_components();
@@ -110,18 +197,21 @@ namespace ts
         auto& locations = car_locations_;
         glBindAttribLocation(prog, 0, "in_position");
         glBindAttribLocation(prog, 1, "in_texCoords");
+        glBindAttribLocation(prog, 2, "in_modelRow0");
+        glBindAttribLocation(prog, 3, "in_modelRow1");
+        glBindAttribLocation(prog, 4, "in_newModelRow0");
+        glBindAttribLocation(prog, 5, "in_newModelRow1");
+        glBindAttribLocation(prog, 6, "in_colorizerRow0");
+        glBindAttribLocation(prog, 7, "in_colorizerRow1");
+        glBindAttribLocation(prog, 8, "in_texCoordsTransform");
+        glBindAttribLocation(prog, 9, "in_carColor0");
+        glBindAttribLocation(prog, 10, "in_carColor1");
+        glBindAttribLocation(prog, 11, "in_carColor2");
 
         graphics::link_shader_program(car_shader_program_);
 
-        locations.car_colors = glCheck(glGetUniformLocation(prog, "u_carColors"));
         locations.view_matrix = glCheck(glGetUniformLocation(prog, "u_viewMatrix"));
-        locations.model_matrix = glCheck(glGetUniformLocation(prog, "u_modelMatrix"));
-        locations.new_model_matrix = glCheck(glGetUniformLocation(prog, "u_newModelMatrix"));
         locations.frame_progress = glCheck(glGetUniformLocation(prog, "u_frameProgress"));
-        locations.texture_coords_offset = glCheck(glGetUniformLocation(prog, "u_texCoordsOffset"));
-        locations.texture_coords_scale = glCheck(glGetUniformLocation(prog, "u_texCoordsScale"));
-
-        locations.colorizer_matrix = glCheck(glGetUniformLocation(prog, "u_colorizerMatrix"));
         locations.texture_sampler = glCheck(glGetUniformLocation(prog, "u_textureSampler"));
         locations.colorizer_sampler = glCheck(glGetUniformLocation(prog, "u_colorizerSampler")); 
       }
@@ -145,13 +235,20 @@ namespace ts
 
         auto& locations = particle_locations_;
         auto prog = particle_shader_program_.get();
-        glBindAttribLocation(prog, 0, "in_position");
-        glBindAttribLocation(prog, 1, "in_texCoords");
-        glBindAttribLocation(prog, 2, "in_color");
+        glBindAttribLocation(prog, 0, "in_corner");
+        glBindAttribLocation(prog, 1, "in_position");
+        glBindAttribLocation(prog, 2, "in_radiusRange");
+        glBindAttribLocation(prog, 3, "in_color");
+        glBindAttribLocation(prog, 4, "in_seed");
+        glBindAttribLocation(prog, 5, "in_spawnTicks");
         graphics::link_shader_program(particle_shader_program_);
 
         locations.view_matrix = glCheck(glGetUniformLocation(prog, "u_viewMatrix"));
         locations.texture_sampler = glCheck(glGetUniformLocation(prog, "u_textureSampler"));
+        locations.tick_counter = glCheck(glGetUniformLocation(prog, "u_tickCounter"));
+        locations.display_time = glCheck(glGetUniformLocation(prog, "u_displayTime"));
+        locations.position_variance = glCheck(glGetUniformLocation(prog, "u_positionVariance"));
+        locations.color_variance = glCheck(glGetUniformLocation(prog, "u_colorVariance"));
 
         glUseProgram(prog);
         glUniform1i(locations.texture_sampler, 0);
@@ -180,6 +277,14 @@ namespace ts
       glCheck(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(CarVertex),
                                     reinterpret_cast<const void*>(offsetof(CarVertex, texture_coords))));
 
+      // The instance attributes advance once per car. Their pointers are set for every batch,
+      // see detail::set_car_instance_pointers.
+      for (GLuint attribute = 2; attribute <= 11; ++attribute)
+      {
+        glCheck(glEnableVertexAttribArray(attribute));
+        glCheck(glVertexAttribDivisor(attribute, 1));
+      }
+
       boundary_vertex_array_ = graphics::create_vertex_array();
       glCheck(glBindVertexArray(boundary_vertex_array_.get()));
       glCheck(glBindBuffer(GL_ARRAY_BUFFER, boundary_vertex_buffer_.get()));
@@ -231,6 +336,7 @@ namespace ts
     {
       car_index_buffer_ = graphics::create_buffer();
       car_vertex_buffer_ = graphics::create_buffer();
+      car_instance_buffer_ = graphics::create_buffer();
 
       auto make_car_vertex = [](Vector2f pos)
       {
@@ -283,6 +389,71 @@ namespace ts
 
     void RenderScene::render(const Viewport& view_port, Vector2i screen_size, double frame_progress,
                              const render_callback& post_render) const
+    {
+      TS_PROFILE_ZONE("RenderScene::render");
+
+      begin_render();
+
+      auto view_matrix = compute_view_matrix(view_port, track_scene_.track_size(), frame_progress);
+
+      culling_stats_.resize(1);
+      compute_visibility(&view_matrix, 1, culling_stats_.data());
+
+      texture_residency_.begin_frame();
+      update_texture_residency(&view_port, &view_matrix, 1);
+
+      render_viewport(view_port, view_matrix, 1, screen_size, frame_progress);
+
+      texture_residency_.end_frame();
+      end_render();
+
+      if (post_render) post_render(view_matrix);
+
+      graphics::disable_scissor_box();
+      glCheck(glViewport(0, 0, screen_size.x, screen_size.y));
+    }
+
+    void RenderScene::render(viewport_range viewports, Vector2i screen_size, double frame_progress) const
+    {
+      TS_PROFILE_ZONE("RenderScene::render");
+
+      begin_render();
+
+      view_matrices_.clear();
+      for (const auto& view_port : viewports)
+      {
+        view_matrices_.push_back(compute_view_matrix(view_port, track_scene_.track_size(), frame_progress));
+      }
+
+      culling_stats_.resize(view_matrices_.size());
+      texture_residency_.begin_frame();
+
+      // Each command has one visibility bit per viewport, so take the viewports in groups.
+      const std::size_t group_size = 32;
+      for (std::size_t group_start = 0; group_start < view_matrices_.size(); group_start += group_size)
+      {
+        auto group_end = std::min(group_start + group_size, view_matrices_.size());
+        compute_visibility(view_matrices_.data() + group_start, group_end - group_start,
+                           culling_stats_.data() + group_start);
+
+        update_texture_residency(viewports.begin() + group_start, view_matrices_.data() + group_start,
+                                 group_end - group_start);
+
+        for (auto index = group_start; index != group_end; ++index)
+        {
+          auto visibility_bit = std::uint32_t(1) << (index - group_start);
+          render_viewport(viewports[index], view_matrices_[index], visibility_bit, screen_size, frame_progress);
+        }
+      }
+
+      texture_residency_.end_frame();
+      end_render();
+
+      graphics::disable_scissor_box();
+      glCheck(glViewport(0, 0, screen_size.x, screen_size.y));
+    }
+
+    void RenderScene::begin_render() const
     {
       if (first_time_setup_)
       {
@@ -314,9 +485,137 @@ namespace ts
       glCheck(glEnable(GL_MULTISAMPLE));
       glCheck(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
 
-      glCheck(glDisable(GL_DEPTH_TEST));
       glCheck(glDisable(GL_STENCIL_TEST));
+      glCheck(glStencilMask(0xFF));
+      glCheck(glDepthFunc(GL_LESS));
+
+      // Whatever was rendered before us may have changed the GL state behind the cache's back.
+      // From here on, the cache is kept intact until end_render(), across all viewports.
+      state_cache_.invalidate();
+      state_cache_.reset_counters();
+    }
+
+    void RenderScene::end_render() const
+    {
+      static const stats::Counter draw_calls("render.draw_calls");
+      static const stats::Counter texture_binds("render.texture_binds");
+      static const stats::Gauge atlas_count("render.atlas_count");
+      static const stats::Gauge resident_atlases("render.resident_atlases");
+
+      const auto& counters = state_cache_.counters();
+      draw_calls.add(counters.draw_calls);
+      texture_binds.add(counters.texture_binds);
+      atlas_count.set(track_scene_.texture_mapping().textures().size());
+      resident_atlases.set(texture_residency_.stats().resident_textures);
+
+      // The state is restored directly from here on, so the cache no longer knows what it is.
+      state_cache_.invalidate();
+
+      glCheck(glActiveTexture(GL_TEXTURE0));
+      glCheck(glBindVertexArray(0));
+      glCheck(glBindBuffer(GL_ARRAY_BUFFER, 0));
+      glCheck(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+      glCheck(glUseProgram(0));
+      glCheck(glBindTexture(GL_TEXTURE_2D, 0));
+      glCheck(glDisable(GL_STENCIL_TEST));
+      glCheck(glDisable(GL_DEPTH_TEST));
+      glCheck(glDepthMask(GL_TRUE));
+    }
+
+    void RenderScene::compute_visibility(const sf::Transform* view_matrices, std::size_t viewport_count,
+                                         CullingStats* culling_stats) const
+    {
+      // A single pass over the commands, testing every component against all of the viewports.
+      std::fill(culling_stats, culling_stats + viewport_count, CullingStats());
+
+      visibility_masks_.resize(track_commands_.size());
+      auto mask_it = visibility_masks_.begin();
+      for (const auto& command : track_commands_)
+      {
+        auto& mask = *mask_it++;
+        mask = 0;
+
+        const auto& component = track_components_[command.index];
+        if (!component.visible) continue;
+
+        auto face_count = component.element_count / 3;
+        for (std::size_t index = 0; index != viewport_count; ++index)
+        {
+          auto& stats = culling_stats[index];
+          ++stats.total_components;
+          stats.total_faces += face_count;
+
+          if (intersects_view(view_matrices[index], component.bounding_box))
+          {
+            ++stats.submitted_components;
+            stats.submitted_faces += face_count;
+
+            mask |= std::uint32_t(1) << index;
+          }
+        }
+      }
+    }
+
+    void RenderScene::update_texture_residency(const Viewport* viewports, const sf::Transform* view_matrices,
+                                               std::size_t viewport_count) const
+    {
+      if (texture_residency_.empty()) return;
+
+      bool uploaded = false;
+      auto mask_it = visibility_masks_.begin();
+      for (const auto& command : track_commands_)
+      {
+        if (*mask_it++ == 0) continue;
+
+        for (auto texture : track_components_[command.index].textures)
+        {
+          if (texture_residency_.request(texture)) uploaded = true;
+        }
+      }
+
+      // Look ahead by moving the views to where the followed entities will be shortly.
+      look_ahead_matrices_.clear();
+      for (std::size_t index = 0; index != viewport_count; ++index)
+      {
+        if (auto entity = viewports[index].camera().followed_entity())
+        {
+          auto offset = vector2_cast<float>(entity->velocity() * detail::texture_look_ahead_time);
+
+          look_ahead_matrices_.push_back(view_matrices[index]);
+          look_ahead_matrices_.back().translate(-offset.x, -offset.y);
+        }
+      }
+
+      mask_it = visibility_masks_.begin();
+      for (const auto& command : track_commands_)
+      {
+        if (look_ahead_matrices_.empty()) break;
+        if (*mask_it++ != 0) continue;
+
+        const auto& component = track_components_[command.index];
+        if (!component.visible) continue;
+
+        bool in_view = std::any_of(look_ahead_matrices_.begin(), look_ahead_matrices_.end(),
+                                   [&](const sf::Transform& look_ahead_matrix)
+        {
+          return intersects_view(look_ahead_matrix, component.bounding_box);
+        });
 
+        if (!in_view) continue;
+
+        for (auto texture : component.textures)
+        {
+          if (texture_residency_.prefetch(texture)) uploaded = true;
+        }
+      }
+
+      // Uploading binds the textures behind the state cache's back.
+      if (uploaded) state_cache_.invalidate();
+    }
+
+    void RenderScene::render_viewport(const Viewport& view_port, const sf::Transform& view_matrix,
+                                      std::uint32_t visibility_bit, Vector2i screen_size, double frame_progress) const
+    {
       auto screen_rect = view_port.screen_rect();
       glCheck(glViewport(screen_rect.left, screen_size.y - screen_rect.bottom(),
                          screen_rect.width, screen_rect.height));
@@ -324,14 +623,13 @@ namespace ts
       graphics::scissor_box(screen_rect, screen_size);
 
       auto world_size = track_scene_.track_size();
-      auto view_matrix = compute_view_matrix(view_port, world_size, frame_progress);
-      
-      glCheck(glDepthMask(GL_TRUE));
-      glCheck(glStencilMask(0xFF));
+
+      state_cache_.enable_depth_write(true);
       glCheck(glClearColor(background_color_.r, background_color_.g, background_color_.b, background_color_.a));
       glCheck(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT));
 
-      glCheck(glUseProgram(boundary_shader_program_.get()));
+      state_cache_.enable_depth_test(false);
+      state_cache_.use_program(boundary_shader_program_.get());
       
       glStencilFunc(GL_ALWAYS, 1, 0xFF);
       glStencilOp(GL_REPLACE, GL_REPLACE, GL_REPLACE);      
@@ -341,71 +639,74 @@ namespace ts
       glCheck(glUniform2f(boundary_locations_.world_size, static_cast<float>(world_size.x),
                            static_cast<float>(world_size.y)));
 
-      glBindVertexArray(boundary_vertex_array_.get());
-      glCheck(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT,
-                                reinterpret_cast<const void*>(std::uintptr_t(0))));
+      state_cache_.bind_vertex_array(boundary_vertex_array_.get());
+      state_cache_.draw_elements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
       
       glCheck(glStencilFunc(GL_EQUAL, 1, 0xFF));
       glCheck(glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP));
       
-      glCheck(glUseProgram(track_shader_program_.get()));
+      state_cache_.use_program(track_shader_program_.get());
       glCheck(glUniformMatrix4fv(track_component_locations_.view_matrix, 1, GL_FALSE,
                                  view_matrix.getMatrix()));
 
-      glCheck(glUseProgram(track_path_shader_program_.get()));
+      state_cache_.use_program(track_path_shader_program_.get());
       glCheck(glUniformMatrix4fv(track_path_component_locations_.view_matrix, 1, GL_FALSE,
                                  view_matrix.getMatrix()));
 
-      glCheck(glUseProgram(particle_shader_program_.get()));
+      state_cache_.use_program(particle_shader_program_.get());
       glCheck(glUniformMatrix4fv(particle_locations_.view_matrix, 1, GL_FALSE,
                                  view_matrix.getMatrix()));
+      glCheck(glUniform1ui(particle_locations_.tick_counter, particle_tick_counter_));
+      glCheck(glUniform1f(particle_locations_.display_time, particle_display_time_));
+      glCheck(glUniform1f(particle_locations_.position_variance, particle_position_variance_));
+      glCheck(glUniform1f(particle_locations_.color_variance, particle_color_variance_));
 
       std::uint32_t max_level = 0;
       if (!track_components_.empty()) max_level = std::max(track_components_.back().level, max_level);
-      if (!drawable_entities_.empty()) max_level = std::max(drawable_entities_.back().level, max_level);
+      if (!car_batches_.empty()) max_level = std::max(car_batches_.back().level, max_level);
 
-      glCheck(glUseProgram(car_shader_program_.get()));
+      state_cache_.use_program(car_shader_program_.get());
       glCheck(glUniform1f(car_locations_.frame_progress, static_cast<float>(frame_progress)));
       glCheck(glUniformMatrix4fv(car_locations_.view_matrix, 1, GL_FALSE,
                                  view_matrix.getMatrix()));
 
-      auto component_it = track_components_.begin();
-      auto entity_it = drawable_entities_.begin();
+      auto texture_name = [](const graphics::Texture* texture)
+      {
+        return texture ? texture->get() : 0;
+      };
+
+      auto command_it = track_commands_.begin();
+      auto batch_it = car_batches_.begin();
       for (std::uint32_t level = 0; level <= max_level; ++level)
       {
-        while (component_it != track_components_.end() && level == component_it->level)
+        for (; command_it != track_commands_.end() && level == sort_key_level(command_it->sort_key); ++command_it)
         {
-          const auto& component = *component_it++;
-          if (!component.visible) continue;
+          auto command_index = static_cast<std::size_t>(command_it - track_commands_.begin());
+          if ((visibility_masks_[command_index] & visibility_bit) == 0) continue;
 
+          const auto& component = track_components_[command_it->index];
           auto bb = component.bounding_box;
-          auto screen_rect = view_matrix.transformRect(sf::FloatRect(bb.left, bb.top, bb.width, bb.height));
-
-          if (screen_rect.left > 1.0 || screen_rect.top > 1.0 ||
-              screen_rect.left + screen_rect.width < -1.0 || screen_rect.top + screen_rect.height < -1.0) continue;
 
-          glCheck(glBindVertexArray(component.layer_data->vertex_array.get()));
+          state_cache_.bind_vertex_array(component.layer_data->vertex_array.get());
 
           auto min_corner_loc = track_component_locations_.min_corner;
           auto max_corner_loc = track_component_locations_.max_corner;
 
           if (component.type == TrackComponent::Default)
           {
-            glUseProgram(track_shader_program_.get());
+            state_cache_.use_program(track_shader_program_.get());
+            state_cache_.enable_depth_test(false);
           }
 
           else if (component.type == TrackComponent::Path)
           {
-            glUseProgram(track_path_shader_program_.get());
+            state_cache_.use_program(track_path_shader_program_.get());
 
             min_corner_loc = track_path_component_locations_.min_corner;
             max_corner_loc = track_path_component_locations_.max_corner;
 
-            glCheck(glActiveTexture(GL_TEXTURE0 + 1));
-            glCheck(glBindTexture(GL_TEXTURE_2D, component.textures[1]->get()));
-
-            glCheck(glActiveTexture(GL_TEXTURE0 + 2));
-            glCheck(glBindTexture(GL_TEXTURE_2D, component.textures[2]->get()));
+            state_cache_.bind_texture(1, texture_name(component.textures[1]));
+            state_cache_.bind_texture(2, texture_name(component.textures[2]));
 
             glUniform2f(track_path_component_locations_.primary_scale, 
                         component.texture_scales[0].x, component.texture_scales[0].y);
@@ -418,122 +719,64 @@ namespace ts
             glUniform1f(track_path_component_locations_.z_scale, z_index_increment_);
             glUniform1f(track_path_component_locations_.border_width, component.path_border_width);
 
-            glEnable(GL_DEPTH_TEST);
-            glDepthMask(GL_TRUE);
-            glDepthFunc(GL_LESS);
+            state_cache_.enable_depth_test(true);
+            state_cache_.enable_depth_write(true);
           }
 
           glUniform2f(min_corner_loc, bb.left - 0.2f, bb.top - 0.2f);
           glUniform2f(max_corner_loc, bb.left + bb.width + 0.2f, bb.top + bb.height + 0.2f);
 
-          glCheck(glActiveTexture(GL_TEXTURE0));
-          if (component.textures[0])
-          {
-            glCheck(glBindTexture(GL_TEXTURE_2D, component.textures[0]->get()));
-          }
-
-          else
-          {
-            glCheck(glBindTexture(GL_TEXTURE_2D, 0));
-          }
-          
-
-          auto offset = reinterpret_cast<const void*>(static_cast<std::uintptr_t>(component.element_buffer_offset));
-          glCheck(glDrawElements(GL_TRIANGLES, component.element_count, GL_UNSIGNED_INT, offset));
-
-          glDisable(GL_DEPTH_TEST);
-          glDepthMask(GL_FALSE);
+          state_cache_.bind_texture(0, texture_name(component.textures[0]));
+          state_cache_.draw_elements(GL_TRIANGLES, component.element_count, GL_UNSIGNED_INT,
+                                     component.element_buffer_offset);
         }
 
+        state_cache_.enable_depth_test(false);
 
         if (level < particle_level_info_.size())
         {
-          auto& particle_info = particle_level_info_[level];
-          if (particle_info.count != 0)
+          const auto& particle_info = particle_level_info_[level];
+          if (particle_info.begin_sequence != particle_info.end_sequence)
           {
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, particle_texture_.get());
-
-            glBindVertexArray(particle_vertex_array_.get());
-            glUseProgram(particle_shader_program_.get());
-
-            std::uintptr_t base_offset = level * max_particles_per_level_ * sizeof(std::uint32_t) * 6;
-            std::uintptr_t offset = base_offset + particle_info.start_index * sizeof(std::uint32_t) * 6;
-
-            auto end_index = particle_info.start_index + particle_info.count;
-            if (end_index > max_particles_per_level_)
-            {
-              auto count_1 = max_particles_per_level_ - particle_info.start_index;
-              auto count_2 = end_index - max_particles_per_level_;
-              glDrawElements(GL_TRIANGLES, count_1 * 6, GL_UNSIGNED_INT,
-                             reinterpret_cast<const void*>(offset));
-              glDrawElements(GL_TRIANGLES, count_2 * 6, GL_UNSIGNED_INT,
-                             reinterpret_cast<const void*>(base_offset));
-            }
-
-            else
+            state_cache_.bind_texture(0, particle_texture_.get());
+            state_cache_.bind_vertex_array(particle_vertex_array_.get());
+            state_cache_.use_program(particle_shader_program_.get());
+            glCheck(glBindBuffer(GL_ARRAY_BUFFER, particle_record_buffer_.get()));
+
+            // The live records wrap around the end of the level's part of the buffer at most once.
+            auto layout = detail::particle_buffer_layout(particle_level_info_.size() * max_particles_per_level_);
+            auto ranges = split_ring_range(particle_info.begin_sequence, particle_info.end_sequence,
+                                           max_particles_per_level_);
+            for (auto range : ranges)
             {
-              glDrawElements(GL_TRIANGLES, particle_info.count * 6, GL_UNSIGNED_INT,
-                             reinterpret_cast<const void*>(offset));
+              detail::set_particle_record_pointers(layout, level * max_particles_per_level_ + range.offset);
+              state_cache_.draw_elements_instanced(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0, range.count);
             }
           }
         }
 
-        if (entity_it != drawable_entities_.end() && level == entity_it->level)
+        if (batch_it != car_batches_.end() && level == batch_it->level)
         {          
-          glCheck(glUseProgram(car_shader_program_.get()));
-          glCheck(glBindVertexArray(car_vertex_array_.get()));
+          state_cache_.use_program(car_shader_program_.get());
+          state_cache_.bind_vertex_array(car_vertex_array_.get());
+          glCheck(glBindBuffer(GL_ARRAY_BUFFER, car_instance_buffer_.get()));
 
-          while (entity_it != drawable_entities_.end() && level == entity_it->level)
+          for (; batch_it != car_batches_.end() && level == batch_it->level; ++batch_it)
           {
-            const auto& e = *entity_it++;
-
-            glCheck(glActiveTexture(GL_TEXTURE0));
-            glCheck(glBindTexture(GL_TEXTURE_2D, e.texture->get()));
-
-            glCheck(glActiveTexture(GL_TEXTURE0 + 1));
-            glCheck(glBindTexture(GL_TEXTURE_2D, e.colorizer_texture->get()));
-
-            glCheck(glUniformMatrix4fv(car_locations_.model_matrix, 1, GL_FALSE,
-                                       e.model_transform.getMatrix()));
-
-            glCheck(glUniformMatrix4fv(car_locations_.new_model_matrix, 1, GL_FALSE,
-                                       e.new_model_transform.getMatrix()));           
-
-            glCheck(glUniformMatrix4fv(car_locations_.colorizer_matrix, 1, GL_FALSE,
-                                       e.colorizer_transform.getMatrix()));
+            state_cache_.bind_texture(0, batch_it->texture->get());
+            state_cache_.bind_texture(1, batch_it->colorizer_texture->get());
 
-            glCheck(glUniform3fv(car_locations_.car_colors, 3, e.colors.data()));
-
-            glCheck(glUniform2f(car_locations_.texture_coords_offset, e.texture_coords_offset.x, e.texture_coords_offset.y));
-            glCheck(glUniform2f(car_locations_.texture_coords_scale, e.texture_coords_scale.x, e.texture_coords_scale.y));
-
-            glCheck(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 
-                                   reinterpret_cast<const void*>(std::uintptr_t(0))));
+            detail::set_car_instance_pointers(batch_it->instance_offset);
+            state_cache_.draw_elements_instanced(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0,
+                                                 batch_it->instance_count);
           }
         }
-
-
       }
-
-      glCheck(glBindVertexArray(0));
-      glCheck(glBindBuffer(GL_ARRAY_BUFFER, 0));
-      glCheck(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
-      glCheck(glUseProgram(0));
-      glCheck(glBindTexture(GL_TEXTURE_2D, 0));
-      glCheck(glDisable(GL_STENCIL_TEST));
-      glCheck(glDisable(GL_DEPTH_TEST));
-      glCheck(glDepthMask(GL_TRUE));
-
-      if (post_render) post_render(view_matrix);
-
-      graphics::disable_scissor_box();
-      glCheck(glViewport(0, 0, screen_size.x, screen_size.y));
     }
 
     void RenderScene::update_entities(const DynamicScene& dynamic_scene)
     {
-      // Prepare our local state so that we can easily set the uniform variables for the entities.
+      // Prepare our local state so that we can easily fill the instance buffer for the entities.
       // Loop through all the dynamic entities, and store the required information.
 
       drawable_entities_.clear();
@@ -542,138 +785,118 @@ namespace ts
         drawable_entities_.push_back(dynamic_scene.entity_info(instance_id));
       }
 
-      std::sort(drawable_entities_.begin(), drawable_entities_.end(),
-                [](const DrawableEntity& a, const DrawableEntity& b)
-      {
-        return a.level < b.level;
-      });
+      record_entity_commands(drawable_entities_.data(), drawable_entities_.size(), entity_commands_);
+      pack_car_instances(drawable_entities_.data(), entity_commands_, car_instances_, car_batches_);
+
+      if (car_instances_.empty() || car_instance_buffer_.get() == 0) return;
+
+      // Orphan the previous frame's storage, so that the upload doesn't have to wait for it to be drawn.
+      auto data_size = car_instances_.size() * sizeof(CarInstance);
+      car_instance_buffer_size_ = std::max(car_instance_buffer_size_, next_power_of_two(data_size));
+
+      glCheck(glBindBuffer(GL_ARRAY_BUFFER, car_instance_buffer_.get()));
+      glCheck(glBufferData(GL_ARRAY_BUFFER, car_instance_buffer_size_, nullptr, GL_STREAM_DRAW));
+      glCheck(glBufferSubData(GL_ARRAY_BUFFER, 0, data_size, car_instances_.data()));
+      glCheck(glBindBuffer(GL_ARRAY_BUFFER, 0));
     }
 
     void RenderScene::setup_particle_buffers(std::uint32_t num_levels, std::uint32_t max_particles)
     {
-      particle_vertex_buffer_ = graphics::create_buffer();      
+      particle_corner_buffer_ = graphics::create_buffer();
       particle_index_buffer_ = graphics::create_buffer();
+      particle_record_buffer_ = graphics::create_buffer();
       particle_vertex_array_ = graphics::create_vertex_array();
 
-      auto total_max_particles = num_levels * max_particles;
-
-      std::vector<std::uint32_t> indices;
-      for (std::uint32_t i = 0; i < total_max_particles; ++i)
-      {
-        auto base = i * 4;
-        indices.insert(indices.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
-      }
-
-      glBindVertexArray(particle_vertex_array_.get());
+      // Every particle is an instance of the same quad, the shader positions it according to the
+      // particle's spawn record.
+      const Vector2f corners[] = { { -1.0f, -1.0f }, { -1.0f, 1.0f }, { 1.0f, 1.0f }, { 1.0f, -1.0f } };
+      const std::uint16_t indices[] = { 0, 1, 2, 0, 2, 3 };
 
-      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, particle_index_buffer_.get());
-      glBindBuffer(GL_ARRAY_BUFFER, particle_vertex_buffer_.get());
+      glCheck(glBindVertexArray(particle_vertex_array_.get()));
 
-      glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(indices.front()), indices.data(), GL_STATIC_DRAW);
-      glBufferData(GL_ARRAY_BUFFER, total_max_particles * 4 * sizeof(ParticleVertex), nullptr, GL_DYNAMIC_DRAW);      
+      glCheck(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, particle_index_buffer_.get()));
+      glCheck(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW));
 
+      glCheck(glBindBuffer(GL_ARRAY_BUFFER, particle_corner_buffer_.get()));
+      glCheck(glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW));
       glCheck(glEnableVertexAttribArray(0));
-      glCheck(glEnableVertexAttribArray(1));
-      glCheck(glEnableVertexAttribArray(2));
+      glCheck(glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vector2f), nullptr));
+
+      // One ring of spawn records per level, mirroring the particle generator's rings.
+      auto layout = detail::particle_buffer_layout(std::uintptr_t(num_levels) * max_particles);
+      glCheck(glBindBuffer(GL_ARRAY_BUFFER, particle_record_buffer_.get()));
+      glCheck(glBufferData(GL_ARRAY_BUFFER, layout.total_size, nullptr, GL_DYNAMIC_DRAW));
 
-      glCheck(glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ParticleVertex),
-                                    reinterpret_cast<const void*>(offsetof(ParticleVertex, position))));
-      glCheck(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ParticleVertex),
-                                    reinterpret_cast<const void*>(offsetof(ParticleVertex, texture_coords))));
-      glCheck(glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ParticleVertex),
-                                    reinterpret_cast<const void*>(offsetof(ParticleVertex, color))));
+      // The record attribute pointers depend on the range that is drawn,
+      // see detail::set_particle_record_pointers.
+      for (GLuint attribute = 1; attribute <= 5; ++attribute)
+      {
+        glCheck(glEnableVertexAttribArray(attribute));
+        glCheck(glVertexAttribDivisor(attribute, 1));
+      }
 
-      glBindVertexArray(0);
-      glBindBuffer(GL_ARRAY_BUFFER, 0);
-      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);      
+      glCheck(glBindVertexArray(0));
+      glCheck(glBindBuffer(GL_ARRAY_BUFFER, 0));
+      glCheck(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
     }
 
     void RenderScene::update_particles(const ParticleGenerator& particle_generator)
     {
-      // For each level
-      // Fetch "new" particles and replace the oldest ones in the buffer with those.
-
+      // The generator only keeps the spawn records of the particles, so all that needs to be
+      // done is to upload the records that were spawned since the previous update.
       auto level_count = particle_generator.level_count();
-      particle_level_info_.resize(level_count);      
+      particle_level_info_.resize(level_count);
 
       max_particles_per_level_ = particle_generator.max_particles_per_level();
-      particle_vertex_cache_.reserve(max_particles_per_level_ * 4);
-
-      if (particle_vertex_buffer_.get() == 0)
+      if (particle_record_buffer_.get() == 0)
       {
         setup_particle_buffers(level_count, max_particles_per_level_);
       }
 
-      glBindBuffer(GL_ARRAY_BUFFER, particle_vertex_buffer_.get());
+      auto layout = detail::particle_buffer_layout(std::uintptr_t(level_count) * max_particles_per_level_);
+      glCheck(glBindBuffer(GL_ARRAY_BUFFER, particle_record_buffer_.get()));
 
-      std::uint32_t buffer_offset = 0;
       for (std::uint32_t level = 0; level != level_count; ++level)
-      { 
-        auto particles = particle_generator.particle_info(level);
+      {
+        const auto& spawn_ring = particle_generator.spawn_ring(level);
         auto& info = particle_level_info_[level];
 
-        auto count = particle_generator.particle_count(level);
-        auto start_index = particle_generator.particle_start_index(level);
-
-        auto end_index = info.start_index + info.count;
-        auto new_end_index = start_index + count;
+        // A different generator starts counting from scratch.
+        if (spawn_ring.end_sequence() < info.uploaded_sequence) info = {};
 
-        info.start_index = start_index;
-        info.count = count;
+        // Records that were spawned and overwritten or expired since the last update are skipped.
+        auto first = std::max(info.uploaded_sequence, spawn_ring.begin_sequence());
+        auto last = spawn_ring.end_sequence();
 
-        while (end_index >= max_particles_per_level_) end_index -= max_particles_per_level_;
-        while (new_end_index >= max_particles_per_level_) new_end_index -= max_particles_per_level_;
-
-        particle_vertex_cache_.clear();
-
-        // Update range between end_index and new_end_index.
-        for (auto idx = end_index; idx != new_end_index; )
+        auto level_offset = std::uintptr_t(level) * max_particles_per_level_;
+        for (auto range : split_ring_range(first, last, max_particles_per_level_))
         {
-          auto particle = particles[idx];
-          auto r = particle.radius;
-
-          // Create particle vertices
-          ParticleVertex v;
-          v.color = particle.color;
-          v.position = particle.position + make_vector2(-r, -r);
-          v.texture_coords = { 0.0f, 0.0f };
-          particle_vertex_cache_.push_back(v);
-          
-          v.position = particle.position + make_vector2(-r, r);
-          v.texture_coords = { 0.0f, 1.0f };
-          particle_vertex_cache_.push_back(v);
-
-          v.position = particle.position + make_vector2(r, r);
-          v.texture_coords = { 1.0f, 1.0f };
-          particle_vertex_cache_.push_back(v);
-
-          v.position = particle.position + make_vector2(r, -r);
-          v.texture_coords = { 1.0f, 0.0f };
-          particle_vertex_cache_.push_back(v);
-
-          if (++idx == max_particles_per_level_)
+          auto upload = [&](std::uintptr_t region_offset, const auto* data)
           {
-            glBufferSubData(GL_ARRAY_BUFFER, buffer_offset + end_index * sizeof(ParticleVertex) * 4,
-                            particle_vertex_cache_.size() * sizeof(ParticleVertex),
-                            particle_vertex_cache_.data());
-
-            particle_vertex_cache_.clear();
-
-            end_index = 0;
-            idx = 0;
-          }
+            const auto element_size = sizeof(*data);
+            glCheck(glBufferSubData(GL_ARRAY_BUFFER, region_offset + (level_offset + range.offset) * element_size,
+                                    range.count * element_size, data + range.offset));
+          };
+
+          upload(layout.positions, spawn_ring.positions());
+          upload(layout.radius_ranges, spawn_ring.radius_ranges());
+          upload(layout.colors, spawn_ring.colors());
+          upload(layout.seeds, spawn_ring.seeds());
+          upload(layout.spawn_ticks, spawn_ring.spawn_ticks());
         }
 
-        if (!particle_vertex_cache_.empty())
-        {
-          glBufferSubData(GL_ARRAY_BUFFER, buffer_offset + end_index * sizeof(ParticleVertex) * 4,
-                          particle_vertex_cache_.size() * sizeof(ParticleVertex), particle_vertex_cache_.data());
-        }
-
-        buffer_offset += max_particles_per_level_ * sizeof(ParticleVertex) * 4;
+        info.uploaded_sequence = last;
+        info.begin_sequence = spawn_ring.begin_sequence();
+        info.end_sequence = last;
       }
 
-      glBindBuffer(GL_ARRAY_BUFFER, 0);
+      glCheck(glBindBuffer(GL_ARRAY_BUFFER, 0));
+
+      const auto& settings = particle_generator.settings();
+      particle_tick_counter_ = particle_generator.tick_counter();
+      particle_display_time_ = static_cast<float>(std::max(settings.display_time, 1U));
+      particle_position_variance_ = static_cast<float>(settings.position_variance);
+      particle_color_variance_ = static_cast<float>(settings.color_variance);
     }
 
     void RenderScene::clear_dynamic_state()
@@ -691,6 +914,26 @@ namespace ts
       return track_scene_;
     }
 
+    const CullingStats& RenderScene::culling_stats(std::size_t viewport_index) const
+    {
+      return culling_stats_.at(viewport_index);
+    }
+
+    const graphics::RenderCounters& RenderScene::render_counters() const
+    {
+      return state_cache_.counters();
+    }
+
+    void RenderScene::set_texture_budget(std::size_t budget_bytes)
+    {
+      texture_residency_.set_budget(budget_bytes);
+    }
+
+    const ResidencyStats& RenderScene::residency_stats() const
+    {
+      return texture_residency_.stats();
+    }
+
     void RenderScene::update_layer_geometry(const resources::TrackLayer* layer)
     {
       const auto& scene_layers = track_scene_.layers();
@@ -763,6 +1006,8 @@ namespace ts
               track_component.texture_scales[0] = 1.0f / scene_layer.primary_texture_tile_size();
               track_component.texture_scales[1] = 1.0f / scene_layer.secondary_texture_tile_size();              
 
+              track_component.sequence = static_cast<std::uint32_t>(&component - region.data());
+
               track_components_.push_back(track_component);         
 
               buffer_offset += size;
@@ -771,8 +1016,8 @@ namespace ts
         }
       }
 
-      std::sort(track_components_.begin(), track_components_.end(),
-                [](const TrackComponent& a, const TrackComponent& b)
+      std::stable_sort(track_components_.begin(), track_components_.end(),
+                       [](const TrackComponent& a, const TrackComponent& b)
       {
         return std::tie(a.level, a.z_index) < std::tie(b.level, b.z_index);
       });
@@ -788,6 +1033,8 @@ namespace ts
       z_level_increment_ = -1.0f / (max_z_level + 1);
       z_index_increment_ = z_level_increment_ / (max_z_index + 1);      
 
+      rebuild_track_commands();
+
       glCheck(glBindBuffer(GL_ARRAY_BUFFER, 0));
       glCheck(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
 
@@ -802,6 +1049,7 @@ namespace ts
         return c.layer_data->scene_layer->associated_layer() == layer;
       }), track_components_.end());
 
+      rebuild_track_commands();
       track_scene_.deactivate_layer(layer);
     }
 
@@ -830,11 +1078,54 @@ namespace ts
         component.z_index = component.layer_data->scene_layer->z_index();        
       }
 
-      std::sort(track_components_.begin(), track_components_.end(),
-                [](const TrackComponent& a, const TrackComponent& b)
+      std::stable_sort(track_components_.begin(), track_components_.end(),
+                       [](const TrackComponent& a, const TrackComponent& b)
       {
         return std::tie(a.level, a.z_index) < std::tie(b.level, b.z_index);
       });
+
+      rebuild_track_commands();
+    }
+
+    void RenderScene::rebuild_track_commands()
+    {
+      // Components of a layer that share their position within their region don't overlap,
+      // which means they can be reordered to group the ones that use the same program and texture.
+      // Within a region, the components must be drawn in the order they were created.
+      track_commands_.clear();
+
+      // Streamed textures change their GL names, so textures are told apart by an ordinal instead.
+      std::unordered_map<const graphics::Texture*, std::uint32_t> texture_ordinals;
+      auto texture_ordinal = [&](const graphics::Texture* texture) -> std::uint32_t
+      {
+        if (!texture) return 0;
+
+        auto result = texture_ordinals.insert(std::make_pair(texture, texture_ordinals.size() + 1));
+        return result.first->second;
+      };
+
+      std::uint32_t layer_ordinal = 0;
+      const TrackLayerData* current_layer = nullptr;
+      for (std::uint32_t index = 0; index != track_components_.size(); ++index)
+      {
+        const auto& component = track_components_[index];
+        if (component.layer_data != current_layer)
+        {
+          if (current_layer) ++layer_ordinal;
+          current_layer = component.layer_data;
+        }
+
+        DrawKey key;
+        key.level = component.level;
+        key.z_index = component.z_index;
+        key.layer = layer_ordinal;
+        key.sequence = component.sequence;
+        key.program = component.type;
+        key.texture = texture_ordinal(component.textures[0]);
+        track_commands_.push(make_sort_key(key), index);
+      }
+
+      track_commands_.sort();
     }
 
     void RenderScene::reload_track_components()
@@ -7,11 +7,16 @@
 #pragma once
 
 #include "track_scene.hpp"
+#include "track_culling.hpp"
+#include "render_commands.hpp"
+#include "car_instances.hpp"
+#include "texture_residency.hpp"
 #include "viewport.hpp"
 #include "drawable_entity.hpp"
 
 #include "graphics/shader.hpp"
 #include "graphics/buffer.hpp"
+#include "graphics/state_cache.hpp"
 
 #include "utility/color.hpp"
 #include "utility/vector2.hpp"
@@ -19,6 +24,8 @@
 
 #include <SFML/Graphics/Transform.hpp>
 
+#include <boost/range/iterator_range.hpp>
+
 #include <cstdint>
 #include <functional>
 #include <array>
@@ -33,13 +40,6 @@ namespace ts
 
   namespace scene
   {
-    struct ParticleVertex
-    {
-      Vector2f position;
-      Vector2f texture_coords;
-      Colorb color;
-    };
-
     namespace render_scene
     {
       struct TrackLayerData
@@ -74,6 +74,7 @@ namespace ts
 
         std::uint32_t level;
         std::uint32_t z_index;
+        std::uint32_t sequence; // The component's position within its region
         std::uint32_t element_buffer_offset;
         std::uint32_t element_count;
 
@@ -115,12 +116,6 @@ namespace ts
       {
         std::uint32_t frame_progress;
         std::uint32_t view_matrix;
-        std::uint32_t model_matrix;
-        std::uint32_t new_model_matrix;
-        std::uint32_t texture_coords_offset;
-        std::uint32_t texture_coords_scale;
-        std::uint32_t colorizer_matrix;        
-        std::uint32_t car_colors;
         std::uint32_t texture_sampler;
         std::uint32_t colorizer_sampler;
       };
@@ -129,6 +124,10 @@ namespace ts
       {
         std::uint32_t view_matrix;
         std::uint32_t texture_sampler;
+        std::uint32_t tick_counter;
+        std::uint32_t display_time;
+        std::uint32_t position_variance;
+        std::uint32_t color_variance;
       };
     }
 
@@ -154,6 +153,12 @@ namespace ts
       void render(const Viewport& viewport, Vector2i screen_size, double frame_progress,
                   const render_callback& = nullptr) const;
 
+      // Render a number of viewports at once, e.g. for split-screen. The culling is done for all
+      // viewports in a single pass, and the viewports are submitted from the same sorted command list
+      // without resetting the GL state in between.
+      using viewport_range = boost::iterator_range<const Viewport*>;
+      void render(viewport_range viewports, Vector2i screen_size, double frame_progress) const;
+
       void clear_dynamic_state();
       void update_entities(const DynamicScene& dynamic_scene);
       void update_particles(const ParticleGenerator& particle_generator);
@@ -161,6 +166,16 @@ namespace ts
       void set_background_color(Colorf bg_color);
 
       const TrackScene& track_scene() const;
+
+      // The culling statistics of the viewports of the most recent render call.
+      const CullingStats& culling_stats(std::size_t viewport_index = 0) const;
+
+      // The state changes and draw calls of the most recent render call.
+      const graphics::RenderCounters& render_counters() const;
+
+      // Streamed texture atlases are kept within this budget, see TextureResidency.
+      void set_texture_budget(std::size_t budget_bytes);
+      const ResidencyStats& residency_stats() const;
       
       void add_tile(const resources::TrackLayer* layer,
                     const resources::PlacedTile* tile_expansion, std::size_t tile_count);
@@ -186,6 +201,19 @@ namespace ts
       void update_layer_geometry(const resources::TrackLayer* layer);
 
       void reload_track_components();
+      void rebuild_track_commands();
+
+      void begin_render() const;
+      void end_render() const;
+      void compute_visibility(const sf::Transform* view_matrices, std::size_t viewport_count,
+                              CullingStats* culling_stats) const;
+      void render_viewport(const Viewport& viewport, const sf::Transform& view_matrix,
+                           std::uint32_t visibility_bit, Vector2i screen_size, double frame_progress) const;
+
+      // Requests the textures of the components that were found to be visible, and prefetches
+      // the ones that the viewports' cameras are heading towards.
+      void update_texture_residency(const Viewport* viewports, const sf::Transform* view_matrices,
+                                    std::size_t viewport_count) const;
 
       TrackScene track_scene_;
 
@@ -198,13 +226,16 @@ namespace ts
       graphics::Buffer car_vertex_buffer_;
       graphics::Buffer car_index_buffer_;
       graphics::VertexArray car_vertex_array_;
+      graphics::Buffer car_instance_buffer_;
+      std::size_t car_instance_buffer_size_ = 0;
 
       graphics::Buffer boundary_vertex_buffer_;
       graphics::Buffer boundary_index_buffer_;
       graphics::VertexArray boundary_vertex_array_;
 
-      graphics::Buffer particle_vertex_buffer_;
+      graphics::Buffer particle_corner_buffer_;
       graphics::Buffer particle_index_buffer_;
+      graphics::Buffer particle_record_buffer_;
       graphics::VertexArray particle_vertex_array_;
       graphics::Texture particle_texture_;
       
@@ -218,23 +249,40 @@ namespace ts
       std::vector<render_scene::TrackComponent> track_components_;
       std::vector<DrawableEntity> drawable_entities_;
 
+      DrawCommandList track_commands_;
+      DrawCommandList entity_commands_;
+      std::vector<CarInstance> car_instances_;
+      std::vector<CarInstanceBatch> car_batches_;
+
       bool first_time_setup_ = true;
       bool update_track_vaos_ = false;
 
       float z_level_increment_ = 0.0f;
       float z_index_increment_ = 0.0f;
 
+      // Sequence numbers of the generator's spawn rings. The records in [begin, end) are live,
+      // and everything before uploaded_sequence is already in the record buffer.
       struct ParticleLevelInfo
       {
-        std::uint32_t start_index = 0;
-        std::uint32_t count = 0;        
+        std::uint64_t uploaded_sequence = 0;
+        std::uint64_t begin_sequence = 0;
+        std::uint64_t end_sequence = 0;
       };
 
       std::uint32_t max_particles_per_level_ = 0;
       std::vector<ParticleLevelInfo> particle_level_info_;
-      std::vector<ParticleVertex> particle_vertex_cache_;
+      std::uint32_t particle_tick_counter_ = 0;
+      float particle_display_time_ = 1.0f;
+      float particle_position_variance_ = 0.0f;
+      float particle_color_variance_ = 0.0f;
 
       Colorf background_color_ = Colorf(0.f, 0.f, 0.f, 1.0f);      
+      mutable std::vector<CullingStats> culling_stats_ = std::vector<CullingStats>(1);
+      mutable TextureResidency texture_residency_;
+      mutable std::vector<sf::Transform> look_ahead_matrices_;
+      mutable std::vector<sf::Transform> view_matrices_;
+      mutable std::vector<std::uint32_t> visibility_masks_; // One bit per viewport, for every track command
+      mutable graphics::StateCache state_cache_;
     };
   }
 }
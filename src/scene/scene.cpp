@@ -11,6 +11,8 @@
 
 #include "world/world_messages.hpp"
 
+#include "utility/profiler.hpp"
+
 namespace ts
 {
   namespace scene
@@ -46,11 +48,7 @@ namespace ts
     void Scene::render(const ViewportArrangement& viewport_arrangement, Vector2i screen_size,
                        double frame_progress) const
     {
-      for (std::size_t viewport_id = 0; viewport_id != viewport_arrangement.viewport_count(); ++viewport_id)
-      {
-        const auto& viewport = viewport_arrangement.viewport(viewport_id);
-        impl_->render_scene_.render(viewport, screen_size, frame_progress);
-      }
+      impl_->render_scene_.render(viewport_arrangement.viewports(), screen_size, frame_progress);
     }
 
     void Scene::update_stored_state()
@@ -60,6 +58,8 @@ namespace ts
 
     void Scene::update(std::uint32_t frame_duration)
     {
+      TS_PROFILE_ZONE("Scene::update");
+
       impl_->particle_generator_.update(frame_duration);
       impl_->car_sound_controller_.update(frame_duration);      
 
@@ -74,8 +74,8 @@ namespace ts
 
     void Scene::handle_collision(const world::messages::EntityCollision& collision)
     {
-      //impl_->sound_effect_controller_.play_collision_sound(*collision.subject, *collision.object,
-      //                                                    collision.collision);
+      impl_->sound_effect_controller_.play_collision_sound(*collision.subject, *collision.object,
+                                                           collision.collision);
     }
 
     SceneComponents Scene::release()
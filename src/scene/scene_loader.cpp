@@ -17,6 +17,8 @@
 
 #include "game/loading_thread.hpp"
 
+#include "utility/profiler.hpp"
+
 namespace ts
 {
   namespace scene
@@ -26,6 +28,13 @@ namespace ts
       return ParticleGenerator(&stage.world(), ParticleSettings());
     }
 
+    static auto make_render_scene(TrackScene track_scene, const VideoSettings& video_settings)
+    {
+      RenderScene render_scene(std::move(track_scene));
+      render_scene.set_texture_budget(video_settings.texture_budget);
+      return render_scene;
+    }
+
     static auto make_sound_effect_controller()
     {
       return SoundEffectController(12);
@@ -54,8 +63,9 @@ namespace ts
       return car_sound_controller;
     }
 
-    SceneLoader::SceneLoader(game::LoadingThread* loading_thread)
-      : loading_thread_(loading_thread)
+    SceneLoader::SceneLoader(game::LoadingThread* loading_thread, const VideoSettings& video_settings)
+      : loading_thread_(loading_thread),
+        video_settings_(video_settings)
     {}
 
     void SceneLoader::async_load_scene(const stage::Stage* stage_ptr)
@@ -71,7 +81,7 @@ namespace ts
   
     Scene SceneLoader::load(const stage::Stage* stage_ptr)
     {
-      return Scene(load_scene_components(stage_ptr));
+      return Scene(load_scene_components(stage_ptr, video_settings_));
     }
 
     bool SceneLoader::is_ready() const
@@ -86,12 +96,20 @@ namespace ts
       return scene_future_->get();
     }
 
-    SceneComponents load_scene_components(const stage::Stage* stage_ptr)
+    SceneComponents load_scene_components(const stage::Stage* stage_ptr, const VideoSettings& video_settings)
     {
+      return load_scene_components(stage_ptr, generate_track_scene(stage_ptr->track()), video_settings);
+    }
+
+    SceneComponents load_scene_components(const stage::Stage* stage_ptr, TrackScene track_scene,
+                                          const VideoSettings& video_settings)
+    {
+      TS_PROFILE_ZONE("load_scene_components");
+
       return SceneComponents
       {
         stage_ptr,
-        RenderScene(generate_track_scene(stage_ptr->track())),
+        make_render_scene(std::move(track_scene), video_settings),
         generate_dynamic_scene(*stage_ptr),
         create_particle_generator(*stage_ptr),
         make_car_sound_controller(*stage_ptr),
@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include "video_settings.hpp"
+
 #include "utility/generic_loader.hpp"
 
 #include <boost/optional.hpp>
@@ -25,6 +27,7 @@ namespace ts
   namespace scene
   {
     class Scene;
+    class TrackScene;
     struct SceneComponents;
 
     enum class LoadingState
@@ -40,7 +43,7 @@ namespace ts
     {
     public:
 
-      SceneLoader(game::LoadingThread* loading_thread);
+      SceneLoader(game::LoadingThread* loading_thread, const VideoSettings& video_settings = {});
 
       void async_load_scene(const stage::Stage* stage_ptr);
 
@@ -52,9 +55,12 @@ namespace ts
     private:
       boost::optional<std::future<scene::Scene>> scene_future_ = boost::none;
       game::LoadingThread* loading_thread_ = nullptr;
+      VideoSettings video_settings_;
     };
 
-    SceneComponents load_scene_components(const stage::Stage* stage_ptr);
+    SceneComponents load_scene_components(const stage::Stage* stage_ptr, const VideoSettings& video_settings = {});
+    SceneComponents load_scene_components(const stage::Stage* stage_ptr, TrackScene track_scene,
+                                          const VideoSettings& video_settings = {});
     SceneComponents load_scene_components_no_render(const stage::Stage* stage_ptr);
   }
 }
@@ -119,24 +119,41 @@ namespace ts
       static const char car_vertex_shader[] = R"(
         #version 130
         uniform mat4 u_viewMatrix;
-        uniform mat4 u_modelMatrix;
-        uniform mat4 u_newModelMatrix;
-        uniform mat4 u_colorizerMatrix;
-        uniform vec2 u_texCoordsOffset;
-        uniform vec2 u_texCoordsScale;
         uniform float u_frameProgress;
 
         in vec2 in_position;
         in vec2 in_texCoords;
+
+        in vec3 in_modelRow0;
+        in vec3 in_modelRow1;
+        in vec3 in_newModelRow0;
+        in vec3 in_newModelRow1;
+        in vec3 in_colorizerRow0;
+        in vec3 in_colorizerRow1;
+        in vec4 in_texCoordsTransform;
+        in vec3 in_carColor0;
+        in vec3 in_carColor1;
+        in vec3 in_carColor2;
+
         out vec2 frag_texCoords;
         out vec2 frag_colorizerCoords;
+        flat out vec3 frag_carColor0;
+        flat out vec3 frag_carColor1;
+        flat out vec3 frag_carColor2;
+        vec2 transform(vec3 row0, vec3 row1, vec2 point)
+        {
+          return vec2(dot(row0, vec3(point, 1.0)), dot(row1, vec3(point, 1.0)));
+        }
         void main()
         {
-          frag_texCoords = in_texCoords * u_texCoordsScale + u_texCoordsOffset;
-          frag_colorizerCoords = (u_colorizerMatrix * vec4(in_texCoords.xy, 0.0, 1.0)).xy;
+          frag_texCoords = in_texCoords * in_texCoordsTransform.zw + in_texCoordsTransform.xy;
+          frag_colorizerCoords = transform(in_colorizerRow0, in_colorizerRow1, in_texCoords);
+          frag_carColor0 = in_carColor0;
+          frag_carColor1 = in_carColor1;
+          frag_carColor2 = in_carColor2;
    
-          vec4 position = u_viewMatrix * u_modelMatrix * vec4(in_position, 0.0, 1.0);
-          vec4 newPosition = u_viewMatrix * u_newModelMatrix * vec4(in_position, 0.0, 1.0);
+          vec4 position = u_viewMatrix * vec4(transform(in_modelRow0, in_modelRow1, in_position), 0.0, 1.0);
+          vec4 newPosition = u_viewMatrix * vec4(transform(in_newModelRow0, in_newModelRow1, in_position), 0.0, 1.0);
           gl_Position = mix(position, newPosition, u_frameProgress);
         }
       )";
@@ -145,9 +162,11 @@ namespace ts
         #version 130
         uniform sampler2D u_textureSampler;
         uniform sampler2D u_colorizerSampler;
-        uniform vec3 u_carColors[3];
         in vec2 frag_texCoords;
         in vec2 frag_colorizerCoords;
+        flat in vec3 frag_carColor0;
+        flat in vec3 frag_carColor1;
+        flat in vec3 frag_carColor2;
         out vec4 frag_color;
         vec4 colorize(vec4 source, vec4 target)
         {
@@ -167,9 +186,9 @@ namespace ts
         {
           vec4 textureColor = texture2D(u_textureSampler, frag_texCoords);
           vec4 colorizerColor = texture2D(u_colorizerSampler, frag_colorizerCoords);
-          vec3 totalColor = colorizerColor.r * u_carColors[0] + 
-                            colorizerColor.g * u_carColors[1] + 
-                            colorizerColor.b * u_carColors[2];
+          vec3 totalColor = colorizerColor.r * frag_carColor0 + 
+                            colorizerColor.g * frag_carColor1 + 
+                            colorizerColor.b * frag_carColor2;
           
           float d = colorizerColor.r + colorizerColor.g + colorizerColor.b;
           vec4 avgColor = vec4(totalColor / max(d, 1.0), 1.0);
@@ -233,16 +252,55 @@ namespace ts
       static const char particle_vertex_shader[] = R"(
         #version 130
         uniform mat4 u_viewMatrix;
+        uniform uint u_tickCounter;
+        uniform float u_displayTime;
+        uniform float u_positionVariance;
+        uniform float u_colorVariance;
+
+        in vec2 in_corner;
         in vec2 in_position;
-        in vec2 in_texCoords;
+        in vec2 in_radiusRange;
         in vec4 in_color;
+        in uint in_seed;
+        in uint in_spawnTicks;
+
         out vec2 frag_texCoords;
         out vec4 frag_color;
+        uint hash(uint x)
+        {
+          x ^= x >> 16u;
+          x *= 0x7feb352du;
+          x ^= x >> 15u;
+          x *= 0x846ca68bu;
+          x ^= x >> 16u;
+          return x;
+        }
+        float random(inout uint state)
+        {
+          state = hash(state);
+          return float(state >> 8u) * (1.0 / 16777216.0);
+        }
         void main()
         {
-          frag_texCoords = in_texCoords;
-          frag_color = in_color;
-          gl_Position = u_viewMatrix * vec4(in_position, 0, 1);          
+          float age = float(u_tickCounter - in_spawnTicks);
+          if (age >= u_displayTime)
+          {
+            // Expired, move it out of the way.
+            gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+            frag_texCoords = vec2(0.0);
+            frag_color = vec4(0.0);
+            return;
+          }
+
+          uint state = in_seed;
+          vec2 offset = vec2(random(state), random(state)) * 2.0 - 1.0;
+          vec2 position = in_position + offset * u_positionVariance * 0.5;
+          float radius = mix(in_radiusRange.x, in_radiusRange.y, random(state));
+          float color_variance = clamp((random(state) - 0.5) * u_colorVariance, -1.0, 1.0);
+
+          frag_texCoords = in_corner * 0.5 + 0.5;
+          frag_color = vec4(clamp(in_color.rgb * (1.0 + color_variance), 0.0, 1.0), 1.0 - age / u_displayTime);
+          gl_Position = u_viewMatrix * vec4(position + in_corner * radius, 0, 1);          
         }
       )";
 
@@ -9,6 +9,10 @@
 
 #include "core/config.hpp"
 
+#include "world/collision_result.hpp"
+
+#include <algorithm>
+
 namespace ts
 {
   namespace scene
@@ -40,7 +44,6 @@ namespace ts
     void SoundEffectController::play_collision_sound(const world::Entity& subject, const world::Entity& object,
                                                      const world::CollisionResult& collision_result)
     {
-      /*
       if (entity_collision_sample_)
       {
         audio::PlaybackProperties properties;
@@ -50,7 +53,6 @@ namespace ts
 
         playback_controller_.play_sound_effect(*entity_collision_sample_, properties, 1);
       }
-      */
     }
 
     void SoundEffectController::pause_all()
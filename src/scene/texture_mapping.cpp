@@ -83,6 +83,16 @@ namespace ts
       return texture_storage_;
     }
 
+    TextureMapping::mapping_range TextureMapping::mapped_textures() const
+    {
+      return mapping_range(textures_.data(), textures_.data() + textures_.size());
+    }
+
+    TextureMapping::mapping_range TextureMapping::mapped_fragments() const
+    {
+      return mapping_range(texture_fragments_.data(), texture_fragments_.data() + texture_fragments_.size());
+    }
+
     TextureMappingInterface TextureMapping::create_mapping_interface()
     {
       return TextureMappingInterface(this);
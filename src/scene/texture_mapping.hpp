@@ -63,6 +63,10 @@ namespace ts
 
       const std::vector<std::unique_ptr<graphics::Texture>>& textures() const;
 
+      // All mapped textures and fragments, sorted by resource id.
+      mapping_range mapped_textures() const;
+      mapping_range mapped_fragments() const;
+
       void adopt_texture(std::unique_ptr<graphics::Texture> texture);
 
     private:
@@ -0,0 +1,195 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "texture_residency.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace ts
+{
+  namespace scene
+  {
+    const std::size_t TextureResidency::default_budget;
+    const std::size_t TextureResidency::max_prefetch_uploads;
+
+    graphics::Texture upload_atlas_texture(const gli::texture2d& source)
+    {
+      auto texture = graphics::create_texture(source);
+      glCheck(glBindTexture(GL_TEXTURE_2D, texture.get()));
+      glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+      glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+      glCheck(glBindTexture(GL_TEXTURE_2D, 0));
+      return texture;
+    }
+
+    TextureResidency::TextureResidency(std::size_t budget_bytes)
+      : TextureResidency(budget_bytes, upload_atlas_texture)
+    {
+    }
+
+    TextureResidency::TextureResidency(std::size_t budget_bytes, upload_function upload)
+      : upload_(std::move(upload))
+    {
+      stats_.budget_bytes = budget_bytes;
+    }
+
+    void TextureResidency::assign(const std::vector<graphics::Texture*>& textures,
+                                  std::vector<gli::texture2d> sources)
+    {
+      if (textures.size() != sources.size())
+      {
+        throw std::invalid_argument("every managed texture needs exactly one source");
+      }
+
+      entries_.clear();
+      entry_lookup_.clear();
+
+      for (std::size_t index = 0; index != textures.size(); ++index)
+      {
+        Entry entry;
+        entry.texture = textures[index];
+        entry.source = std::move(sources[index]);
+        entry.byte_size = entry.source.size();
+        entry.last_used_frame = 0;
+        entry.resident = false;
+
+        entry_lookup_[entry.texture] = entries_.size();
+        entries_.push_back(std::move(entry));
+      }
+
+      auto budget = stats_.budget_bytes;
+      stats_ = ResidencyStats();
+      stats_.managed_textures = entries_.size();
+      stats_.budget_bytes = budget;
+    }
+
+    void TextureResidency::set_budget(std::size_t budget_bytes)
+    {
+      stats_.budget_bytes = budget_bytes;
+    }
+
+    void TextureResidency::begin_frame()
+    {
+      ++frame_;
+      frame_prefetch_uploads_ = 0;
+    }
+
+    TextureResidency::Entry* TextureResidency::find_entry(const graphics::Texture* texture)
+    {
+      if (!texture) return nullptr;
+
+      auto it = entry_lookup_.find(texture);
+      if (it == entry_lookup_.end()) return nullptr;
+
+      return &entries_[it->second];
+    }
+
+    void TextureResidency::upload(Entry& entry)
+    {
+      *entry.texture = upload_(entry.source);
+      entry.resident = true;
+
+      ++stats_.resident_textures;
+      stats_.resident_bytes += entry.byte_size;
+    }
+
+    void TextureResidency::evict(Entry& entry)
+    {
+      auto size = entry.texture->size();
+      *entry.texture = graphics::Texture(0, size);
+      entry.resident = false;
+
+      --stats_.resident_textures;
+      stats_.resident_bytes -= entry.byte_size;
+      ++stats_.evictions;
+    }
+
+    bool TextureResidency::request(const graphics::Texture* texture)
+    {
+      auto entry = find_entry(texture);
+      if (!entry) return false;
+
+      entry->last_used_frame = frame_;
+      if (entry->resident) return false;
+
+      upload(*entry);
+      ++stats_.demand_uploads;
+      return true;
+    }
+
+    bool TextureResidency::prefetch(const graphics::Texture* texture)
+    {
+      auto entry = find_entry(texture);
+      if (!entry || entry->resident)
+      {
+        return false;
+      }
+
+      if (frame_prefetch_uploads_ >= max_prefetch_uploads || entry->byte_size > stats_.budget_bytes ||
+          !evict_until(stats_.budget_bytes - entry->byte_size))
+      {
+        return false;
+      }
+
+      entry->last_used_frame = frame_;
+      upload(*entry);
+      ++stats_.prefetch_uploads;
+      ++frame_prefetch_uploads_;
+      return true;
+    }
+
+    void TextureResidency::end_frame()
+    {
+      evict_until(stats_.budget_bytes);
+    }
+
+    bool TextureResidency::evict_until(std::size_t target_bytes)
+    {
+      if (stats_.resident_bytes <= target_bytes) return true;
+
+      eviction_candidates_.clear();
+      for (auto& entry : entries_)
+      {
+        if (entry.resident && entry.last_used_frame != frame_)
+        {
+          eviction_candidates_.push_back(&entry);
+        }
+      }
+
+      std::sort(eviction_candidates_.begin(), eviction_candidates_.end(),
+                [](const Entry* a, const Entry* b)
+      {
+        return a->last_used_frame < b->last_used_frame;
+      });
+
+      for (auto entry : eviction_candidates_)
+      {
+        if (stats_.resident_bytes <= target_bytes) break;
+
+        evict(*entry);
+      }
+
+      return stats_.resident_bytes <= target_bytes;
+    }
+
+    bool TextureResidency::empty() const
+    {
+      return entries_.empty();
+    }
+
+    bool TextureResidency::is_resident(const graphics::Texture* texture) const
+    {
+      auto it = entry_lookup_.find(texture);
+      return it != entry_lookup_.end() && entries_[it->second].resident;
+    }
+
+    const ResidencyStats& TextureResidency::stats() const
+    {
+      return stats_;
+    }
+  }
+}
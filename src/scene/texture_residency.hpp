@@ -0,0 +1,112 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include "graphics/texture.hpp"
+
+#include <gli/texture2d.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace ts
+{
+  namespace scene
+  {
+    struct ResidencyStats
+    {
+      std::size_t managed_textures = 0;
+      std::size_t resident_textures = 0;
+      std::size_t resident_bytes = 0;
+      std::size_t budget_bytes = 0;
+
+      // Cumulative counts. Demand uploads are the ones that were needed for the frame that was
+      // being rendered, and could not be hidden by prefetching.
+      std::size_t demand_uploads = 0;
+      std::size_t prefetch_uploads = 0;
+      std::size_t evictions = 0;
+    };
+
+    // TextureResidency keeps the GPU copies of a set of textures within a byte budget. It holds on to
+    // the pixel data of every managed texture, uploads a texture when it's requested, and evicts the
+    // least recently used ones at the end of the frame. The texture objects themselves stay where
+    // they are, evicted textures are replaced by texture objects without a GL name, which means
+    // anything that refers to the textures by address keeps working.
+    // Textures that are used in the current frame are never evicted, so the budget may be exceeded
+    // if a single frame needs more than that.
+    class TextureResidency
+    {
+    public:
+      using upload_function = std::function<graphics::Texture(const gli::texture2d&)>;
+
+      static const std::size_t default_budget = 256 * 1024 * 1024;
+
+      explicit TextureResidency(std::size_t budget_bytes = default_budget);
+      TextureResidency(std::size_t budget_bytes, upload_function upload);
+
+      // Manages the given textures, which must outlive this object. The sources must have the
+      // same size as the textures, and the textures must not be resident yet.
+      void assign(const std::vector<graphics::Texture*>& textures, std::vector<gli::texture2d> sources);
+
+      void set_budget(std::size_t budget_bytes);
+
+      void begin_frame();
+
+      // Marks a texture as used in this frame, and uploads it if needed. Textures that aren't
+      // managed are ignored. Returns true if the texture was uploaded.
+      bool request(const graphics::Texture* texture);
+
+      // Like request(), but for textures that are expected to be needed soon. Only uploads if the
+      // texture fits in the budget after evicting textures that haven't been used in this frame,
+      // and at most max_prefetch_uploads times per frame.
+      bool prefetch(const graphics::Texture* texture);
+
+      // Evicts the least recently used textures until the budget is met.
+      void end_frame();
+
+      bool empty() const;
+      bool is_resident(const graphics::Texture* texture) const;
+
+      const ResidencyStats& stats() const;
+
+      static const std::size_t max_prefetch_uploads = 1;
+
+    private:
+      struct Entry
+      {
+        graphics::Texture* texture;
+        gli::texture2d source;
+        std::size_t byte_size;
+        std::uint64_t last_used_frame;
+        bool resident;
+      };
+
+      Entry* find_entry(const graphics::Texture* texture);
+      void upload(Entry& entry);
+      void evict(Entry& entry);
+
+      // Evicts textures that weren't used in the current frame, oldest first, until the resident
+      // size is at most target_bytes. Returns false if that's not possible.
+      bool evict_until(std::size_t target_bytes);
+
+      upload_function upload_;
+      std::vector<Entry> entries_;
+      std::unordered_map<const graphics::Texture*, std::size_t> entry_lookup_;
+      std::vector<Entry*> eviction_candidates_;
+
+      std::uint64_t frame_ = 0;
+      std::size_t frame_prefetch_uploads_ = 0;
+      ResidencyStats stats_;
+    };
+
+    // Uploads the source the way the track scene's atlases are uploaded.
+    graphics::Texture upload_atlas_texture(const gli::texture2d& source);
+  }
+}
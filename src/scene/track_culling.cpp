@@ -0,0 +1,50 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "track_culling.hpp"
+#include "track_scene.hpp"
+
+#include "resources/track_layer.hpp"
+
+namespace ts
+{
+  namespace scene
+  {
+    bool intersects_view(const sf::Transform& view_matrix, const FloatRect& rect)
+    {
+      auto clip_rect = view_matrix.transformRect(sf::FloatRect(rect.left, rect.top, rect.width, rect.height));
+
+      return !(clip_rect.left > 1.0f || clip_rect.top > 1.0f ||
+               clip_rect.left + clip_rect.width < -1.0f || clip_rect.top + clip_rect.height < -1.0f);
+    }
+
+    CullingStats compute_culling_stats(const TrackScene& track_scene, const sf::Transform& view_matrix)
+    {
+      CullingStats stats;
+      for (const auto& scene_layer : track_scene.layers())
+      {
+        if (!scene_layer.associated_layer()->visible()) continue;
+
+        for (const auto& region : scene_layer.component_regions())
+        {
+          for (const auto& component : region)
+          {
+            ++stats.total_components;
+            stats.total_faces += component.faces.size();
+
+            if (intersects_view(view_matrix, rect_cast<float>(component.bounding_box)))
+            {
+              ++stats.submitted_components;
+              stats.submitted_faces += component.faces.size();
+            }
+          }
+        }
+      }
+
+      return stats;
+    }
+  }
+}
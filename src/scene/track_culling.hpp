@@ -0,0 +1,39 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include "utility/rect.hpp"
+
+#include <SFML/Graphics/Transform.hpp>
+
+#include <cstddef>
+
+namespace ts
+{
+  namespace scene
+  {
+    class TrackScene;
+
+    // Counts how much of the track geometry survives frustum culling in a viewport,
+    // so that the effect of the spatial chunking can be measured without a GPU.
+    struct CullingStats
+    {
+      std::size_t total_components = 0;
+      std::size_t submitted_components = 0;
+      std::size_t total_faces = 0;
+      std::size_t submitted_faces = 0;
+    };
+
+    // Tests whether a world-space rectangle overlaps the clip-space square [-1, 1]
+    // after being transformed by the view matrix.
+    bool intersects_view(const sf::Transform& view_matrix, const FloatRect& rect);
+
+    // Computes the culling statistics of the track scene's visible layers, using the same
+    // per-chunk test as the renderer.
+    CullingStats compute_culling_stats(const TrackScene& track_scene, const sf::Transform& view_matrix);
+  }
+}
@@ -18,8 +18,13 @@
 
 namespace ts
 {
-  const std::int32_t region_size = 1024;
-  const std::int32_t max_regions = 16;
+  // Non-base terrain layers are split into square chunks of this size, each with their own
+  // components, so that the renderer can cull the parts of a layer that are not in view.
+  const std::int32_t region_size = 512;
+  const std::int32_t max_regions = 32;
+
+  static_assert(max_regions * max_regions == scene::TrackSceneLayer::max_component_regions,
+                "Region grid does not match the component region limit");
 
   namespace scene
   {
@@ -34,6 +39,23 @@ namespace ts
       return texture_mapping_;
     }
 
+    void TrackScene::set_atlas_sources(std::vector<gli::texture2d> atlas_sources)
+    {
+      atlas_sources_ = std::move(atlas_sources);
+    }
+
+    const std::vector<gli::texture2d>& TrackScene::atlas_sources() const
+    {
+      return atlas_sources_;
+    }
+
+    std::vector<gli::texture2d> TrackScene::release_atlas_sources()
+    {
+      auto result = std::move(atlas_sources_);
+      atlas_sources_.clear();
+      return result;
+    }
+
     Vector2i TrackScene::track_size() const
     {
       return track_size_;
@@ -102,7 +124,7 @@ namespace ts
     {     
       using T = resources::TrackLayerType;
       if (layer->type() == T::BaseTerrain) components_.resize(1);
-      else components_.resize(256);
+      else components_.resize(max_component_regions);
 
       switch (layer->type())
       {
@@ -287,10 +309,10 @@ namespace ts
           auto max_cell_x = static_cast<std::int32_t>(std::floor(bounding_rect.right() * inv_region_size));
           auto max_cell_y = static_cast<std::int32_t>(std::floor(bounding_rect.bottom() * inv_region_size));
 
-          min_cell_x = clamp(min_cell_x, 0, 15);
-          max_cell_x = clamp(max_cell_x, 0, 15);
-          min_cell_y = clamp(min_cell_y, 0, 15);
-          max_cell_y = clamp(max_cell_y, 0, 15);
+          min_cell_x = clamp(min_cell_x, 0, max_regions - 1);
+          max_cell_x = clamp(max_cell_x, 0, max_regions - 1);
+          min_cell_y = clamp(min_cell_y, 0, max_regions - 1);
+          max_cell_y = clamp(max_cell_y, 0, max_regions - 1);
 
           for (auto cell_y = min_cell_y; cell_y <= max_cell_y; ++cell_y)
           {
@@ -300,7 +322,7 @@ namespace ts
             {
               if (detail::region_contains_triangle(rect_cast<float>(bounding_box), a, b, c))
               {
-                auto& entry = components_[cell_y * 16 + cell_x];
+                auto& entry = components_[cell_y * max_regions + cell_x];
                 if (entry.empty() || entry.back().texture != texture)
                 {
                   Component component;
@@ -332,6 +354,12 @@ namespace ts
       }
     }
 
+    void TrackSceneLayer::assign_geometry(std::vector<vertex_type> vertices, ComponentContainer components)
+    {
+      vertices_ = std::move(vertices);
+      components_ = std::move(components);
+    }
+
     void TrackScene::rebuild_base_terrain_geometry(const resources::TrackLayer* layer)
     {
       if (auto base_terrain = layer->base_terrain())
@@ -382,25 +410,22 @@ namespace ts
     void TrackScene::add_tile_geometry(const resources::TrackLayer* layer,
                                        const resources::PlacedTile* expanded_tiles, std::size_t tile_count)
     {
-      const auto& tex_mapping = texture_mapping();
-      auto expansion_range = boost::make_iterator_range(expanded_tiles, expanded_tiles + tile_count);
-
-      for (const auto& tile : expansion_range)
-      {
-        for (const auto& mapping : tex_mapping.find(tex_mapping.tile_id(tile.id)))
-        {
-          auto vertices = generate_tile_vertices(tile, *tile.definition,
-                                                 mapping.texture_rect, mapping.fragment_offset,
-                                                 1.0f / mapping.texture->size());
+      tile_geometry_cache_.clear();
+      tile_geometry_cache_.layer = layer;
 
-          auto faces = generate_tile_faces(0);
+      generate_tile_geometry(expanded_tiles, tile_count, texture_mapping(), tile_geometry_cache_);
+      add_tile_geometry(tile_geometry_cache_);
+    }
 
-          auto& scene_layer = this->scene_layer(layer, tile.level);
+    void TrackScene::add_tile_geometry(const TileGeometry& tile_geometry)
+    {
+      for (const auto& batch : tile_geometry.batches)
+      {
+        auto& scene_layer = this->scene_layer(tile_geometry.layer, batch.level);
 
-          scene_layer.append_geometry(mapping.texture,
-                                      vertices.data(), static_cast<std::uint32_t>(vertices.size()),
-                                      faces.data(), static_cast<std::uint32_t>(faces.size()));
-        }
+        scene_layer.append_geometry(batch.texture,
+                                    tile_geometry.vertices.data() + batch.vertex_offset, batch.vertex_count,
+                                    tile_geometry.faces.data() + batch.face_offset, batch.face_count);
       }
     }
 
@@ -463,7 +488,8 @@ namespace ts
         face_cache_.clear();
 
         float max_width = 0.0f;
-        create_path_geometry(*path_style->path, path_style->style, 0.1f, max_width, vertex_cache_, face_cache_);        
+        create_path_geometry(*path_style->path, path_style->style, 0.1f, max_width, vertex_cache_, face_cache_,
+                             &path_outline_caches_[path_layer]);
 
         if (!face_cache_.empty())
         {
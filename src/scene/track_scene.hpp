@@ -7,6 +7,7 @@
 #pragma once
 
 #include "texture_mapping.hpp"
+#include "track_vertices.hpp"
 #include "path_geometry.hpp"
 
 #include "resources/geometry.hpp"
@@ -61,12 +62,18 @@ namespace ts
 
       using ComponentContainer = std::vector<boost::container::small_vector<Component, 1>>;
 
+      // Non-base terrain layers have one component region per cell of a 32x32 grid.
+      static constexpr std::uint32_t max_component_regions = 32 * 32;
+
       const ComponentContainer& component_regions() const;
       const std::vector<vertex_type>& vertices() const;
 
       void append_geometry(const texture_type* texture,
                            const vertex_type* vertices, std::uint32_t vertex_count,
                            const face_type* faces, std::uint32_t face_count);
+
+      // Replace the layer's geometry wholesale, e.g. with geometry taken from the geometry cache.
+      void assign_geometry(std::vector<vertex_type> vertices, ComponentContainer components);
       
       bool visible() const;
       void hide();
@@ -135,8 +142,18 @@ namespace ts
 
       const TextureMapping& texture_mapping() const;
 
+      // The pixel data of the texture atlases, if they are to be streamed. In that case, the first
+      // atlas_sources().size() textures of the texture mapping have no GL texture behind them, and
+      // the renderer uploads them when they're needed.
+      void set_atlas_sources(std::vector<gli::texture2d> atlas_sources);
+      const std::vector<gli::texture2d>& atlas_sources() const;
+      std::vector<gli::texture2d> release_atlas_sources();
+
       void add_tile_geometry(const resources::TrackLayer* layer,
                              const resources::PlacedTile* expanded_tile, std::size_t count);
+
+      // Add geometry that was generated beforehand, see generate_tile_geometry().
+      void add_tile_geometry(const TileGeometry& tile_geometry);
       
       void rebuild_tile_layer_geometry(const resources::TrackLayer* layer,
                                        const resources::PlacedTile* expanded_tile, std::size_t count);
@@ -156,8 +173,13 @@ namespace ts
       std::vector<TrackSceneLayer*> layer_list_;
       std::vector<resources::Vertex> vertex_cache_;
       std::vector<resources::Face> face_cache_;
+      TileGeometry tile_geometry_cache_;
+
+      // Path layers are rebuilt after every edit, this keeps the tessellated curves around.
+      std::map<LayerHandle, OutlineCache> path_outline_caches_;
 
       TextureMapping texture_mapping_;
+      std::vector<gli::texture2d> atlas_sources_;
       Vector2i track_size_;
     };
   }
@@ -7,8 +7,15 @@
 
 #include "track_scene_generator.hpp"
 #include "track_scene_generator_detail.hpp"
+#include "geometry_cache.hpp"
+
+#include "core/config.hpp"
+
+#include "graphics/texture_compression.hpp"
 
 #include "utility/vector2.hpp"
+#include "utility/debug_log.hpp"
+#include "utility/profiler.hpp"
 
 #include <GL/glew.h>
 
@@ -23,29 +30,83 @@ namespace ts
   {
     static const std::int32_t desired_atlas_size = 2048;
     
-    TrackScene generate_track_scene(const resources::Track& track, bool include_all_assets)
+    TrackScene generate_track_scene(const resources::Track& track, bool include_all_assets, bool stream_atlases)
     {
+      TS_PROFILE_ZONE("generate_track_scene");
+
       /* In order to generate a track scene, we must:
          * Generate one or more texture atlases so that the track can be rendered efficiently.
          * Load image files at most once, and keep them in the cache.
          * Create the texture images and once this is done, the textures themselves.
-         * Finally, we have to generate the vertices that make up the track.
+         * Store the atlases on disk, so that the next time we can skip the above steps.
+         * Finally, we have to generate the vertices that make up the track, which are cached as well.
          */
       
+      std::int32_t atlas_size = std::min(desired_atlas_size, graphics::max_texture_size());
+      bool compress_atlases = graphics::block_compression_supported();
+
+      // If we have generated this scene before, the atlases and the geometry can be taken from the cache.
+      auto atlas_cache_key = compute_atlas_cache_key(track, make_vector2(atlas_size, atlas_size), include_all_assets,
+                                                     compress_atlases);
+      auto cache_file = atlas_cache_file_name(atlas_cache_key);
+      auto geometry_cache_file = geometry_cache_file_name(compute_geometry_cache_key(track, atlas_cache_key));
+
+      boost::optional<AtlasCacheEntry> cache_entry;
+      try
+      {
+        cache_entry = load_atlas_cache(cache_file);
+      }
+
+      catch (const std::exception& e)
+      {
+        DEBUG_RELEVANT << "Failed to load atlas cache '" << cache_file << "': " << e.what() << debug::endl;
+      }
+
+      if (cache_entry)
+      {
+        return detail::generate_track_scene(track, *cache_entry, include_all_assets, stream_atlases,
+                                            geometry_cache_file);
+      }
+
       // The first thing we have to do is see which tiles we are working with, possibly
       // filter out the ones we don't need, and also make sure we only have a single
       // entry for tiles that overlap sufficiently.
 
       auto image_mapping = detail::generate_image_mapping(track);
 
-      
-      std::int32_t atlas_size = std::min(desired_atlas_size, graphics::max_texture_size());
+      detail::AtlasPackingOptions packing_options;
+      packing_options.block_aligned = compress_atlases;
 
       auto placement_map = detail::generate_atlas_placement_map(track, image_mapping,
                                                                 make_vector2(atlas_size, atlas_size),
-                                                                include_all_assets);
+                                                                include_all_assets, packing_options);
+
+      cache_entry.emplace();
+      auto track_scene = detail::generate_track_scene(track, placement_map, include_all_assets, stream_atlases,
+                                                      compress_atlases, &*cache_entry, geometry_cache_file);
+
+      try
+      {
+        save_atlas_cache(cache_file, *cache_entry);
+      }
+
+      catch (const std::exception& e)
+      {
+        DEBUG_RELEVANT << "Failed to save atlas cache '" << cache_file << "': " << e.what() << debug::endl;
+      }
+
+      // Every track and every atlas size gets its own cache files, so they have to be cleaned up.
+      try
+      {
+        trim_cache_directory(config::cache_directory, config::cache_size_limit);
+      }
+
+      catch (const std::exception& e)
+      {
+        DEBUG_RELEVANT << "Failed to trim cache directory: " << e.what() << debug::endl;
+      }
 
-      return detail::generate_track_scene(track, placement_map, include_all_assets);
+      return track_scene;
     }
   }
 }
\ No newline at end of file
@@ -21,6 +21,9 @@ namespace ts
 
   namespace scene
   {
-    TrackScene generate_track_scene(const resources::Track& track, bool include_all_assets = false);
+    // If stream_atlases is set, the texture atlases are only uploaded when the renderer needs them,
+    // see TextureResidency. The editor needs every atlas at all times, and doesn't stream them.
+    TrackScene generate_track_scene(const resources::Track& track, bool include_all_assets = false,
+                                    bool stream_atlases = true);
   }
 }
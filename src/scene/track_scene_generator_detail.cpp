@@ -8,8 +8,10 @@
 #include "track_scene_generator_detail.hpp"
 #include "track_scene.hpp"
 #include "track_vertices.hpp"
+#include "geometry_cache.hpp"
 
 #include "utility/texture_atlas.hpp"
+#include "utility/parallel_for.hpp"
 
 #include "resources/track.hpp"
 #include "resources/track_layer.hpp"
@@ -19,9 +21,15 @@
 #include "graphics/image_loader.hpp"
 #include "graphics/image.hpp"
 #include "graphics/texture.hpp"
+#include "graphics/texture_compression.hpp"
 #include "graphics/gl_check.hpp"
 
+#include "utility/debug_log.hpp"
+
 #include <algorithm>
+#include <map>
+#include <cstring>
+#include <tuple>
 
 #include <gli/load.hpp>
 #include <gli/texture.hpp>
@@ -216,10 +224,36 @@ namespace ts
         placement_list.push_back(atlas_placement);
       }
 
+      // Copies a rectangle of the source image into an RGBA pixel buffer. The rect is clipped
+      // in the same way sf::Image::copy does, but unlike that function, this one can be used
+      // concurrently for non-overlapping regions of the same buffer.
+      static void copy_image_rect(std::uint8_t* dest, Vector2i dest_size, Vector2i position,
+                                  const sf::Image& source, IntRect source_rect)
+      {
+        Vector2i source_size(source.getSize().x, source.getSize().y);
+
+        source_rect.left = std::max(source_rect.left, 0);
+        source_rect.top = std::max(source_rect.top, 0);
+        source_rect.width = std::min(source_rect.right(), source_size.x) - source_rect.left;
+        source_rect.height = std::min(source_rect.bottom(), source_size.y) - source_rect.top;
+
+        auto width = std::min(source_rect.width, dest_size.x - position.x);
+        auto height = std::min(source_rect.height, dest_size.y - position.y);
+        if (width <= 0 || height <= 0) return;
+
+        const auto* source_pixels = source.getPixelsPtr();
+        for (std::int32_t y = 0; y != height; ++y)
+        {
+          auto source_offset = ((source_rect.top + y) * source_size.x + source_rect.left) * 4;
+          auto dest_offset = ((position.y + y) * dest_size.x + position.x) * 4;
+
+          std::memcpy(dest + dest_offset, source_pixels + source_offset, width * 4);
+        }
+      }
+
       sf::Image build_atlas_image(const AtlasDefinition& atlas, ImageLoader& image_loader)
       {
-        sf::Image surface;
-        surface.create(atlas.size.x, atlas.size.y, sf::Color(0, 0, 0, 0));
+        std::vector<std::uint8_t> pixels(atlas.size.x * atlas.size.y * 4, 0);
 
         // Copy the loaded images into the newly created atlas image.
         for (const auto& image_data : atlas.image_data)
@@ -231,15 +265,101 @@ namespace ts
           for (const auto& placement : placement_list)
           {
             Vector2i position(placement.atlas_rect.left, placement.atlas_rect.top);
-            auto src_rect = placement.source_rect;
-
-            surface.copy(image, position.x, position.y, { src_rect.left, src_rect.top, src_rect.width, src_rect.height });
+            copy_image_rect(pixels.data(), atlas.size, position, image, placement.source_rect);
           }
         }
 
+        sf::Image surface;
+        surface.create(atlas.size.x, atlas.size.y, pixels.data());
         return surface;
       }
 
+      void preload_atlas_images(const PlacementMap& placement_map, ImageLoader& image_loader)
+      {
+        std::vector<boost::string_ref> file_names;
+        for (const auto& atlas : placement_map.atlases)
+        {
+          for (const auto& image_data : atlas.image_data)
+          {
+            if (!image_loader.find_image(image_data.first))
+            {
+              file_names.push_back(image_data.first);
+            }
+          }
+        }
+
+        std::sort(file_names.begin(), file_names.end());
+        file_names.erase(std::unique(file_names.begin(), file_names.end()), file_names.end());
+
+        // The loading function is stateless, so the decoding can safely be spread over
+        // multiple threads. Only the insertion into the cache has to happen serially.
+        const auto& load_image = image_loader.loading_func();
+        std::vector<sf::Image> images(file_names.size());
+        utility::parallel_for(file_names.size(), [&](std::size_t index)
+        {
+          images[index] = load_image(file_names[index]);
+        });
+
+        for (std::size_t index = 0; index != file_names.size(); ++index)
+        {
+          image_loader.store_image(file_names[index], std::move(images[index]));
+        }
+      }
+
+      std::vector<sf::Image> build_atlas_images(const PlacementMap& placement_map, ImageLoader& image_loader)
+      {
+        preload_atlas_images(placement_map, image_loader);
+
+        struct CopyCommand
+        {
+          std::size_t atlas_id;
+          const sf::Image* image;
+          const AtlasPlacement* placement;
+        };
+
+        // Gather the copy operations of all atlases into one list. The placements never
+        // overlap, so they can be processed in any order and on any thread.
+        std::vector<CopyCommand> copy_commands;
+        std::vector<std::vector<std::uint8_t>> atlas_pixels(placement_map.atlases.size());
+        for (std::size_t atlas_id = 0; atlas_id != placement_map.atlases.size(); ++atlas_id)
+        {
+          const auto& atlas = placement_map.atlases[atlas_id];
+          atlas_pixels[atlas_id].resize(atlas.size.x * atlas.size.y * 4, 0);
+
+          for (const auto& image_data : atlas.image_data)
+          {
+            const auto* image = image_loader.find_image(image_data.first);
+            for (const auto& placement : image_data.second)
+            {
+              copy_commands.push_back({ atlas_id, image, &placement });
+            }
+          }
+        }
+
+        utility::parallel_for(copy_commands.size(), [&](std::size_t index)
+        {
+          const auto& command = copy_commands[index];
+          const auto& placement = *command.placement;
+          const auto& atlas = placement_map.atlases[command.atlas_id];
+
+          Vector2i position(placement.atlas_rect.left, placement.atlas_rect.top);
+          copy_image_rect(atlas_pixels[command.atlas_id].data(), atlas.size, position,
+                          *command.image, placement.source_rect);
+        });
+
+        std::vector<sf::Image> atlas_images(placement_map.atlases.size());
+        utility::parallel_for(atlas_images.size(), [&](std::size_t atlas_id)
+        {
+          const auto& atlas = placement_map.atlases[atlas_id];
+          atlas_images[atlas_id].create(atlas.size.x, atlas.size.y, atlas_pixels[atlas_id].data());
+
+          // Release the intermediate buffer as soon as possible, atlases are big.
+          std::vector<std::uint8_t>().swap(atlas_pixels[atlas_id]);
+        });
+
+        return atlas_images;
+      }
+
       TextureMapping generate_resource_texture_map(const resources::Track& track, const PlacementMap& placement_map,
                                                    std::vector<std::unique_ptr<graphics::Texture>> texture_storage)
       {
@@ -314,19 +434,27 @@ namespace ts
       }
 
       PlacementMap generate_atlas_placement_map(const resources::Track& track, const ImageMapping& image_mapping,
-                                                Vector2i atlas_size, bool include_all_assets)
+                                                Vector2i atlas_size, bool include_all_assets,
+                                                const AtlasPackingOptions& packing_options)
       {
         const auto& tile_interface = track.tile_library().tiles();
         const auto& tile_group_interface = track.tile_library().tile_groups();
 
         AssetCache<resources::max_tile_id> tile_cache;
 
-        utility::AtlasList atlas_list(atlas_size);
+        utility::AtlasList atlas_list(atlas_size, packing_options.strategy);
+        atlas_list.set_first_fit(packing_options.presort);
 
         // Make sure that fragmented entries have one pixel of overlap space, to make
         // sure we can draw them without artifacts.
         atlas_list.set_fragment_overlap(1);
 
+        if (packing_options.block_aligned)
+        {
+          atlas_list.set_padding(graphics::block_extent);
+          atlas_list.set_alignment(graphics::block_extent);
+        }
+
         PlacementMap placement_map;
         placement_map.atlases.resize(atlas_list.atlas_count());
         auto max_atlas_rect_size = atlas_size / 2;
@@ -360,11 +488,29 @@ namespace ts
           store_entries(entry, file_name, full_source_rect);
         };
 
+        struct PendingRect
+        {
+          boost::string_ref file_name;
+          IntRect rect;
+        };
+
+        std::vector<PendingRect> pending_rects;
+
         // Little helper lambda that only allocates space if the rect does not exist in the placement map yet.
+        // When presorting, the rect is only recorded, and allocated after the whole track has been visited.
         auto allocate_rect_if_required = [&](boost::string_ref file_name, const IntRect& source_rect,
                                              auto& asset_cache, std::size_t asset_id)
         {
           IntRect rect = find_enclosing_rect(image_mapping, file_name, source_rect);
+          if (packing_options.presort)
+          {
+            // Nothing is allocated until the track has been visited, so the current atlas stays the same,
+            // and the cache tells us which assets were already recorded.
+            asset_cache.set(atlas_list.current_atlas(), asset_id);
+            pending_rects.push_back({ file_name, rect });
+            return;
+          }
+
           std::size_t atlas_id = atlas_list.current_atlas();
 
           if (!texture_rect_exists(placement_map.atlases[atlas_id], file_name, rect) &&
@@ -430,8 +576,53 @@ namespace ts
           }
         }
 
+        if (packing_options.presort)
+        {
+          if (include_all_assets)
+          {
+            for (const auto& image_data : image_mapping)
+            {
+              for (auto rect : image_data.second)
+              {
+                pending_rects.push_back({ image_data.first, rect });
+              }
+            }
+          }
+
+          // Pack the largest rects first, they are the hardest to fit. Ties are broken by the
+          // remaining fields, so that the result does not depend on the hash map's ordering.
+          auto sort_key = [](const PendingRect& entry)
+          {
+            const auto& rect = entry.rect;
+            return std::make_tuple(-std::int64_t(rect.width) * rect.height, -rect.height, entry.file_name,
+                                   rect.left, rect.top, rect.width, rect.height);
+          };
+
+          std::sort(pending_rects.begin(), pending_rects.end(),
+                    [=](const PendingRect& a, const PendingRect& b)
+          {
+            return sort_key(a) < sort_key(b);
+          });
+
+          pending_rects.erase(std::unique(pending_rects.begin(), pending_rects.end(),
+                                          [=](const PendingRect& a, const PendingRect& b)
+          {
+            return sort_key(a) == sort_key(b);
+          }), pending_rects.end());
+
+          for (const auto& entry : pending_rects)
+          {
+            if (!texture_rect_exists(placement_map, entry.file_name, entry.rect) &&
+                !fragmented_texture_rect_exists(placement_map, entry.file_name, entry.rect))
+            {
+              auto callback = std::bind(store_entries, std::placeholders::_1, entry.file_name, entry.rect);
+              utility::allocate_atlas_rect(atlas_list, entry.rect, max_atlas_rect_size, callback);
+            }
+          }
+        }
+
         // If requested, allocate space for the tiles and textures that weren't used
-        if (include_all_assets)
+        else if (include_all_assets)
         {
           for (const auto& image_data : image_mapping)
           {
@@ -459,6 +650,38 @@ namespace ts
         return placement_map;
       }
 
+      AtlasPackingStats compute_packing_stats(const PlacementMap& placement_map)
+      {
+        AtlasPackingStats stats;
+        stats.atlas_count = placement_map.atlases.size();
+
+        std::int64_t total_area = 0, total_used_area = 0;
+        for (const auto& atlas : placement_map.atlases)
+        {
+          std::int64_t used_area = 0;
+          for (const auto& image_data : atlas.image_data)
+          {
+            for (const auto& placement : image_data.second)
+            {
+              used_area += std::int64_t(placement.atlas_rect.width) * placement.atlas_rect.height;
+            }
+          }
+
+          auto area = std::int64_t(atlas.size.x) * atlas.size.y;
+          stats.occupancy.push_back(area != 0 ? double(used_area) / area : 0.0);
+
+          total_area += area;
+          total_used_area += used_area;
+        }
+
+        if (total_area != 0)
+        {
+          stats.total_occupancy = double(total_used_area) / total_area;
+        }
+
+        return stats;
+      }
+
       void discard_excess_levels(gli::texture& tex, std::int32_t max_texture_size)
       {
         auto base_level = tex.base_level();        
@@ -566,7 +789,8 @@ namespace ts
           }
         }        
 
-        std::unordered_map<std::string, std::unique_ptr<graphics::Texture>> textures;
+        // Adopt the textures in a fixed order, the geometry cache refers to them by index.
+        std::map<std::string, std::unique_ptr<graphics::Texture>> textures;
         for (const auto& entry : texture_data)
         {
           // Create texture from texture data
@@ -593,34 +817,147 @@ namespace ts
         }
       }
 
-      TrackScene generate_track_scene(const resources::Track& track, const PlacementMap& placement_map, bool all_assets)
+      static std::unique_ptr<graphics::Texture> make_atlas_texture(graphics::Texture texture)
+      {
+        glCheck(glBindTexture(GL_TEXTURE_2D, texture.get()));
+        glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+        glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+
+        return std::make_unique<graphics::Texture>(std::move(texture));
+      }
+
+      static TrackScene finish_track_scene(const resources::Track& track, TextureMapping texture_mapping,
+                                           bool all_assets, const std::string& geometry_cache_file)
+      {
+        // Now, load the terrain textures, and add them to the texture mapping.
+        load_terrain_textures(track, texture_mapping, all_assets, 2048);        
+
+        TrackScene track_scene(track.size(), std::move(texture_mapping));
+        if (geometry_cache_file.empty())
+        {
+          scene::build_track_vertices(track, track_scene);
+          return track_scene;
+        }
+
+        try
+        {
+          if (load_geometry_cache(geometry_cache_file, track, track_scene)) return track_scene;
+        }
+
+        catch (const std::exception& e)
+        {
+          DEBUG_RELEVANT << "Failed to load geometry cache '" << geometry_cache_file << "': " << e.what() << debug::endl;
+        }
+
+        scene::build_track_vertices(track, track_scene);
+
+        try
+        {
+          save_geometry_cache(geometry_cache_file, track, track_scene);
+        }
+
+        catch (const std::exception& e)
+        {
+          DEBUG_RELEVANT << "Failed to save geometry cache '" << geometry_cache_file << "': " << e.what() << debug::endl;
+        }
+
+        return track_scene;
+      }
+
+      // Streamed atlases start out as texture objects without a GL texture, with the right size.
+      static std::unique_ptr<graphics::Texture> make_streamed_atlas_texture(const gli::texture2d& atlas)
+      {
+        auto extent = atlas.extent();
+        return std::make_unique<graphics::Texture>(0, Vector2u(extent.x, extent.y));
+      }
+
+      TrackScene generate_track_scene(const resources::Track& track, const PlacementMap& placement_map, bool all_assets,
+                                      bool stream_atlases, bool compress_atlases, AtlasCacheEntry* cache_entry,
+                                      const std::string& geometry_cache_file)
       {
         ImageLoader image_loader;
 
         std::vector<std::unique_ptr<graphics::Texture>> textures;
         textures.reserve(placement_map.atlases.size());
 
-        for (const auto& atlas : placement_map.atlases)
+        auto packing_stats = compute_packing_stats(placement_map);
+        DEBUG_AUXILIARY << "Track scene uses " << packing_stats.atlas_count << " texture atlas(es), " <<
+          "occupancy " << packing_stats.total_occupancy * 100.0 << "%" << debug::endl;
+
+        // Compose the atlas images up front, only the texture upload has to happen here.
+        auto atlas_images = build_atlas_images(placement_map, image_loader);
+
+        // gli textures share their storage when copied, so the cache entry and the
+        // streamed atlas sources can refer to the same pixels.
+        std::vector<gli::texture2d> atlas_sources;
+        atlas_sources.reserve(atlas_images.size());
+        for (const auto& image : atlas_images)
         {
-          auto image = build_atlas_image(atlas, image_loader);
+          auto atlas = graphics::make_texture_data(image);
+          if (compress_atlases)
+          {
+            atlas = graphics::compress_texture(atlas, graphics::select_block_format(atlas));
+          }
 
-          auto texture = std::make_unique<graphics::Texture>(graphics::create_texture(image));
+          atlas_sources.push_back(std::move(atlas));
+        }
 
-          glCheck(glBindTexture(GL_TEXTURE_2D, texture->get()));
-          glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-          glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+        for (const auto& atlas : atlas_sources)
+        {
+          if (stream_atlases)
+          {
+            textures.push_back(make_streamed_atlas_texture(atlas));
+          }
 
-          textures.push_back(std::move(texture));
-        }        
+          else
+          {
+            textures.push_back(make_atlas_texture(graphics::create_texture(atlas)));
+          }
+        }
 
         glCheck(glBindTexture(GL_TEXTURE_2D, 0));
+
         auto texture_mapping = generate_resource_texture_map(track, placement_map, std::move(textures));
 
-        // Now, load the terrain textures, and add them to the texture mapping.
-        load_terrain_textures(track, texture_mapping, all_assets, 2048);        
+        if (cache_entry)
+        {
+          cache_entry->atlases = atlas_sources;
+          cache_entry->mappings = extract_atlas_mappings(texture_mapping, atlas_images.size());
+        }
+
+        auto track_scene = finish_track_scene(track, std::move(texture_mapping), all_assets, geometry_cache_file);
+        if (stream_atlases) track_scene.set_atlas_sources(std::move(atlas_sources));
+
+        return track_scene;
+      }
+
+      TrackScene generate_track_scene(const resources::Track& track, const AtlasCacheEntry& cache_entry, bool all_assets,
+                                      bool stream_atlases, const std::string& geometry_cache_file)
+      {
+        std::vector<std::unique_ptr<graphics::Texture>> textures;
+        textures.reserve(cache_entry.atlases.size());
+
+        for (const auto& atlas : cache_entry.atlases)
+        {
+          if (stream_atlases)
+          {
+            textures.push_back(make_streamed_atlas_texture(atlas));
+          }
+
+          else
+          {
+            textures.push_back(make_atlas_texture(graphics::create_texture(atlas)));
+          }
+        }
+
+        glCheck(glBindTexture(GL_TEXTURE_2D, 0));
+
+        TextureMapping texture_mapping(std::move(textures));
+        apply_atlas_mappings(texture_mapping, cache_entry.mappings);
+
+        auto track_scene = finish_track_scene(track, std::move(texture_mapping), all_assets, geometry_cache_file);
+        if (stream_atlases) track_scene.set_atlas_sources(cache_entry.atlases);
 
-        TrackScene track_scene(track.size(), std::move(texture_mapping));
-        scene::build_track_vertices(track, track_scene);
         return track_scene;
       }
     }
@@ -7,8 +7,10 @@
 #pragma once
 
 #include "texture_mapping.hpp"
+#include "atlas_cache.hpp"
 
 #include "utility/string_utilities.hpp"
+#include "utility/texture_atlas.hpp"
 #include "utility/rect.hpp"
 #include "utility/vector2.hpp"
 
@@ -57,6 +59,29 @@ namespace ts
         std::vector<AtlasFragment> atlas_fragments;
       };
 
+      struct AtlasPackingOptions
+      {
+        utility::AtlasPackingStrategy strategy = utility::AtlasPackingStrategy::MaxRects;
+
+        // Gather all rects up front and pack them largest first, revisiting earlier atlases
+        // before opening new ones. When disabled, the rects are packed in track order and
+        // a new atlas is opened as soon as one does not fit.
+        bool presort = true;
+
+        // Set when the atlases are going to be block-compressed. The rects are then aligned to
+        // 4x4 blocks and kept a full block apart, so that no block mixes the pixels of two rects.
+        bool block_aligned = false;
+      };
+
+      struct AtlasPackingStats
+      {
+        std::size_t atlas_count = 0;
+        std::vector<double> occupancy;
+        double total_occupancy = 0.0;
+      };
+
+      AtlasPackingStats compute_packing_stats(const PlacementMap& placement_map);
+
       using ImageMapping = std::unordered_map<boost::string_ref, std::vector<IntRect>, StringRefHasher>;
       ImageMapping generate_image_mapping(const resources::Track& track);
 
@@ -66,7 +91,8 @@ namespace ts
                                                    
 
       PlacementMap generate_atlas_placement_map(const resources::Track& track, const ImageMapping& image_mapping,
-                                                Vector2i atlas_size, bool include_all_assets = false);
+                                                Vector2i atlas_size, bool include_all_assets = false,
+                                                const AtlasPackingOptions& packing_options = AtlasPackingOptions());
 
       bool texture_rect_exists(const AtlasDefinition& atlas, boost::string_ref file_name, const IntRect& rect);
       bool texture_rect_exists(const PlacementMap& placement_map, boost::string_ref file_name, const IntRect& rect);
@@ -74,10 +100,29 @@ namespace ts
       IntRect find_enclosing_rect(const ImageMapping& image_mapping,
                                   boost::string_ref file_name, const IntRect& rect);
 
-      TrackScene generate_track_scene(const resources::Track& track, const PlacementMap& placement_map, bool all_assets);
+      // If cache_entry is not null, it receives the composed atlases and their mappings,
+      // so that they can be stored in the atlas cache. If geometry_cache_file is not empty,
+      // the geometry is taken from that file if possible, and stored there otherwise.
+      // If stream_atlases is set, the atlases are not uploaded, but handed to the track scene
+      // as atlas sources instead. If compress_atlases is set, the atlases are block-compressed
+      // before they are uploaded, streamed or cached.
+      TrackScene generate_track_scene(const resources::Track& track, const PlacementMap& placement_map, bool all_assets,
+                                      bool stream_atlases, bool compress_atlases, AtlasCacheEntry* cache_entry = nullptr,
+                                      const std::string& geometry_cache_file = std::string());
+
+      TrackScene generate_track_scene(const resources::Track& track, const AtlasCacheEntry& cache_entry, bool all_assets,
+                                      bool stream_atlases, const std::string& geometry_cache_file = std::string());
 
       using ImageLoader = graphics::DefaultImageLoader;
       sf::Image build_atlas_image(const AtlasDefinition &atlas, ImageLoader& image_loader);
+
+      // Decodes all source images referenced by the placement map that are not in the
+      // image loader's cache yet. The images are decoded concurrently.
+      void preload_atlas_images(const PlacementMap& placement_map, ImageLoader& image_loader);
+
+      // Composes the images of all atlases in the placement map, copying the placements in parallel.
+      // This does not need a GL context, the textures are created separately.
+      std::vector<sf::Image> build_atlas_images(const PlacementMap& placement_map, ImageLoader& image_loader);
     }
   }
 }
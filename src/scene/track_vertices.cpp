@@ -14,6 +14,8 @@
 #include "resources/tiles.hpp"
 #include "resources/tile_expansion.hpp"
 
+#include <boost/container/flat_map.hpp>
+
 namespace ts
 {
   namespace scene
@@ -82,40 +84,121 @@ namespace ts
     }
 
 
-    void build_track_vertices(const resources::Track& track, TrackScene& track_scene)
+    void TileGeometry::clear()
+    {
+      layer = nullptr;
+      batches.clear();
+      vertices.clear();
+      faces.clear();
+    }
+
+    void generate_tile_geometry(const resources::PlacedTile* tiles, std::size_t tile_count,
+                                const TextureMapping& texture_mapping, TileGeometry& geometry)
+    {
+      auto tile_range = boost::make_iterator_range(tiles, tiles + tile_count);
+
+      // Tracks tend to use a handful of tile definitions many times over, so look up every
+      // distinct tile id once instead of searching the whole texture mapping for every tile.
+      std::vector<std::uint64_t> tile_ids;
+      tile_ids.reserve(tile_count);
+      for (const auto& tile : tile_range)
+      {
+        tile_ids.push_back(TextureMapping::tile_id(tile.id));
+      }
+
+      std::sort(tile_ids.begin(), tile_ids.end());
+      tile_ids.erase(std::unique(tile_ids.begin(), tile_ids.end()), tile_ids.end());
+
+      boost::container::flat_map<std::uint64_t, TextureMapping::mapping_range> texture_lookup;
+      texture_lookup.reserve(tile_ids.size());
+      for (auto tile_id : tile_ids)
+      {
+        texture_lookup.emplace_hint(texture_lookup.end(), tile_id, texture_mapping.find(tile_id));
+      }
+
+      for (const auto& tile : tile_range)
+      {
+        for (const auto& mapping : texture_lookup.find(TextureMapping::tile_id(tile.id))->second)
+        {
+          auto& batches = geometry.batches;
+          if (batches.empty() || batches.back().level != tile.level || batches.back().texture != mapping.texture)
+          {
+            TileGeometry::Batch batch;
+            batch.level = tile.level;
+            batch.texture = mapping.texture;
+            batch.vertex_offset = static_cast<std::uint32_t>(geometry.vertices.size());
+            batch.vertex_count = 0;
+            batch.face_offset = static_cast<std::uint32_t>(geometry.faces.size());
+            batch.face_count = 0;
+            batches.push_back(batch);
+          }
+
+          auto& batch = batches.back();
+          auto vertices = generate_tile_vertices(tile, *tile.definition,
+                                                 mapping.texture_rect, mapping.fragment_offset,
+                                                 1.0f / mapping.texture->size());
+
+          auto faces = generate_tile_faces(batch.vertex_count);
 
+          geometry.vertices.insert(geometry.vertices.end(), vertices.begin(), vertices.end());
+          geometry.faces.insert(geometry.faces.end(), faces.begin(), faces.end());
+
+          batch.vertex_count += static_cast<std::uint32_t>(vertices.size());
+          batch.face_count += static_cast<std::uint32_t>(faces.size());
+        }
+      }
+    }
+
+    void generate_tile_layer_geometry(const resources::TrackLayer& layer, const resources::TileLibrary& tile_library,
+                                      const TextureMapping& texture_mapping, TileGeometry& geometry)
     {
-      const auto& tile_library = track.tile_library();
-      const auto& texture_library = track.texture_library();
-      const auto& texture_mapping = track_scene.texture_mapping();
+      geometry.clear();
+      geometry.layer = &layer;
 
-      const auto& textures = texture_library.textures();
+      if (auto tiles = layer.tiles())
+      {
+        std::vector<resources::PlacedTile> placed_tiles;
+        placed_tiles.reserve(tiles->size());
 
-      boost::optional<TextureMapping::texture_type> current_texture = boost::none;
-      Vector2f texture_scale;
+        resources::expand_tiles(tiles->begin(), tiles->end(), tile_library, std::back_inserter(placed_tiles));
 
-      std::vector<resources::PlacedTile> placed_tiles;
-      std::vector<resources::Vertex> vertex_cache;
+        geometry.vertices.reserve(placed_tiles.size() * 4);
+        geometry.faces.reserve(placed_tiles.size() * 2);
+        generate_tile_geometry(placed_tiles.data(), placed_tiles.size(), texture_mapping, geometry);
+      }
+    }
+
+    std::vector<TileGeometry> generate_tile_geometry(const resources::Track& track, const TextureMapping& texture_mapping,
+                                                     std::size_t thread_count)
+    {
+      std::vector<const resources::TrackLayer*> tile_layers;
+      for (const auto& layer : track.layers())
+      {
+        if (layer.tiles()) tile_layers.push_back(&layer);
+      }
 
-      auto texture_lookup = [&](std::size_t resource_id)
+      // The layers are independent of each other, and they all get their own buffer.
+      std::vector<TileGeometry> result(tile_layers.size());
+      utility::parallel_for(tile_layers.size(), [&](std::size_t index)
       {
-        if (current_texture) return texture_mapping.find(resource_id, *current_texture);
+        generate_tile_layer_geometry(*tile_layers[index], track.tile_library(), texture_mapping, result[index]);
+      }, thread_count);
+
+      return result;
+    }
 
-        return texture_mapping.find(resource_id);
-      };
+    void build_track_vertices(const resources::Track& track, TrackScene& track_scene)
+    {
+      // Generate the tile geometry for all layers up front, and then add everything
+      // to the scene in the original layer order.
+      auto tile_geometry = generate_tile_geometry(track, track_scene.texture_mapping());
+      auto tile_geometry_it = tile_geometry.begin();
 
       for (const auto& layer : track.layers())
       {
-        if (auto tiles = layer.tiles())
+        if (layer.tiles())
         {
-          for (const auto& tile : *tiles)
-          {
-            placed_tiles.clear();
-            resources::expand_tiles(&tile, &tile + 1,
-                                    tile_library, std::back_inserter(placed_tiles));
-
-            track_scene.add_tile_geometry(&layer, placed_tiles.data(), placed_tiles.size());
-          }
+          track_scene.add_tile_geometry(*tile_geometry_it++);
         }
 
         else if (auto path_style = layer.path_style())
@@ -130,4 +213,4 @@ namespace ts
       }
     }
   }
-}
\ No newline at end of file
+}
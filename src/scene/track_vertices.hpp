@@ -11,6 +11,7 @@
 #include "utility/rect.hpp"
 #include "utility/color.hpp"
 #include "utility/vector2.hpp"
+#include "utility/parallel_for.hpp"
 
 #include <boost/optional.hpp>
 
@@ -18,12 +19,20 @@
 #include <array>
 #include <cmath>
 #include <cstdint>
+#include <vector>
 
 namespace ts
 {
+  namespace graphics
+  {
+    class Texture;
+  }
+
   namespace resources
   {
     class Track;
+    class TrackLayer;
+    class TileLibrary;
     struct Tile;
     struct TileDefinition;
     struct TrackVertex;
@@ -43,6 +52,42 @@ namespace ts
 
     std::array<resources::Face, 2> generate_tile_faces(std::uint32_t base_index);
 
+    // The geometry of a number of tiles, generated without touching the TrackScene so that
+    // independent layers can be processed concurrently. Consecutive tiles that share a level
+    // and a texture are merged into a single batch, and face indices are relative to the first
+    // vertex of their batch.
+    struct TileGeometry
+    {
+      struct Batch
+      {
+        std::uint32_t level;
+        const graphics::Texture* texture;
+        std::uint32_t vertex_offset;
+        std::uint32_t vertex_count;
+        std::uint32_t face_offset;
+        std::uint32_t face_count;
+      };
+
+      const resources::TrackLayer* layer = nullptr;
+      std::vector<Batch> batches;
+      std::vector<resources::Vertex> vertices;
+      std::vector<resources::Face> faces;
+
+      void clear();
+    };
+
+    // Generate the geometry for a range of expanded tiles, appending it to the output.
+    void generate_tile_geometry(const resources::PlacedTile* tiles, std::size_t tile_count,
+                                const TextureMapping& texture_mapping, TileGeometry& geometry);
+
+    // Expand all tiles of a tile layer at once, and generate the geometry for them.
+    void generate_tile_layer_geometry(const resources::TrackLayer& layer, const resources::TileLibrary& tile_library,
+                                      const TextureMapping& texture_mapping, TileGeometry& geometry);
+
+    // Generate the geometry for all tile layers of the track, in layer order.
+    std::vector<TileGeometry> generate_tile_geometry(const resources::Track& track, const TextureMapping& texture_mapping,
+                                                     std::size_t thread_count = utility::default_thread_count());
+
     // This function takes a track and generates the vertices required to display it.
     // Writes the result to the TrackScene object. if use_relative_texture_coords is true,
     // divides the absolute texture coords by the texture size so that we get relative texture coords.    
@@ -0,0 +1,23 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include "texture_residency.hpp"
+
+#include <cstddef>
+
+namespace ts
+{
+  namespace scene
+  {
+    struct VideoSettings
+    {
+      // The GPU memory that streamed track atlases may take up, in bytes, see TextureResidency.
+      std::size_t texture_budget = TextureResidency::default_budget;
+    };
+  }
+}
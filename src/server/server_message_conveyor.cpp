@@ -13,6 +13,8 @@
 #include "stage/race_messages.hpp"
 #include "world/world_messages.hpp"
 
+#include "utility/stats.hpp"
+
 namespace ts
 {
   namespace server
@@ -34,6 +36,9 @@ namespace ts
     template <typename MessageType>
     void MessageConveyor::process_internal(const MessageType& message) const
     {
+      static const stats::Counter messages("server.messages_dispatched");
+      messages.add();
+
       process_helper(cup_, message, 0);
       process_helper(stage_, message, 0);
     }
@@ -52,6 +57,7 @@ namespace ts
         c.process(cm(client::messages::Update{}));
         c.process(cm(client::messages::LocalConnection{}));
         c.process(cm(world::messages::CarPropertiesUpdate{}));
+        c.process(cm(world::messages::PhysicsModeChange{}));
 
         c.process(stage::messages::RaceTimeUpdate{});        
         c.process(stage::messages::LapComplete{});           
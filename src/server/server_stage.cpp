@@ -56,6 +56,11 @@ namespace ts
       stage_regulator_.handle_message(car_update.message);
     }
 
+    void Stage::handle_message(const ClientMessage<world::messages::PhysicsModeChange>& mode_change)
+    {
+      stage_regulator_.handle_message(mode_change.message);
+    }
+
     const stage::StageDescription& Stage::stage_description() const
     {
       return stage_regulator_.stage()->stage_description();
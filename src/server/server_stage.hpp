@@ -39,6 +39,7 @@ namespace ts
       void handle_message(const ClientMessage<stage::messages::ControlUpdate>& update_message);
       void handle_message(const ClientMessage<client::messages::LocalConnection>& connect_message);
       void handle_message(const ClientMessage<world::messages::CarPropertiesUpdate>& car_update);
+      void handle_message(const ClientMessage<world::messages::PhysicsModeChange>& mode_change);
 
       // Internal message (server <-> server)
       void handle_message(const world::messages::ControlPointHit& cp_hit);
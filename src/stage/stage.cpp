@@ -22,6 +22,8 @@ namespace ts
         stage_description_(std::move(stage_description)),
         race_tracker_(100, static_cast<std::uint16_t>(world_.track().control_points().size()))
     {
+      world_.set_sub_step_config(stage_description_.sub_step_config);
+      world_.set_physics_mode(stage_description_.physics_mode);
       create_stage_entities();
     }
 
@@ -91,5 +93,15 @@ namespace ts
         }
       }
     }
+
+    void Stage::set_physics_mode(world::PhysicsMode mode)
+    {
+      world_.set_physics_mode(mode);
+    }
+
+    std::uint64_t Stage::state_hash() const
+    {
+      return world_.state_hash();
+    }
   }
 }
\ No newline at end of file
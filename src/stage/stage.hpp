@@ -54,6 +54,12 @@ namespace ts
       void set_controllable_state(std::uint16_t controllable_id, controls::ControlsMask controls_mask);
       void update_car_properties(const world::messages::CarPropertiesUpdate& msg);
 
+      // Can be changed in the middle of a race.
+      void set_physics_mode(world::PhysicsMode mode);
+
+      // The world's state hash after the most recent update, to compare runs of the same race.
+      std::uint64_t state_hash() const;
+
       void control_point_hit(const world::Entity* entity, std::uint16_t point_id, std::uint32_t point_flags,
                              std::uint32_t frame_offset, RaceEventInterface& event_interface);
 
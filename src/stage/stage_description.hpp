@@ -10,6 +10,9 @@
 #include "resources/track_reference.hpp"
 #include "resources/color_scheme.hpp"
 
+#include "world/sub_stepping.hpp"
+#include "world/physics_mode.hpp"
+
 #include <vector>
 
 namespace ts
@@ -39,6 +42,10 @@ namespace ts
 
       std::vector<resources::CarDefinition> car_models;
       std::vector<object_description::Car> car_instances;
+
+      // Applied to the stage's world. The default doesn't sub-step.
+      world::SubStepConfig sub_step_config;
+      world::PhysicsMode physics_mode = world::PhysicsMode::Chipmunk;
     };
   }
 }
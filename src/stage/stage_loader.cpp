@@ -14,6 +14,8 @@
 
 #include "world/terrain_map_builder.hpp"
 
+#include "utility/profiler.hpp"
+
 namespace ts
 {
   namespace stage
@@ -31,6 +33,8 @@ namespace ts
 
     std::unique_ptr<Stage> StageLoader::load_stage(StageDescription stage_desc)
     {
+      TS_PROFILE_ZONE("StageLoader::load_stage");
+
       set_progress(0.0);
       set_loading_state(LoadingState::LoadingTrack);
 
@@ -42,6 +46,14 @@ namespace ts
 
       auto terrain_map = world::build_terrain_map(track);
 
+      return load_stage(std::move(stage_desc), std::move(track), std::move(terrain_map));
+    }
+
+    std::unique_ptr<Stage> StageLoader::load_stage(StageDescription stage_desc, resources::Track track,
+                                                   world::TerrainMap terrain_map)
+    {
+      TS_PROFILE_ZONE("StageLoader::create_stage");
+
       world::World world_obj(std::move(track), std::move(terrain_map));
 
       set_loading_state(LoadingState::CreatingEntities);
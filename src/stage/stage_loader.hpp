@@ -12,6 +12,16 @@
 
 namespace ts
 {
+  namespace resources
+  {
+    class Track;
+  }
+
+  namespace world
+  {
+    class TerrainMap;
+  }
+
   namespace stage
   {
     class Stage;
@@ -31,6 +41,11 @@ namespace ts
     public:
       std::unique_ptr<Stage> load_stage(StageDescription stage_desc);
 
+      // Create the stage from a track and terrain map that were loaded beforehand,
+      // skipping the expensive parts of the loading process.
+      std::unique_ptr<Stage> load_stage(StageDescription stage_desc, resources::Track track,
+                                        world::TerrainMap terrain_map);
+
       void async_load_stage(StageDescription stage_desc);
     };
   }
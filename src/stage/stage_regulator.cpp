@@ -28,6 +28,11 @@ namespace ts
       stage_->update_car_properties(car_update);
     }
 
+    void StageRegulator::handle_message(const world::messages::PhysicsModeChange& mode_change)
+    {
+      stage_->set_physics_mode(mode_change.mode);
+    }
+
     void StageRegulator::control_point_hit(const world::messages::ControlPointHit& cp_hit,
                                            RaceEventInterface& event_interface)
     {
@@ -33,6 +33,7 @@ namespace ts
 
       void handle_message(const messages::ControlUpdate& control_message);
       void handle_message(const world::messages::CarPropertiesUpdate& car_update);
+      void handle_message(const world::messages::PhysicsModeChange& mode_change);
 
       void control_point_hit(const world::messages::ControlPointHit& cp_hit,
                              RaceEventInterface& event_interface);
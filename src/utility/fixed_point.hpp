@@ -0,0 +1,111 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+namespace ts
+{
+  // Signed 32.32 fixed-point number. All arithmetic happens on integers, which makes the results
+  // the same for every compiler, platform and set of floating point flags.
+  // Overflow wraps around, like it would for the underlying integer.
+  class Fixed64
+  {
+  public:
+    Fixed64() = default;
+
+    static Fixed64 from_raw(std::int64_t raw)
+    {
+      Fixed64 result;
+      result.raw_ = raw;
+      return result;
+    }
+
+    static Fixed64 from_int(std::int32_t value)
+    {
+      return from_raw(static_cast<std::int64_t>(static_cast<std::uint64_t>(value) << 32));
+    }
+
+    // Rounds to the nearest representable value. Values outside of the range are clamped.
+    static Fixed64 from_double(double value)
+    {
+      const double scale = 4294967296.0;
+      const double limit = 9223372036854774784.0;
+
+      auto scaled = value * scale;
+      if (!(scaled > -limit)) return from_raw(-INT64_C(9223372036854774784));
+      if (scaled > limit) return from_raw(INT64_C(9223372036854774784));
+
+      return from_raw(std::llround(scaled));
+    }
+
+    // numerator / denominator, rounded towards zero.
+    static Fixed64 from_ratio(std::int32_t numerator, std::int32_t denominator)
+    {
+      return from_raw(static_cast<std::int64_t>(static_cast<std::uint64_t>(numerator) << 32) / denominator);
+    }
+
+    std::int64_t raw() const { return raw_; }
+
+    // Exact as long as the magnitude is below 2^21.
+    double to_double() const
+    {
+      return static_cast<double>(raw_) / 4294967296.0;
+    }
+
+    Fixed64& operator+=(Fixed64 other)
+    {
+      raw_ = static_cast<std::int64_t>(static_cast<std::uint64_t>(raw_) + static_cast<std::uint64_t>(other.raw_));
+      return *this;
+    }
+
+    Fixed64& operator-=(Fixed64 other)
+    {
+      raw_ = static_cast<std::int64_t>(static_cast<std::uint64_t>(raw_) - static_cast<std::uint64_t>(other.raw_));
+      return *this;
+    }
+
+    Fixed64& operator*=(Fixed64 other);
+
+  private:
+    std::int64_t raw_ = 0;
+  };
+
+  inline Fixed64 operator+(Fixed64 a, Fixed64 b) { return a += b; }
+  inline Fixed64 operator-(Fixed64 a, Fixed64 b) { return a -= b; }
+  inline Fixed64 operator-(Fixed64 a) { return Fixed64() - a; }
+
+  // Computes the full 128-bit product out of 32-bit halves, and rounds it to the nearest value.
+  inline Fixed64 operator*(Fixed64 a, Fixed64 b)
+  {
+    auto negative = (a.raw() < 0) != (b.raw() < 0);
+    auto abs_a = a.raw() < 0 ? 0 - static_cast<std::uint64_t>(a.raw()) : static_cast<std::uint64_t>(a.raw());
+    auto abs_b = b.raw() < 0 ? 0 - static_cast<std::uint64_t>(b.raw()) : static_cast<std::uint64_t>(b.raw());
+
+    auto a_high = abs_a >> 32, a_low = abs_a & 0xFFFFFFFF;
+    auto b_high = abs_b >> 32, b_low = abs_b & 0xFFFFFFFF;
+
+    auto low = a_low * b_low;
+    auto result = ((a_high * b_high) << 32) + a_high * b_low + a_low * b_high + (low >> 32) +
+      ((low >> 31) & 1);
+
+    return Fixed64::from_raw(static_cast<std::int64_t>(negative ? 0 - result : result));
+  }
+
+  inline Fixed64& Fixed64::operator*=(Fixed64 other)
+  {
+    return *this = *this * other;
+  }
+
+  inline bool operator==(Fixed64 a, Fixed64 b) { return a.raw() == b.raw(); }
+  inline bool operator!=(Fixed64 a, Fixed64 b) { return a.raw() != b.raw(); }
+  inline bool operator<(Fixed64 a, Fixed64 b) { return a.raw() < b.raw(); }
+  inline bool operator>(Fixed64 a, Fixed64 b) { return a.raw() > b.raw(); }
+  inline bool operator<=(Fixed64 a, Fixed64 b) { return a.raw() <= b.raw(); }
+  inline bool operator>=(Fixed64 a, Fixed64 b) { return a.raw() >= b.raw(); }
+}
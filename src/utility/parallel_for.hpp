@@ -0,0 +1,92 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace ts
+{
+  namespace utility
+  {
+    // Returns the number of worker threads that parallel loops should use by default.
+    inline std::size_t default_thread_count()
+    {
+      return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+    // Invokes func(index) for every index in [0, count), dividing the index range into
+    // contiguous chunks that are processed concurrently. The calling thread processes the
+    // first chunk itself. Any exception thrown by func is rethrown once all chunks are done.
+    template <typename Func>
+    void parallel_for(std::size_t count, Func&& func, std::size_t thread_count = default_thread_count())
+    {
+      thread_count = std::max<std::size_t>(std::min(thread_count, count), 1);
+      if (thread_count == 1)
+      {
+        for (std::size_t index = 0; index != count; ++index) func(index);
+        return;
+      }
+
+      auto process_chunk = [&func, count, thread_count](std::size_t chunk)
+      {
+        auto begin = count * chunk / thread_count;
+        auto end = count * (chunk + 1) / thread_count;
+        for (auto index = begin; index != end; ++index) func(index);
+      };
+
+      std::vector<std::future<void>> futures;
+      futures.reserve(thread_count - 1);
+      for (std::size_t chunk = 1; chunk != thread_count; ++chunk)
+      {
+        futures.push_back(std::async(std::launch::async, process_chunk, chunk));
+      }
+
+      // Make sure the workers are joined before any exception leaves this function,
+      // they still refer to the function object.
+      std::exception_ptr exception;
+      try
+      {
+        process_chunk(0);
+      }
+
+      catch (...)
+      {
+        exception = std::current_exception();
+      }
+
+      for (auto& future : futures)
+      {
+        try
+        {
+          future.get();
+        }
+
+        catch (...)
+        {
+          if (!exception) exception = std::current_exception();
+        }
+      }
+
+      if (exception) std::rethrow_exception(exception);
+    }
+
+    // Range-based convenience wrapper around parallel_for.
+    template <typename RandomIt, typename Func>
+    void parallel_for_each(RandomIt first, RandomIt last, Func&& func,
+                           std::size_t thread_count = default_thread_count())
+    {
+      parallel_for(static_cast<std::size_t>(std::distance(first, last)),
+                   [first, &func](std::size_t index) { func(first[index]); }, thread_count);
+    }
+  }
+}
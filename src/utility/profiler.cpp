@@ -0,0 +1,200 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "profiler.hpp"
+#include "stream_utilities.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <ostream>
+
+namespace ts
+{
+  namespace profiler
+  {
+    const std::size_t detail::ThreadBuffer::capacity;
+
+    namespace detail
+    {
+      struct Registry
+      {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        std::vector<std::string> names;
+      };
+
+      // The buffers are never freed, so that the zones of threads that have already exited
+      // can still be collected.
+      Registry& registry()
+      {
+        static Registry registry;
+        return registry;
+      }
+
+      ThreadBuffer& register_thread()
+      {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        auto thread_index = static_cast<std::uint32_t>(reg.buffers.size());
+        reg.buffers.push_back(std::make_unique<ThreadBuffer>(thread_index));
+        reg.names.push_back("thread " + std::to_string(thread_index));
+        return *reg.buffers.back();
+      }
+
+      ThreadBuffer::ThreadBuffer(std::uint32_t thread_index)
+        : write_index_(0),
+          thread_index_(thread_index)
+      {
+      }
+
+      std::size_t ThreadBuffer::read(std::deque<ZoneRecord>& result)
+      {
+        auto write_index = write_index_.load(std::memory_order_acquire);
+        auto first = std::max(read_index_, write_index > capacity ? write_index - capacity : 0);
+        auto dropped = first - read_index_;
+
+        auto old_size = result.size();
+        for (auto index = first; index != write_index; ++index)
+        {
+          result.push_back(records_[index & (capacity - 1)]);
+        }
+
+        // The owner may have lapped us while we were copying. The records it overwrote, or may
+        // be overwriting right now, are at the front of the ones we just read. The fence keeps
+        // the copies above from being reordered past the load below.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        auto unsafe_end = write_index_.load(std::memory_order_acquire) + 1;
+        if (unsafe_end - first > capacity)
+        {
+          auto overwritten = std::min<std::uint64_t>(unsafe_end - capacity - first, write_index - first);
+          result.erase(result.begin() + old_size, result.begin() + old_size + overwritten);
+          dropped += overwritten;
+        }
+
+        read_index_ = write_index;
+        return static_cast<std::size_t>(dropped);
+      }
+    }
+
+    void set_thread_name(const std::string& name)
+    {
+      auto thread_index = detail::thread_buffer().thread_index();
+
+      auto& reg = detail::registry();
+      std::lock_guard<std::mutex> lock(reg.mutex);
+      reg.names[thread_index] = name;
+    }
+
+    Collector::Collector(std::uint64_t history_duration)
+      : history_duration_(history_duration)
+    {
+    }
+
+    void Collector::collect()
+    {
+      auto& reg = detail::registry();
+      {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (std::size_t index = threads_.size(); index < reg.buffers.size(); ++index)
+        {
+          threads_.emplace_back();
+          threads_.back().thread_index = static_cast<std::uint32_t>(index);
+        }
+
+        for (auto& thread : threads_)
+        {
+          thread.name = reg.names[thread.thread_index];
+          dropped_count_ += reg.buffers[thread.thread_index]->read(thread.zones);
+        }
+      }
+
+      latest_time_ = now();
+      auto min_time = latest_time_ > history_duration_ ? latest_time_ - history_duration_ : 0;
+      for (auto& thread : threads_)
+      {
+        while (!thread.zones.empty() && thread.zones.front().end < min_time)
+        {
+          thread.zones.pop_front();
+        }
+      }
+    }
+
+    void Collector::clear()
+    {
+      for (auto& thread : threads_)
+      {
+        thread.zones.clear();
+      }
+
+      dropped_count_ = 0;
+    }
+
+    void Collector::set_history_duration(std::uint64_t duration)
+    {
+      history_duration_ = duration;
+    }
+
+    std::uint64_t Collector::history_duration() const
+    {
+      return history_duration_;
+    }
+
+    const std::vector<ThreadHistory>& Collector::threads() const
+    {
+      return threads_;
+    }
+
+    std::uint64_t Collector::latest_time() const
+    {
+      return latest_time_;
+    }
+
+    std::size_t Collector::dropped_count() const
+    {
+      return dropped_count_;
+    }
+
+    void write_chrome_trace(std::ostream& stream, const Collector& collector)
+    {
+      // The timestamps are in microseconds, relative to the oldest zone to keep them short.
+      auto origin = collector.latest_time();
+      for (const auto& thread : collector.threads())
+      {
+        for (const auto& zone : thread.zones) origin = std::min(origin, zone.start);
+      }
+
+      auto precision = stream.precision(3);
+      auto flags = stream.setf(std::ios::fixed, std::ios::floatfield);
+
+      const char* separator = "\n";
+      stream << "{\"traceEvents\":[";
+      for (const auto& thread : collector.threads())
+      {
+        stream << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.thread_index
+          << ",\"args\":{\"name\":";
+        write_json_string(stream, thread.name);
+        stream << "}}";
+        separator = ",\n";
+
+        for (const auto& zone : thread.zones)
+        {
+          stream << separator << "{\"name\":";
+          write_json_string(stream, zone.name);
+          stream << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.thread_index
+            << ",\"ts\":" << (zone.start - origin) * 0.001 << ",\"dur\":" << (zone.end - zone.start) * 0.001 << "}";
+        }
+      }
+
+      stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+      stream.precision(precision);
+      stream.flags(flags);
+    }
+  }
+}
@@ -0,0 +1,170 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// TS_PROFILE_ZONE("name") times the rest of the enclosing scope. The name must be a string
+// literal, only the pointer is stored. Without TS_PROFILER, the macros expand to nothing.
+#if defined(TS_PROFILER)
+#define TS_PROFILER_CONCAT_IMPL(a, b) a##b
+#define TS_PROFILER_CONCAT(a, b) TS_PROFILER_CONCAT_IMPL(a, b)
+
+#define TS_PROFILE_ZONE(name) const ::ts::profiler::Zone TS_PROFILER_CONCAT(profile_zone_, __LINE__)(name)
+#define TS_PROFILE_THREAD(name) ::ts::profiler::set_thread_name(name)
+#else
+#define TS_PROFILE_ZONE(name) ((void)0)
+#define TS_PROFILE_THREAD(name) ((void)0)
+#endif
+
+namespace ts
+{
+  namespace profiler
+  {
+    // Nanoseconds since an arbitrary, fixed point in time.
+    inline std::uint64_t now()
+    {
+      using clock_type = std::chrono::steady_clock;
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now().time_since_epoch()).count();
+    }
+
+    struct ZoneRecord
+    {
+      const char* name;
+      std::uint64_t start;
+      std::uint64_t end;
+      std::uint32_t depth;
+    };
+
+    namespace detail
+    {
+      // Every thread writes its zones into a ring buffer of its own, which the collector reads
+      // without locking. If the collector falls behind, the oldest zones are overwritten.
+      class ThreadBuffer
+      {
+      public:
+        static const std::size_t capacity = 1 << 14;
+
+        explicit ThreadBuffer(std::uint32_t thread_index);
+
+        void push(const ZoneRecord& record)
+        {
+          auto index = write_index_.load(std::memory_order_relaxed);
+          records_[index & (capacity - 1)] = record;
+          write_index_.store(index + 1, std::memory_order_release);
+        }
+
+        // Appends the zones that were finished since the last call, and returns the number of
+        // zones that were lost in between. Must only be called by one thread at a time.
+        std::size_t read(std::deque<ZoneRecord>& result);
+
+        std::uint32_t thread_index() const { return thread_index_; }
+
+        // Only used by the owning thread.
+        std::uint32_t depth = 0;
+
+      private:
+        std::array<ZoneRecord, capacity> records_;
+        std::atomic<std::uint64_t> write_index_;
+        std::uint64_t read_index_ = 0;
+        std::uint32_t thread_index_;
+      };
+
+      ThreadBuffer& register_thread();
+
+      inline ThreadBuffer& thread_buffer()
+      {
+        static thread_local ThreadBuffer* buffer = nullptr;
+        if (!buffer) buffer = &register_thread();
+
+        return *buffer;
+      }
+    }
+
+    // Records the time between its construction and its destruction. Zones that are
+    // created while another one is alive on the same thread are nested in that one.
+    class Zone
+    {
+    public:
+      explicit Zone(const char* name)
+        : buffer_(&detail::thread_buffer()),
+          name_(name),
+          depth_(buffer_->depth++),
+          start_(now())
+      {
+      }
+
+      ~Zone()
+      {
+        buffer_->push({ name_, start_, now(), depth_ });
+        --buffer_->depth;
+      }
+
+      Zone(const Zone&) = delete;
+      Zone& operator=(const Zone&) = delete;
+
+    private:
+      detail::ThreadBuffer* buffer_;
+      const char* name_;
+      std::uint32_t depth_;
+      std::uint64_t start_;
+    };
+
+    // Names the calling thread in the profiler's output.
+    void set_thread_name(const std::string& name);
+
+    struct ThreadHistory
+    {
+      std::uint32_t thread_index;
+      std::string name;
+
+      // In the order in which the zones ended, which puts nested zones before their parent.
+      std::deque<ZoneRecord> zones;
+    };
+
+    // The Collector gathers the zones of all threads, and keeps the ones that ended within
+    // the history duration. Only one collector should exist at a time, because reading
+    // the zones consumes them.
+    class Collector
+    {
+    public:
+      explicit Collector(std::uint64_t history_duration = 2000000000);
+
+      // Meant to be called once per frame.
+      void collect();
+      void clear();
+
+      void set_history_duration(std::uint64_t duration);
+      std::uint64_t history_duration() const;
+
+      const std::vector<ThreadHistory>& threads() const;
+
+      // The time of the last call to collect().
+      std::uint64_t latest_time() const;
+
+      // The number of zones that were overwritten before they could be collected.
+      std::size_t dropped_count() const;
+
+    private:
+      std::uint64_t history_duration_;
+      std::uint64_t latest_time_ = 0;
+      std::size_t dropped_count_ = 0;
+      std::vector<ThreadHistory> threads_;
+    };
+
+    // Writes the collected zones in the Chrome trace event format, which can be
+    // opened with chrome://tracing or any other compatible viewer.
+    void write_chrome_trace(std::ostream& stream, const Collector& collector);
+  }
+}
@@ -8,6 +8,7 @@
 
 #include <random>
 #include <limits>
+#include <cstdint>
 
 namespace ts
 {
@@ -43,5 +44,44 @@ namespace ts
     {
       return dist(detail::random_engine());
     }
+
+    // PCG32 (pcg-random.org): a small and fast generator for hot loops that don't need the
+    // quality of the standard engines. Usable with the standard distributions.
+    class Pcg32
+    {
+    public:
+      using result_type = std::uint32_t;
+
+      explicit Pcg32(std::uint64_t seed = 0x853C49E6748FEA9BULL, std::uint64_t stream = 0xDA3E39CB94B95BDBULL)
+        : increment_((stream << 1) | 1)
+      {
+        operator()();
+        state_ += seed;
+        operator()();
+      }
+
+      result_type operator()()
+      {
+        auto old_state = state_;
+        state_ = old_state * 6364136223846793005ULL + increment_;
+
+        auto xor_shifted = static_cast<std::uint32_t>(((old_state >> 18) ^ old_state) >> 27);
+        auto rotation = static_cast<std::uint32_t>(old_state >> 59);
+        return (xor_shifted >> rotation) | (xor_shifted << ((0U - rotation) & 31));
+      }
+
+      // Uniformly distributed in [0, 1).
+      float next_float()
+      {
+        return (operator()() >> 8) * (1.0f / 16777216.0f);
+      }
+
+      static constexpr result_type min() { return 0; }
+      static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    private:
+      std::uint64_t state_ = 0;
+      std::uint64_t increment_;
+    };
   }
 }
@@ -0,0 +1,165 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "stats.hpp"
+#include "stream_utilities.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+
+namespace ts
+{
+  namespace stats
+  {
+    namespace detail
+    {
+      CounterShard::CounterShard()
+      {
+        for (auto& value : values) value.store(0, std::memory_order_relaxed);
+      }
+
+      struct Registry
+      {
+        Registry()
+        {
+          for (auto& value : gauges) value.store(0, std::memory_order_relaxed);
+        }
+
+        std::mutex mutex;
+        std::vector<std::string> names;
+        std::vector<StatKind> kinds;
+
+        // Like the profiler's buffers, the shards outlive their threads, so that nothing that
+        // was counted gets lost.
+        std::vector<std::unique_ptr<CounterShard>> shards;
+        std::array<std::atomic<std::int64_t>, max_stats> gauges;
+
+        std::vector<std::int64_t> previous_totals;
+        Snapshot snapshot;
+      };
+
+      Registry& registry()
+      {
+        static Registry registry;
+        return registry;
+      }
+
+      CounterShard& register_thread()
+      {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        reg.shards.push_back(std::make_unique<CounterShard>());
+        return *reg.shards.back();
+      }
+
+      std::atomic<std::int64_t>& gauge_value(std::uint32_t index)
+      {
+        return registry().gauges[index];
+      }
+
+      std::uint32_t register_stat(const char* name, StatKind kind)
+      {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        auto it = std::find(reg.names.begin(), reg.names.end(), name);
+        if (it != reg.names.end())
+        {
+          auto index = static_cast<std::uint32_t>(it - reg.names.begin());
+          if (reg.kinds[index] != kind)
+          {
+            throw std::logic_error("stat '" + std::string(name) + "' registered as both counter and gauge");
+          }
+
+          return index;
+        }
+
+        if (reg.names.size() == max_stats)
+        {
+          throw std::length_error("too many stats");
+        }
+
+        reg.names.push_back(name);
+        reg.kinds.push_back(kind);
+        return static_cast<std::uint32_t>(reg.names.size() - 1);
+      }
+    }
+
+    const SnapshotEntry* Snapshot::find(const std::string& name) const
+    {
+      auto it = std::find_if(entries.begin(), entries.end(),
+                             [&](const SnapshotEntry& entry) { return entry.name == name; });
+
+      return it != entries.end() ? &*it : nullptr;
+    }
+
+    void merge_frame()
+    {
+      auto& reg = detail::registry();
+      std::lock_guard<std::mutex> lock(reg.mutex);
+
+      auto stat_count = reg.names.size();
+      reg.previous_totals.resize(stat_count, 0);
+
+      auto& snapshot = reg.snapshot;
+      snapshot.entries.resize(stat_count);
+      ++snapshot.frame_count;
+
+      for (std::size_t index = 0; index != stat_count; ++index)
+      {
+        auto& entry = snapshot.entries[index];
+        entry.name = reg.names[index];
+        entry.kind = reg.kinds[index];
+
+        if (entry.kind == StatKind::Gauge)
+        {
+          entry.value = entry.total = reg.gauges[index].load(std::memory_order_relaxed);
+          continue;
+        }
+
+        std::int64_t total = 0;
+        for (const auto& shard : reg.shards)
+        {
+          total += shard->values[index].load(std::memory_order_relaxed);
+        }
+
+        entry.total = total;
+        entry.value = total - reg.previous_totals[index];
+        reg.previous_totals[index] = total;
+      }
+    }
+
+    Snapshot latest_snapshot()
+    {
+      auto& reg = detail::registry();
+      std::lock_guard<std::mutex> lock(reg.mutex);
+      return reg.snapshot;
+    }
+
+    void write_snapshot(std::ostream& stream, const Snapshot& snapshot)
+    {
+      stream << "{\"frame\":" << snapshot.frame_count << ",\"stats\":{";
+
+      const char* separator = "";
+      for (const auto& entry : snapshot.entries)
+      {
+        stream << separator << "\n";
+        write_json_string(stream, entry.name);
+        stream << ":{\"value\":" << entry.value;
+        if (entry.kind == StatKind::Counter) stream << ",\"total\":" << entry.total;
+
+        stream << "}";
+        separator = ",";
+      }
+
+      stream << "\n}}\n";
+    }
+  }
+}
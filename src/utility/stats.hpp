@@ -0,0 +1,124 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace ts
+{
+  namespace stats
+  {
+    static const std::size_t max_stats = 256;
+
+    enum class StatKind
+    {
+      Counter,
+      Gauge
+    };
+
+    namespace detail
+    {
+      // Every thread adds to its own copy of the counters, so that incrementing one never
+      // contends with other threads. The shards are summed by merge_frame().
+      struct CounterShard
+      {
+        CounterShard();
+
+        std::array<std::atomic<std::int64_t>, max_stats> values;
+      };
+
+      CounterShard& register_thread();
+      std::atomic<std::int64_t>& gauge_value(std::uint32_t index);
+
+      inline CounterShard& counter_shard()
+      {
+        static thread_local CounterShard* shard = nullptr;
+        if (!shard) shard = &register_thread();
+
+        return *shard;
+      }
+
+      std::uint32_t register_stat(const char* name, StatKind kind);
+    }
+
+    // A Counter keeps counting up, its value in a snapshot is the amount it was increased by
+    // during the last frame. Counters with the same name share their value, which allows them
+    // to be declared as function-local statics.
+    class Counter
+    {
+    public:
+      explicit Counter(const char* name)
+        : index_(detail::register_stat(name, StatKind::Counter))
+      {
+      }
+
+      void add(std::int64_t amount = 1) const
+      {
+        // Only the owning thread writes to the shard, so this needs no read-modify-write.
+        auto& value = detail::counter_shard().values[index_];
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+      }
+
+    private:
+      std::uint32_t index_;
+    };
+
+    // A Gauge holds the last value that was set, from any thread.
+    class Gauge
+    {
+    public:
+      explicit Gauge(const char* name)
+        : index_(detail::register_stat(name, StatKind::Gauge))
+      {
+      }
+
+      void set(std::int64_t value) const
+      {
+        detail::gauge_value(index_).store(value, std::memory_order_relaxed);
+      }
+
+    private:
+      std::uint32_t index_;
+    };
+
+    struct SnapshotEntry
+    {
+      std::string name;
+      StatKind kind;
+
+      // Counters: the increase during the last merged frame, and the total since startup.
+      // Gauges: the current value, for both.
+      std::int64_t value;
+      std::int64_t total;
+    };
+
+    struct Snapshot
+    {
+      std::uint64_t frame_count = 0;
+
+      // In the order of registration.
+      std::vector<SnapshotEntry> entries;
+
+      const SnapshotEntry* find(const std::string& name) const;
+    };
+
+    // Sums the per-thread counters and takes the next snapshot. Meant to be called once per frame,
+    // by one thread.
+    void merge_frame();
+
+    // The snapshot taken by the last call to merge_frame(). Can be called from any thread.
+    Snapshot latest_snapshot();
+
+    // Writes the snapshot as a JSON object, for periodic dumps.
+    void write_snapshot(std::ostream& stream, const Snapshot& snapshot);
+  }
+}
@@ -24,4 +24,17 @@ namespace ts
   {
     return read_stream_contents(make_ifstream(file_name, std::ios::binary | std::ios::in));
   }
+
+  void write_json_string(std::ostream& stream, boost::string_ref string)
+  {
+    stream << '"';
+    for (char ch : string)
+    {
+      if (ch == '"' || ch == '\\') stream << '\\' << ch;
+      else if (static_cast<unsigned char>(ch) < 0x20) stream << ' ';
+      else stream << ch;
+    }
+
+    stream << '"';
+  }
 }
\ No newline at end of file
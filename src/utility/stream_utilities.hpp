@@ -12,8 +12,11 @@
 
 #include <string>
 #include <istream>
+#include <ostream>
 #include <fstream>
 #include <vector>
+#include <cstddef>
+#include <cstring>
 
 namespace ts
 {
@@ -22,6 +25,9 @@ namespace ts
 
   std::vector<char> load_file_contents(const std::string& file_name);
 
+  // Writes the string as a quoted JSON string. Control characters are replaced by spaces.
+  void write_json_string(std::ostream& stream, boost::string_ref string);
+
   template <typename CharType>
   std::vector<CharType> read_stream_contents(std::basic_istream<CharType>& stream)
   {
@@ -46,6 +52,51 @@ namespace ts
     return read_stream_contents(stream);
   }
 
+  // Writes the object representation of trivially copyable values, for use in binary cache files.
+  template <typename T>
+  void write_value(std::ostream& stream, const T& value)
+  {
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  template <typename T>
+  void write_values(std::ostream& stream, const T* values, std::size_t count)
+  {
+    stream.write(reinterpret_cast<const char*>(values), sizeof(T) * count);
+  }
+
+  // Reads values from a memory buffer, keeping track of whether a read went out of bounds.
+  struct BufferReader
+  {
+    const char* data;
+    const char* end;
+    bool valid = true;
+
+    template <typename T>
+    T read()
+    {
+      T value{};
+      read(&value, 1);
+      return value;
+    }
+
+    template <typename T>
+    void read(T* values, std::size_t count)
+    {
+      if (static_cast<std::size_t>(end - data) / sizeof(T) < count)
+      {
+        valid = false;
+        data = end;
+      }
+
+      else
+      {
+        std::memcpy(values, data, sizeof(T) * count);
+        data += sizeof(T) * count;
+      }
+    }
+  };
+
   struct ArrayStream
     : private boost::iostreams::array_source, 
       public boost::iostreams::stream<boost::iostreams::array_source>
@@ -21,14 +21,17 @@ namespace ts
       // Finds the element in the range that has sufficient width and height,
       // and leaves the *least* space on the short side. That is, the rect
       // where min(rect.width - width, rect.height - height) is the lowest.
+      // The rect must also have room for the footprint, unless it is cut off by the atlas edge.
       // Returns an iterator to the best match.
 
       template <typename ForwardRectIt>
-      static ForwardRectIt find_best_matching_rect(ForwardRectIt begin, ForwardRectIt end, std::int32_t width, std::int32_t height)
+      static ForwardRectIt find_best_matching_rect(ForwardRectIt begin, ForwardRectIt end, std::int32_t width, std::int32_t height,
+                                                   Vector2i footprint, Vector2i atlas_size)
       {
         auto match_rect = [=](const IntRect& rect)
         {
-          return rect.width >= width && rect.height >= height;
+          return rect.width >= std::max(width, std::min(footprint.x, atlas_size.x - rect.left)) &&
+            rect.height >= std::max(height, std::min(footprint.y, atlas_size.y - rect.top));
         };
 
         ForwardRectIt it = std::find_if(begin, end, match_rect);
@@ -134,18 +137,37 @@ namespace ts
       }
     }
 
-    TextureAtlas::TextureAtlas(Vector2i size)
-      : my_size_(size)
+    TextureAtlas::TextureAtlas(Vector2i size, AtlasPackingStrategy strategy)
+      : strategy_(strategy),
+        my_size_(size)
     {
       if (size.x && size.y)
       {
         free_space_.push_back({ 0, 0, size.x, size.y });
+        skyline_.push_back({ 0, 0, size.x });
       }
     }
 
     void TextureAtlas::clear()
     {
-      *this = TextureAtlas(my_size_);
+      auto padding = padding_;
+      auto alignment = alignment_;
+      *this = TextureAtlas(my_size_, strategy_);
+      padding_ = padding;
+      alignment_ = alignment;
+    }
+
+    AtlasPackingStrategy TextureAtlas::packing_strategy() const
+    {
+      return strategy_;
+    }
+
+    double TextureAtlas::occupancy() const
+    {
+      auto area = static_cast<std::int64_t>(my_size_.x) * my_size_.y;
+      if (area == 0) return 0.0;
+
+      return static_cast<double>(used_area_) / area;
     }
 
     Vector2i TextureAtlas::size() const
@@ -163,25 +185,63 @@ namespace ts
       padding_ = padding;
     }
 
+    std::int32_t TextureAtlas::alignment() const
+    {
+      return alignment_;
+    }
+
+    void TextureAtlas::set_alignment(std::int32_t alignment)
+    {
+      alignment_ = std::max(alignment, 1);
+    }
+
+    // Returns the size of the space a rect takes up: its padding included, rounded up to the alignment.
+    Vector2i TextureAtlas::footprint(Vector2i rect_size) const
+    {
+      auto aligned_extent = [this](std::int32_t extent)
+      {
+        return (extent + alignment_ - 1) / alignment_ * alignment_;
+      };
+
+      return{ aligned_extent(rect_size.x + padding_), aligned_extent(rect_size.y + padding_) };
+    }
+
     boost::optional<IntRect> TextureAtlas::insert(Vector2i rect_size)
+    {
+      auto result = strategy_ == AtlasPackingStrategy::Skyline ?
+        insert_skyline(rect_size) : insert_max_rects(rect_size);
+
+      if (result)
+      {
+        used_area_ += static_cast<std::int64_t>(rect_size.x) * rect_size.y;
+      }
+
+      return result;
+    }
+
+    boost::optional<IntRect> TextureAtlas::insert_max_rects(Vector2i rect_size)
     {
       const IntRect* free_space = free_space_.data();
       const IntRect* free_space_end = free_space_.data() + free_space_.size();
 
-      auto padded_size = rect_size + padding_ * 2;
+      auto padded_size = footprint(rect_size);
 
+      // Requiring room for the whole footprint keeps the padding between this rect and the ones
+      // after it, too. Otherwise, a rect could be placed right up against one inserted before it.
       const IntRect* best_match = detail::find_best_matching_rect(free_space, free_space_end, 
-                                                                  rect_size.x, rect_size.y);
+                                                                  rect_size.x, rect_size.y,
+                                                                  padded_size, my_size_);
       if (best_match == free_space_end)
       {
         // No suitable rects found.
         return boost::none;
       }
 
+      // The free rects' edges stay aligned, as long as the space taken up by every rect is.
       IntRect used_rect(best_match->left, best_match->top, rect_size.x, rect_size.y);
       IntRect padded_rect = used_rect;
-      padded_rect.width += padding_;
-      padded_rect.height += padding_;
+      padded_rect.width = padded_size.x;
+      padded_rect.height = padded_size.y;
 
       // Split the free rects. First we need to find all the rects that intersect with the one
       // we allocated, split them, and then remove the old ones.
@@ -207,11 +267,109 @@ namespace ts
       return used_rect;
     }
 
+    // Returns the y coordinate at which a rect of the given size can be placed, if its left edge
+    // is put at the start of the given skyline node. The rect rests on the highest node its
+    // footprint spans, so that the padding to its right isn't taken up by a taller neighbour.
+    boost::optional<std::int32_t> TextureAtlas::skyline_fit(std::size_t node_index, Vector2i rect_size) const
+    {
+      auto x = skyline_[node_index].x;
+      if (x + rect_size.x > my_size_.x) return boost::none;
+
+      std::int32_t y = 0;
+      auto span = std::min(footprint(rect_size).x, my_size_.x - x);
+      for (auto width_left = span; width_left > 0; ++node_index)
+      {
+        const auto& node = skyline_[node_index];
+        y = std::max(y, node.y);
+        if (y + rect_size.y > my_size_.y) return boost::none;
+
+        width_left -= node.width;
+      }
+
+      return y;
+    }
+
+    // Bottom-left skyline packing: place the rect where its bottom edge ends up lowest,
+    // preferring narrower nodes in case of a tie.
+    boost::optional<IntRect> TextureAtlas::insert_skyline(Vector2i rect_size)
+    {
+      auto best_index = skyline_.size();
+      auto best_bottom = my_size_.y + 1;
+      auto best_width = my_size_.x + 1;
+      std::int32_t best_y = 0;
+
+      for (std::size_t index = 0; index != skyline_.size(); ++index)
+      {
+        if (auto y = skyline_fit(index, rect_size))
+        {
+          auto bottom = *y + rect_size.y;
+          if (bottom < best_bottom || (bottom == best_bottom && skyline_[index].width < best_width))
+          {
+            best_index = index;
+            best_bottom = bottom;
+            best_width = skyline_[index].width;
+            best_y = *y;
+          }
+        }
+      }
+
+      if (best_index == skyline_.size())
+      {
+        return boost::none;
+      }
+
+      IntRect used_rect(skyline_[best_index].x, best_y, rect_size.x, rect_size.y);
+
+      SkylineNode new_node;
+      new_node.x = used_rect.left;
+      auto padded_size = footprint(rect_size);
+      new_node.y = used_rect.top + padded_size.y;
+      new_node.width = std::min(padded_size.x, my_size_.x - used_rect.left);
+
+      auto node_it = skyline_.insert(skyline_.begin() + best_index, new_node);
+      auto new_right = new_node.x + new_node.width;
+
+      // Shrink or remove the nodes that are now covered by the new one.
+      for (auto it = std::next(node_it); it != skyline_.end() && it->x < new_right; )
+      {
+        auto shrink = new_right - it->x;
+        if (shrink >= it->width)
+        {
+          it = skyline_.erase(it);
+        }
+
+        else
+        {
+          it->x += shrink;
+          it->width -= shrink;
+          break;
+        }
+      }
+
+      // Merge neighbouring nodes at the same height.
+      for (std::size_t index = 0; index + 1 < skyline_.size(); )
+      {
+        if (skyline_[index].y == skyline_[index + 1].y)
+        {
+          skyline_[index].width += skyline_[index + 1].width;
+          skyline_.erase(skyline_.begin() + index + 1);
+        }
+
+        else
+        {
+          ++index;
+        }
+      }
+
+      return used_rect;
+    }
+
 
-    AtlasList::AtlasList(Vector2i atlas_size)
-      : atlas_size_(atlas_size)
+    AtlasList::AtlasList(Vector2i atlas_size, AtlasPackingStrategy strategy)
+      : atlas_size_(atlas_size),
+        strategy_(strategy)
     {
-      atlas_list_.emplace_back(atlas_size);
+      atlas_list_.emplace_back(atlas_size, strategy);
     }
 
     std::size_t AtlasList::current_atlas() const
@@ -242,6 +400,18 @@ namespace ts
     void AtlasList::set_padding(std::int32_t padding)
     {
       padding_ = padding;
+      for (auto& atlas : atlas_list_) atlas.set_padding(padding);
+    }
+
+    std::int32_t AtlasList::alignment() const
+    {
+      return alignment_;
+    }
+
+    void AtlasList::set_alignment(std::int32_t alignment)
+    {
+      alignment_ = alignment;
+      for (auto& atlas : atlas_list_) atlas.set_alignment(alignment);
     }
 
     std::int32_t AtlasList::fragment_overlap() const
@@ -254,12 +424,42 @@ namespace ts
       fragment_overlap_ = fragment_overlap;
     }
 
+    bool AtlasList::first_fit() const
+    {
+      return first_fit_;
+    }
+
+    void AtlasList::set_first_fit(bool first_fit)
+    {
+      first_fit_ = first_fit;
+    }
+
+    double AtlasList::occupancy(std::size_t atlas_id) const
+    {
+      return atlas_list_[atlas_id].occupancy();
+    }
+
     boost::optional<AtlasEntry> AtlasList::allocate_rect(IntRect source_rect)
+    {
+      if (first_fit_)
+      {
+        for (std::size_t atlas_id = 0; atlas_id != atlas_list_.size(); ++atlas_id)
+        {
+          if (auto entry = allocate_rect(atlas_id, source_rect)) return entry;
+        }
+
+        return boost::none;
+      }
+
+      return allocate_rect(current_atlas_, source_rect);
+    }
+
+    boost::optional<AtlasEntry> AtlasList::allocate_rect(std::size_t atlas_id, IntRect source_rect)
     {     
-      if (auto rect = atlas_list_[current_atlas_].insert({ source_rect.width, source_rect.height }))
+      if (auto rect = atlas_list_[atlas_id].insert({ source_rect.width, source_rect.height }))
       {
         AtlasEntry result;
-        result.atlas_id = current_atlas_;
+        result.atlas_id = atlas_id;
         result.atlas_rect = *rect;
         result.source_rect = source_rect;
         return result;
@@ -276,8 +476,9 @@ namespace ts
     std::size_t AtlasList::create_atlas(Vector2i size)
     {
       current_atlas_ = atlas_list_.size();
-      atlas_list_.emplace_back(atlas_size_);
+      atlas_list_.emplace_back(atlas_size_, strategy_);
       atlas_list_.back().set_padding(padding_);
+      atlas_list_.back().set_alignment(alignment_);
 
       return current_atlas_;
     }
@@ -18,10 +18,19 @@ namespace ts
 {
   namespace utility
   {
+    // MaxRects keeps a list of maximal free rectangles and picks the one that leaves the
+    // least space on the short side. Skyline only tracks the top edge of the packed area,
+    // which is cheaper, but tends to waste more space with rects of varying heights.
+    enum class AtlasPackingStrategy
+    {
+      MaxRects,
+      Skyline
+    };
+
     class TextureAtlas
     {
     public:
-      explicit TextureAtlas(Vector2i size = {});
+      explicit TextureAtlas(Vector2i size = {}, AtlasPackingStrategy strategy = AtlasPackingStrategy::MaxRects);
 
       Vector2i size() const;
       void clear();
@@ -30,11 +39,39 @@ namespace ts
       void set_padding(std::int32_t padding);
       std::int32_t padding() const;
 
+      // Inserted rects are kept at least `padding` pixels apart. Their positions are multiples of
+      // the alignment, and the space they take up, padding included, is rounded up to it. With an alignment of 4, no 4x4 block of a
+      // block-compressed atlas spans more than one rect. The atlas size must be a multiple of it.
+      void set_alignment(std::int32_t alignment);
+      std::int32_t alignment() const;
+
+      AtlasPackingStrategy packing_strategy() const;
+
+      // Returns the fraction of the atlas area that is covered by inserted rects, padding excluded.
+      double occupancy() const;
+
     private:
+      boost::optional<IntRect> insert_max_rects(Vector2i rect_size);
+      boost::optional<IntRect> insert_skyline(Vector2i rect_size);
+
+      struct SkylineNode
+      {
+        std::int32_t x;
+        std::int32_t y;
+        std::int32_t width;
+      };
+
+      boost::optional<std::int32_t> skyline_fit(std::size_t node_index, Vector2i rect_size) const;
+      Vector2i footprint(Vector2i rect_size) const;
+
       std::vector<IntRect> free_space_;
       std::vector<IntRect> rect_cache_;
+      std::vector<SkylineNode> skyline_;
 
+      AtlasPackingStrategy strategy_ = AtlasPackingStrategy::MaxRects;
       std::int32_t padding_ = 1;
+      std::int32_t alignment_ = 1;
+      std::int64_t used_area_ = 0;
       Vector2i my_size_ = {};
     };
 
@@ -48,11 +85,13 @@ namespace ts
     class AtlasList
     {
     public:
-      explicit AtlasList(Vector2i atlas_size);
+      explicit AtlasList(Vector2i atlas_size, AtlasPackingStrategy strategy = AtlasPackingStrategy::MaxRects);
 
       std::size_t current_atlas() const;
       std::size_t create_atlas();
 
+      // Allocates space in the current atlas, or, in first-fit mode, in the first atlas
+      // that has room for it.
       boost::optional<AtlasEntry> allocate_rect(IntRect source_rect);
 
       template <typename OutIt>
@@ -63,19 +102,34 @@ namespace ts
       Vector2i atlas_size(std::size_t atlas_id) const;
       void set_atlas_size(Vector2i size);
 
+      // The padding and alignment apply to all atlases, see TextureAtlas.
       void set_padding(std::int32_t padding);
       std::int32_t padding() const;
 
+      void set_alignment(std::int32_t alignment);
+      std::int32_t alignment() const;
+
       void set_fragment_overlap(std::int32_t overlap);
       std::int32_t fragment_overlap() const;
 
+      // In first-fit mode, earlier atlases are revisited when allocating. This is most
+      // effective when the rects are allocated in order of decreasing size.
+      void set_first_fit(bool first_fit);
+      bool first_fit() const;
+
+      double occupancy(std::size_t atlas_id) const;
+
     private:
       std::size_t create_atlas(Vector2i size);
+      boost::optional<AtlasEntry> allocate_rect(std::size_t atlas_id, IntRect source_rect);
 
       std::size_t current_atlas_ = 0;
       Vector2i atlas_size_;
+      AtlasPackingStrategy strategy_;
       std::int32_t padding_ = 1;
+      std::int32_t alignment_ = 1;
       std::int32_t fragment_overlap_ = 0;
+      bool first_fit_ = false;
       std::vector<utility::TextureAtlas> atlas_list_;
     };
 
@@ -96,8 +150,8 @@ namespace ts
             std::min(atlas_size_.y, source_rect.height - y)
           };
 
-          create_atlas(size);
-          *out++ = *allocate_rect({ x, y, size.x, size.y });
+          auto atlas_id = create_atlas(size);
+          *out++ = *allocate_rect(atlas_id, { x, y, size.x, size.y });
         }
       }
 
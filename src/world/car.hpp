@@ -43,6 +43,7 @@ namespace ts
       const HandlingState& handling_state() const { return handling_state_; }
 
       void set_handling(const resources::Handling& h) { handling_ = h; };
+      void set_handling_state(const HandlingState& state) { handling_state_ = state; }
       
 
     private:
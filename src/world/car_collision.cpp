@@ -0,0 +1,439 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "car_collision.hpp"
+#include "entity.hpp"
+#include "world_event_interface.hpp"
+
+#include "resources/car_definition.hpp"
+
+#include "utility/stats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace ts
+{
+  namespace world
+  {
+    resources::CollisionShape car_collision_shape(const resources::CarDefinition& car_definition)
+    {
+      if (!car_definition.collision_shape.sub_shapes.empty()) return car_definition.collision_shape;
+
+      auto half_width = static_cast<float>(car_definition.image_rect.width / car_definition.image_scale * 0.5);
+      auto half_height = static_cast<float>(car_definition.image_rect.height / car_definition.image_scale * 0.5);
+
+      resources::collision_shapes::Polygon box;
+      box.num_points = 4;
+      box.points[0].position = { -half_width, -half_height };
+      box.points[1].position = { half_width, -half_height };
+      box.points[2].position = { half_width, half_height };
+      box.points[3].position = { -half_width, half_height };
+
+      resources::CollisionShape result;
+      result.sub_shapes.push_back({ box, static_cast<float>(car_definition.bounciness) });
+      return result;
+    }
+
+    namespace detail
+    {
+      static bool circles_overlap(const BoundingCircle& a, const BoundingCircle& b)
+      {
+        auto radius = a.radius + b.radius;
+        return a.z_level == b.z_level && magnitude_squared(a.center - b.center) < radius * radius;
+      }
+
+      void find_all_pairs(const BoundingCircle* circles, std::size_t count, std::vector<CollisionPair>& pairs)
+      {
+        pairs.clear();
+        for (std::uint32_t first = 0; first < count; ++first)
+        {
+          for (auto second = first + 1; second < count; ++second)
+          {
+            if (circles_overlap(circles[first], circles[second])) pairs.push_back({ first, second });
+          }
+        }
+      }
+    }
+
+    const std::vector<CollisionPair>& BroadPhase::find_pairs(const BoundingCircle* circles, std::size_t count)
+    {
+      pairs_.clear();
+      if (count == 0) return pairs_;
+
+      auto min_corner = circles[0].center, max_corner = circles[0].center;
+      for (auto circle = circles; circle != circles + count; ++circle)
+      {
+        min_corner.x = std::min(min_corner.x, circle->center.x);
+        min_corner.y = std::min(min_corner.y, circle->center.y);
+        max_corner.x = std::max(max_corner.x, circle->center.x);
+        max_corner.y = std::max(max_corner.y, circle->center.y);
+      }
+
+      auto use_x_axis = max_corner.x - min_corner.x >= max_corner.y - min_corner.y;
+
+      if (order_.size() != count)
+      {
+        order_.resize(count);
+        std::iota(order_.begin(), order_.end(), 0);
+      }
+
+      intervals_.clear();
+      for (auto index : order_)
+      {
+        const auto& circle = circles[index];
+        auto center = use_x_axis ? circle.center.x : circle.center.y;
+        intervals_.push_back({ center - circle.radius, center + circle.radius, index });
+      }
+
+      for (auto it = std::next(intervals_.begin()); it != intervals_.end(); ++it)
+      {
+        auto interval = *it;
+        auto dest = it;
+        for (; dest != intervals_.begin() && std::prev(dest)->min > interval.min; --dest)
+        {
+          *dest = *std::prev(dest);
+        }
+
+        *dest = interval;
+      }
+
+      for (std::size_t index = 0; index != count; ++index)
+      {
+        order_[index] = intervals_[index].index;
+      }
+
+      for (auto first = intervals_.begin(); first != intervals_.end(); ++first)
+      {
+        for (auto second = std::next(first); second != intervals_.end() && second->min < first->max; ++second)
+        {
+          if (detail::circles_overlap(circles[first->index], circles[second->index]))
+          {
+            pairs_.push_back({ std::min(first->index, second->index), std::max(first->index, second->index) });
+          }
+        }
+      }
+
+      return pairs_;
+    }
+
+    namespace
+    {
+      // A shape transformed to world coordinates. Circles don't have any points.
+      struct WorldShape
+      {
+        boost::container::small_vector<Vector2d, 8> points;
+        Vector2d center;
+        double radius;
+      };
+
+      struct Contact
+      {
+        Vector2d point;
+        Vector2d normal;
+        double depth = -1.0;
+      };
+
+      std::pair<double, double> project(const WorldShape& shape, Vector2d axis)
+      {
+        if (shape.points.empty())
+        {
+          auto center = dot_product(shape.center, axis);
+          return{ center - shape.radius, center + shape.radius };
+        }
+
+        auto result = std::make_pair(std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest());
+        for (auto point : shape.points)
+        {
+          auto value = dot_product(point, axis);
+          result.first = std::min(result.first, value);
+          result.second = std::max(result.second, value);
+        }
+
+        return result;
+      }
+
+      // The furthest point in the given direction. If an edge faces that direction, this is the
+      // middle of the edge, so that a flat contact doesn't make the bodies spin.
+      Vector2d support_point(const WorldShape& shape, Vector2d direction)
+      {
+        if (shape.points.empty()) return shape.center + direction * shape.radius;
+
+        const double tolerance = 0.01;
+        auto furthest = dot_product(*std::max_element(shape.points.begin(), shape.points.end(),
+                                                      [direction](Vector2d a, Vector2d b)
+        {
+          return dot_product(a, direction) < dot_product(b, direction);
+        }), direction);
+
+        Vector2d sum;
+        double count = 0.0;
+        for (auto point : shape.points)
+        {
+          if (dot_product(point, direction) >= furthest - tolerance)
+          {
+            sum += point;
+            count += 1.0;
+          }
+        }
+
+        return sum / count;
+      }
+
+      Vector2d closest_point(const WorldShape& shape, Vector2d position)
+      {
+        if (shape.points.empty()) return shape.center;
+
+        return *std::min_element(shape.points.begin(), shape.points.end(),
+                                 [position](Vector2d a, Vector2d b)
+        {
+          return magnitude_squared(a - position) < magnitude_squared(b - position);
+        });
+      }
+
+      // Separating axis test. The normal points from a to b.
+      Contact find_contact(const WorldShape& a, const WorldShape& b)
+      {
+        Contact contact;
+        contact.depth = std::numeric_limits<double>::max();
+        bool axis_of_a = true;
+
+        auto test_axis = [&](Vector2d axis, bool owned_by_a)
+        {
+          axis = normalize(axis);
+          if (axis.x == 0.0 && axis.y == 0.0) return true;
+
+          auto range_a = project(a, axis);
+          auto range_b = project(b, axis);
+          auto overlap = std::min(range_a.second - range_b.first, range_b.second - range_a.first);
+          if (overlap <= 0.0) return false;
+
+          if (overlap < contact.depth)
+          {
+            contact.depth = overlap;
+            contact.normal = dot_product(axis, b.center - a.center) < 0.0 ? -axis : axis;
+            axis_of_a = owned_by_a;
+          }
+
+          return true;
+        };
+
+        auto test_edges = [&](const WorldShape& shape, bool owned_by_a)
+        {
+          for (std::size_t index = 0; index != shape.points.size(); ++index)
+          {
+            auto next = index + 1 == shape.points.size() ? 0 : index + 1;
+            if (!test_axis(tangent(shape.points[next] - shape.points[index]), owned_by_a)) return false;
+          }
+
+          return true;
+        };
+
+        // Circles need the axis towards the nearest feature of the other shape.
+        if ((a.points.empty() && !test_axis(closest_point(b, a.center) - a.center, true)) ||
+            (b.points.empty() && !test_axis(b.center - closest_point(a, b.center), false)) ||
+            !test_edges(a, true) || !test_edges(b, false) ||
+            contact.depth == std::numeric_limits<double>::max())
+        {
+          return Contact();
+        }
+
+        contact.point = axis_of_a ? support_point(b, -contact.normal) : support_point(a, contact.normal);
+        return contact;
+      }
+    }
+
+    void CarCollisions::add_entity(Entity* entity, const resources::CollisionShape& collision_shape)
+    {
+      Body body;
+      body.entity = entity;
+      body.radius = 0.0;
+
+      for (const auto& sub_shape : collision_shape.sub_shapes)
+      {
+        Shape shape;
+        shape.bounciness = sub_shape.bounciness;
+
+        if (auto circle = boost::get<resources::collision_shapes::Circle>(&sub_shape.data))
+        {
+          shape.center = vector2_cast<double>(circle->center);
+          shape.radius = circle->radius;
+          body.radius = std::max(body.radius, magnitude(shape.center) + shape.radius);
+        }
+
+        else if (auto polygon = boost::get<resources::collision_shapes::Polygon>(&sub_shape.data))
+        {
+          auto point_count = std::min<std::size_t>(polygon->num_points, polygon->points.size());
+          if (point_count == 0) continue;
+
+          shape.center = {};
+          shape.radius = 0.0;
+          for (std::size_t index = 0; index != point_count; ++index)
+          {
+            auto point = vector2_cast<double>(polygon->points[index].position);
+            shape.points.push_back(point);
+            shape.center += point;
+            body.radius = std::max(body.radius, magnitude(point));
+          }
+
+          shape.center /= static_cast<double>(point_count);
+        }
+
+        body.shapes.push_back(shape);
+      }
+
+      bodies_.push_back(body);
+    }
+
+    static Vector2d rotate(Vector2d point, double sin, double cos)
+    {
+      return{ point.x * cos - sin * point.y, point.y * cos + sin * point.x };
+    }
+
+    void CarCollisions::update(EventInterface& event_interface)
+    {
+      update();
+      report_collisions(event_interface);
+    }
+
+    void CarCollisions::report_collisions(EventInterface& event_interface)
+    {
+      for (const auto& collision : pending_collisions_)
+      {
+        event_interface.on_collision(bodies_[collision.pair.first].entity, bodies_[collision.pair.second].entity,
+                                     collision.result);
+      }
+
+      pending_collisions_.clear();
+    }
+
+    void CarCollisions::update()
+    {
+      circles_.clear();
+      for (const auto& body : bodies_)
+      {
+        circles_.push_back({ body.entity->position(), body.radius, body.entity->z_level() });
+      }
+
+      const auto& pairs = broad_phase_.find_pairs(circles_.data(), circles_.size());
+      candidate_pair_count_ = pairs.size();
+      contact_count_ = 0;
+
+      static const stats::Counter collision_tests("world.collision_tests");
+      collision_tests.add(pairs.size());
+
+      auto transform_shape = [](const Shape& shape, Vector2d position, double sin, double cos)
+      {
+        WorldShape result;
+        for (auto point : shape.points) result.points.push_back(position + rotate(point, sin, cos));
+
+        result.center = position + rotate(shape.center, sin, cos);
+        result.radius = shape.radius;
+        return result;
+      };
+
+      for (auto pair : pairs)
+      {
+        auto subject = bodies_[pair.first].entity;
+        auto object = bodies_[pair.second].entity;
+
+        auto position_a = subject->position(), position_b = object->position();
+        auto rotation_a = subject->rotation().radians(), rotation_b = object->rotation().radians();
+        auto sin_a = std::sin(rotation_a), cos_a = std::cos(rotation_a);
+        auto sin_b = std::sin(rotation_b), cos_b = std::cos(rotation_b);
+
+        Contact contact;
+        double bounce_factor = 0.0;
+        for (const auto& shape_a : bodies_[pair.first].shapes)
+        {
+          auto world_a = transform_shape(shape_a, position_a, sin_a, cos_a);
+          for (const auto& shape_b : bodies_[pair.second].shapes)
+          {
+            auto shape_contact = find_contact(world_a, transform_shape(shape_b, position_b, sin_b, cos_b));
+            if (shape_contact.depth > contact.depth)
+            {
+              contact = shape_contact;
+              bounce_factor = shape_a.bounciness * shape_b.bounciness;
+            }
+          }
+        }
+
+        if (contact.depth <= 0.0) continue;
+        ++contact_count_;
+
+        auto inverse_mass_a = 1.0 / subject->mass(), inverse_mass_b = 1.0 / object->mass();
+        auto inverse_moment_a = 1.0 / subject->moment_of_inertia();
+        auto inverse_moment_b = 1.0 / object->moment_of_inertia();
+
+        auto offset_a = contact.point - (position_a + rotate(subject->center_of_mass(), sin_a, cos_a));
+        auto offset_b = contact.point - (position_b + rotate(object->center_of_mass(), sin_b, cos_b));
+
+        auto velocity_a = subject->velocity(), velocity_b = object->velocity();
+        auto angular_velocity_a = subject->angular_velocity(), angular_velocity_b = object->angular_velocity();
+
+        auto relative_velocity = velocity_b + tangent(offset_b) * angular_velocity_b -
+          velocity_a - tangent(offset_a) * angular_velocity_a;
+        auto normal_speed = dot_product(relative_velocity, contact.normal);
+
+        auto total_inverse_mass = inverse_mass_a + inverse_mass_b;
+
+        // Push the bodies apart, so that a resting contact doesn't keep sinking in.
+        const double slop = 0.1;
+        auto correction = contact.normal * (std::max(contact.depth - slop, 0.0) * 0.8 / total_inverse_mass);
+        subject->set_position(position_a - correction * inverse_mass_a);
+        object->set_position(position_b + correction * inverse_mass_b);
+
+        // Only bodies that move towards each other need an impulse.
+        if (normal_speed >= 0.0) continue;
+
+        auto arm_a = cross_product(offset_a, contact.normal);
+        auto arm_b = cross_product(offset_b, contact.normal);
+        auto impulse = -(1.0 + bounce_factor) * normal_speed /
+          (total_inverse_mass + arm_a * arm_a * inverse_moment_a + arm_b * arm_b * inverse_moment_b);
+
+        subject->set_velocity(velocity_a - contact.normal * (impulse * inverse_mass_a));
+        subject->set_angular_velocity(angular_velocity_a - arm_a * impulse * inverse_moment_a);
+        object->set_velocity(velocity_b + contact.normal * (impulse * inverse_mass_b));
+        object->set_angular_velocity(angular_velocity_b + arm_b * impulse * inverse_moment_b);
+
+        CollisionResult result;
+        result.point = contact.point;
+        result.normal = contact.normal;
+        result.impact = -normal_speed;
+        result.bounce_factor = bounce_factor;
+        result.impulse = impulse;
+
+        auto pending = std::find_if(pending_collisions_.begin(), pending_collisions_.end(),
+                                    [pair](const PendingCollision& collision)
+        {
+          return collision.pair.first == pair.first && collision.pair.second == pair.second;
+        });
+
+        if (pending == pending_collisions_.end())
+        {
+          pending_collisions_.push_back({ pair, result });
+        }
+
+        else if (result.impact > pending->result.impact)
+        {
+          pending->result = result;
+        }
+      }
+    }
+
+    std::size_t CarCollisions::candidate_pair_count() const
+    {
+      return candidate_pair_count_;
+    }
+
+    std::size_t CarCollisions::contact_count() const
+    {
+      return contact_count_;
+    }
+  }
+}
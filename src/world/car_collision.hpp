@@ -0,0 +1,132 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include "collision_result.hpp"
+
+#include "resources/collision_shape.hpp"
+
+#include "utility/vector2.hpp"
+
+#include <boost/container/small_vector.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ts
+{
+  namespace resources
+  {
+    struct CarDefinition;
+  }
+
+  namespace world
+  {
+    class Entity;
+    struct EventInterface;
+
+    // The car definition's collision shape, or a box the size of the car's image if the
+    // definition doesn't have one.
+    resources::CollisionShape car_collision_shape(const resources::CarDefinition& car_definition);
+
+    struct BoundingCircle
+    {
+      Vector2d center;
+      double radius;
+      std::uint32_t z_level;
+    };
+
+    struct CollisionPair
+    {
+      std::uint32_t first;
+      std::uint32_t second;
+    };
+
+    // Sweep-and-prune broad-phase. The circles are sorted by the start of their interval on the axis
+    // along which they are spread out the most, and every circle is only tested against the circles
+    // whose intervals start before its own interval ends. The order of the previous call is kept,
+    // because the cars barely move between ticks, which makes the insertion sort close to linear.
+    class BroadPhase
+    {
+    public:
+      // The pairs of circles on the same z level that overlap, with first < second.
+      const std::vector<CollisionPair>& find_pairs(const BoundingCircle* circles, std::size_t count);
+
+    private:
+      struct Interval
+      {
+        double min;
+        double max;
+        std::uint32_t index;
+      };
+
+      std::vector<std::uint32_t> order_;
+      std::vector<Interval> intervals_;
+      std::vector<CollisionPair> pairs_;
+    };
+
+    // CarCollisions resolves the collisions between cars, and reports them through the event interface.
+    // The narrow-phase uses the cars' collision shapes, and the response applies an impulse at the
+    // deepest contact point, with the elasticity combined the same way chipmunk does.
+    class CarCollisions
+    {
+    public:
+      void add_entity(Entity* entity, const resources::CollisionShape& collision_shape);
+
+      // Resolves the collisions, and holds on to the contacts until they are reported. This way,
+      // a tick that is split up into sub-steps reports a pair of cars once, not once per sub-step.
+      void update();
+
+      // Reports every pair that made contact since the last call once, with the hardest contact.
+      void report_collisions(EventInterface& event_interface);
+
+      // Same as update() followed by report_collisions().
+      void update(EventInterface& event_interface);
+
+      // The number of candidate pairs and actual contacts in the most recent update.
+      std::size_t candidate_pair_count() const;
+      std::size_t contact_count() const;
+
+    private:
+      struct Shape
+      {
+        boost::container::small_vector<Vector2d, 8> points;
+        Vector2d center;
+        double radius;
+        double bounciness;
+      };
+
+      struct Body
+      {
+        Entity* entity;
+        boost::container::small_vector<Shape, 4> shapes;
+        double radius;
+      };
+
+      struct PendingCollision
+      {
+        CollisionPair pair;
+        CollisionResult result;
+      };
+
+      std::vector<Body> bodies_;
+      std::vector<BoundingCircle> circles_;
+      std::vector<PendingCollision> pending_collisions_;
+      BroadPhase broad_phase_;
+
+      std::size_t candidate_pair_count_ = 0;
+      std::size_t contact_count_ = 0;
+    };
+
+    namespace detail
+    {
+      // Tests all pairs against each other, for reference.
+      void find_all_pairs(const BoundingCircle* circles, std::size_t count, std::vector<CollisionPair>& pairs);
+    }
+  }
+}
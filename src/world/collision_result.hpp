@@ -0,0 +1,30 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include "utility/vector2.hpp"
+
+namespace ts
+{
+  namespace world
+  {
+    struct CollisionResult
+    {
+      // The contact point in world coordinates, and the contact normal pointing from the
+      // subject towards the object.
+      Vector2d point;
+      Vector2d normal;
+
+      // The speed at which the bodies approached each other along the normal.
+      double impact = 0.0;
+      double bounce_factor = 0.0;
+
+      // The magnitude of the impulse that was applied to separate the bodies.
+      double impulse = 0.0;
+    };
+  }
+}
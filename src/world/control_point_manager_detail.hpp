@@ -10,6 +10,7 @@
 #include "entity.hpp"
 
 #include "utility/line_intersection.hpp"
+#include "utility/stats.hpp"
 
 namespace ts
 {
@@ -89,6 +90,9 @@ namespace ts
     void ControlPointManager::test_control_point_intersections(Vector2<double> old_position, Vector2<double> new_position, 
                                                                EventCallback&& event_callback)
     {      
+      static const stats::Counter control_point_tests("world.control_point_tests");
+      control_point_tests.add(control_points_.size());
+
       for (const auto& point : control_points_)
       {
         switch (point.type)
@@ -125,7 +125,7 @@ namespace ts
 
     std::uint32_t Entity::z_level() const
     {
-      return static_cast<std::uint32_t>(z_position_);
+      return static_cast<std::uint32_t>(z_position());
     }
 
     void Entity::set_position(Vector2d position)
@@ -0,0 +1,51 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "fixed_integrator.hpp"
+
+namespace ts
+{
+  namespace world
+  {
+    static Fixed64 clamp_fixed(Fixed64 value, Fixed64 max)
+    {
+      if (value < Fixed64()) return Fixed64();
+      if (value > max) return max;
+
+      return value;
+    }
+
+    void integrate_body(FixedBodyState& state, const FixedBodyForces& forces, Fixed64 frame_duration,
+                        Vector2<Fixed64> world_size)
+    {
+      state.velocity.x += forces.force.x * forces.inverse_mass * frame_duration;
+      state.velocity.y += forces.force.y * forces.inverse_mass * frame_duration;
+      state.angular_velocity += forces.torque * forces.inverse_moment * frame_duration;
+
+      state.position.x = clamp_fixed(state.position.x + state.velocity.x * frame_duration, world_size.x);
+      state.position.y = clamp_fixed(state.position.y + state.velocity.y * frame_duration, world_size.y);
+      state.rotation += state.angular_velocity * frame_duration;
+    }
+
+    void StateHasher::add(std::uint64_t value)
+    {
+      for (int byte = 0; byte != 8; ++byte)
+      {
+        hash_ ^= (value >> (byte * 8)) & 0xFF;
+        hash_ *= UINT64_C(1099511628211);
+      }
+    }
+
+    void StateHasher::add(const FixedBodyState& state)
+    {
+      for (auto value : { state.position.x, state.position.y, state.velocity.x, state.velocity.y,
+                          state.rotation, state.angular_velocity })
+      {
+        add(static_cast<std::uint64_t>(value.raw()));
+      }
+    }
+  }
+}
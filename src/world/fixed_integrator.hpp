@@ -0,0 +1,56 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include "utility/fixed_point.hpp"
+#include "utility/vector2.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ts
+{
+  namespace world
+  {
+    // The state of a rigid body as the fixed-point integrator sees it.
+    // The position is that of the center of gravity.
+    struct FixedBodyState
+    {
+      Vector2<Fixed64> position;
+      Vector2<Fixed64> velocity;
+      Fixed64 rotation;
+      Fixed64 angular_velocity;
+    };
+
+    struct FixedBodyForces
+    {
+      Vector2<Fixed64> force;
+      Fixed64 torque;
+      Fixed64 inverse_mass;
+      Fixed64 inverse_moment;
+    };
+
+    // Semi-implicit Euler step, the same scheme chipmunk uses for an undamped space without
+    // gravity: the velocities are updated first, and the positions with the new velocities.
+    // The position is clamped to [0, world_size].
+    void integrate_body(FixedBodyState& state, const FixedBodyForces& forces, Fixed64 frame_duration,
+                        Vector2<Fixed64> world_size);
+
+    // FNV-1a hash of the raw state, used to verify that two simulations are in lockstep.
+    class StateHasher
+    {
+    public:
+      void add(const FixedBodyState& state);
+      void add(std::uint64_t value);
+
+      std::uint64_t hash() const { return hash_; }
+
+    private:
+      std::uint64_t hash_ = UINT64_C(14695981039346656037);
+    };
+  }
+}
@@ -0,0 +1,133 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "handling_batch.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace ts
+{
+  namespace world
+  {
+    const std::size_t HandlingBatch::wheel_count;
+
+    void HandlingBatch::resize(std::size_t car_count)
+    {
+      handlings.resize(car_count);
+      handling_states.resize(car_count);
+
+      for (auto* values : { &position_x, &position_y, &velocity_x, &velocity_y, &rotation_sin, &rotation_cos,
+                            &angular_velocity, &mass, &moment_of_inertia, &applied_torque,
+                            &center_of_mass_x, &center_of_mass_y, &throttle_rate, &braking_rate, &turning_rate,
+                            &local_velocity_x, &local_velocity_y, &body_force_x, &body_force_y })
+      {
+        values->resize(car_count);
+      }
+
+      z_level.resize(car_count);
+
+      for (auto* wheel_values : { &wheel_x, &wheel_y, &wheel_position_x, &wheel_position_y,
+                                  &wheel_velocity_x, &wheel_velocity_y, &wheel_force_x, &wheel_force_y })
+      {
+        for (auto& values : *wheel_values) values.resize(car_count);
+      }
+
+      for (auto& terrains : wheel_terrains) terrains.resize(car_count);
+    }
+
+    std::size_t HandlingBatch::size() const
+    {
+      return handlings.size();
+    }
+
+    namespace detail
+    {
+      // The expressions are the ones transform_point() uses, so that this gives the same results
+      // as the per-car code that came before it.
+      void compute_wheel_kinematics_scalar(HandlingBatch& batch, std::size_t begin, std::size_t end)
+      {
+        for (auto car = begin; car != end; ++car)
+        {
+          auto sin = batch.rotation_sin[car];
+          auto cos = batch.rotation_cos[car];
+          auto velocity_x = batch.velocity_x[car];
+          auto velocity_y = batch.velocity_y[car];
+          auto angular_velocity = batch.angular_velocity[car];
+
+          auto local_velocity_x = velocity_x * cos + sin * velocity_y;
+          auto local_velocity_y = velocity_y * cos - sin * velocity_x;
+          batch.local_velocity_x[car] = local_velocity_x;
+          batch.local_velocity_y[car] = local_velocity_y;
+
+          for (std::size_t wheel = 0; wheel != HandlingBatch::wheel_count; ++wheel)
+          {
+            auto x = batch.wheel_x[wheel][car];
+            auto y = batch.wheel_y[wheel][car];
+
+            batch.wheel_position_x[wheel][car] = batch.position_x[car] + (x * cos - sin * y);
+            batch.wheel_position_y[wheel][car] = batch.position_y[car] + (y * cos + sin * x);
+            batch.wheel_velocity_x[wheel][car] = local_velocity_x - angular_velocity * y;
+            batch.wheel_velocity_y[wheel][car] = local_velocity_y + angular_velocity * x;
+          }
+        }
+      }
+
+#if defined(__AVX2__)
+      // Processes the cars in groups of four, and returns the number of cars that were processed.
+      static std::size_t compute_wheel_kinematics_avx2(HandlingBatch& batch)
+      {
+        auto group_end = batch.size() - batch.size() % 4;
+        for (std::size_t car = 0; car != group_end; car += 4)
+        {
+          auto sin = _mm256_loadu_pd(&batch.rotation_sin[car]);
+          auto cos = _mm256_loadu_pd(&batch.rotation_cos[car]);
+          auto velocity_x = _mm256_loadu_pd(&batch.velocity_x[car]);
+          auto velocity_y = _mm256_loadu_pd(&batch.velocity_y[car]);
+          auto angular_velocity = _mm256_loadu_pd(&batch.angular_velocity[car]);
+          auto position_x = _mm256_loadu_pd(&batch.position_x[car]);
+          auto position_y = _mm256_loadu_pd(&batch.position_y[car]);
+
+          auto local_velocity_x = _mm256_add_pd(_mm256_mul_pd(velocity_x, cos), _mm256_mul_pd(sin, velocity_y));
+          auto local_velocity_y = _mm256_sub_pd(_mm256_mul_pd(velocity_y, cos), _mm256_mul_pd(sin, velocity_x));
+          _mm256_storeu_pd(&batch.local_velocity_x[car], local_velocity_x);
+          _mm256_storeu_pd(&batch.local_velocity_y[car], local_velocity_y);
+
+          for (std::size_t wheel = 0; wheel != HandlingBatch::wheel_count; ++wheel)
+          {
+            auto x = _mm256_loadu_pd(&batch.wheel_x[wheel][car]);
+            auto y = _mm256_loadu_pd(&batch.wheel_y[wheel][car]);
+
+            auto offset_x = _mm256_sub_pd(_mm256_mul_pd(x, cos), _mm256_mul_pd(sin, y));
+            auto offset_y = _mm256_add_pd(_mm256_mul_pd(y, cos), _mm256_mul_pd(sin, x));
+            _mm256_storeu_pd(&batch.wheel_position_x[wheel][car], _mm256_add_pd(position_x, offset_x));
+            _mm256_storeu_pd(&batch.wheel_position_y[wheel][car], _mm256_add_pd(position_y, offset_y));
+
+            auto wheel_velocity_x = _mm256_sub_pd(local_velocity_x, _mm256_mul_pd(angular_velocity, y));
+            auto wheel_velocity_y = _mm256_add_pd(local_velocity_y, _mm256_mul_pd(angular_velocity, x));
+            _mm256_storeu_pd(&batch.wheel_velocity_x[wheel][car], wheel_velocity_x);
+            _mm256_storeu_pd(&batch.wheel_velocity_y[wheel][car], wheel_velocity_y);
+          }
+        }
+
+        return group_end;
+      }
+#endif
+    }
+
+    void compute_wheel_kinematics(HandlingBatch& batch)
+    {
+      std::size_t car = 0;
+
+#if defined(__AVX2__)
+      car = detail::compute_wheel_kinematics_avx2(batch);
+#endif
+
+      detail::compute_wheel_kinematics_scalar(batch, car, batch.size());
+    }
+  }
+}
@@ -0,0 +1,80 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include "handling_v2.hpp"
+
+#include "resources/terrain_definition.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ts
+{
+  namespace resources
+  {
+    struct Handling;
+  }
+
+  namespace world
+  {
+    // HandlingBatch holds the state of the handling model for a number of cars as a structure of
+    // arrays. The wheel arrays are indexed by wheel first and by car second, so that the same wheel
+    // of consecutive cars is contiguous in memory. Every car has wheel_count wheels, because that's
+    // what the handling model always uses.
+    struct HandlingBatch
+    {
+      static const std::size_t wheel_count = 4;
+
+      template <typename T>
+      using WheelArray = std::array<std::vector<T>, wheel_count>;
+
+      void resize(std::size_t car_count);
+      std::size_t size() const;
+
+      // Gathered from the cars.
+      std::vector<const resources::Handling*> handlings;
+      std::vector<HandlingState> handling_states;
+      std::vector<double> position_x, position_y;
+      std::vector<double> velocity_x, velocity_y;
+      std::vector<double> rotation_sin, rotation_cos;
+      std::vector<double> angular_velocity;
+      std::vector<double> mass, moment_of_inertia, applied_torque;
+      std::vector<double> center_of_mass_x, center_of_mass_y;
+      std::vector<double> throttle_rate, braking_rate, turning_rate;
+      std::vector<std::uint32_t> z_level;
+
+      // Wheel positions relative to the car.
+      WheelArray<double> wheel_x, wheel_y;
+
+      // Computed by compute_wheel_kinematics(). Velocities are relative to the car's rotation,
+      // wheel positions are in world coordinates.
+      std::vector<double> local_velocity_x, local_velocity_y;
+      WheelArray<double> wheel_position_x, wheel_position_y;
+      WheelArray<double> wheel_velocity_x, wheel_velocity_y;
+
+      WheelArray<resources::TerrainDefinition> wheel_terrains;
+
+      // Computed by compute_handling_forces(). The wheel forces are applied at the wheels,
+      // the body force at the center of mass.
+      WheelArray<double> wheel_force_x, wheel_force_y;
+      std::vector<double> body_force_x, body_force_y;
+    };
+
+    // Computes the local velocity of every car, and the position and velocity of every wheel.
+    // Uses AVX2 for groups of four cars if the build enables it.
+    void compute_wheel_kinematics(HandlingBatch& batch);
+
+    namespace detail
+    {
+      // The scalar kernel for the cars in the range [begin, end).
+      void compute_wheel_kinematics_scalar(HandlingBatch& batch, std::size_t begin, std::size_t end);
+    }
+  }
+}
@@ -5,6 +5,7 @@
 */
 
 #include "handling_v2.hpp"
+#include "handling_batch.hpp"
 #include "car.hpp"
 #include "world.hpp"
 
@@ -24,11 +25,10 @@ namespace ts
 {
   namespace world
   {
-    HandlingState update_car_state(Car& car, const World& world, double frame_duration)
+    // Wheel positions relative to the car, front wheels first. An axle with a single wheel
+    // still gets two entries, the second one at the car's origin.
+    static std::array<Vector2d, HandlingBatch::wheel_count> wheel_positions(const resources::Handling& handling)
     {
-      auto& handling = car.handling();
-
-      using controls::Control;
       auto half_wheelbase = handling.wheelbase_length * 0.5;
 
       std::array<Vector2d, 2> front_wheel_positions =
@@ -59,20 +59,86 @@ namespace ts
         } };
       }
 
-      auto transform = make_transformation(car.rotation());
-      auto inv_transform = make_transformation(-car.rotation());
+      return
+      { {
+        front_wheel_positions[0], front_wheel_positions[1], rear_wheel_positions[0], rear_wheel_positions[1]
+      } };
+    }
 
-      auto handling_state = car.handling_state();
+    void gather_car_states(HandlingBatch& batch, Car* const* cars, std::size_t car_count)
+    {
+      using controls::Control;
+
+      batch.resize(car_count);
+      for (std::size_t index = 0; index != car_count; ++index)
+      {
+        const auto& car = *cars[index];
+        const auto& handling = car.handling();
+
+        batch.handlings[index] = &handling;
+        batch.handling_states[index] = car.handling_state();
+
+        auto position = car.position();
+        auto velocity = car.velocity();
+        auto transform = make_transformation(car.rotation());
+        auto center_of_mass = car.center_of_mass();
+
+        batch.position_x[index] = position.x;
+        batch.position_y[index] = position.y;
+        batch.velocity_x[index] = velocity.x;
+        batch.velocity_y[index] = velocity.y;
+        batch.rotation_sin[index] = transform.sin;
+        batch.rotation_cos[index] = transform.cos;
+        batch.angular_velocity[index] = car.angular_velocity();
+        batch.mass[index] = car.mass();
+        batch.moment_of_inertia[index] = car.moment_of_inertia();
+        batch.applied_torque[index] = car.applied_torque();
+        batch.center_of_mass_x[index] = center_of_mass.x;
+        batch.center_of_mass_y[index] = center_of_mass.y;
+        batch.z_level[index] = car.z_level();
+
+        auto turning_left_rate = car.control_state(Control::Left) / 255.0;
+        auto turning_right_rate = car.control_state(Control::Right) / 255.0;
+        batch.throttle_rate[index] = car.control_state(Control::Throttle) / 255.0;
+        batch.braking_rate[index] = car.control_state(Control::Brake) / 255.0;
+        batch.turning_rate[index] = -turning_left_rate + turning_right_rate;
+
+        auto wheels = wheel_positions(handling);
+        for (std::size_t wheel = 0; wheel != HandlingBatch::wheel_count; ++wheel)
+        {
+          batch.wheel_x[wheel][index] = wheels[wheel].x;
+          batch.wheel_y[wheel][index] = wheels[wheel].y;
+        }
+      }
+    }
+
+    void gather_wheel_terrains(HandlingBatch& batch, const World& world)
+    {
+      for (std::size_t wheel = 0; wheel != HandlingBatch::wheel_count; ++wheel)
+      {
+        for (std::size_t car = 0; car != batch.size(); ++car)
+        {
+          auto position = make_vector2(batch.wheel_position_x[wheel][car], batch.wheel_position_y[wheel][car]);
+          batch.wheel_terrains[wheel][car] = world.terrain_at(position, batch.z_level[car]);
+        }
+      }
+    }
+
+    // Computes the forces for a single car, using nothing but the batch's data.
+    static void compute_car_forces(HandlingBatch& batch, std::size_t car, double frame_duration)
+    {
+      const auto& handling = *batch.handlings[car];
+      auto& handling_state = batch.handling_states[car];
       handling_state.wheel_states.clear();
 
-      auto local_velocity = transform_point(car.velocity(), inv_transform);
+      auto local_velocity = make_vector2(batch.local_velocity_x[car], batch.local_velocity_y[car]);
       auto local_heading = normalize(local_velocity);
       auto speed = magnitude(local_velocity);
-      auto angular_velocity = car.angular_velocity();
-      auto mass = car.mass();
-      auto center_of_mass = car.center_of_mass();
+      auto angular_velocity = batch.angular_velocity[car];
+      auto mass = batch.mass[car];
+      auto center_of_mass = make_vector2(batch.center_of_mass_x[car], batch.center_of_mass_y[car]);
 
-      auto inv_moment = 1.0 / car.moment_of_inertia();
+      auto inv_moment = 1.0 / batch.moment_of_inertia[car];
 
       auto num_wheels = handling.num_front_wheels + handling.num_rear_wheels;
       auto inv_num_wheels = 1.0 / num_wheels;
@@ -98,12 +164,8 @@ namespace ts
       auto front_traction_limit = std::max(front_base_load + (front_load_transfer + front_downforce) * inv_num_front_wheels, 0.0);
       auto rear_traction_limit = std::max(rear_base_load + (rear_load_transfer + rear_downforce) * inv_num_rear_wheels, 0.0);
 
-      auto throttle_rate = car.control_state(Control::Throttle) / 255.0;
-      auto braking_rate = car.control_state(Control::Brake) / 255.0;
-      auto turning_left_rate = car.control_state(Control::Left) / 255.0;
-      auto turning_right_rate = car.control_state(Control::Right) / 255.0;
-      auto turning_rate = -turning_left_rate + turning_right_rate;
-      auto net_throttle = throttle_rate - braking_rate;
+      auto turning_rate = batch.turning_rate[car];
+      auto net_throttle = batch.throttle_rate[car] - batch.braking_rate[car];
 
       auto inv_frame_duration = 1.0 / frame_duration;
 
@@ -268,31 +330,31 @@ namespace ts
       auto cornering_bias_2d = normalize(make_vector2(cornering_bias, longitudinal_bias));
       auto antislide_bias_2d = normalize(make_vector2(cornering_bias, longitudinal_bias));
 
-      boost::container::small_vector<WheelState, 4> wheel_states;
-      for (auto p : front_wheel_positions)
+      std::array<WheelState, HandlingBatch::wheel_count> wheel_states;
+      for (std::size_t wheel = 0; wheel != 2; ++wheel)
       {
-        WheelState ws{};
-        ws.pos = p;
+        auto& ws = wheel_states[wheel];
+        ws = WheelState{};
+        ws.pos = make_vector2(batch.wheel_x[wheel][car], batch.wheel_y[wheel][car]);
         ws.traction_limit = front_traction_limit;
         ws.acceleration = front_acceleration;
         ws.braking = front_braking;
         ws.cornering = handling.cornering;
         ws.max_steering_angle = front_steering * degrees(handling.max_steering_angle).radians();
-        ws.bias = cornering_bias_2d;        
-        wheel_states.push_back(ws);
+        ws.bias = cornering_bias_2d;
       }
 
-      for (auto p : rear_wheel_positions)
+      for (std::size_t wheel = 2; wheel != HandlingBatch::wheel_count; ++wheel)
       {
-        WheelState ws{};
-        ws.pos = p;
+        auto& ws = wheel_states[wheel];
+        ws = WheelState{};
+        ws.pos = make_vector2(batch.wheel_x[wheel][car], batch.wheel_y[wheel][car]);
         ws.traction_limit = rear_traction_limit;
         ws.acceleration = rear_acceleration;
         ws.braking = rear_braking;
         ws.cornering = handling.cornering;
         ws.max_steering_angle = -rear_steering * degrees(handling.max_steering_angle).radians();
         ws.bias = antislide_bias_2d;
-        wheel_states.push_back(ws);
       }
 
       auto max_cornering_multiplier = speed * mass * inv_num_wheels * inv_frame_duration;
@@ -300,13 +362,12 @@ namespace ts
 
       auto adjusted_steering_rate = 0.0;
 
-      for (auto& ws : wheel_states)
-      {        
-        auto global_pos = car.position() + transform_point(ws.pos, transform);
-
+      for (std::size_t wheel = 0; wheel != HandlingBatch::wheel_count; ++wheel)
+      {
+        auto& ws = wheel_states[wheel];
         ws.vertical_load = ws.traction_limit;
-        ws.terrain = world.terrain_at(global_pos, car.z_level());
-        ws.velocity = local_velocity + angular_velocity * make_vector2(-ws.pos.y, ws.pos.x);
+        ws.terrain = batch.wheel_terrains[wheel][car];
+        ws.velocity = make_vector2(batch.wheel_velocity_x[wheel][car], batch.wheel_velocity_y[wheel][car]);
         ws.heading_angle = std::atan2(ws.velocity.x, -ws.velocity.y);
 
         if (is_turning && std::abs(ws.max_steering_angle) >= 0.00001)
@@ -408,10 +469,13 @@ namespace ts
         }
       }
 
-      handling_state.wheel_states.clear();
+      // The torque that the wheel forces add to the body, which chipmunk would compute as the
+      // cross product of the rotated offset and force. Rotation doesn't change the cross product.
+      auto applied_torque = batch.applied_torque[car];
       auto net_force = make_vector2(0.0, 0.0);
-      for (auto& ws : wheel_states)
+      for (std::size_t wheel = 0; wheel != HandlingBatch::wheel_count; ++wheel)
       {
+        auto& ws = wheel_states[wheel];
         {
           auto longitudinal_force = (std::abs(ws.acceleration_force) + ws.braking_force) * pedal_adjustment;
           auto rem = std::max(ws.traction_limit * ws.traction_limit - longitudinal_force * longitudinal_force, 0.0);
@@ -430,7 +494,7 @@ namespace ts
         auto slide_direction = normalize(target_heading - wheel_heading);
 
         auto terrain_cornering_multiplier = ws.terrain.cornering;
-        if (&ws - wheel_states.data() >= handling.num_front_wheels)
+        if (wheel >= handling.num_front_wheels)
         {
           terrain_cornering_multiplier = ws.terrain.antislide;
         }                
@@ -446,12 +510,14 @@ namespace ts
 
         force += ws.terrain.roughness * mass * -ws.velocity * inv_num_wheels;
         
-        car.apply_force(force, ws.pos);       
+        batch.wheel_force_x[wheel][car] = force.x;
+        batch.wheel_force_y[wheel][car] = force.y;
+        applied_torque += cross_product(ws.pos - center_of_mass, force);
 
         net_force += force;
 
         HandlingState::WheelState stored_info;
-        stored_info.pos = car.position() + transform_point(ws.pos, transform);
+        stored_info.pos = make_vector2(batch.wheel_position_x[wheel][car], batch.wheel_position_y[wheel][car]);
         stored_info.slide_ratio = ws.slide_ratio;
         stored_info.terrain_color = ws.terrain.color;
         stored_info.terrain_roughness = ws.terrain.roughness;
@@ -460,10 +526,10 @@ namespace ts
       }
 
       auto drag = speed * -local_velocity * handling.drag_coefficient;
-      car.apply_force(drag, center_of_mass);
+      auto body_force = drag;
       net_force += drag;
       
-      auto torque_effect = car.applied_torque() * inv_moment * mass;
+      auto torque_effect = applied_torque * inv_moment * mass;
       auto min_lateral_force = net_force.x + -wheel_states.front().pos.y * torque_effect;
       auto max_lateral_force = min_lateral_force;
       for (std::uint32_t idx = 1; idx < wheel_states.size(); ++idx)
@@ -484,14 +550,63 @@ namespace ts
       {
         auto m = (max_lateral_force - min_lateral_force) * 0.5;
         auto f = clamp(min_lateral_force < 0.0 ? -max_lateral_force : -min_lateral_force, -m, m);
-        car.apply_force(make_vector2(f, 0.0), center_of_mass);
+        body_force.x += f;
         net_force.x += f;
       }
 
       angular_velocity -= angular_velocity * handling.angular_damping * frame_duration;
-      car.set_angular_velocity(angular_velocity);
-      handling_state.net_force = net_force;     
-      return handling_state;      
+      batch.angular_velocity[car] = angular_velocity;
+      batch.body_force_x[car] = body_force.x;
+      batch.body_force_y[car] = body_force.y;
+      handling_state.net_force = net_force;
+    }
+
+    void compute_handling_forces(HandlingBatch& batch, double frame_duration)
+    {
+      for (std::size_t car = 0; car != batch.size(); ++car)
+      {
+        compute_car_forces(batch, car, frame_duration);
+      }
+    }
+
+    void apply_handling_forces(const HandlingBatch& batch, Car* const* cars)
+    {
+      for (std::size_t index = 0; index != batch.size(); ++index)
+      {
+        auto& car = *cars[index];
+        for (std::size_t wheel = 0; wheel != HandlingBatch::wheel_count; ++wheel)
+        {
+          car.apply_force(make_vector2(batch.wheel_force_x[wheel][index], batch.wheel_force_y[wheel][index]),
+                          make_vector2(batch.wheel_x[wheel][index], batch.wheel_y[wheel][index]));
+        }
+
+        car.apply_force(make_vector2(batch.body_force_x[index], batch.body_force_y[index]),
+                        make_vector2(batch.center_of_mass_x[index], batch.center_of_mass_y[index]));
+        car.set_angular_velocity(batch.angular_velocity[index]);
+      }
+    }
+
+    void update_car_states(Car* const* cars, std::size_t car_count, const World& world, double frame_duration,
+                           HandlingBatch& batch)
+    {
+      gather_car_states(batch, cars, car_count);
+      compute_wheel_kinematics(batch);
+      gather_wheel_terrains(batch, world);
+      compute_handling_forces(batch, frame_duration);
+      apply_handling_forces(batch, cars);
+
+      for (std::size_t index = 0; index != car_count; ++index)
+      {
+        cars[index]->set_handling_state(batch.handling_states[index]);
+      }
+    }
+
+    HandlingState update_car_state(Car& car, const World& world, double frame_duration)
+    {
+      HandlingBatch batch;
+      Car* cars[] = { &car };
+      update_car_states(cars, 1, world, frame_duration, batch);
+      return batch.handling_states.front();
     }
   }
-}
+}
\ No newline at end of file
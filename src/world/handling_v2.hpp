@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 #include "utility/vector2.hpp"
@@ -19,6 +20,7 @@ namespace ts
   {
     class Car;
     class World;
+    struct HandlingBatch;
 
     struct HandlingState
     {
@@ -41,6 +43,23 @@ namespace ts
 
     HandlingState update_car_state(Car& car, const World& world, double frame_duration);
 
+    // Updates the handling of all given cars at once, with the same results as calling
+    // update_car_state() for every car. The batch is scratch space that can be reused
+    // between calls to avoid allocations.
+    // The handling is computed in double precision, in fixed-point mode too. Without contraction,
+    // the arithmetic itself is reproducible, but std::atan2, std::sin and std::cos are not guaranteed
+    // to give the same results with every standard library. Making the handling deterministic across
+    // builds is out of scope, so only replays on the same platform are guaranteed to be exact.
+    void update_car_states(Car* const* cars, std::size_t car_count, const World& world, double frame_duration,
+                           HandlingBatch& batch);
+
+    // The steps update_car_states() consists of. Only the first and the last step touch the
+    // physics bodies, the ones in between work on the batch alone.
+    void gather_car_states(HandlingBatch& batch, Car* const* cars, std::size_t car_count);
+    void gather_wheel_terrains(HandlingBatch& batch, const World& world);
+    void compute_handling_forces(HandlingBatch& batch, double frame_duration);
+    void apply_handling_forces(const HandlingBatch& batch, Car* const* cars);
+
     //HandlingState apply_physics_forces(Car& car, const TerrainMap& terrain_map,
     //                                   double frame_duration);
   }
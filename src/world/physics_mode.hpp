@@ -0,0 +1,25 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+namespace ts
+{
+  namespace world
+  {
+    enum class PhysicsMode
+    {
+      // Chipmunk integrates the bodies, and resolves the collisions between them.
+      Chipmunk,
+
+      // The bodies are integrated in 32.32 fixed point, which gives the same results for every
+      // build, so that simulations can be run in lockstep or replayed. Neither chipmunk's collision
+      // solver nor the car collisions run in this mode. The handling forces that go into the
+      // integrator are still computed in floating point, see update_car_states().
+      FixedPoint
+    };
+  }
+}
@@ -0,0 +1,75 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "sub_stepping.hpp"
+#include "control_point_manager.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
+
+namespace ts
+{
+  namespace world
+  {
+    std::uint64_t SubStepStats::total_ticks() const
+    {
+      return std::accumulate(tick_counts.begin(), tick_counts.end(), std::uint64_t(0));
+    }
+
+    double SubStepStats::average_sub_steps() const
+    {
+      std::uint64_t sub_steps = 0;
+      for (std::size_t n = 0; n != tick_counts.size(); ++n)
+      {
+        sub_steps += n * tick_counts[n];
+      }
+
+      auto ticks = total_ticks();
+      return ticks != 0 ? static_cast<double>(sub_steps) / ticks : 0.0;
+    }
+
+    double thinnest_feature(const ControlPoint* control_points, std::size_t count, double min_feature_size)
+    {
+      auto result = min_feature_size;
+      for (auto point = control_points; point != control_points + count; ++point)
+      {
+        if (point->type != resources::ControlPoint::Area) continue;
+
+        auto width = std::abs(point->end.x - point->start.x);
+        auto height = std::abs(point->end.y - point->start.y);
+        auto size = static_cast<double>(std::min(width, height));
+        if (size > 0.0) result = std::min(result, size);
+      }
+
+      return result;
+    }
+
+    SubStepCount compute_sub_step_count(const SubStepConfig& config, double max_speed, double frame_duration,
+                                        double feature_size, std::size_t car_count)
+    {
+      auto max_sub_steps = std::max(config.max_sub_steps, std::uint32_t(1));
+      auto max_step_distance = feature_size * 0.5;
+
+      std::uint32_t wanted = max_sub_steps;
+      if (max_step_distance > 0.0)
+      {
+        auto steps = std::ceil(max_speed * frame_duration / max_step_distance);
+        if (steps < max_sub_steps) wanted = std::max(static_cast<std::uint32_t>(steps), std::uint32_t(1));
+      }
+
+      auto count = wanted;
+      if (car_count != 0)
+      {
+        auto budget = static_cast<std::uint32_t>(std::max<std::size_t>(config.car_update_budget / car_count, 1));
+        count = std::min(count, budget);
+      }
+
+      return{ count, count < wanted };
+    }
+  }
+}
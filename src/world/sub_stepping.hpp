@@ -0,0 +1,63 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ts
+{
+  namespace world
+  {
+    struct ControlPoint;
+
+    // Sub-stepping runs the handling and the physics step a number of times per tick, so that fast
+    // cars don't skip over thin features. The number of sub-steps is chosen such that no car moves
+    // further than half of the thinnest feature in a single sub-step.
+    // It is opt-in: by default, every tick is a single step, which is how the game has always
+    // handled. Raising max_sub_steps changes the handling, and the cost of a tick.
+    struct SubStepConfig
+    {
+      // Upper bound for the number of sub-steps in a single tick. 1 disables sub-stepping.
+      std::uint32_t max_sub_steps = 1;
+
+      // Upper bound for the number of car updates in a single tick, summed over all sub-steps.
+      // This keeps the cost of a tick bounded when there are many cars.
+      std::uint32_t car_update_budget = 64;
+
+      // The thinnest wall on the track, in world units. The thinnest area control point is taken
+      // into account separately.
+      double min_feature_size = 8.0;
+    };
+
+    struct SubStepStats
+    {
+      // tick_counts[n] is the number of ticks that were divided into n sub-steps.
+      std::vector<std::uint64_t> tick_counts;
+
+      // The number of ticks where the budget made the sub-step count lower than it should have been.
+      std::uint64_t budget_limited_ticks = 0;
+
+      std::uint64_t total_ticks() const;
+      double average_sub_steps() const;
+    };
+
+    // The width or height of the smallest area control point, or min_feature_size if that's smaller.
+    double thinnest_feature(const ControlPoint* control_points, std::size_t count, double min_feature_size);
+
+    struct SubStepCount
+    {
+      std::uint32_t count;
+      bool budget_limited;
+    };
+
+    // max_speed is in world units per second, frame_duration in seconds.
+    SubStepCount compute_sub_step_count(const SubStepConfig& config, double max_speed, double frame_duration,
+                                        double feature_size, std::size_t car_count);
+  }
+}
@@ -0,0 +1,212 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "terrain_coverage.hpp"
+
+#include <boost/container/static_vector.hpp>
+
+#include <algorithm>
+#include <tuple>
+#include <utility>
+
+namespace ts
+{
+  namespace world
+  {
+    const std::int32_t CoverageMask::size;
+    const std::int32_t CoverageMask::size_bits;
+
+    namespace detail
+    {
+      std::int64_t floor_div(std::int64_t a, std::int64_t b)
+      {
+        auto q = a / b;
+        if ((a % b != 0) && ((a < 0) != (b < 0))) --q;
+        return q;
+      }
+
+      std::int64_t ceil_div(std::int64_t a, std::int64_t b)
+      {
+        return -floor_div(-a, b);
+      }
+
+      // The bits first to last, inclusive.
+      std::uint64_t bit_range(std::int32_t first, std::int32_t last)
+      {
+        return (~std::uint64_t(0) >> (63 - (last - first))) << first;
+      }
+
+      // Keeps track of floor(numerator / denominator) while the numerator grows by a fixed step
+      // every row, without dividing. The denominator must be positive.
+      struct FloorDivStepper
+      {
+        FloorDivStepper(std::int64_t numerator, std::int64_t step, std::int64_t denominator)
+          : quotient(floor_div(numerator, denominator)),
+            remainder(numerator - quotient * denominator),
+            quotient_step(floor_div(step, denominator)),
+            remainder_step(step - quotient_step * denominator),
+            denominator(denominator)
+        {
+        }
+
+        void advance()
+        {
+          // Without branches, the carry is as good as random.
+          remainder += remainder_step;
+          auto carry = static_cast<std::int64_t>(remainder >= denominator);
+          quotient += quotient_step + carry;
+          remainder -= carry * denominator;
+        }
+
+        std::int64_t floor() const { return quotient; }
+        std::int64_t ceil() const { return quotient + (remainder != 0); }
+
+        std::int64_t quotient, remainder;
+        std::int64_t quotient_step, remainder_step;
+        std::int64_t denominator;
+      };
+    }
+
+    CoverageMask& CoverageMaskStore::create()
+    {
+      masks_.emplace_back();
+      auto& mask = masks_.back();
+      mask.rows.fill(0);
+      return mask;
+    }
+
+    std::size_t CoverageMaskStore::size() const
+    {
+      return masks_.size();
+    }
+
+    CoverageRasterizer::CoverageRasterizer(CoverageMaskStore& mask_store, IntRect bounds)
+      : mask_store_(&mask_store),
+        bounds_(bounds)
+    {
+    }
+
+    void CoverageRasterizer::add_triangle(Vector2i a, Vector2i b, Vector2i c)
+    {
+      // Same winding as the faces: a point is inside if it is on or to the right of every edge.
+      if (cross_product(b - a, c - a) > 0) std::swap(a, c);
+
+      // Also clip to the bounding box, for degenerate triangles that would otherwise cover
+      // their whole line.
+      auto min_x = std::max(std::min({ a.x, b.x, c.x }), bounds_.left);
+      auto max_x = std::min(std::max({ a.x, b.x, c.x }), bounds_.right() - 1);
+      auto min_y = std::max(std::min({ a.y, b.y, c.y }), bounds_.top);
+      auto max_y = std::min(std::max({ a.y, b.y, c.y }), bounds_.bottom() - 1);
+
+      if (min_y > max_y) return;
+
+      // The edges that bound the span from the left or from the right, and the ones that don't
+      // depend on x, which either include or exclude the whole row.
+      boost::container::static_vector<detail::FloorDivStepper, 3> left_edges, right_edges;
+      boost::container::static_vector<std::pair<std::int64_t, std::int64_t>, 3> flat_edges;
+
+      const std::array<std::pair<Vector2i, Vector2i>, 3> edges = { { { a, b }, { b, c }, { c, a } } };
+      for (const auto& edge : edges)
+      {
+        // cross(q - p, (x, y) - p) <= 0 comes down to dy * x >= limit, with the limit
+        // growing by dx every row.
+        auto p = edge.first, q = edge.second;
+        std::int64_t dx = q.x - p.x, dy = q.y - p.y;
+        auto limit = dx * (min_y - p.y) + dy * p.x;
+
+        if (dy > 0) left_edges.emplace_back(limit, dx, dy);
+        else if (dy < 0) right_edges.emplace_back(-limit, -dx, -dy);
+        else flat_edges.emplace_back(limit, dx);
+      }
+
+      for (auto y = min_y; y <= max_y; ++y)
+      {
+        std::int64_t x_min = min_x, x_max = max_x;
+        for (auto& edge : left_edges)
+        {
+          x_min = std::max(x_min, edge.ceil());
+          edge.advance();
+        }
+
+        for (auto& edge : right_edges)
+        {
+          x_max = std::min(x_max, edge.floor());
+          edge.advance();
+        }
+
+        for (auto& edge : flat_edges)
+        {
+          if (edge.first > 0) x_max = x_min - 1;
+          edge.first += edge.second;
+        }
+
+        if (x_min <= x_max)
+        {
+          fill_span(y, static_cast<std::int32_t>(x_min), static_cast<std::int32_t>(x_max));
+        }
+      }
+    }
+
+    void CoverageRasterizer::fill_span(std::int32_t y, std::int32_t x_min, std::int32_t x_max)
+    {
+      const auto bits = CoverageMask::size_bits;
+      const auto low_mask = CoverageMask::size - 1;
+
+      auto tile_y = y >> bits;
+      auto row = y & low_mask;
+      for (auto tile_x = x_min >> bits, last_tile_x = x_max >> bits; tile_x <= last_tile_x; ++tile_x)
+      {
+        auto first = tile_x == (x_min >> bits) ? x_min & low_mask : 0;
+        auto last = tile_x == last_tile_x ? x_max & low_mask : low_mask;
+        tile_mask(tile_x, tile_y).rows[row] |= detail::bit_range(first, last);
+      }
+    }
+
+    CoverageMask& CoverageRasterizer::tile_mask(std::int32_t tile_x, std::int32_t tile_y)
+    {
+      // Consecutive rows nearly always fall into the same tile.
+      auto key = (static_cast<std::uint64_t>(tile_y) << 32) | static_cast<std::uint32_t>(tile_x);
+      if (last_tile_ && key == last_tile_key_) return *last_tile_;
+
+      auto& mask = tile_lookup_[key];
+      if (!mask)
+      {
+        mask = &mask_store_->create();
+
+        auto position = make_vector2(tile_x << CoverageMask::size_bits, tile_y << CoverageMask::size_bits);
+        tiles_.push_back({ position, mask });
+        tiles_sorted_ = false;
+      }
+
+      last_tile_key_ = key;
+      last_tile_ = mask;
+      return *mask;
+    }
+
+    const std::vector<CoverageTile>& CoverageRasterizer::tiles()
+    {
+      if (!tiles_sorted_)
+      {
+        std::sort(tiles_.begin(), tiles_.end(), [](const CoverageTile& a, const CoverageTile& b)
+        {
+          return std::tie(a.position.y, a.position.x) < std::tie(b.position.y, b.position.x);
+        });
+
+        tiles_sorted_ = true;
+      }
+
+      return tiles_;
+    }
+
+    void CoverageRasterizer::clear()
+    {
+      tile_lookup_.clear();
+      tiles_.clear();
+      tiles_sorted_ = true;
+      last_tile_ = nullptr;
+    }
+  }
+}
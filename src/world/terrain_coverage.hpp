@@ -0,0 +1,89 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#pragma once
+
+#include "utility/vector2.hpp"
+#include "utility/rect.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace ts
+{
+  namespace world
+  {
+    // One bit per pixel for a square tile of the track, the least significant bit is the leftmost pixel.
+    struct CoverageMask
+    {
+      static const std::int32_t size = 64;
+      static const std::int32_t size_bits = 6;
+
+      std::array<std::uint64_t, size> rows;
+    };
+
+    // Owns the coverage masks of a terrain map. Like the pattern store, the masks stay where
+    // they are when more masks are added or when the store is moved.
+    class CoverageMaskStore
+    {
+    public:
+      CoverageMaskStore(const CoverageMaskStore&) = delete;
+      CoverageMaskStore(CoverageMaskStore&&) = default;
+      CoverageMaskStore() = default;
+
+      CoverageMaskStore& operator=(const CoverageMaskStore&) = delete;
+      CoverageMaskStore& operator=(CoverageMaskStore&&) = default;
+
+      CoverageMask& create();
+      std::size_t size() const;
+
+    private:
+      std::deque<CoverageMask> masks_;
+    };
+
+    struct CoverageTile
+    {
+      Vector2i position;
+      const CoverageMask* mask;
+    };
+
+    // CoverageRasterizer scan-converts triangles into coverage tiles. It uses the same inclusive
+    // inside test as the terrain map's faces, which means that the tiles of a path layer cover
+    // exactly the pixels that its triangles did, no matter how many triangles there were.
+    class CoverageRasterizer
+    {
+    public:
+      // Pixels outside of the bounds are left out. The bounds must not be negative.
+      CoverageRasterizer(CoverageMaskStore& mask_store, IntRect bounds);
+
+      void add_triangle(Vector2i a, Vector2i b, Vector2i c);
+
+      // The tiles that were touched since the last call to clear(), in row order.
+      const std::vector<CoverageTile>& tiles();
+
+      // Starts a new set of tiles. The masks of the previous ones stay in the store.
+      void clear();
+
+    private:
+      void fill_span(std::int32_t y, std::int32_t x_min, std::int32_t x_max);
+      CoverageMask& tile_mask(std::int32_t tile_x, std::int32_t tile_y);
+
+      CoverageMaskStore* mask_store_;
+      IntRect bounds_;
+
+      std::unordered_map<std::uint64_t, CoverageMask*> tile_lookup_;
+      std::vector<CoverageTile> tiles_;
+      bool tiles_sorted_ = true;
+
+      std::uint64_t last_tile_key_ = 0;
+      CoverageMask* last_tile_ = nullptr;
+    };
+  }
+}
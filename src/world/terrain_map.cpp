@@ -12,6 +12,7 @@
 #include "utility/interpolate.hpp"
 #include "utility/triangle_utilities.hpp"
 #include "utility/math_utilities.hpp"
+#include "utility/stats.hpp"
 
 namespace ts
 {
@@ -47,7 +48,13 @@ namespace ts
           if (p.y > max.y) max.y = p.y;
         }
 
-        return IntRect(min.x, min.y, max.x - min.x, max.y - min.y);
+        // The inside test is inclusive, so the right and bottom edges lie one past the last vertex.
+        return IntRect(min.x, min.y, max.x - min.x + 1, max.y - min.y + 1);
+      }
+
+      IntRect bounding_box(const Coverage& coverage)
+      {
+        return IntRect(coverage.position, make_vector2(CoverageMask::size, CoverageMask::size));
       }
 
       Vector2i calculate_local_coords(const Pattern& pattern, Vector2i position)
@@ -68,7 +75,31 @@ namespace ts
 
       bool region_contains(IntRect region, const Face& face)
       {
-        return region_contains_triangle(region, face.vertices[0], face.vertices[1], face.vertices[2]);
+        // Like region_contains_triangle, but a pixel on the triangle's edge counts as covered,
+        // to match terrain_at. The corners are the region's outermost pixels.
+        auto v = face.vertices;
+        if (cross_product(v[1] - v[0], v[2] - v[0]) > 0)
+        {
+          std::swap(v[0], v[2]);
+        }
+
+        const Vector2i corners[] =
+        {
+          { region.left, region.top },
+          { region.right() - 1, region.top },
+          { region.left, region.bottom() - 1 },
+          { region.right() - 1, region.bottom() - 1 }
+        };
+
+        auto test_edge = [&](Vector2i a, Vector2i b)
+        {
+          return std::any_of(std::begin(corners), std::end(corners), [=](Vector2i p)
+          {
+            return cross_product(b - a, p - a) <= 0;
+          });
+        };
+
+        return test_edge(v[0], v[1]) && test_edge(v[1], v[2]) && test_edge(v[2], v[0]);
       }
 
       bool region_contains(IntRect region, const Pattern& pattern)
@@ -87,6 +118,23 @@ namespace ts
         return intersects(IntRect(0, 0, pattern.rect.width, pattern.rect.height), rect);
       }
 
+      bool region_contains(IntRect region, const Coverage& coverage)
+      {
+        auto local = intersection(region, bounding_box(coverage));
+        if (local.width <= 0 || local.height <= 0) return false;
+
+        local.left -= coverage.position.x;
+        local.top -= coverage.position.y;
+
+        auto columns = (~std::uint64_t(0) >> (CoverageMask::size - local.width)) << local.left;
+        for (auto y = local.top; y != local.bottom(); ++y)
+        {
+          if (coverage.mask->rows[y] & columns) return true;
+        }
+
+        return false;
+      }
+
       TerrainDescriptor terrain_at(const Pattern& pattern, Vector2i position)
       {
         const auto& pat_rect = pattern.rect;
@@ -121,6 +169,19 @@ namespace ts
         return{};
       }
 
+      TerrainDescriptor terrain_at(const Coverage& coverage, Vector2i position)
+      {
+        auto x = position.x - coverage.position.x;
+        auto y = position.y - coverage.position.y;
+        if (x >= 0 && y >= 0 && x < CoverageMask::size && y < CoverageMask::size &&
+            (coverage.mask->rows[y] >> x) & 1)
+        {
+          return{ coverage.terrain_id, 255 };
+        }
+
+        return{};
+      }
+
       TerrainDescriptor terrain_at(const Base& base, Vector2i position)
       {
         if (contains(base.rect, position))
@@ -134,6 +195,9 @@ namespace ts
 
     namespace detail
     {
+      const stats::Counter terrain_queries("terrain.queries");
+      const stats::Counter component_tests("terrain.component_tests");
+
       TerrainDescriptor terrain_at(const TerrainMapComponent& component, Vector2i position)
       {
         return boost::apply_visitor([=](const auto& data)
@@ -180,9 +244,10 @@ namespace ts
     }
 
     TerrainMap::TerrainMap(std::vector<TerrainMapComponent> components, resources::PatternStore pattern_store, 
-                           Vector2i track_size, resources::TerrainId base_terrain)
+                           CoverageMaskStore coverage_store, Vector2i track_size, resources::TerrainId base_terrain)
       : terrain_components_(std::move(components)),
       pattern_store_(std::move(pattern_store)),
+      coverage_store_(std::move(coverage_store)),
       track_size_(track_size),
       base_terrain_(base_terrain)
     {
@@ -216,10 +281,13 @@ namespace ts
           return intersection(map_components::bounding_box(v), IntRect(Vector2i(), track_size_));
         }, component.data);
 
+        if (bounding_box.width <= 0 || bounding_box.height <= 0) continue;
+
+        // The right and bottom edges are exclusive, and may lie on the edge of the track.
         auto min_cell_x = bounding_box.left >> cell_bits_;
         auto min_cell_y = bounding_box.top >> cell_bits_;
-        auto max_cell_x = bounding_box.right() >> cell_bits_;
-        auto max_cell_y = bounding_box.bottom() >> cell_bits_;
+        auto max_cell_x = (bounding_box.right() - 1) >> cell_bits_;
+        auto max_cell_y = (bounding_box.bottom() - 1) >> cell_bits_;
 
         for (auto y = min_cell_y; y <= max_cell_y; ++y)
         {
@@ -289,7 +357,8 @@ namespace ts
       auto end = component_mapping_.data() + range.second;
 
       std::int32_t alpha = 0;
-      for (auto ptr = begin; ptr != end && alpha < 255; ++ptr)
+      auto ptr = begin;
+      for (; ptr != end && alpha < 255; ++ptr)
       {
         auto& component = terrain_components_[*ptr];
 
@@ -311,6 +380,9 @@ namespace ts
         result = detail::interpolate_terrain(result, base_terrain, 255 - alpha);
       }
 
+      detail::terrain_queries.add();
+      detail::component_tests.add(ptr - begin);
+
       return result;
     }
   }
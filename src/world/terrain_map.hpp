@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include "terrain_coverage.hpp"
+
 #include "resources/terrain_definition.hpp"
 #include "resources/pattern.hpp"
 #include "resources/pattern_store.hpp"
@@ -62,6 +64,14 @@ namespace ts
         IntRect mask_rect;
       };
 
+      // A tile of the track that is covered by a path, see CoverageRasterizer.
+      struct Coverage
+      {
+        resources::TerrainId terrain_id;
+        Vector2i position;
+        const CoverageMask* mask;
+      };
+
       struct Base
       {
         resources::TerrainId terrain_id;
@@ -78,7 +88,7 @@ namespace ts
 
     struct TerrainMapComponent
     {
-      boost::variant<map_components::Pattern, map_components::Face> data;
+      boost::variant<map_components::Pattern, map_components::Face, map_components::Coverage> data;
       std::uint32_t level;
     };
 
@@ -86,7 +96,7 @@ namespace ts
     {
     public:      
       explicit TerrainMap(std::vector<TerrainMapComponent> components, resources::PatternStore pattern_store, 
-                          Vector2i track_size, resources::TerrainId base_terrain);
+                          CoverageMaskStore coverage_store, Vector2i track_size, resources::TerrainId base_terrain);
 
       resources::TerrainDefinition terrain_at(Vector2i position, std::int32_t level, 
                                               const resources::TerrainLibrary& terrain_lib) const;
@@ -102,6 +112,7 @@ namespace ts
       resources::TerrainId base_terrain_ = 0;
 
       resources::PatternStore pattern_store_;
+      CoverageMaskStore coverage_store_;
     };
   }
 }
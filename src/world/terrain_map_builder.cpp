@@ -14,6 +14,8 @@
 
 #include "scene/path_geometry.hpp"
 
+#include "utility/profiler.hpp"
+
 #include <vector>
 #include <array>
 
@@ -23,6 +25,8 @@ namespace ts
   {
     TerrainMap build_terrain_map(const resources::Track& track)
     {
+      TS_PROFILE_ZONE("build_terrain_map");
+
       resources::PatternStore pattern_store;
 
       std::vector<TerrainMapComponent> components;
@@ -31,34 +35,41 @@ namespace ts
       std::vector<scene::PathFace> path_faces;
       std::vector<scene::PathVertex> path_vertices;
 
+      CoverageMaskStore coverage_store;
+      CoverageRasterizer path_rasterizer(coverage_store, IntRect(Vector2i(), track.size()));
+
       const auto& tile_library = track.tile_library();
       const auto& texture_library = track.texture_library().textures();
 
       resources::TerrainId base_terrain_id = 0;
       for (const auto& layer : track.layers())
       {
+        // The faces of a path all have the same terrain, so they are merged into coverage tiles,
+        // rather than adding every face as a component of its own.
         auto add_path_component = [&](auto terrain_id)
         {
+          path_rasterizer.clear();
           for (auto& path_face : path_faces)
           {
-            map_components::Face face;
-            face.alpha = 255;
-            face.mask = nullptr;
-            face.terrain_id = terrain_id;
-
-            std::transform(path_face.indices.begin(), path_face.indices.end(), face.vertices.begin(),
+            std::array<Vector2i, 3> vertices;
+            std::transform(path_face.indices.begin(), path_face.indices.end(), vertices.begin(),
                            [&](std::uint32_t idx)
             {
               return vector2_cast<std::int32_t>(path_vertices[idx].position);
             });
 
-            if (cross_product(face.vertices[1] - face.vertices[0], face.vertices[2] - face.vertices[0]) > 0.0)
-            {
-              std::swap(face.vertices[0], face.vertices[2]);
-            }
+            path_rasterizer.add_triangle(vertices[0], vertices[1], vertices[2]);
+          }
+
+          for (const auto& tile : path_rasterizer.tiles())
+          {
+            map_components::Coverage coverage;
+            coverage.terrain_id = terrain_id;
+            coverage.position = tile.position;
+            coverage.mask = tile.mask;
 
             TerrainMapComponent component;
-            component.data = face;
+            component.data = coverage;
             component.level = layer.level();
             components.push_back(component);
           }
@@ -111,7 +122,7 @@ namespace ts
         }
       }
 
-      return TerrainMap(components, std::move(pattern_store), track.size(), base_terrain_id);      
+      return TerrainMap(components, std::move(pattern_store), std::move(coverage_store), track.size(), base_terrain_id);      
     }
   }
 }
\ No newline at end of file
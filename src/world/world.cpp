@@ -21,6 +21,9 @@
 #include "utility/line_plotter.hpp"
 #include "utility/debug_log.hpp"
 #include "utility/math_utilities.hpp"
+#include "utility/fixed_point.hpp"
+#include "utility/profiler.hpp"
+#include "utility/stats.hpp"
 
 #include <boost/function_output_iterator.hpp>
 #include <boost/iterator/transform_iterator.hpp>
@@ -28,9 +31,11 @@
 
 #include <chipmunk/chipmunk.h>
 
+#include <algorithm>
 #include <vector>
 #include <iostream>
 #include <cmath>
+#include <limits>
 
 namespace ts
 {
@@ -60,9 +65,15 @@ namespace ts
       user_data_->size = size;
     }
 
-    void PhysicsSpace::update(std::uint32_t frame_duration)
+    void PhysicsSpace::update(std::uint32_t frame_duration, std::uint32_t sub_step_count)
     {
-      auto fd = frame_duration * 0.001;
+      if (mode_ == PhysicsMode::FixedPoint)
+      {
+        integrate_fixed_point(frame_duration, sub_step_count);
+        return;
+      }
+
+      auto fd = frame_duration * 0.001 / sub_step_count;
 
       cpSpaceStep(static_cast<cpSpace*>(physics_space_.get()), fd);
     }
@@ -74,6 +85,129 @@ namespace ts
       cpSpaceAddBody(static_cast<cpSpace*>(physics_space_.get()), body);
 
       cpBodySetPositionUpdateFunc(body, update_body_position);
+
+      // NaN never compares equal, which makes sure the fixed-point state is read from the body first.
+      const auto nan = std::numeric_limits<double>::quiet_NaN();
+      bodies_.push_back({ entity, FixedBodyState(), { nan, nan }, { nan, nan }, nan, nan });
+    }
+
+    void PhysicsSpace::set_mode(PhysicsMode mode)
+    {
+      mode_ = mode;
+
+      const auto nan = std::numeric_limits<double>::quiet_NaN();
+      for (auto& body : bodies_)
+      {
+        body.written_position = { nan, nan };
+        body.written_velocity = { nan, nan };
+        body.written_rotation = nan;
+        body.written_angular_velocity = nan;
+      }
+    }
+
+    PhysicsMode PhysicsSpace::mode() const
+    {
+      return mode_;
+    }
+
+    static Vector2<Fixed64> to_fixed(cpVect v)
+    {
+      return{ Fixed64::from_double(v.x), Fixed64::from_double(v.y) };
+    }
+
+    static cpVect to_cp(Vector2<Fixed64> v)
+    {
+      return{ v.x.to_double(), v.y.to_double() };
+    }
+
+    void PhysicsSpace::integrate_fixed_point(std::uint32_t frame_duration, std::uint32_t sub_step_count)
+    {
+      auto fd = Fixed64::from_ratio(static_cast<std::int32_t>(frame_duration),
+                                    static_cast<std::int32_t>(1000 * sub_step_count));
+      auto world_size = make_vector2(Fixed64::from_double(user_data_->size.x),
+                                     Fixed64::from_double(user_data_->size.y));
+
+      for (auto& entry : bodies_)
+      {
+        auto body = static_cast<cpBody*>(entry.entity->physics_body_.get());
+        auto& state = entry.fixed_state;
+
+        // Only take the values that were changed from outside, anything else would
+        // lose the precision of the fixed-point state.
+        auto position = cpBodyGetPosition(body);
+        auto velocity = cpBodyGetVelocity(body);
+        auto rotation = cpBodyGetAngle(body);
+        auto angular_velocity = cpBodyGetAngularVelocity(body);
+
+        if (position.x != entry.written_position.x || position.y != entry.written_position.y ||
+            rotation != entry.written_rotation)
+        {
+          state.position = to_fixed(cpBodyLocalToWorld(body, cpBodyGetCenterOfGravity(body)));
+        }
+
+        if (velocity.x != entry.written_velocity.x || velocity.y != entry.written_velocity.y)
+        {
+          state.velocity = to_fixed(velocity);
+        }
+
+        if (rotation != entry.written_rotation) state.rotation = Fixed64::from_double(rotation);
+
+        if (angular_velocity != entry.written_angular_velocity)
+        {
+          state.angular_velocity = Fixed64::from_double(angular_velocity);
+        }
+
+        FixedBodyForces forces;
+        forces.force = to_fixed(cpBodyGetForce(body));
+        forces.torque = Fixed64::from_double(cpBodyGetTorque(body));
+        forces.inverse_mass = Fixed64::from_double(1.0 / cpBodyGetMass(body));
+        forces.inverse_moment = Fixed64::from_double(1.0 / cpBodyGetMoment(body));
+
+        integrate_body(state, forces, fd, world_size);
+
+        // The angle has to be set first, the body's transform depends on it.
+        cpBodySetAngle(body, state.rotation.to_double());
+        cpBodySetVelocity(body, to_cp(state.velocity));
+        cpBodySetAngularVelocity(body, state.angular_velocity.to_double());
+
+        auto center_offset = cpvsub(cpBodyLocalToWorld(body, cpBodyGetCenterOfGravity(body)),
+                                    cpBodyGetPosition(body));
+        cpBodySetPosition(body, cpvsub(to_cp(state.position), center_offset));
+
+        cpBodySetForce(body, cpvzero);
+        cpBodySetTorque(body, 0.0);
+
+        auto written_position = cpBodyGetPosition(body);
+        auto written_velocity = cpBodyGetVelocity(body);
+        entry.written_position = { written_position.x, written_position.y };
+        entry.written_velocity = { written_velocity.x, written_velocity.y };
+        entry.written_rotation = cpBodyGetAngle(body);
+        entry.written_angular_velocity = cpBodyGetAngularVelocity(body);
+      }
+    }
+
+    std::uint64_t PhysicsSpace::state_hash() const
+    {
+      StateHasher hasher;
+      for (const auto& entry : bodies_)
+      {
+        if (mode_ == PhysicsMode::FixedPoint)
+        {
+          hasher.add(entry.fixed_state);
+          continue;
+        }
+
+        auto body = static_cast<const cpBody*>(entry.entity->physics_body_.get());
+
+        FixedBodyState state;
+        state.position = to_fixed(cpBodyLocalToWorld(body, cpBodyGetCenterOfGravity(body)));
+        state.velocity = to_fixed(cpBodyGetVelocity(body));
+        state.rotation = Fixed64::from_double(cpBodyGetAngle(body));
+        state.angular_velocity = Fixed64::from_double(cpBodyGetAngularVelocity(body));
+        hasher.add(state);
+      }
+
+      return hasher.hash();
     }
 
     void PhysicsSpace::Deleter::operator()(void* space) const
@@ -89,6 +223,8 @@ namespace ts
     {
       entity_map_.resize(limits::max_car_count);
       cars_.reserve(limits::max_car_count);
+
+      set_sub_step_config(sub_step_config_);
     }
 
     Car* World::create_car(const CarDefinition& car_definition, std::uint8_t car_id, std::uint16_t start_pos)
@@ -115,6 +251,7 @@ namespace ts
       entity_map_[entity_id] = std::move(car);
 
       physics_space_.add_entity(car_ptr);
+      car_collisions_.add_entity(car_ptr, car_collision_shape(car_definition));
 
       car_ptr->set_position(position);
       car_ptr->set_rotation(rotation);
@@ -125,33 +262,103 @@ namespace ts
 
     void World::update(std::uint32_t frame_duration, world::EventInterface& event_interface)
     {
+      TS_PROFILE_ZONE("World::update");
+
       double fd = frame_duration * 0.001;
 
       auto max_corner = vector2_cast<std::int32_t>(world_size()) - make_vector2(1, 1);
 
       const auto& terrain_lib = track_.terrain_library();
 
-      entity_states_.clear();      
+      double max_speed = 0.0;
       for (auto* car : cars_)
       {
-        entity_states_.push_back({ car, car->position() });
-
-        car->update(*this, fd);
+        max_speed = std::max(max_speed, magnitude(car->velocity()));
       }
 
-      physics_space_.update(frame_duration);
+      auto sub_steps = compute_sub_step_count(sub_step_config_, max_speed, fd, thinnest_feature_, cars_.size());
 
-      for (auto& es : entity_states_)
+      auto& tick_counts = sub_step_stats_.tick_counts;
+      if (tick_counts.size() <= sub_steps.count) tick_counts.resize(sub_steps.count + 1);
+      ++tick_counts[sub_steps.count];
+      if (sub_steps.budget_limited) ++sub_step_stats_.budget_limited_ticks;
+
+      for (std::uint32_t sub_step = 0; sub_step != sub_steps.count; ++sub_step)
       {
-        auto cp_hit_callback = [&](const ControlPoint& point, double time_point)
+        entity_states_.clear();
+        for (auto* car : cars_)
+        {
+          entity_states_.push_back({ car, car->position() });
+        }
+
+        update_car_states(cars_.data(), cars_.size(), *this, fd / sub_steps.count, handling_batch_);
+
+        physics_space_.update(frame_duration, sub_steps.count);
+
+        // The collision response works in floating point, and would write its results back into
+        // the fixed-point state. Cars pass through each other in fixed-point mode.
+        if (physics_space_.mode() != PhysicsMode::FixedPoint) car_collisions_.update();
+
+        for (auto& es : entity_states_)
         {
-          auto frame_offset = static_cast<std::uint32_t>(frame_duration * time_point);
+          auto cp_hit_callback = [&](const ControlPoint& point, double time_point)
+          {
+            auto frame_offset = static_cast<std::uint32_t>(frame_duration * (sub_step + time_point) /
+                                                           sub_steps.count);
 
-          event_interface.on_control_point_hit(es.entity, point, frame_offset);
-        };
+            event_interface.on_control_point_hit(es.entity, point, frame_offset);
+          };
 
-        control_point_manager_.test_control_point_intersections(es.old_position, es.entity->position(), cp_hit_callback);
+          control_point_manager_.test_control_point_intersections(es.old_position, es.entity->position(), cp_hit_callback);
+        }
       }
+
+      car_collisions_.report_collisions(event_interface);
+
+      state_hash_ = physics_space_.state_hash();
+
+      // Ends up in the stats dumps, which makes it possible to compare two runs of the same race.
+      static const stats::Gauge state_hash("world.state_hash");
+      state_hash.set(static_cast<std::int64_t>(state_hash_));
+    }
+
+    void World::set_physics_mode(PhysicsMode mode)
+    {
+      physics_space_.set_mode(mode);
+    }
+
+    PhysicsMode World::physics_mode() const
+    {
+      return physics_space_.mode();
+    }
+
+    std::uint64_t World::state_hash() const
+    {
+      return state_hash_;
+    }
+
+    void World::set_sub_step_config(const SubStepConfig& config)
+    {
+      sub_step_config_ = config;
+
+      const auto& control_points = control_point_manager_.control_points();
+      thinnest_feature_ = thinnest_feature(control_points.data(), control_points.size(),
+                                           config.min_feature_size);
+    }
+
+    const SubStepConfig& World::sub_step_config() const
+    {
+      return sub_step_config_;
+    }
+
+    const SubStepStats& World::sub_step_stats() const
+    {
+      return sub_step_stats_;
+    }
+
+    void World::reset_sub_step_stats()
+    {
+      sub_step_stats_ = SubStepStats();
     }
 
     Car* World::find_car(std::uint8_t car_id)
@@ -9,6 +9,11 @@
 #include "entity.hpp"
 #include "control_point_manager.hpp"
 #include "terrain_map.hpp"
+#include "handling_batch.hpp"
+#include "fixed_integrator.hpp"
+#include "sub_stepping.hpp"
+#include "car_collision.hpp"
+#include "physics_mode.hpp"
 
 #include "resources/track.hpp"
 #include "resources/pattern.hpp"
@@ -54,12 +59,20 @@ namespace ts
     public:
       explicit PhysicsSpace(Vector2d size);
 
-      void update(std::uint32_t frame_duration);
+      // Advances the simulation by frame_duration / sub_step_count milliseconds.
+      void update(std::uint32_t frame_duration, std::uint32_t sub_step_count = 1);
 
       void add_entity(Entity* entity);
 
       void add_static_circle();
       void add_static_polygon();
+
+      void set_mode(PhysicsMode mode);
+      PhysicsMode mode() const;
+
+      // Hash of the state of all bodies. In fixed-point mode, this is exactly the integrator's state,
+      // otherwise the bodies' state is rounded to fixed point first.
+      std::uint64_t state_hash() const;
       
       struct UserData
       {
@@ -67,13 +80,31 @@ namespace ts
       };
 
     private:
+      void integrate_fixed_point(std::uint32_t frame_duration, std::uint32_t sub_step_count);
+
       struct Deleter
       {
         void operator()(void*) const;
       };      
+
+      struct Body
+      {
+        Entity* entity;
+        FixedBodyState fixed_state;
+
+        // The values that were last written to the chipmunk body. If the body doesn't have these
+        // values anymore, it has been modified from outside and the fixed-point state is refreshed.
+        Vector2d written_position;
+        Vector2d written_velocity;
+        double written_rotation;
+        double written_angular_velocity;
+      };
       
       std::unique_ptr<void, Deleter> physics_space_;
       std::unique_ptr<UserData> user_data_;
+
+      PhysicsMode mode_ = PhysicsMode::Chipmunk;
+      std::vector<Body> bodies_;
     };
 
     // The World class manages all objects related to the physical state of the game.
@@ -88,6 +119,19 @@ namespace ts
 
       void update(std::uint32_t frame_duration, world::EventInterface& event_interface);
 
+      // The mode can be changed at any time, the bodies carry their state over to the new mode.
+      void set_physics_mode(PhysicsMode mode);
+      PhysicsMode physics_mode() const;
+
+      // The physics state hash after the most recent update.
+      std::uint64_t state_hash() const;
+
+      void set_sub_step_config(const SubStepConfig& config);
+      const SubStepConfig& sub_step_config() const;
+
+      const SubStepStats& sub_step_stats() const;
+      void reset_sub_step_stats();
+
       Car* create_car(const CarDefinition& car_definition, std::uint8_t car_id, std::uint16_t start_pos);
 
       const Car* find_car(std::uint8_t car_id) const;
@@ -117,12 +161,20 @@ namespace ts
         Vector2d old_position;
       };
       std::vector<EntityState> entity_states_;
+      HandlingBatch handling_batch_;
 
       resources::Track track_;
       TerrainMap terrain_map_;
       ControlPointManager control_point_manager_;
 
       PhysicsSpace physics_space_;
+      std::uint64_t state_hash_ = 0;
+
+      CarCollisions car_collisions_;
+
+      SubStepConfig sub_step_config_;
+      SubStepStats sub_step_stats_;
+      double thinnest_feature_;
     };
   }
 }
@@ -56,7 +56,7 @@ namespace ts
       messages::EntityCollision message;
       message.subject = subject;
       message.object = object;
-      //message.collision = collision;
+      message.collision = collision;
       dispatch_message(message);
     }
   }
@@ -16,6 +16,7 @@ namespace ts
       struct SceneryCollision;
       struct EntityCollision;
       struct CarPropertiesUpdate;
+      struct PhysicsModeChange;
     }
   }
 }
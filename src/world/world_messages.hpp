@@ -8,6 +8,9 @@
 
 #include <cstdint>
 
+#include "collision_result.hpp"
+#include "physics_mode.hpp"
+
 #include "resources/handling.hpp"
 
 #include "utility/vector2.hpp"
@@ -38,6 +41,7 @@ namespace ts
       {
         const Entity* subject;
         const Entity* object;
+        CollisionResult collision;
       };
 
       struct CarPropertiesUpdate
@@ -48,6 +52,11 @@ namespace ts
         double moment;
         resources::Handling handling;
       };
+
+      struct PhysicsModeChange
+      {
+        PhysicsMode mode;
+      };
     }
   }
 }
@@ -0,0 +1,174 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "catch.hpp"
+
+#include "world/car.hpp"
+#include "world/car_collision.hpp"
+#include "world/world_event_interface.hpp"
+
+#include "resources/car_definition.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using namespace ts;
+
+namespace
+{
+  struct CollisionRecorder
+    : world::EventInterface
+  {
+    virtual void on_collision(const world::Entity*, const world::Entity*,
+                              const world::CollisionResult& collision) override
+    {
+      collisions.push_back(collision);
+    }
+
+    std::vector<world::CollisionResult> collisions;
+  };
+
+  resources::CarDefinition make_car_definition()
+  {
+    resources::CarDefinition car_definition;
+    car_definition.image_rect = IntRect(0, 0, 40, 20);
+    car_definition.image_scale = 2.0;
+    car_definition.bounciness = 0.5;
+    return car_definition;
+  }
+
+  bool pair_less(const world::CollisionPair& a, const world::CollisionPair& b)
+  {
+    return std::tie(a.first, a.second) < std::tie(b.first, b.second);
+  }
+}
+
+TEST_CASE("Sweep-and-prune finds the same pairs as testing all pairs")
+{
+  std::mt19937 random_engine(42);
+  std::uniform_real_distribution<double> position_dist(-200.0, 200.0);
+  std::uniform_real_distribution<double> radius_dist(2.0, 12.0);
+
+  std::vector<world::BoundingCircle> circles;
+  for (int index = 0; index != 300; ++index)
+  {
+    circles.push_back({ { position_dist(random_engine), position_dist(random_engine) }, radius_dist(random_engine),
+                        static_cast<std::uint32_t>(index % 7 == 0) });
+  }
+
+  // The second call starts from the order of the first one.
+  world::BroadPhase broad_phase;
+  broad_phase.find_pairs(circles.data(), circles.size());
+  for (auto& circle : circles) circle.center.y += position_dist(random_engine) * 0.1;
+
+  auto sweep_pairs = broad_phase.find_pairs(circles.data(), circles.size());
+
+  std::vector<world::CollisionPair> all_pairs;
+  world::detail::find_all_pairs(circles.data(), circles.size(), all_pairs);
+
+  std::sort(sweep_pairs.begin(), sweep_pairs.end(), pair_less);
+  REQUIRE(sweep_pairs.size() == all_pairs.size());
+  CHECK(std::equal(sweep_pairs.begin(), sweep_pairs.end(), all_pairs.begin(),
+                   [](const world::CollisionPair& a, const world::CollisionPair& b)
+  {
+    return a.first == b.first && a.second == b.second;
+  }));
+}
+
+TEST_CASE("Colliding cars bounce off each other")
+{
+  auto car_definition = make_car_definition();
+  auto collision_shape = world::car_collision_shape(car_definition);
+  REQUIRE(collision_shape.sub_shapes.size() == 1);
+
+  world::Car first(car_definition, 0), second(car_definition, 1), distant(car_definition, 2);
+  first.set_position({ 100.0, 100.0 });
+  first.set_velocity({ 50.0, 0.0 });
+  second.set_position({ 119.0, 100.0 });
+  second.set_velocity({ -50.0, 0.0 });
+  distant.set_position({ 500.0, 100.0 });
+
+  world::CarCollisions car_collisions;
+  car_collisions.add_entity(&first, collision_shape);
+  car_collisions.add_entity(&second, collision_shape);
+  car_collisions.add_entity(&distant, collision_shape);
+
+  CollisionRecorder recorder;
+  car_collisions.update(recorder);
+
+  CHECK(car_collisions.candidate_pair_count() == 1);
+  CHECK(car_collisions.contact_count() == 1);
+  REQUIRE(recorder.collisions.size() == 1);
+
+  const auto& collision = recorder.collisions.front();
+  CHECK(collision.normal.x == Approx(1.0));
+  CHECK(collision.impact == Approx(100.0));
+  CHECK(collision.bounce_factor == Approx(0.25));
+  CHECK(collision.impulse > 0.0);
+
+  CHECK(first.velocity().x < 0.0);
+  CHECK(second.velocity().x > 0.0);
+  CHECK(first.velocity().x + second.velocity().x == Approx(0.0).epsilon(0.0001));
+  CHECK(second.position().x - first.position().x > 19.0);
+}
+
+TEST_CASE("Cars on different levels don't collide")
+{
+  auto car_definition = make_car_definition();
+  auto collision_shape = world::car_collision_shape(car_definition);
+
+  world::Car first(car_definition, 0), second(car_definition, 1);
+  first.set_position({ 100.0, 100.0 });
+  second.set_position({ 105.0, 100.0 });
+  second.set_z_position(1.0);
+
+  world::CarCollisions car_collisions;
+  car_collisions.add_entity(&first, collision_shape);
+  car_collisions.add_entity(&second, collision_shape);
+
+  CollisionRecorder recorder;
+  car_collisions.update(recorder);
+
+  CHECK(car_collisions.candidate_pair_count() == 0);
+  CHECK(recorder.collisions.empty());
+}
+
+TEST_CASE("Contacts during sub-steps are reported once per pair")
+{
+  auto car_definition = make_car_definition();
+  auto collision_shape = world::car_collision_shape(car_definition);
+
+  world::Car first(car_definition, 0), second(car_definition, 1);
+  first.set_position({ 100.0, 100.0 });
+  second.set_position({ 115.0, 100.0 });
+
+  world::CarCollisions car_collisions;
+  car_collisions.add_entity(&first, collision_shape);
+  car_collisions.add_entity(&second, collision_shape);
+
+  // The cars are still overlapping in every sub-step, and hit each other hardest in the second one.
+  const double speeds[] = { 20.0, 60.0, 40.0 };
+  for (auto speed : speeds)
+  {
+    first.set_velocity({ speed, 0.0 });
+    second.set_velocity({ -speed, 0.0 });
+    car_collisions.update();
+    CHECK(car_collisions.contact_count() == 1);
+  }
+
+  CollisionRecorder recorder;
+  car_collisions.report_collisions(recorder);
+  REQUIRE(recorder.collisions.size() == 1);
+  CHECK(recorder.collisions.front().impact == Approx(120.0));
+
+  // Everything was reported already.
+  recorder.collisions.clear();
+  car_collisions.report_collisions(recorder);
+  CHECK(recorder.collisions.empty());
+}
@@ -0,0 +1,106 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "catch.hpp"
+
+#include "scene/car_instances.hpp"
+
+#include "graphics/texture.hpp"
+
+#include <cstddef>
+#include <vector>
+
+TEST_CASE("Car instances are packed in draw order, and batched without reordering overlapping cars")
+{
+  using namespace ts;
+
+  // The textures have no GL texture behind them, so they're told apart by address only.
+  graphics::Texture car_textures[2] = { graphics::Texture(0, { 256, 256 }), graphics::Texture(0, { 256, 256 }) };
+  graphics::Texture colorizer_texture(0, { 256, 256 });
+
+  // Interleave the textures on level 1, so that grouping by texture would change the overlap order.
+  const std::uint32_t levels[] = { 1, 0, 1, 1, 0, 1 };
+  const std::size_t textures[] = { 0, 1, 1, 0, 1, 0 };
+
+  std::vector<scene::DrawableEntity> entities(6);
+  for (std::size_t index = 0; index != entities.size(); ++index)
+  {
+    auto& entity = entities[index];
+    entity.texture = &car_textures[textures[index]];
+    entity.colorizer_texture = &colorizer_texture;
+    entity.level = levels[index];
+
+    entity.model_transform.translate(10.0f * index, 20.0f);
+    entity.new_model_transform.translate(10.0f * index + 1.0f, 20.0f);
+    entity.texture_coords_offset = { 0.25f * index, 0.5f };
+    entity.texture_coords_scale = { 0.25f, 0.125f };
+    entity.colors.fill(static_cast<float>(index));
+  }
+
+  scene::DrawCommandList commands;
+  scene::record_entity_commands(entities.data(), entities.size(), commands);
+
+  std::vector<std::uint32_t> order;
+  for (const auto& command : commands) order.push_back(command.index);
+  REQUIRE(order == std::vector<std::uint32_t>({ 1, 4, 0, 2, 3, 5 }));
+
+  std::vector<scene::CarInstance> instances;
+  std::vector<scene::CarInstanceBatch> batches;
+  scene::pack_car_instances(entities.data(), commands, instances, batches);
+
+  REQUIRE(instances.size() == entities.size());
+  for (std::size_t instance_index = 0; instance_index != instances.size(); ++instance_index)
+  {
+    const auto& instance = instances[instance_index];
+    auto entity_index = order[instance_index];
+
+    // The transforms are stored as the top two rows of the affine matrix, translation last.
+    CHECK(instance.model_transform[0] == 1.0f);
+    CHECK(instance.model_transform[2] == 10.0f * entity_index);
+    CHECK(instance.model_transform[4] == 1.0f);
+    CHECK(instance.model_transform[5] == 20.0f);
+    CHECK(instance.new_model_transform[2] == 10.0f * entity_index + 1.0f);
+    CHECK(instance.texture_coords_offset.x == 0.25f * entity_index);
+    CHECK(instance.texture_coords_scale.y == 0.125f);
+    CHECK(instance.colors[8] == static_cast<float>(entity_index));
+  }
+
+  // Only consecutive instances that share their level and textures are batched.
+  REQUIRE(batches.size() == 4);
+  CHECK(batches[0].level == 0);
+  CHECK(batches[0].texture == &car_textures[1]);
+  CHECK(batches[0].instance_offset == 0);
+  CHECK(batches[0].instance_count == 2);
+
+  CHECK(batches[1].level == 1);
+  CHECK(batches[1].texture == &car_textures[0]);
+  CHECK(batches[1].instance_offset == 2);
+  CHECK(batches[1].instance_count == 1);
+
+  CHECK(batches[2].level == 1);
+  CHECK(batches[2].texture == &car_textures[1]);
+  CHECK(batches[2].instance_offset == 3);
+  CHECK(batches[2].instance_count == 1);
+
+  CHECK(batches[3].level == 1);
+  CHECK(batches[3].texture == &car_textures[0]);
+  CHECK(batches[3].instance_offset == 4);
+  CHECK(batches[3].instance_count == 2);
+}
+
+TEST_CASE("The car instance layout matches the instance attributes")
+{
+  using namespace ts;
+
+  // The attributes are read as tightly packed floats: three vec3 pairs, one vec4 and three vec3s.
+  CHECK(sizeof(scene::CarInstance) == sizeof(float) * 31);
+  CHECK(offsetof(scene::CarInstance, model_transform) == 0);
+  CHECK(offsetof(scene::CarInstance, new_model_transform) == sizeof(float) * 6);
+  CHECK(offsetof(scene::CarInstance, colorizer_transform) == sizeof(float) * 12);
+  CHECK(offsetof(scene::CarInstance, texture_coords_offset) == sizeof(float) * 18);
+  CHECK(offsetof(scene::CarInstance, texture_coords_scale) == sizeof(float) * 20);
+  CHECK(offsetof(scene::CarInstance, colors) == sizeof(float) * 22);
+}
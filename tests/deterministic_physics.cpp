@@ -0,0 +1,325 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "catch.hpp"
+
+#include "world/fixed_integrator.hpp"
+#include "world/world.hpp"
+#include "world/car.hpp"
+#include "world/terrain_map_builder.hpp"
+#include "world/world_event_interface.hpp"
+
+#include "controls/control.hpp"
+
+#include "resources/track_loader.hpp"
+#include "resources/car_definition.hpp"
+#include "resources/track.hpp"
+#include "resources/start_point.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+using namespace ts;
+
+namespace
+{
+  // Integer generator, so that the input stream is the same for every standard library.
+  struct InputStream
+  {
+    std::int32_t next(std::int32_t max)
+    {
+      state = state * UINT64_C(6364136223846793005) + UINT64_C(1442695040888963407);
+      return static_cast<std::int32_t>((state >> 33) % static_cast<std::uint64_t>(2 * max + 1)) - max;
+    }
+
+    std::uint64_t state = 12345;
+  };
+
+  std::uint64_t run_simulation(std::size_t body_count, std::size_t tick_count,
+                               std::vector<std::uint64_t>* tick_hashes = nullptr)
+  {
+    auto world_size = make_vector2(Fixed64::from_int(2048), Fixed64::from_int(2048));
+    auto frame_duration = Fixed64::from_ratio(20, 1000);
+
+    std::vector<world::FixedBodyState> bodies(body_count);
+    for (std::size_t i = 0; i != body_count; ++i)
+    {
+      bodies[i].position = make_vector2(Fixed64::from_int(200 + 100 * static_cast<std::int32_t>(i)),
+                                        Fixed64::from_int(1000));
+      bodies[i].rotation = Fixed64::from_ratio(static_cast<std::int32_t>(i), 3);
+    }
+
+    InputStream input;
+    world::StateHasher hasher;
+    for (std::size_t tick = 0; tick != tick_count; ++tick)
+    {
+      for (auto& body : bodies)
+      {
+        world::FixedBodyForces forces;
+        forces.force = make_vector2(Fixed64::from_ratio(input.next(50000), 7),
+                                    Fixed64::from_ratio(input.next(50000), 7));
+        forces.torque = Fixed64::from_ratio(input.next(20000), 3);
+        forces.inverse_mass = Fixed64::from_ratio(1, 1500);
+        forces.inverse_moment = Fixed64::from_ratio(1, 4000);
+
+        world::integrate_body(body, forces, frame_duration, world_size);
+        hasher.add(body);
+      }
+
+      if (tick_hashes) tick_hashes->push_back(hasher.hash());
+    }
+
+    return hasher.hash();
+  }
+
+  // The test track has no control points to derive the start points from, so they are placed by hand.
+  resources::Track load_test_track(std::initializer_list<Vector2i> start_positions)
+  {
+    resources::TrackLoader track_loader;
+    track_loader.load_from_file("assets/tracks/test.trk");
+
+    auto track = track_loader.get_result();
+    for (auto position : start_positions)
+    {
+      resources::StartPoint start_point;
+      start_point.position = position;
+      track.add_start_point(start_point);
+    }
+
+    return track;
+  }
+
+  struct CollisionCounter
+    : world::EventInterface
+  {
+    virtual void on_collision(const world::Entity*, const world::Entity*,
+                              const world::CollisionResult&) override
+    {
+      ++count;
+    }
+
+    std::size_t count = 0;
+  };
+}
+
+TEST_CASE("Fixed-point arithmetic is exact and rounds to nearest")
+{
+  CHECK(Fixed64::from_int(3).raw() == INT64_C(3) << 32);
+  CHECK((Fixed64::from_int(3) * Fixed64::from_int(-7)) == Fixed64::from_int(-21));
+  CHECK((Fixed64::from_ratio(1, 2) * Fixed64::from_ratio(1, 2)) == Fixed64::from_ratio(1, 4));
+  CHECK((Fixed64::from_raw(1) * Fixed64::from_ratio(1, 2)).raw() == 1);
+  CHECK((Fixed64::from_raw(-1) * Fixed64::from_ratio(1, 2)).raw() == -1);
+  CHECK((Fixed64::from_raw(1) * Fixed64::from_raw(1)).raw() == 0);
+  CHECK(Fixed64::from_double(-2.25).to_double() == -2.25);
+  CHECK(Fixed64::from_double(1e30) > Fixed64::from_int(2000000000));
+  CHECK(Fixed64::from_double(-1e30) < Fixed64::from_int(-2000000000));
+  CHECK(-Fixed64::from_int(5) == Fixed64::from_int(-5));
+}
+
+TEST_CASE("Fixed-point integration keeps bodies inside the world")
+{
+  world::FixedBodyState state;
+  state.position = make_vector2(Fixed64::from_int(1), Fixed64::from_int(1));
+  state.velocity = make_vector2(Fixed64::from_int(-1000), Fixed64::from_int(1000));
+
+  world::FixedBodyForces forces;
+  world::integrate_body(state, forces, Fixed64::from_ratio(1, 10), make_vector2(Fixed64::from_int(50),
+                                                                                Fixed64::from_int(50)));
+
+  CHECK(state.position.x == Fixed64());
+  CHECK(state.position.y == Fixed64::from_int(50));
+}
+
+TEST_CASE("Fixed-point simulation is deterministic")
+{
+  std::vector<std::uint64_t> first, second;
+  run_simulation(8, 500, &first);
+  run_simulation(8, 500, &second);
+
+  REQUIRE(first.size() == 500);
+  CHECK(first == second);
+
+  // Recorded on the reference build. Any change means the simulation no longer
+  // runs in lockstep with other builds or with recorded replays.
+  CHECK(run_simulation(8, 3000) == UINT64_C(0xfb476b42b36ffb0d));
+}
+
+TEST_CASE("The physics mode can be switched in the middle of a race")
+{
+  auto track = load_test_track({ { 300, 300 } });
+
+  resources::CarDefinition car_definition;
+  car_definition.image_rect = IntRect(0, 0, 40, 20);
+
+  struct RaceResult
+  {
+    std::uint64_t state_hash;
+    double max_distance;
+    Vector2d end_position;
+    world::PhysicsMode end_mode;
+  };
+
+  // A car coasts along for 60 ticks, in fixed-point mode during [fixed_point_start, fixed_point_end).
+  auto run_race = [&](std::uint32_t fixed_point_start, std::uint32_t fixed_point_end)
+  {
+    world::World world_obj(track, world::build_terrain_map(track));
+    auto car = world_obj.create_car(car_definition, 0, 0);
+    REQUIRE(car != nullptr);
+
+    auto start_position = car->position();
+    car->set_velocity({ 100.0, 40.0 });
+
+    world::EventInterface event_interface;
+    RaceResult result = {};
+    for (std::uint32_t tick = 0; tick != 60; ++tick)
+    {
+      if (tick == fixed_point_start) world_obj.set_physics_mode(world::PhysicsMode::FixedPoint);
+      if (tick == fixed_point_end) world_obj.set_physics_mode(world::PhysicsMode::Chipmunk);
+
+      auto position = car->position();
+      world_obj.update(20, event_interface);
+      result.max_distance = std::max(result.max_distance, magnitude(car->position() - position));
+    }
+
+    result.state_hash = world_obj.state_hash();
+    result.end_position = car->position();
+    result.end_mode = world_obj.physics_mode();
+
+    CHECK(result.end_position != start_position);
+    return result;
+  };
+
+  auto chipmunk_only = run_race(60, 60);
+  auto switched = run_race(20, 40);
+
+  // The car's state is carried over in both directions, so the car doesn't jump when switching.
+  // At 108 units per second, it moves about 2 units per tick.
+  CHECK(switched.max_distance < 5.0);
+  CHECK(switched.max_distance <= chipmunk_only.max_distance + 1.0);
+  CHECK(switched.end_mode == world::PhysicsMode::Chipmunk);
+
+  // Replaying the same race gives the same result.
+  auto replayed = run_race(20, 40);
+  CHECK(replayed.state_hash == switched.state_hash);
+  CHECK(replayed.end_position == switched.end_position);
+}
+
+TEST_CASE("Overlapping cars don't disturb the fixed-point simulation")
+{
+  // The second car sits right on top of the first one.
+  auto track = load_test_track({ { 300, 300 }, { 310, 300 } });
+
+  resources::CarDefinition car_definition;
+  car_definition.image_rect = IntRect(0, 0, 40, 20);
+
+  struct RaceResult
+  {
+    std::uint64_t state_hash;
+    Vector2d end_position;
+    Vector2d end_velocity;
+    std::size_t collision_count;
+  };
+
+  auto run_race = [&](std::uint16_t car_count)
+  {
+    world::World world_obj(track, world::build_terrain_map(track));
+    world_obj.set_physics_mode(world::PhysicsMode::FixedPoint);
+
+    world::Car* first_car = nullptr;
+    for (std::uint16_t index = 0; index != car_count; ++index)
+    {
+      auto car = world_obj.create_car(car_definition, static_cast<std::uint8_t>(index), index);
+      REQUIRE(car != nullptr);
+      car->set_velocity({ 60.0 - 40.0 * index, 10.0 });
+
+      if (!first_car) first_car = car;
+    }
+
+    CollisionCounter event_interface;
+    for (std::uint32_t tick = 0; tick != 50; ++tick)
+    {
+      world_obj.update(20, event_interface);
+    }
+
+    return RaceResult{ world_obj.state_hash(), first_car->position(), first_car->velocity(),
+                       event_interface.count };
+  };
+
+  auto overlapping = run_race(2);
+  auto replayed = run_race(2);
+  auto alone = run_race(1);
+
+  CHECK(overlapping.collision_count == 0);
+  CHECK(replayed.state_hash == overlapping.state_hash);
+
+  // The collision response would have pushed the cars apart and changed their velocities.
+  CHECK(overlapping.end_position == alone.end_position);
+  CHECK(overlapping.end_velocity == alone.end_velocity);
+}
+
+TEST_CASE("A recorded race in fixed-point mode replays to the recorded state hash")
+{
+  auto track = load_test_track({ { 300, 300 }, { 300, 400 }, { 300, 500 } });
+
+  // Three cars that handle differently.
+  std::vector<resources::CarDefinition> car_definitions(3);
+  for (std::size_t index = 0; index != car_definitions.size(); ++index)
+  {
+    auto& car_definition = car_definitions[index];
+    car_definition.image_rect = IntRect(0, 0, 40, 20);
+    car_definition.handling.gear_ratios = { 3.0, 2.2, 1.7, 1.35, 1.1 };
+    car_definition.handling.max_acceleration_force = 40000.0 + 10000.0 * index;
+    car_definition.handling.max_braking_force = 30000.0;
+    car_definition.handling.front_driven = index == 2;
+  }
+
+  auto run_race = [&]()
+  {
+    world::World world_obj(track, world::build_terrain_map(track));
+    world_obj.set_physics_mode(world::PhysicsMode::FixedPoint);
+
+    std::vector<world::Car*> cars;
+    for (std::uint16_t index = 0; index != 3; ++index)
+    {
+      cars.push_back(world_obj.create_car(car_definitions[index], static_cast<std::uint8_t>(index), index));
+      REQUIRE(cars.back() != nullptr);
+    }
+
+    // The recorded input: every car holds the throttle most of the time, and steers at random.
+    InputStream input;
+    world::EventInterface event_interface;
+    for (std::uint32_t tick = 0; tick != 300; ++tick)
+    {
+      for (auto car : cars)
+      {
+        auto steering = input.next(2);
+        car->set_control_state(controls::Control::Throttle, input.next(3) != 0);
+        car->set_control_state(controls::Control::Brake, input.next(5) == 5);
+        car->set_control_state(controls::Control::Left, steering < 0);
+        car->set_control_state(controls::Control::Right, steering > 0);
+      }
+
+      world_obj.update(20, event_interface);
+    }
+
+    for (std::uint16_t index = 0; index != 3; ++index)
+    {
+      const auto& start_point = track.start_points()[index];
+      CHECK(magnitude(cars[index]->position() - vector2_cast<double>(start_point.position)) > 50.0);
+    }
+
+    return world_obj.state_hash();
+  };
+
+  auto state_hash = run_race();
+  CHECK(run_race() == state_hash);
+
+  // Recorded on the reference build. The handling model is computed in floating point, so on other
+  // platforms, this may differ because of the standard library's trigonometric functions.
+  CHECK(state_hash == UINT64_C(0x1833395a20f5fc47));
+}
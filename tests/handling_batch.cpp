@@ -0,0 +1,102 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "catch.hpp"
+
+#include "world/car.hpp"
+#include "world/handling_batch.hpp"
+
+#include "resources/car_definition.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace ts;
+
+namespace
+{
+  std::vector<std::unique_ptr<world::Car>> make_cars(std::size_t count)
+  {
+    resources::CarDefinition car_definition;
+    car_definition.handling.gear_ratios = { 3.0, 2.2, 1.7, 1.35, 1.1 };
+    car_definition.handling.max_acceleration_force = 60000.0;
+    car_definition.handling.max_braking_force = 30000.0;
+
+    std::mt19937 random_engine(4321);
+    std::uniform_real_distribution<double> unit_dist(0.0, 1.0);
+
+    std::vector<std::unique_ptr<world::Car>> cars;
+    for (std::size_t index = 0; index != count; ++index)
+    {
+      if (index % 3 == 2) car_definition.handling.num_front_wheels = 1;
+
+      auto car = std::make_unique<world::Car>(car_definition, static_cast<std::uint16_t>(index));
+      car->set_position({ unit_dist(random_engine) * 1000.0, unit_dist(random_engine) * 1000.0 });
+      car->set_velocity({ unit_dist(random_engine) * 200.0 - 100.0, unit_dist(random_engine) * 200.0 - 100.0 });
+      car->set_rotation(degrees(unit_dist(random_engine) * 360.0));
+      car->set_angular_velocity(unit_dist(random_engine) * 2.0 - 1.0);
+      car->set_control_state(controls::Control::Throttle, index % 2 == 0);
+      car->set_control_state(controls::Control::Brake, index % 4 == 1);
+      car->set_control_state(controls::Control::Left, index % 3 == 0);
+      car->set_control_state(controls::Control::Right, index % 5 == 0);
+      cars.push_back(std::move(car));
+    }
+
+    return cars;
+  }
+
+  // All wheels are on the default terrain, so no world is needed.
+  void update_handling(world::HandlingBatch& batch, world::Car* const* cars, std::size_t count, bool scalar)
+  {
+    world::gather_car_states(batch, cars, count);
+    if (scalar) world::detail::compute_wheel_kinematics_scalar(batch, 0, batch.size());
+    else world::compute_wheel_kinematics(batch);
+
+    world::compute_handling_forces(batch, 0.01);
+    world::apply_handling_forces(batch, cars);
+  }
+
+  bool approximately_equal(double a, double b)
+  {
+    return std::abs(a - b) <= 1e-9 * std::max({ 1.0, std::abs(a), std::abs(b) });
+  }
+}
+
+TEST_CASE("Batched handling matches the per-car update")
+{
+  // Not a multiple of four, so that the scalar remainder is covered too.
+  const std::size_t car_count = 11;
+  auto per_car = make_cars(car_count);
+  auto batched = make_cars(car_count);
+
+  world::HandlingBatch batch;
+  for (auto& car : per_car)
+  {
+    world::Car* car_ptr = car.get();
+    update_handling(batch, &car_ptr, 1, true);
+  }
+
+  std::vector<world::Car*> car_pointers;
+  for (auto& car : batched) car_pointers.push_back(car.get());
+  update_handling(batch, car_pointers.data(), car_pointers.size(), false);
+
+  for (std::size_t index = 0; index != car_count; ++index)
+  {
+    const auto& a = *per_car[index];
+    const auto& b = *batched[index];
+
+    REQUIRE(approximately_equal(a.applied_force().x, b.applied_force().x));
+    REQUIRE(approximately_equal(a.applied_force().y, b.applied_force().y));
+    REQUIRE(approximately_equal(a.applied_torque(), b.applied_torque()));
+    REQUIRE(approximately_equal(a.angular_velocity(), b.angular_velocity()));
+  }
+
+  // Something must actually have happened.
+  REQUIRE(batched.front()->applied_force().x != 0.0);
+}
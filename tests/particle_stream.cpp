@@ -0,0 +1,77 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "catch.hpp"
+
+#include "scene/particle_stream.hpp"
+
+#include <stdexcept>
+
+namespace
+{
+  ts::scene::ParticleSpawnRecord make_record(std::uint32_t seed, std::uint32_t spawn_ticks)
+  {
+    ts::scene::ParticleSpawnRecord record = {};
+    record.seed = seed;
+    record.spawn_ticks = spawn_ticks;
+    return record;
+  }
+}
+
+TEST_CASE("Particle spawn rings expire the oldest records and overwrite them when full")
+{
+  using namespace ts;
+
+  scene::ParticleSpawnRing ring(4);
+  REQUIRE(ring.capacity() == 4);
+  REQUIRE(ring.size() == 0);
+
+  ring.push(make_record(0, 0));
+  ring.push(make_record(1, 10));
+  ring.push(make_record(2, 20));
+  REQUIRE(ring.size() == 3);
+  REQUIRE(ring.end_sequence() == 3);
+
+  ring.expire(25, 15);
+  REQUIRE(ring.begin_sequence() == 2);
+  REQUIRE(ring.record(ring.begin_sequence()).seed == 2);
+
+  ring.push(make_record(3, 30));
+  ring.push(make_record(4, 40));
+  ring.push(make_record(5, 50));
+  ring.push(make_record(6, 60));
+  REQUIRE(ring.full());
+  REQUIRE(ring.begin_sequence() == 3);
+  REQUIRE(ring.end_sequence() == 7);
+
+  // Sequence numbers keep counting up, the storage wraps around.
+  REQUIRE(ring.record(6).seed == 6);
+  REQUIRE(ring.seeds()[2] == 6);
+
+  ring.expire(1000, 15);
+  REQUIRE(ring.size() == 0);
+  REQUIRE(ring.begin_sequence() == ring.end_sequence());
+}
+
+TEST_CASE("Ring ranges are split where they wrap around the end of the storage")
+{
+  using namespace ts;
+
+  auto ranges = scene::split_ring_range(2, 5, 8);
+  REQUIRE(ranges.size() == 1);
+  REQUIRE(ranges[0].offset == 2);
+  REQUIRE(ranges[0].count == 3);
+
+  ranges = scene::split_ring_range(14, 20, 8);
+  REQUIRE(ranges.size() == 2);
+  REQUIRE(ranges[0].offset == 6);
+  REQUIRE(ranges[0].count == 2);
+  REQUIRE(ranges[1].offset == 0);
+  REQUIRE(ranges[1].count == 4);
+
+  REQUIRE(scene::split_ring_range(5, 5, 8).empty());
+  REQUIRE_THROWS_AS(scene::split_ring_range(0, 9, 8), const std::out_of_range&);
+}
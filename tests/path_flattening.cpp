@@ -0,0 +1,153 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "catch.hpp"
+
+#include "scene/path_flattening.hpp"
+
+#include <cmath>
+#include <vector>
+
+using namespace ts;
+
+namespace
+{
+  resources::TrackPathNode make_node(Vector2f position, Vector2f tangent, float width)
+  {
+    resources::TrackPathNode node;
+    node.position = position;
+    node.first_control = position - tangent;
+    node.second_control = position + tangent;
+    node.width = width;
+    return node;
+  }
+
+  resources::SubPath make_sub_path(bool closed)
+  {
+    resources::SubPath sub_path;
+    sub_path.closed = closed;
+    sub_path.nodes.push_back(make_node({ 100.0f, 100.0f }, { 80.0f, 0.0f }, 20.0f));
+    sub_path.nodes.push_back(make_node({ 400.0f, 150.0f }, { 0.0f, 120.0f }, 30.0f));
+    sub_path.nodes.push_back(make_node({ 250.0f, 400.0f }, { -100.0f, 40.0f }, 10.0f));
+    sub_path.nodes.push_back(make_node({ 50.0f, 300.0f }, { 0.0f, 0.0f }, 20.0f));
+    return sub_path;
+  }
+
+  Vector2f exact_outline_point(const resources::TrackPathNode& a, const resources::TrackPathNode& b,
+                               float time_point, const scene::OutlineProperties& properties)
+  {
+    auto width = resources::path_width_at(a, b, time_point) + properties.width;
+    auto normal = resources::path_normal_at(a, b, time_point);
+    if (properties.invert_normal) normal = -normal;
+
+    return resources::path_point_at(a, b, time_point) + normal * width * 0.5f;
+  }
+}
+
+TEST_CASE("Flattened curves lie on the path outline")
+{
+  auto sub_path = make_sub_path(false);
+  const auto& a = sub_path.nodes[0];
+  const auto& b = sub_path.nodes[1];
+
+  scene::OutlineProperties properties;
+  properties.width = 4.0f;
+  properties.invert_normal = true;
+
+  // Less than one group of eight, and several groups plus a remainder.
+  for (std::uint32_t segment_count : { 5u, 37u })
+  {
+    std::vector<scene::OutlinePoint> points(segment_count);
+    scene::flatten_curve(a, b, 0.25f, 1.0f, 2.0f, segment_count, properties, points.data());
+
+    for (std::uint32_t index = 0; index != segment_count; ++index)
+    {
+      auto t = 0.25f + 0.75f * index / segment_count;
+      auto expected = exact_outline_point(a, b, t, properties);
+
+      CHECK(points[index].time_point == Approx(2.0f + t));
+      CHECK(points[index].point.x == Approx(expected.x).epsilon(0.0001));
+      CHECK(points[index].point.y == Approx(expected.y).epsilon(0.0001));
+      CHECK(points[index].width == Approx(resources::path_width_at(a, b, t) + 4.0f));
+    }
+  }
+}
+
+TEST_CASE("The estimated segment count keeps the center line within the tolerance")
+{
+  auto sub_path = make_sub_path(true);
+
+  scene::OutlineProperties properties;
+  properties.center_line = true;
+  properties.tolerance = 0.5f;
+
+  for (std::size_t node = 0; node != sub_path.nodes.size(); ++node)
+  {
+    const auto& a = sub_path.nodes[node];
+    const auto& b = sub_path.nodes[(node + 1) % sub_path.nodes.size()];
+
+    auto segment_count = scene::flattened_segment_count(a, b, properties);
+    REQUIRE(segment_count >= 1);
+
+    for (std::uint32_t index = 0; index != segment_count; ++index)
+    {
+      auto t1 = static_cast<float>(index) / segment_count;
+      auto t2 = static_cast<float>(index + 1) / segment_count;
+      auto start = resources::path_point_at(a, b, t1);
+      auto end = resources::path_point_at(a, b, t2);
+
+      for (float s : { 0.25f, 0.5f, 0.75f })
+      {
+        auto p = resources::path_point_at(a, b, t1 + (t2 - t1) * s);
+        auto chord = end - start;
+        auto distance = std::abs(cross_product(chord, p - start)) / magnitude(chord);
+        CHECK(distance <= properties.tolerance * 1.01f);
+      }
+    }
+  }
+}
+
+TEST_CASE("Path flattener gives every request its own range of points")
+{
+  auto open_path = make_sub_path(false);
+  auto closed_path = make_sub_path(true);
+
+  scene::OutlineProperties properties;
+  properties.width = 8.0f;
+
+  std::vector<scene::FlattenRequest> requests =
+  {
+    { &open_path, properties }, { &closed_path, properties }, { &closed_path, invert(properties) }
+  };
+
+  scene::PathFlattener flattener;
+  flattener.flatten(requests.data(), requests.size(), 1);
+  auto single_threaded = flattener.outline_points();
+
+  flattener.flatten(requests.data(), requests.size(), 3);
+  const auto& points = flattener.outline_points();
+
+  CHECK(flattener.curve_count() == 3 + 4 + 4);
+  REQUIRE(points.size() == single_threaded.size());
+  REQUIRE(flattener.point_offset(0) == 0);
+  CHECK(flattener.point_offset(1) == flattener.point_count(0));
+  CHECK(flattener.point_offset(2) + flattener.point_count(2) == points.size());
+
+  for (std::size_t index = 0; index != points.size(); ++index)
+  {
+    CHECK(points[index].point == single_threaded[index].point);
+  }
+
+  // The open path ends at its last node, the closed path returns to its first one.
+  auto open_end = points[flattener.point_count(0) - 1];
+  CHECK(open_end.time_point == Approx(3.0f));
+
+  auto closed_begin = points[flattener.point_offset(1)];
+  auto closed_end = points[flattener.point_offset(1) + flattener.point_count(1) - 1];
+  CHECK(closed_end.time_point == Approx(4.0f));
+  CHECK(closed_end.point.x == Approx(closed_begin.point.x));
+  CHECK(closed_end.point.y == Approx(closed_begin.point.y));
+}
@@ -0,0 +1,100 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "catch.hpp"
+
+#include "scene/path_geometry.hpp"
+
+#include <cmath>
+#include <vector>
+
+using namespace ts;
+
+namespace
+{
+  resources::TrackPath make_loop_path(std::size_t node_count)
+  {
+    resources::SubPath sub_path;
+    sub_path.closed = true;
+
+    for (std::size_t index = 0; index != node_count; ++index)
+    {
+      auto angle = static_cast<float>(index) * 6.2831853f / node_count;
+      auto direction = make_vector2(std::cos(angle), std::sin(angle));
+      auto tangent = make_vector2(-direction.y, direction.x) * 20.0f;
+
+      resources::TrackPathNode node;
+      node.position = direction * (300.0f + (index % 2 == 0 ? 15.0f : -15.0f)) + make_vector2(500.0f, 500.0f);
+      node.first_control = node.position - tangent;
+      node.second_control = node.position + tangent;
+      node.width = 12.0f + static_cast<float>(index % 3);
+      sub_path.nodes.push_back(node);
+    }
+
+    resources::TrackPath path;
+    path.sub_paths.push_back(sub_path);
+    return path;
+  }
+
+  bool equal_vertices(const std::vector<scene::PathVertex>& a, const std::vector<scene::PathVertex>& b)
+  {
+    if (a.size() != b.size()) return false;
+
+    for (std::size_t index = 0; index != a.size(); ++index)
+    {
+      if (a[index].position != b[index].position || a[index].z != b[index].z ||
+          a[index].texture_coords != b[index].texture_coords) return false;
+    }
+
+    return true;
+  }
+
+  bool equal_faces(const std::vector<scene::PathFace>& a, const std::vector<scene::PathFace>& b)
+  {
+    if (a.size() != b.size()) return false;
+
+    for (std::size_t index = 0; index != a.size(); ++index)
+    {
+      if (a[index].indices != b[index].indices) return false;
+    }
+
+    return true;
+  }
+}
+
+TEST_CASE("Cached path geometry is identical to freshly built geometry")
+{
+  auto path = make_loop_path(40);
+
+  resources::PathStyle path_style;
+  path_style.width = 6.0f;
+
+  float max_width = 0.0f;
+  std::vector<scene::PathVertex> cached_vertices, vertices;
+  std::vector<scene::PathFace> cached_faces, faces;
+
+  scene::OutlineCache outline_cache;
+  scene::create_path_geometry(path, path_style, 0.1f, max_width, cached_vertices, cached_faces, &outline_cache);
+  CHECK(outline_cache.hit_count() == 0);
+  CHECK(outline_cache.size() > 0);
+
+  auto& node = path.sub_paths.front().nodes[17];
+  node.position += make_vector2(4.0f, -3.0f);
+  node.second_control += make_vector2(10.0f, 0.0f);
+
+  cached_vertices.clear();
+  cached_faces.clear();
+  scene::create_path_geometry(path, path_style, 0.1f, max_width, cached_vertices, cached_faces, &outline_cache);
+  scene::create_path_geometry(path, path_style, 0.1f, max_width, vertices, faces);
+
+  // Only the curves on either side of the moved node are tessellated again, once for the
+  // path itself and once for its border.
+  CHECK(outline_cache.miss_count() <= 6);
+  CHECK(outline_cache.hit_count() > 0);
+
+  CHECK(equal_vertices(cached_vertices, vertices));
+  CHECK(equal_faces(cached_faces, faces));
+}
@@ -0,0 +1,97 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "catch.hpp"
+
+#include "utility/profiler.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+using namespace ts;
+
+namespace
+{
+  const profiler::ThreadHistory* find_thread(const profiler::Collector& collector, const char* name)
+  {
+    const auto& threads = collector.threads();
+    auto it = std::find_if(threads.begin(), threads.end(),
+                           [=](const profiler::ThreadHistory& thread) { return thread.name == name; });
+
+    return it != threads.end() ? &*it : nullptr;
+  }
+}
+
+TEST_CASE("Profiler zones are collected per thread, with their nesting")
+{
+  profiler::Collector collector;
+  collector.collect();
+  collector.clear();
+
+  std::thread thread([]()
+  {
+    profiler::set_thread_name("profiler test");
+
+    profiler::Zone outer("outer");
+    {
+      profiler::Zone inner("inner");
+    }
+  });
+
+  thread.join();
+  collector.collect();
+
+  auto history = find_thread(collector, "profiler test");
+  REQUIRE(history != nullptr);
+  REQUIRE(history->zones.size() == 2);
+
+  // Nested zones end first.
+  const auto& inner = history->zones[0];
+  const auto& outer = history->zones[1];
+  CHECK(std::strcmp(inner.name, "inner") == 0);
+  CHECK(inner.depth == 1);
+  CHECK(std::strcmp(outer.name, "outer") == 0);
+  CHECK(outer.depth == 0);
+
+  CHECK(outer.start <= inner.start);
+  CHECK(inner.end <= outer.end);
+  CHECK(collector.dropped_count() == 0);
+
+  std::ostringstream stream;
+  profiler::write_chrome_trace(stream, collector);
+
+  auto trace = stream.str();
+  CHECK(trace.find("\"traceEvents\"") != std::string::npos);
+  CHECK(trace.find("\"name\":\"profiler test\"") != std::string::npos);
+  CHECK(trace.find("\"name\":\"inner\",\"ph\":\"X\"") != std::string::npos);
+}
+
+TEST_CASE("Profiler keeps the latest zones when its buffer overflows")
+{
+  profiler::Collector collector;
+  collector.collect();
+  collector.clear();
+
+  const std::size_t zone_count = profiler::detail::ThreadBuffer::capacity + 100;
+  std::thread thread([=]()
+  {
+    profiler::set_thread_name("profiler overflow test");
+    for (std::size_t i = 0; i != zone_count; ++i)
+    {
+      profiler::Zone zone("zone");
+    }
+  });
+
+  thread.join();
+  collector.collect();
+
+  auto history = find_thread(collector, "profiler overflow test");
+  REQUIRE(history != nullptr);
+  CHECK(history->zones.size() + collector.dropped_count() == zone_count);
+  CHECK(history->zones.size() >= profiler::detail::ThreadBuffer::capacity - 1);
+}
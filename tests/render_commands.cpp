@@ -0,0 +1,123 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "catch.hpp"
+
+#include "scene/render_commands.hpp"
+#include "graphics/state_cache.hpp"
+
+#include <vector>
+
+TEST_CASE("Draw commands are sorted by their keys, keeping the recorded order for equal keys")
+{
+  using namespace ts;
+
+  auto make_key = [](std::uint32_t level, std::uint32_t sequence, std::uint32_t texture)
+  {
+    scene::DrawKey key;
+    key.level = level;
+    key.sequence = sequence;
+    key.texture = texture;
+    return scene::make_sort_key(key);
+  };
+
+  scene::DrawCommandList command_list;
+  command_list.push(make_key(1, 0, 5), 0);
+  command_list.push(make_key(0, 1, 3), 1);
+  command_list.push(make_key(0, 0, 7), 2);
+  command_list.push(make_key(0, 0, 3), 3);
+  command_list.push(make_key(0, 0, 7), 4);
+  command_list.sort();
+
+  std::vector<std::uint32_t> order;
+  for (const auto& command : command_list) order.push_back(command.index);
+
+  REQUIRE(order == std::vector<std::uint32_t>({ 3, 2, 4, 1, 0 }));
+  REQUIRE(scene::sort_key_level(command_list.begin()->sort_key) == 0);
+  REQUIRE(scene::sort_key_level(std::prev(command_list.end())->sort_key) == 1);
+
+  scene::DrawKey huge_key;
+  huge_key.level = 1000;
+  REQUIRE(scene::sort_key_level(scene::make_sort_key(huge_key)) == 255);
+}
+
+TEST_CASE("Program and texture never reorder components with different sequence numbers")
+{
+  using namespace ts;
+
+  // Far more components in one region than a single byte can count, with alternating programs
+  // and textures. They overlap, so they have to be drawn in the order they were created.
+  const std::uint32_t component_count = 1000;
+
+  scene::DrawCommandList command_list;
+  for (std::uint32_t index = 0; index != component_count; ++index)
+  {
+    scene::DrawKey key;
+    key.level = 1;
+    key.z_index = 2;
+    key.layer = 3;
+    key.sequence = index;
+    key.program = (index / 3) % 2;
+    key.texture = component_count - index;
+    command_list.push(scene::make_sort_key(key), index);
+  }
+
+  command_list.sort();
+
+  std::vector<std::uint32_t> order;
+  for (const auto& command : command_list) order.push_back(command.index);
+
+  REQUIRE(order.size() == component_count);
+  for (std::uint32_t index = 0; index != component_count; ++index)
+  {
+    REQUIRE(order[index] == index);
+  }
+}
+
+TEST_CASE("The state cache filters out redundant state changes")
+{
+  using namespace ts;
+
+  graphics::StateCache state_cache(false);
+  CHECK(state_cache.use_program(1));
+  CHECK_FALSE(state_cache.use_program(1));
+  CHECK(state_cache.use_program(2));
+
+  CHECK(state_cache.bind_texture(0, 10));
+  CHECK(state_cache.bind_texture(1, 10));
+  CHECK_FALSE(state_cache.bind_texture(0, 10));
+
+  CHECK(state_cache.bind_vertex_array(3));
+  CHECK_FALSE(state_cache.bind_vertex_array(3));
+
+  CHECK(state_cache.enable_depth_test(true));
+  CHECK_FALSE(state_cache.enable_depth_test(true));
+  CHECK(state_cache.enable_depth_write(false));
+
+  state_cache.draw_elements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+
+  const auto& counters = state_cache.counters();
+  CHECK(counters.program_binds == 2);
+  CHECK(counters.texture_binds == 2);
+  CHECK(counters.vertex_array_binds == 1);
+  CHECK(counters.capability_changes == 2);
+  CHECK(counters.redundant_changes == 4);
+  CHECK(counters.draw_calls == 1);
+
+  SECTION("Invalidating the cache forces the next change through")
+  {
+    state_cache.invalidate();
+    CHECK(state_cache.use_program(2));
+    CHECK(state_cache.bind_texture(0, 10));
+  }
+
+  SECTION("Resetting the counters leaves the state alone")
+  {
+    state_cache.reset_counters();
+    CHECK_FALSE(state_cache.use_program(2));
+    CHECK(state_cache.counters().program_binds == 0);
+  }
+}
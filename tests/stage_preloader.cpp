@@ -0,0 +1,86 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "catch.hpp"
+
+#include "game/stage_preloader.hpp"
+#include "game/loading_thread.hpp"
+
+#include "resources/track_reference.hpp"
+
+using namespace ts;
+
+TEST_CASE("The stage preloader hands over one preloaded track at a time")
+{
+  game::LoadingThread loading_thread(2);
+
+  // Generating the track scene needs a GL context, the track and terrain map are enough here.
+  game::StagePreloader preloader(&loading_thread, false);
+
+  resources::TrackReference test_track;
+  test_track.path = "assets/tracks/test.trk";
+  test_track.name = "test";
+
+  resources::TrackReference other_track;
+  other_track.path = "assets/tracks/banaring.trk";
+  other_track.name = "banaring";
+
+  CHECK(preloader.take(test_track) == nullptr);
+
+  SECTION("Taking the preloaded track")
+  {
+    preloader.preload(test_track);
+    CHECK(preloader.is_preloading(test_track));
+    CHECK_FALSE(preloader.is_preloading(other_track));
+
+    // A different track is not handed over, and does not disturb the preloaded one.
+    CHECK(preloader.take(other_track) == nullptr);
+    CHECK(preloader.is_preloading(test_track));
+
+    auto preloaded = preloader.take(test_track);
+    REQUIRE(preloaded != nullptr);
+    CHECK(preloaded->track.size() == Vector2i(1799, 1153));
+    CHECK_FALSE(preloaded->track_scene);
+
+    // It can only be taken once.
+    CHECK_FALSE(preloader.is_preloading(test_track));
+    CHECK(preloader.take(test_track) == nullptr);
+  }
+
+  SECTION("Discarding the preloaded track")
+  {
+    preloader.preload(test_track);
+    preloader.discard();
+
+    CHECK_FALSE(preloader.is_preloading(test_track));
+    CHECK_FALSE(preloader.is_ready());
+    CHECK(preloader.take(test_track) == nullptr);
+  }
+
+  SECTION("Preloading another track cancels the previous one")
+  {
+    preloader.preload(test_track);
+    preloader.preload(other_track);
+
+    CHECK_FALSE(preloader.is_preloading(test_track));
+    CHECK(preloader.is_preloading(other_track));
+    CHECK(preloader.take(test_track) == nullptr);
+
+    auto preloaded = preloader.take(other_track);
+    REQUIRE(preloaded != nullptr);
+    CHECK(preloaded->track.path() == other_track.path);
+  }
+
+  SECTION("A track that fails to load is not handed over")
+  {
+    resources::TrackReference missing_track;
+    missing_track.path = "assets/tracks/doesnotexist.trk";
+
+    preloader.preload(missing_track);
+    CHECK(preloader.is_preloading(missing_track));
+    CHECK(preloader.take(missing_track) == nullptr);
+  }
+}
@@ -0,0 +1,58 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "catch.hpp"
+
+#include "utility/stats.hpp"
+
+#include <sstream>
+#include <thread>
+
+using namespace ts;
+
+TEST_CASE("Stats counters are merged across threads, once per frame")
+{
+  stats::Counter counter("test.counter");
+  stats::Gauge gauge("test.gauge");
+  stats::merge_frame();
+
+  counter.add(3);
+  std::thread thread([]()
+  {
+    stats::Counter same_counter("test.counter");
+    for (int i = 0; i != 1000; ++i) same_counter.add();
+  });
+
+  thread.join();
+  gauge.set(42);
+
+  stats::merge_frame();
+  auto snapshot = stats::latest_snapshot();
+
+  auto counter_entry = snapshot.find("test.counter");
+  REQUIRE(counter_entry != nullptr);
+  CHECK(counter_entry->kind == stats::StatKind::Counter);
+  CHECK(counter_entry->value == 1003);
+
+  auto gauge_entry = snapshot.find("test.gauge");
+  REQUIRE(gauge_entry != nullptr);
+  CHECK(gauge_entry->value == 42);
+
+  // Nothing happened in between, so the next frame's value is zero, but the total remains.
+  stats::merge_frame();
+  snapshot = stats::latest_snapshot();
+  counter_entry = snapshot.find("test.counter");
+  REQUIRE(counter_entry != nullptr);
+  CHECK(counter_entry->value == 0);
+  CHECK(counter_entry->total >= 1003);
+  CHECK(snapshot.find("test.gauge")->value == 42);
+
+  std::ostringstream stream;
+  stats::write_snapshot(stream, snapshot);
+  CHECK(stream.str().find("\"test.counter\":{\"value\":0,") != std::string::npos);
+
+  CHECK_THROWS_AS(stats::Gauge("test.counter"), const std::logic_error&);
+}
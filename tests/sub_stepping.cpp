@@ -0,0 +1,80 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "catch.hpp"
+
+#include "world/sub_stepping.hpp"
+#include "world/control_point_manager.hpp"
+
+#include <vector>
+
+using namespace ts;
+
+TEST_CASE("Sub-step count follows the fastest car")
+{
+  world::SubStepConfig config;
+  config.max_sub_steps = 8;
+  config.car_update_budget = 64;
+
+  // 4 units per sub-step at most.
+  CHECK(world::compute_sub_step_count(config, 0.0, 0.02, 8.0, 4).count == 1);
+  CHECK(world::compute_sub_step_count(config, 200.0, 0.02, 8.0, 4).count == 1);
+  CHECK(world::compute_sub_step_count(config, 201.0, 0.02, 8.0, 4).count == 2);
+  CHECK(world::compute_sub_step_count(config, 1000.0, 0.02, 8.0, 4).count == 5);
+
+  auto capped = world::compute_sub_step_count(config, 10000.0, 0.02, 8.0, 4);
+  CHECK(capped.count == 8);
+  CHECK_FALSE(capped.budget_limited);
+}
+
+TEST_CASE("Sub-step count stays within the car update budget")
+{
+  world::SubStepConfig config;
+  config.max_sub_steps = 8;
+  config.car_update_budget = 40;
+
+  auto limited = world::compute_sub_step_count(config, 1000.0, 0.02, 8.0, 20);
+  CHECK(limited.count == 2);
+  CHECK(limited.budget_limited);
+
+  // A single sub-step is always made, even if the budget doesn't allow it.
+  CHECK(world::compute_sub_step_count(config, 1000.0, 0.02, 8.0, 100).count == 1);
+}
+
+TEST_CASE("Thinnest feature takes area control points into account")
+{
+  std::vector<world::ControlPoint> points(2);
+  points[0].type = resources::ControlPoint::HorizontalLine;
+  points[0].start = { 0, 10 };
+  points[0].end = { 100, 10 };
+
+  points[1].type = resources::ControlPoint::Area;
+  points[1].start = { 50, 50 };
+  points[1].end = { 80, 55 };
+
+  CHECK(world::thinnest_feature(points.data(), 1, 8.0) == 8.0);
+  CHECK(world::thinnest_feature(points.data(), 2, 8.0) == 5.0);
+  CHECK(world::thinnest_feature(points.data(), 2, 4.0) == 4.0);
+}
+
+TEST_CASE("Sub-step stats summarize the distribution")
+{
+  world::SubStepStats stats;
+  stats.tick_counts = { 0, 6, 2, 0, 2 };
+
+  CHECK(stats.total_ticks() == 10);
+  CHECK(stats.average_sub_steps() == Approx(1.8));
+}
+
+TEST_CASE("Sub-stepping is off by default")
+{
+  world::SubStepConfig config;
+  CHECK(config.max_sub_steps == 1);
+
+  auto sub_steps = world::compute_sub_step_count(config, 10000.0, 0.02, 8.0, 4);
+  CHECK(sub_steps.count == 1);
+  CHECK_FALSE(sub_steps.budget_limited);
+}
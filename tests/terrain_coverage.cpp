@@ -0,0 +1,135 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "catch.hpp"
+
+#include "world/terrain_coverage.hpp"
+#include "world/terrain_map.hpp"
+
+#include "resources/terrain_library.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace ts;
+
+namespace
+{
+  std::vector<std::array<Vector2i, 3>> make_triangles(std::size_t count, Vector2i track_size)
+  {
+    std::mt19937 random_engine(1337);
+    std::uniform_int_distribution<std::int32_t> x_dist(-20, track_size.x + 20), y_dist(-20, track_size.y + 20);
+    std::uniform_int_distribution<std::int32_t> offset_dist(-40, 40);
+
+    std::vector<std::array<Vector2i, 3>> triangles;
+    for (std::size_t index = 0; index != count; ++index)
+    {
+      auto a = make_vector2(x_dist(random_engine), y_dist(random_engine));
+      auto b = a + make_vector2(offset_dist(random_engine), offset_dist(random_engine));
+      auto c = a + make_vector2(offset_dist(random_engine), offset_dist(random_engine));
+      triangles.push_back({ { a, b, c } });
+    }
+
+    // A degenerate one, and one that spans several tiles.
+    triangles.push_back({ { { 10, 10 }, { 30, 10 }, { 50, 10 } } });
+    triangles.push_back({ { { 5, 5 }, { 250, 20 }, { 100, 180 } } });
+    return triangles;
+  }
+}
+
+TEST_CASE("Path coverage covers the same pixels as the path's faces")
+{
+  const auto track_size = make_vector2(300, 200);
+  auto triangles = make_triangles(60, track_size);
+
+  resources::TerrainLibrary terrain_library;
+  for (resources::TerrainId id : { 1, 2, 3 })
+  {
+    resources::TerrainDefinition terrain;
+    terrain.id = id;
+    terrain_library.define_terrain(terrain);
+  }
+
+  // The first half of the triangles is one path layer, the second half another one on top of it.
+  auto terrain_id = [&](std::size_t index) -> resources::TerrainId
+  {
+    return index < triangles.size() / 2 ? 2 : 3;
+  };
+
+  // The inside test of the terrain map's faces, for every triangle whose bounding box contains the position.
+  auto expected_terrain_at = [&](Vector2i position) -> resources::TerrainId
+  {
+    for (auto index = triangles.size(); index-- != 0; )
+    {
+      auto v = triangles[index];
+      auto x_limits = std::minmax({ v[0].x, v[1].x, v[2].x });
+      auto y_limits = std::minmax({ v[0].y, v[1].y, v[2].y });
+      if (position.x < x_limits.first || position.x > x_limits.second ||
+          position.y < y_limits.first || position.y > y_limits.second) continue;
+
+      if (cross_product(v[1] - v[0], v[2] - v[0]) > 0) std::swap(v[0], v[2]);
+
+      auto sign = [=](Vector2i a, Vector2i b)
+      {
+        return cross_product(b - a, position - a) <= 0;
+      };
+
+      if (sign(v[0], v[1]) && sign(v[1], v[2]) && sign(v[2], v[0])) return terrain_id(index);
+    }
+
+    return 1;
+  };
+
+  std::vector<world::TerrainMapComponent> components;
+  world::CoverageMaskStore coverage_store;
+  world::CoverageRasterizer rasterizer(coverage_store, IntRect(Vector2i(), track_size));
+  for (auto half : { 0, 1 })
+  {
+    rasterizer.clear();
+
+    auto begin = half == 0 ? 0 : triangles.size() / 2;
+    auto end = half == 0 ? triangles.size() / 2 : triangles.size();
+    for (auto index = begin; index != end; ++index)
+    {
+      const auto& triangle = triangles[index];
+      rasterizer.add_triangle(triangle[0], triangle[1], triangle[2]);
+    }
+
+    for (const auto& tile : rasterizer.tiles())
+    {
+      world::map_components::Coverage coverage;
+      coverage.terrain_id = terrain_id(begin);
+      coverage.position = tile.position;
+      coverage.mask = tile.mask;
+
+      world::TerrainMapComponent component;
+      component.data = coverage;
+      component.level = 0;
+      components.push_back(component);
+    }
+  }
+
+  // Every tile of the track, at most.
+  CHECK(components.size() <= 2 * 5 * 4);
+
+  world::TerrainMap terrain_map(components, resources::PatternStore(), std::move(coverage_store), track_size, 1);
+
+  std::size_t mismatches = 0, path_pixels = 0;
+  for (std::int32_t y = 0; y != track_size.y; ++y)
+  {
+    for (std::int32_t x = 0; x != track_size.x; ++x)
+    {
+      auto expected = expected_terrain_at({ x, y });
+      auto actual = terrain_map.terrain_at({ x, y }, 0, terrain_library).id;
+      if (expected != actual) ++mismatches;
+      if (expected != 1) ++path_pixels;
+    }
+  }
+
+  CHECK(path_pixels > 0);
+  CHECK(mismatches == 0);
+}
@@ -0,0 +1,88 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "catch.hpp"
+
+#include "world/terrain_map.hpp"
+
+#include "resources/terrain_library.hpp"
+
+#include <vector>
+
+using namespace ts;
+
+TEST_CASE("Faces are found on the cell boundaries that they touch")
+{
+  // Small enough for the terrain map to use 8x8 cells.
+  const auto track_size = make_vector2(256, 256);
+
+  resources::TerrainLibrary terrain_library;
+  for (resources::TerrainId id : { 1, 2 })
+  {
+    resources::TerrainDefinition terrain;
+    terrain.id = id;
+    terrain_library.define_terrain(terrain);
+  }
+
+  // All vertices lie on cell boundaries, and the last two faces touch the right and bottom edges of the track.
+  const std::vector<std::array<Vector2i, 3>> triangles =
+  {
+    { { { 0, 0 }, { 16, 16 }, { 16, 0 } } },
+    { { { 32, 40 }, { 32, 64 }, { 64, 40 } } },
+    { { { 96, 96 }, { 96, 128 }, { 104, 96 } } },
+    { { { 200, 0 }, { 256, 56 }, { 256, 0 } } },
+    { { { 0, 200 }, { 0, 256 }, { 56, 256 } } }
+  };
+
+  std::vector<world::TerrainMapComponent> components;
+  for (const auto& triangle : triangles)
+  {
+    world::map_components::Face face;
+    face.terrain_id = 2;
+    face.alpha = 255;
+    face.vertices = triangle;
+
+    world::TerrainMapComponent component;
+    component.data = face;
+    component.level = 0;
+    components.push_back(component);
+  }
+
+  world::TerrainMap terrain_map(components, resources::PatternStore(), world::CoverageMaskStore(), track_size, 1);
+
+  auto expected_terrain_at = [&](Vector2i position) -> resources::TerrainId
+  {
+    for (const auto& v : triangles)
+    {
+      auto sign = [=](Vector2i a, Vector2i b)
+      {
+        return cross_product(b - a, position - a) <= 0;
+      };
+
+      if (sign(v[0], v[1]) && sign(v[1], v[2]) && sign(v[2], v[0])) return 2;
+    }
+
+    return 1;
+  };
+
+  std::size_t mismatches = 0;
+  for (std::int32_t y = 0; y != track_size.y; ++y)
+  {
+    for (std::int32_t x = 0; x != track_size.x; ++x)
+    {
+      if (terrain_map.terrain_at({ x, y }, 0, terrain_library).id != expected_terrain_at({ x, y })) ++mismatches;
+    }
+  }
+
+  CHECK(mismatches == 0);
+
+  // The right edge of the first face, and the corners that lie exactly on a cell's top left pixel.
+  CHECK(terrain_map.terrain_at({ 16, 8 }, 0, terrain_library).id == 2);
+  CHECK(terrain_map.terrain_at({ 16, 16 }, 0, terrain_library).id == 2);
+  CHECK(terrain_map.terrain_at({ 64, 40 }, 0, terrain_library).id == 2);
+  CHECK(terrain_map.terrain_at({ 96, 128 }, 0, terrain_library).id == 2);
+  CHECK(terrain_map.terrain_at({ 17, 8 }, 0, terrain_library).id == 1);
+}
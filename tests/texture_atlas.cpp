@@ -9,18 +9,22 @@
 #include "utility/texture_atlas.hpp"
 
 #include <vector>
+#include <tuple>
+#include <algorithm>
 #include <iostream>
 
 using namespace ts;
 using utility::TextureAtlas;
+using utility::AtlasList;
+using utility::AtlasPackingStrategy;
 
-TEST_CASE("Let's see if the texture atlas works and packs in an efficient manner.")
+static void test_atlas_packing(AtlasPackingStrategy strategy)
 {
-  TextureAtlas atlas;  
+  TextureAtlas atlas({}, strategy);
 
   REQUIRE_FALSE(atlas.insert({ 100, 100 }));
 
-  atlas = TextureAtlas({ 512, 512 });
+  atlas = TextureAtlas({ 512, 512 }, strategy);
   atlas.set_padding(0);
 
   REQUIRE(atlas.insert({ 512, 256 }));
@@ -48,3 +52,136 @@ TEST_CASE("Let's see if the texture atlas works and packs in an efficient manner
     }
   }
 }
+
+TEST_CASE("Let's see if the texture atlas works and packs in an efficient manner.")
+{
+  SECTION("MaxRects")
+  {
+    test_atlas_packing(AtlasPackingStrategy::MaxRects);
+  }
+
+  SECTION("Skyline")
+  {
+    test_atlas_packing(AtlasPackingStrategy::Skyline);
+  }
+}
+
+namespace
+{
+  struct PackingResult
+  {
+    std::size_t atlas_count = 0;
+    double occupancy = 0.0;
+  };
+
+  // Packs the rects into a list of atlases, and verifies that every rect ended up
+  // within the bounds of its atlas without intersecting any other rect.
+  PackingResult pack_rects(const std::vector<IntRect>& rects, AtlasPackingStrategy strategy, bool first_fit)
+  {
+    AtlasList atlas_list({ 512, 512 }, strategy);
+    atlas_list.set_first_fit(first_fit);
+
+    std::vector<utility::AtlasEntry> entries;
+    for (auto rect : rects)
+    {
+      utility::allocate_atlas_rect(atlas_list, rect, { 512, 512 }, [&](const utility::AtlasEntry& entry)
+      {
+        entries.push_back(entry);
+      });
+    }
+
+    REQUIRE(entries.size() == rects.size());
+    for (auto outer = entries.begin(); outer != entries.end(); ++outer)
+    {
+      REQUIRE(contains(IntRect(0, 0, 512, 512), outer->atlas_rect));
+      REQUIRE(outer->atlas_rect.width == outer->source_rect.width);
+      REQUIRE(outer->atlas_rect.height == outer->source_rect.height);
+
+      for (auto inner = std::next(outer); inner != entries.end(); ++inner)
+      {
+        if (inner->atlas_id == outer->atlas_id)
+        {
+          REQUIRE_FALSE(intersects(inner->atlas_rect, outer->atlas_rect));
+        }
+      }
+    }
+
+    PackingResult result;
+    result.atlas_count = atlas_list.atlas_count();
+    for (std::size_t id = 0; id != result.atlas_count; ++id)
+    {
+      result.occupancy += atlas_list.occupancy(id) / result.atlas_count;
+    }
+
+    return result;
+  }
+}
+
+TEST_CASE("Sorting the rects by area and packing them first-fit should not need more atlases than packing them in order.")
+{
+  // A deterministic mix of big and small tiles, in no particular order.
+  std::vector<IntRect> rects;
+  std::uint32_t seed = 12345;
+  for (int i = 0; i != 200; ++i)
+  {
+    seed = seed * 1664525 + 1013904223;
+    auto size = (seed >> 8) % 4 == 0 ? 96 + (seed >> 12) % 160 : 16 + (seed >> 12) % 48;
+
+    seed = seed * 1664525 + 1013904223;
+    rects.push_back({ 0, 0, std::int32_t(size), std::int32_t(16 + (seed >> 12) % 112) });
+  }
+
+  auto sorted_rects = rects;
+  std::sort(sorted_rects.begin(), sorted_rects.end(), [](const IntRect& a, const IntRect& b)
+  {
+    return std::make_tuple(a.width * a.height, a.height) > std::make_tuple(b.width * b.height, b.height);
+  });
+
+  for (auto strategy : { AtlasPackingStrategy::MaxRects, AtlasPackingStrategy::Skyline })
+  {
+    auto in_order = pack_rects(rects, strategy, false);
+    auto presorted = pack_rects(sorted_rects, strategy, true);
+
+    REQUIRE(presorted.atlas_count <= in_order.atlas_count);
+    REQUIRE(presorted.occupancy >= in_order.occupancy);
+    REQUIRE(presorted.occupancy <= 1.0);
+  }
+
+  TextureAtlas atlas({ 256, 256 }, AtlasPackingStrategy::Skyline);
+  atlas.set_padding(0);
+  REQUIRE(atlas.insert({ 128, 256 }));
+  REQUIRE(atlas.occupancy() == Approx(0.5));
+
+  atlas.clear();
+  REQUIRE(atlas.occupancy() == 0.0);
+  REQUIRE(atlas.padding() == 0);
+  REQUIRE(atlas.packing_strategy() == AtlasPackingStrategy::Skyline);
+}
+
+TEST_CASE("Aligned atlases place every rect on an alignment boundary")
+{
+  for (auto strategy : { AtlasPackingStrategy::MaxRects, AtlasPackingStrategy::Skyline })
+  {
+    TextureAtlas atlas({ 256, 256 }, strategy);
+    atlas.set_padding(4);
+    atlas.set_alignment(4);
+
+    std::vector<IntRect> placed;
+    for (std::int32_t index = 0; index != 40; ++index)
+    {
+      auto rect = atlas.insert({ 1 + (index * 5) % 19, 2 + (index * 3) % 17 });
+      REQUIRE(rect);
+      REQUIRE(rect->left % 4 == 0);
+      REQUIRE(rect->top % 4 == 0);
+
+      // Padding keeps at least four pixels between the aligned footprints of any two rects.
+      IntRect footprint(rect->left, rect->top, rect->width + 4, rect->height + 4);
+      for (const auto& other : placed)
+      {
+        REQUIRE_FALSE(intersects(footprint, other));
+      }
+
+      placed.push_back(footprint);
+    }
+  }
+}
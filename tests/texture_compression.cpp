@@ -0,0 +1,207 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "catch.hpp"
+
+#include "graphics/texture_compression.hpp"
+
+#include "utility/texture_atlas.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+  gli::texture2d make_texture(std::uint32_t width, std::uint32_t height)
+  {
+    gli::texture2d texture(gli::FORMAT_RGBA8_UNORM_PACK8, gli::extent2d(width, height), 1);
+    auto* pixels = static_cast<std::uint8_t*>(texture.data());
+    for (std::uint32_t y = 0; y != height; ++y)
+    {
+      for (std::uint32_t x = 0; x != width; ++x)
+      {
+        auto* p = pixels + (y * width + x) * 4;
+        p[0] = static_cast<std::uint8_t>(x * 255 / width);
+        p[1] = static_cast<std::uint8_t>(y * 255 / height);
+        p[2] = 96;
+        p[3] = 255;
+      }
+    }
+
+    return texture;
+  }
+
+  int max_difference(const gli::texture2d& a, const gli::texture2d& b)
+  {
+    const auto* pixels_a = static_cast<const std::uint8_t*>(a.data());
+    const auto* pixels_b = static_cast<const std::uint8_t*>(b.data());
+
+    int result = 0;
+    for (std::size_t index = 0; index != a.size(); ++index)
+    {
+      result = std::max(result, std::abs(pixels_a[index] - pixels_b[index]));
+    }
+
+    return result;
+  }
+}
+
+TEST_CASE("Block compression reproduces solid colors and alpha extremes")
+{
+  using namespace ts::graphics;
+
+  std::uint8_t pixels[64];
+  for (int pixel = 0; pixel != 16; ++pixel)
+  {
+    pixels[pixel * 4] = 255;
+    pixels[pixel * 4 + 1] = 0;
+    pixels[pixel * 4 + 2] = 0;
+    pixels[pixel * 4 + 3] = pixel % 2 == 0 ? 0 : 255;
+  }
+
+  std::uint8_t block[16];
+  std::uint8_t decoded[64];
+  detail::encode_bc3_block(pixels, block);
+  detail::decode_bc3_block(block, decoded);
+
+  for (int index = 0; index != 64; ++index)
+  {
+    REQUIRE(decoded[index] == pixels[index]);
+  }
+
+  detail::encode_bc1_block(pixels, block);
+  detail::decode_bc1_block(block, decoded);
+  REQUIRE(decoded[0] == 255);
+  REQUIRE(decoded[1] == 0);
+  REQUIRE(decoded[2] == 0);
+  REQUIRE(decoded[3] == 255);
+}
+
+TEST_CASE("Texture compression")
+{
+  using namespace ts::graphics;
+
+  // Not a multiple of the block size, to cover the partial blocks.
+  auto texture = make_texture(70, 38);
+  REQUIRE(select_block_format(texture) == BlockFormat::BC1);
+
+  SECTION("BC1")
+  {
+    auto compressed = compress_texture(texture, BlockFormat::BC1, 3);
+    REQUIRE(compressed.format() == gli::FORMAT_RGB_DXT1_UNORM_BLOCK8);
+    REQUIRE(compressed.size() == 18 * 10 * 8);
+
+    auto decompressed = decompress_texture(compressed);
+    REQUIRE(decompressed.extent() == texture.extent());
+    REQUIRE(max_difference(texture, decompressed) <= 16);
+  }
+
+  SECTION("BC3")
+  {
+    static_cast<std::uint8_t*>(texture.data())[3] = 128;
+    REQUIRE(select_block_format(texture) == BlockFormat::BC3);
+
+    auto compressed = compress_texture(texture, BlockFormat::BC3, 3);
+    REQUIRE(compressed.format() == gli::FORMAT_RGBA_DXT5_UNORM_BLOCK16);
+    REQUIRE(compressed.size() == 18 * 10 * 16);
+
+    auto decompressed = decompress_texture(compressed);
+    REQUIRE(max_difference(texture, decompressed) <= 16);
+  }
+}
+
+TEST_CASE("Block-aligned atlas rects keep their own colors after compression")
+{
+  using namespace ts;
+  using namespace ts::graphics;
+
+  const std::uint8_t colors[][3] =
+  {
+    { 255, 0, 0 }, { 0, 255, 0 }, { 0, 0, 255 }, { 255, 255, 0 }, { 255, 0, 255 }, { 0, 255, 255 }
+  };
+
+  for (auto strategy : { utility::AtlasPackingStrategy::MaxRects, utility::AtlasPackingStrategy::Skyline })
+  {
+    utility::AtlasList atlas_list({ 256, 256 }, strategy);
+    atlas_list.set_padding(block_extent);
+    atlas_list.set_alignment(block_extent);
+
+    // Sizes that are not multiples of the block size, so that every rect ends in partial blocks.
+    std::vector<IntRect> atlas_rects;
+    for (std::int32_t index = 0; index != 60; ++index)
+    {
+      auto entry = atlas_list.allocate_rect({ 0, 0, 5 + (index * 7) % 23, 3 + (index * 11) % 29 });
+      REQUIRE(entry);
+      REQUIRE(entry->atlas_id == 0);
+      atlas_rects.push_back(entry->atlas_rect);
+    }
+
+    // No two rects touch the same block.
+    auto block_rect = [](const IntRect& rect)
+    {
+      return IntRect(rect.left / block_extent, rect.top / block_extent,
+                     (rect.right() - 1) / block_extent - rect.left / block_extent + 1,
+                     (rect.bottom() - 1) / block_extent - rect.top / block_extent + 1);
+    };
+
+    for (std::size_t a = 0; a != atlas_rects.size(); ++a)
+    {
+      REQUIRE(atlas_rects[a].left % block_extent == 0);
+      REQUIRE(atlas_rects[a].top % block_extent == 0);
+
+      for (std::size_t b = a + 1; b != atlas_rects.size(); ++b)
+      {
+        REQUIRE_FALSE(intersects(block_rect(atlas_rects[a]), block_rect(atlas_rects[b])));
+      }
+    }
+
+    // Fill every rect with a solid color, on an opaque black background.
+    gli::texture2d texture(gli::FORMAT_RGBA8_UNORM_PACK8, gli::extent2d(256, 256), 1);
+    auto* pixels = static_cast<std::uint8_t*>(texture.data());
+    for (std::size_t index = 0; index != 256 * 256; ++index)
+    {
+      pixels[index * 4] = pixels[index * 4 + 1] = pixels[index * 4 + 2] = 0;
+      pixels[index * 4 + 3] = 255;
+    }
+
+    for (std::size_t index = 0; index != atlas_rects.size(); ++index)
+    {
+      const auto& rect = atlas_rects[index];
+      for (auto y = rect.top; y != rect.bottom(); ++y)
+      {
+        for (auto x = rect.left; x != rect.right(); ++x)
+        {
+          std::copy(colors[index % 6], colors[index % 6] + 3, pixels + (y * 256 + x) * 4);
+        }
+      }
+    }
+
+    auto decompressed = decompress_texture(compress_texture(texture, BlockFormat::BC1, 2));
+    const auto* decoded = static_cast<const std::uint8_t*>(decompressed.data());
+
+    // The edge blocks of each rect only contain the rect's color and the background, which BC1
+    // reproduces exactly. A block shared with a neighbouring rect would need more colors than that.
+    std::size_t contaminated_pixels = 0;
+    for (std::size_t index = 0; index != atlas_rects.size(); ++index)
+    {
+      const auto& rect = atlas_rects[index];
+      for (auto y = rect.top; y != rect.bottom(); ++y)
+      {
+        for (auto x = rect.left; x != rect.right(); ++x)
+        {
+          const auto* pixel = decoded + (y * 256 + x) * 4;
+          const auto* color = colors[index % 6];
+          if (std::abs(pixel[0] - color[0]) > 8 || std::abs(pixel[1] - color[1]) > 8 ||
+              std::abs(pixel[2] - color[2]) > 8) ++contaminated_pixels;
+        }
+      }
+    }
+
+    REQUIRE(contaminated_pixels == 0);
+  }
+}
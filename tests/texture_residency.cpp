@@ -0,0 +1,119 @@
+/*
+* TS Elements
+* Copyright 2015-2018 M. Newhouse
+* Released under the MIT license.
+*/
+
+#include "catch.hpp"
+
+#include "scene/texture_residency.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace
+{
+  // Without a GL context, resident textures are told apart by the bookkeeping only.
+  struct HeadlessTextures
+  {
+    explicit HeadlessTextures(std::size_t count)
+    {
+      for (std::size_t index = 0; index != count; ++index)
+      {
+        textures.push_back(std::make_unique<ts::graphics::Texture>(0, ts::Vector2u(64, 64)));
+        sources.emplace_back(gli::FORMAT_RGBA8_UNORM_PACK8, gli::extent2d(64, 64), 1);
+      }
+    }
+
+    std::vector<ts::graphics::Texture*> pointers() const
+    {
+      std::vector<ts::graphics::Texture*> result;
+      for (const auto& texture : textures) result.push_back(texture.get());
+      return result;
+    }
+
+    std::vector<std::unique_ptr<ts::graphics::Texture>> textures;
+    std::vector<gli::texture2d> sources;
+  };
+
+  ts::graphics::Texture headless_upload(const gli::texture2d& source)
+  {
+    auto extent = source.extent();
+    return ts::graphics::Texture(0, ts::Vector2u(extent.x, extent.y));
+  }
+}
+
+TEST_CASE("Texture residency evicts the least recently used textures to meet its budget")
+{
+  using namespace ts;
+
+  const std::size_t texture_bytes = 64 * 64 * 4;
+
+  HeadlessTextures headless(4);
+  scene::TextureResidency residency(texture_bytes * 2, headless_upload);
+  residency.assign(headless.pointers(), headless.sources);
+
+  auto* textures = headless.textures.data();
+  REQUIRE(residency.stats().managed_textures == 4);
+  REQUIRE_FALSE(residency.is_resident(textures[0].get()));
+
+  residency.begin_frame();
+  REQUIRE(residency.request(textures[0].get()));
+  REQUIRE_FALSE(residency.request(textures[0].get()));
+  residency.end_frame();
+
+  residency.begin_frame();
+  REQUIRE(residency.request(textures[1].get()));
+  residency.end_frame();
+
+  // Everything that's used in the current frame stays, even if that exceeds the budget.
+  residency.begin_frame();
+  residency.request(textures[1].get());
+  residency.request(textures[2].get());
+  residency.request(textures[3].get());
+  REQUIRE(residency.stats().resident_bytes == texture_bytes * 4);
+  residency.end_frame();
+
+  REQUIRE_FALSE(residency.is_resident(textures[0].get()));
+  REQUIRE(residency.is_resident(textures[1].get()));
+  REQUIRE(residency.stats().resident_textures == 3);
+  REQUIRE(residency.stats().evictions == 1);
+  REQUIRE(residency.stats().demand_uploads == 4);
+
+  // Textures that aren't managed are ignored.
+  graphics::Texture unmanaged(0, Vector2u(64, 64));
+  REQUIRE_FALSE(residency.request(&unmanaged));
+  REQUIRE_FALSE(residency.request(nullptr));
+}
+
+TEST_CASE("Texture residency only prefetches within the budget")
+{
+  using namespace ts;
+
+  const std::size_t texture_bytes = 64 * 64 * 4;
+
+  HeadlessTextures headless(3);
+  scene::TextureResidency residency(texture_bytes * 2, headless_upload);
+  residency.assign(headless.pointers(), headless.sources);
+
+  auto* textures = headless.textures.data();
+
+  residency.begin_frame();
+  residency.request(textures[0].get());
+  residency.request(textures[1].get());
+
+  // Both resident textures are in use, so there's no room to prefetch.
+  REQUIRE_FALSE(residency.prefetch(textures[2].get()));
+  residency.end_frame();
+
+  // In the next frame, the least recently used texture makes room for it.
+  residency.begin_frame();
+  residency.request(textures[1].get());
+  REQUIRE(residency.prefetch(textures[2].get()));
+  residency.end_frame();
+
+  REQUIRE_FALSE(residency.is_resident(textures[0].get()));
+  REQUIRE(residency.is_resident(textures[2].get()));
+  REQUIRE(residency.stats().prefetch_uploads == 1);
+  REQUIRE(residency.stats().resident_bytes <= residency.stats().budget_bytes);
+}
@@ -14,10 +14,19 @@
 
 #include "scene/track_scene_generator_detail.hpp"
 #include "scene/track_scene.hpp"
+#include "scene/atlas_cache.hpp"
+#include "scene/geometry_cache.hpp"
+#include "scene/track_vertices.hpp"
 
 #include "graphics/image.hpp"
 
+#include <boost/filesystem.hpp>
+
+#include <ctime>
+#include <fstream>
 #include <iostream>
+#include <set>
+#include <tuple>
 
 using namespace ts;
 
@@ -136,6 +145,89 @@ TEST_CASE("Track loading is a complex process, which is required to work perfect
       */
     }
 
+    SECTION("Atlas cache")
+    {
+      auto key = compute_atlas_cache_key(track, { 2048, 2048 }, true);
+      REQUIRE(key == compute_atlas_cache_key(track, { 2048, 2048 }, true));
+      REQUIRE(key != compute_atlas_cache_key(track, { 1024, 1024 }, true));
+      REQUIRE(key != compute_atlas_cache_key(track, { 2048, 2048 }, true, true));
+
+      AtlasCacheEntry cache_entry;
+      cache_entry.atlases.emplace_back(gli::FORMAT_RGBA8_UNORM_PACK8, gli::extent2d(16, 8), 1);
+      std::fill(cache_entry.atlases[0].data<std::uint32_t>(), cache_entry.atlases[0].data<std::uint32_t>() + 128,
+                0xFF00FF00);
+      cache_entry.mappings.push_back({ texture_map.tile_id(25), 0, IntRect(1, 2, 3, 4), Vector2i(5, 6), true });
+
+      save_atlas_cache("assets/output/atlas_cache.bin", cache_entry);
+      auto loaded = load_atlas_cache("assets/output/atlas_cache.bin");
+      REQUIRE(loaded);
+      REQUIRE(loaded->atlases.size() == 1);
+      REQUIRE(loaded->atlases[0].extent() == cache_entry.atlases[0].extent());
+      REQUIRE(*loaded->atlases[0].data<std::uint32_t>() == 0xFF00FF00);
+      REQUIRE(loaded->mappings.size() == 1);
+      REQUIRE(loaded->mappings[0].resource_id == texture_map.tile_id(25));
+      REQUIRE(loaded->mappings[0].texture_rect == IntRect(1, 2, 3, 4));
+      REQUIRE(loaded->mappings[0].is_fragment);
+
+      REQUIRE_FALSE(load_atlas_cache("assets/output/doesnotexist.bin"));
+    }
+
+    SECTION("Geometry cache")
+    {
+      auto atlas_key = compute_atlas_cache_key(track, { 2048, 2048 }, true);
+      auto key = compute_geometry_cache_key(track, atlas_key);
+      REQUIRE(key == compute_geometry_cache_key(track, atlas_key));
+      REQUIRE(key != compute_geometry_cache_key(track, compute_atlas_cache_key(track, { 1024, 1024 }, true)));
+
+      auto make_track_scene = [&]()
+      {
+        std::vector<std::unique_ptr<graphics::Texture>> atlas_textures;
+        for (std::size_t i = 0; i != placement_map.atlases.size(); ++i)
+        {
+          atlas_textures.push_back(std::make_unique<graphics::Texture>(0, Vector2u(2048, 2048)));
+        }
+
+        return TrackScene(track.size(), detail::generate_resource_texture_map(track, placement_map,
+                                                                              std::move(atlas_textures)));
+      };
+
+      auto track_scene = make_track_scene();
+      build_track_vertices(track, track_scene);
+      REQUIRE_FALSE(track_scene.layers().empty());
+
+      save_geometry_cache("assets/output/geometry_cache.bin", track, track_scene);
+
+      auto loaded_scene = make_track_scene();
+      REQUIRE(load_geometry_cache("assets/output/geometry_cache.bin", track, loaded_scene));
+      REQUIRE(loaded_scene.layers().size() == track_scene.layers().size());
+
+      auto loaded_it = loaded_scene.layers().begin();
+      for (const auto& scene_layer : track_scene.layers())
+      {
+        const auto& loaded_layer = *loaded_it++;
+        REQUIRE(loaded_layer.associated_layer() == scene_layer.associated_layer());
+        REQUIRE(loaded_layer.level() == scene_layer.level());
+        REQUIRE(loaded_layer.vertices().size() == scene_layer.vertices().size());
+        REQUIRE(loaded_layer.component_regions().size() == scene_layer.component_regions().size());
+
+        for (std::size_t i = 0; i != scene_layer.component_regions().size(); ++i)
+        {
+          const auto& region = scene_layer.component_regions()[i];
+          const auto& loaded_region = loaded_layer.component_regions()[i];
+          REQUIRE(loaded_region.size() == region.size());
+          for (std::size_t j = 0; j != region.size() && j != loaded_region.size(); ++j)
+          {
+            REQUIRE(loaded_region[j].faces.size() == region[j].faces.size());
+            REQUIRE(loaded_region[j].bounding_box == region[j].bounding_box);
+          }
+        }
+      }
+
+      auto empty_scene = make_track_scene();
+      REQUIRE_FALSE(load_geometry_cache("assets/output/doesnotexist.bin", track, empty_scene));
+      REQUIRE(empty_scene.layers().empty());
+    }
+
     detail::ImageLoader image_loader;
     std::size_t id = 0;
     for (const auto& atlas : placement_map.atlases)
@@ -146,3 +238,127 @@ TEST_CASE("Track loading is a complex process, which is required to work perfect
   }
 }
 
+TEST_CASE("Presorted atlas packing records every tile once, however often it is placed")
+{
+  resources::TrackLoader track_loader;
+  track_loader.load_from_file("assets/tracks/test.trk");
+  auto track = track_loader.get_result();
+
+  const auto& tile_library = track.tile_library();
+  const auto& tile_interface = tile_library.tiles();
+  const auto& tile_group_interface = tile_library.tile_groups();
+  std::set<resources::TileId> expected_tiles;
+
+  // Place every tile and tile group of the track many times over.
+  for (auto& layer : track.layers())
+  {
+    auto tiles = layer.tiles();
+    if (!tiles) continue;
+
+    auto placed_tiles = *tiles;
+    for (int repetition = 0; repetition != 50; ++repetition)
+    {
+      tiles->insert(tiles->end(), placed_tiles.begin(), placed_tiles.end());
+    }
+
+    for (const auto& tile : placed_tiles)
+    {
+      if (tile_interface.find(tile.id) != tile_interface.end())
+      {
+        expected_tiles.insert(tile.id);
+        continue;
+      }
+
+      auto group_it = tile_group_interface.find(tile.id);
+      if (group_it == tile_group_interface.end()) continue;
+
+      for (const auto& sub_tile : group_it->sub_tiles)
+      {
+        if (tile_interface.find(sub_tile.id) != tile_interface.end())
+        {
+          expected_tiles.insert(sub_tile.id);
+        }
+      }
+    }
+  }
+
+  REQUIRE_FALSE(expected_tiles.empty());
+
+  scene::detail::AtlasPackingOptions packing_options;
+  packing_options.presort = true;
+
+  auto image_mapping = scene::detail::generate_image_mapping(track);
+  auto placement_map = scene::detail::generate_atlas_placement_map(track, image_mapping, { 2048, 2048 },
+                                                                   false, packing_options);
+
+  // No image rect may be placed more than once, and there can't be more of them than there are tiles.
+  std::set<std::tuple<std::string, std::int32_t, std::int32_t, std::int32_t, std::int32_t>> placed_rects;
+  std::size_t placement_count = 0;
+  for (const auto& atlas : placement_map.atlases)
+  {
+    for (const auto& image_data : atlas.image_data)
+    {
+      for (const auto& placement : image_data.second)
+      {
+        const auto& rect = placement.full_source_rect;
+        placed_rects.emplace(image_data.first.to_string(), rect.left, rect.top, rect.width, rect.height);
+        ++placement_count;
+      }
+    }
+  }
+
+  CHECK(placement_map.atlas_fragments.empty());
+  CHECK(placement_count == placed_rects.size());
+  CHECK(placement_count <= expected_tiles.size());
+
+  for (auto tile_id : expected_tiles)
+  {
+    const auto& tile_def = *tile_interface.find(tile_id);
+    CHECK(scene::detail::texture_rect_exists(placement_map, tile_def.image_file, tile_def.image_rect));
+  }
+}
+
+TEST_CASE("Cache files are written through unique temp files, and trimmed least recently used first")
+{
+  using namespace scene;
+  namespace fs = boost::filesystem;
+
+  auto temp_name = cache_temp_file_name("cache/atlas_0123.bin");
+  REQUIRE(temp_name.compare(0, 20, "cache/atlas_0123.bin") == 0);
+  REQUIRE(fs::path(temp_name).extension() == ".tmp");
+  REQUIRE(temp_name != cache_temp_file_name("cache/atlas_0123.bin"));
+
+  fs::path directory("assets/output/cache_trim");
+  fs::remove_all(directory);
+  fs::create_directories(directory);
+
+  auto now = std::time(nullptr);
+  auto write_file = [&](const char* name, std::time_t write_time)
+  {
+    auto path = directory / name;
+    std::ofstream(path.string(), std::ios::binary) << std::string(100, 'x');
+    fs::last_write_time(path, write_time);
+  };
+
+  write_file("atlas_a.bin", now - 400);
+  write_file("atlas_b.bin", now - 300);
+  write_file("geometry_c.bin", now - 200);
+  write_file("geometry_d.bin", now - 100);
+  write_file("atlas_e.bin.1234.tmp", now - 10);
+  write_file("atlas_f.bin.5678.tmp", now - 7200);
+
+  // The oldest file was used just now.
+  touch_cache_file((directory / "atlas_a.bin").string());
+
+  trim_cache_directory(directory.string(), 250);
+
+  // The abandoned temp file goes first, the one that may still be written to stays.
+  CHECK_FALSE(fs::exists(directory / "atlas_f.bin.5678.tmp"));
+  CHECK(fs::exists(directory / "atlas_e.bin.1234.tmp"));
+  CHECK_FALSE(fs::exists(directory / "atlas_b.bin"));
+  CHECK_FALSE(fs::exists(directory / "geometry_c.bin"));
+  CHECK_FALSE(fs::exists(directory / "geometry_d.bin"));
+  CHECK(fs::exists(directory / "atlas_a.bin"));
+
+  fs::remove_all(directory);
+}
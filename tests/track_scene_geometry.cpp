@@ -1,14 +1,87 @@
 /*
 * TS Elements
-* Copyright 2015-2016 M. Newhouse
+* Copyright 2015-2018 M. Newhouse
 * Released under the MIT license.
 */
 
 #include "catch.hpp"
 
 #include "scene/track_scene.hpp"
+#include "scene/track_culling.hpp"
 
-TEST_CASE("The track scene uses complicated algorithms to achieve its functionality, and any slight bug could be disastrous.")
+#include "resources/track_layer.hpp"
+
+#include <SFML/Graphics/Transform.hpp>
+
+namespace
+{
+  void append_quad(ts::scene::TrackSceneLayer& scene_layer, ts::FloatRect rect)
+  {
+    using ts::make_vector2;
+
+    ts::resources::Vertex vertices[4] = {};
+    vertices[0].position = make_vector2(rect.left, rect.top);
+    vertices[1].position = make_vector2(rect.right(), rect.top);
+    vertices[2].position = make_vector2(rect.right(), rect.bottom());
+    vertices[3].position = make_vector2(rect.left, rect.bottom());
+
+    ts::resources::Face faces[2] = { { { 0, 1, 2 } }, { { 0, 2, 3 } } };
+    scene_layer.append_geometry(nullptr, vertices, 4, faces, 2);
+  }
+
+  // Maps the given world rect to the clip-space square [-1, 1].
+  sf::Transform make_view_matrix(ts::FloatRect rect)
+  {
+    sf::Transform view_matrix;
+    view_matrix.scale(2.0f / rect.width, 2.0f / rect.height);
+    view_matrix.translate(-rect.left - rect.width * 0.5f, -rect.top - rect.height * 0.5f);
+    return view_matrix;
+  }
+}
+
+TEST_CASE("Track scene layers are split into chunks that can be culled individually")
 {
+  using namespace ts;
+
+  resources::TrackLayer layer(resources::TrackLayerType::Tiles, 0, "tiles");
+  scene::TrackScene track_scene({ 2048, 2048 }, scene::TextureMapping());
+  auto& scene_layer = track_scene.scene_layer(&layer);
+
+  SECTION("Faces that span multiple chunks end up in all of them")
+  {
+    append_quad(scene_layer, FloatRect(0.0f, 0.0f, 2048.0f, 2048.0f));
+
+    std::size_t used_regions = 0;
+    for (const auto& region : scene_layer.component_regions())
+    {
+      if (!region.empty()) ++used_regions;
+    }
+
+    REQUIRE(used_regions == 16);
+  }
+
+  SECTION("Chunks outside of the view are not submitted")
+  {
+    for (int y = 0; y != 4; ++y)
+    {
+      for (int x = 0; x != 4; ++x)
+      {
+        append_quad(scene_layer, FloatRect(x * 512.0f + 128.0f, y * 512.0f + 128.0f, 256.0f, 256.0f));
+      }
+    }
+
+    auto full_stats = scene::compute_culling_stats(track_scene, make_view_matrix(FloatRect(0.0f, 0.0f, 2048.0f, 2048.0f)));
+    CHECK(full_stats.total_components == 16);
+    CHECK(full_stats.total_faces == 32);
+    CHECK(full_stats.submitted_faces == full_stats.total_faces);
+
+    auto stats = scene::compute_culling_stats(track_scene, make_view_matrix(FloatRect(100.0f, 100.0f, 300.0f, 300.0f)));
+    CHECK(stats.total_faces == 32);
+    CHECK(stats.submitted_components == 1);
+    CHECK(stats.submitted_faces == 2);
 
-}
\ No newline at end of file
+    layer.hide();
+    auto hidden_stats = scene::compute_culling_stats(track_scene, make_view_matrix(FloatRect(0.0f, 0.0f, 2048.0f, 2048.0f)));
+    CHECK(hidden_stats.total_faces == 0);
+  }
+}